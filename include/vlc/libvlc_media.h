@@ -827,6 +827,35 @@ void libvlc_media_tracks_release( libvlc_media_track_t **p_tracks,
 LIBVLC_API
 libvlc_media_type_t libvlc_media_get_type( libvlc_media_t *p_md );
 
+/**
+ * Extract a thumbnail from the media, without playing it.
+ *
+ * Only the first video track is decoded, and the media is seeked to the
+ * closest keyframe of the requested time or position. This is much faster
+ * than playing the media and taking a snapshot, at the cost of accuracy.
+ *
+ * \note This function is synchronous, and may block for up to i_timeout.
+ *
+ * \version LibVLC 4.0.0 and later.
+ *
+ * \param p_md media descriptor object
+ * \param i_time time to seek to (in ms), or -1 to use f_pos instead
+ * \param f_pos position to seek to, in the [0.0, 1.0] range
+ * \param i_width width of the thumbnail, or 0 to keep the aspect ratio
+ * \param i_height height of the thumbnail, or 0 to keep the aspect ratio
+ * \param psz_format image format, e.g. "png" or "jpg" (NULL for png)
+ * \param i_timeout maximum duration of the extraction (in ms), or 0 for none
+ * \param pp_data [OUT] encoded image (must be freed with libvlc_free())
+ * \param pi_size [OUT] size of the encoded image
+ *
+ * \return 0 on success, -1 on error.
+ */
+LIBVLC_API
+int libvlc_media_thumbnail( libvlc_media_t *p_md, libvlc_time_t i_time,
+                            float f_pos, unsigned i_width, unsigned i_height,
+                            const char *psz_format, libvlc_time_t i_timeout,
+                            unsigned char **pp_data, size_t *pi_size );
+
 /**
  * Add a slave to the current media.
  *
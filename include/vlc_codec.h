@@ -65,6 +65,9 @@ struct decoder_owner_callbacks
             /* Display rate
              * cf. decoder_GetDisplayRate */
             int         (*get_display_rate)( decoder_t * );
+            /* Display lateness
+             * cf. decoder_GetDisplayLateness */
+            unsigned    (*get_display_lateness)( decoder_t * );
         } video;
         struct
         {
@@ -453,6 +456,21 @@ static inline int decoder_GetDisplayRate( decoder_t *dec )
     return dec->cbs->video.get_display_rate( dec );
 }
 
+/**
+ * This function returns the share of the recently queued pictures, in
+ * percent, that the video output displayed late or dropped for being late.
+ * You MUST use it *only* for adapting the decoding speed.
+ */
+VLC_USED
+static inline unsigned decoder_GetDisplayLateness( decoder_t *dec )
+{
+    assert( dec->fmt_in.i_cat == VIDEO_ES && dec->cbs != NULL );
+    if( !dec->cbs->video.get_display_lateness )
+        return 0;
+
+    return dec->cbs->video.get_display_lateness( dec );
+}
+
 /** @} */
 /** @} */
 #endif /* _VLC_CODEC_H */
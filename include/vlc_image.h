@@ -70,6 +70,45 @@ VLC_API void image_HandlerDelete( image_handler_t * );
 #define image_WriteUrl( a, b, c, d, e ) a->pf_write_url( a, b, c, d, e )
 #define image_Convert( a, b, c, d ) a->pf_convert( a, b, c, d )
 
+/**
+ * Image writer
+ *
+ * Encodes pictures and writes them to files on a pool of worker threads,
+ * each with its own image handler, so that the caller never waits for the
+ * compression. The queue of pictures to write is bounded.
+ */
+typedef struct image_writer_t image_writer_t;
+
+/**
+ * Creates an image writer.
+ *
+ * \param threads number of worker threads, 0 for one per CPU core
+ * \param queue_size maximum number of pictures waiting to be written
+ */
+VLC_API image_writer_t * image_WriterCreate( vlc_object_t *, unsigned threads,
+                                             unsigned queue_size ) VLC_USED;
+#define image_WriterCreate( a, b, c ) image_WriterCreate( VLC_OBJECT(a), b, c )
+
+/**
+ * Deletes an image writer, once all the queued pictures are written.
+ */
+VLC_API void image_WriterDelete( image_writer_t * );
+
+/**
+ * Queues a picture to be written, as with image_WriteUrl().
+ *
+ * The picture is held until it is written. The completion callback, if not
+ * NULL, is called from a worker thread with the image_WriteUrl() status.
+ *
+ * \return VLC_SUCCESS, or VLC_EGENERIC if the queue is full, in which case
+ * the callback is not called
+ */
+VLC_API int image_WriterQueue( image_writer_t *, picture_t *,
+                               const video_format_t *fmt_in,
+                               const video_format_t *fmt_out,
+                               const char *psz_url,
+                               void (*pf_done)( void *, int ), void *opaque );
+
 VLC_API vlc_fourcc_t image_Type2Fourcc( const char *psz_name );
 VLC_API vlc_fourcc_t image_Ext2Fourcc( const char *psz_name );
 VLC_API vlc_fourcc_t image_Mime2Fourcc( const char *psz_mime );
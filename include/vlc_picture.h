@@ -201,6 +201,26 @@ VLC_API void picture_Copy( picture_t *p_dst, const picture_t *p_src );
  */
 VLC_API picture_t *picture_Clone(picture_t *pic);
 
+/**
+ * Creates a view of a rectangle of a picture
+ *
+ * The view shares the planes of the picture, of which it holds a reference:
+ * no pixel is copied. The rectangle is given in pixels from the start of the
+ * planes, and the view format is the picture one, resized to the rectangle
+ * and without offsets. With vflip, the lines of the view come in reverse
+ * order, so its planes have negative pitches.
+ *
+ * The pixels of the view must not be written to, as they belong to the
+ * picture.
+ *
+ * \return A view picture on success, NULL if the rectangle does not fit in
+ * the picture or does not start on a sample of each plane, if the picture
+ * has no planes (opaque chroma), or on error.
+ */
+VLC_API picture_t *picture_NewView(picture_t *pic, unsigned x, unsigned y,
+                                   unsigned width, unsigned height,
+                                   bool vflip) VLC_USED;
+
 /**
  * This function will export a picture to an encoded bitstream.
  *
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * vlc_slices.h: slice-parallel jobs
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SLICES_H
+#define VLC_SLICES_H 1
+
+#include <assert.h>
+
+/**
+ * \defgroup slices Slice jobs
+ * \ingroup threads
+ * Runs a job split in independent slices on a pool of worker threads shared
+ * by the whole LibVLC instance.
+ *
+ * This is meant for video filters and converters working on row bands of
+ * the planes: the calling thread processes slices too, and only returns once
+ * all of them are done, so the pictures are never accessed concurrently
+ * outside of the call.
+ * @{
+ * \file
+ * Slice jobs
+ */
+
+/** Minimum number of rows worth a slice of its own */
+#define VLC_SLICE_MIN_ROWS 16
+
+/**
+ * Slice callback.
+ *
+ * \param opaque data pointer given to vlc_slices_Run()
+ * \param index index of the slice, in the [0, count) range
+ * \param count total number of slices
+ */
+typedef void (*vlc_slice_cb)(void *opaque, unsigned index, unsigned count);
+
+/**
+ * Returns the number of slices a job on the given number of rows should be
+ * split into.
+ *
+ * The result is constant for a given number of rows, so it can be used to
+ * size per-slice buffers once and for all.
+ *
+ * \param obj an object of the LibVLC instance
+ * \param rows number of rows of the largest plane
+ * \return a number of slices (at least one)
+ */
+VLC_API unsigned vlc_slices_Count(vlc_object_t *obj, unsigned rows) VLC_USED;
+#define vlc_slices_Count(o, r) vlc_slices_Count(VLC_OBJECT(o), r)
+
+/**
+ * Runs a job split in slices, and waits for all of them to complete.
+ *
+ * Slices may run in any order and concurrently. They must not depend on the
+ * results of one another.
+ *
+ * \param obj an object of the LibVLC instance
+ * \param count number of slices
+ * \param func slice callback
+ * \param opaque data pointer for the callback
+ */
+VLC_API void vlc_slices_Run(vlc_object_t *obj, unsigned count,
+                            vlc_slice_cb func, void *opaque);
+#define vlc_slices_Run(o, c, f, d) vlc_slices_Run(VLC_OBJECT(o), c, f, d)
+
+/**
+ * Computes the rows of a slice.
+ *
+ * \param rows total number of rows
+ * \param index index of the slice
+ * \param count total number of slices
+ * \param align alignment of the band boundaries, in rows (power of two)
+ * \param begin [OUT] first row of the slice
+ * \param end [OUT] row following the last one of the slice
+ */
+static inline void vlc_slice_Rows(unsigned rows, unsigned index,
+                                  unsigned count, unsigned align,
+                                  unsigned *begin, unsigned *end)
+{
+    assert(index < count && align > 0 && (align & (align - 1)) == 0);
+
+    *begin = (uint64_t)rows * index / count & ~(align - 1);
+    *end = (index + 1 < count)
+         ? ((uint64_t)rows * (index + 1) / count & ~(align - 1)) : rows;
+}
+
+/** @} */
+
+#endif
@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * vlc_thumbnailer.h: Thumbnails extraction
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_THUMBNAILER_H
+#define VLC_THUMBNAILER_H 1
+
+#include <vlc_picture.h>
+
+/**
+ * \file
+ * This file defines the thumbnail extraction function
+ */
+
+/**
+ * Extracts one picture of a media, without playing it.
+ *
+ * Only the demuxer and the decoder of the first video elementary stream are
+ * run: audio and subtitles are not decoded, and there is no output nor clock.
+ * The demuxer is seeked in fast mode, i.e. to the closest keyframe, and the
+ * first picture decoded from a keyframe is returned.
+ *
+ * \param obj parent object
+ * \param item media to extract the picture from
+ * \param time time to seek to, or a negative value to use pos instead
+ * \param pos position to seek to, in the [0, 1] range, used when time is
+ *        negative
+ * \param timeout maximum duration of the extraction, including I/O
+ * \return a picture in the decoder output format (to be released with
+ *         picture_Release()), or NULL on error
+ */
+VLC_API picture_t *vlc_thumbnailer_Extract( vlc_object_t *obj,
+                                            input_item_t *item,
+                                            mtime_t time, double pos,
+                                            mtime_t timeout ) VLC_USED;
+#define vlc_thumbnailer_Extract(a,b,c,d,e) \
+    vlc_thumbnailer_Extract(VLC_OBJECT(a),b,c,d,e)
+
+#endif
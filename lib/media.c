@@ -34,9 +34,12 @@
 #include <vlc/libvlc_events.h>
 
 #include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_image.h>
 #include <vlc_input.h>
 #include <vlc_meta.h>
 #include <vlc_playlist.h> /* For the preparser */
+#include <vlc_thumbnailer.h>
 #include <vlc_url.h>
 
 #include "../src/libvlc.h"
@@ -1153,6 +1156,62 @@ libvlc_media_type_t libvlc_media_get_type( libvlc_media_t *p_md )
     }
 }
 
+/**************************************************************************
+ * Extract a thumbnail without playing the media
+ **************************************************************************/
+int libvlc_media_thumbnail( libvlc_media_t *p_md, libvlc_time_t i_time,
+                            float f_pos, unsigned i_width, unsigned i_height,
+                            const char *psz_format, libvlc_time_t i_timeout,
+                            unsigned char **pp_data, size_t *pi_size )
+{
+    assert( p_md && pp_data && pi_size );
+
+    vlc_fourcc_t i_format = image_Type2Fourcc( psz_format ? psz_format
+                                                          : "png" );
+    if( i_format == 0 )
+    {
+        libvlc_printerr( "Unknown image format: %s", psz_format );
+        return -1;
+    }
+
+    vlc_object_t *p_obj = VLC_OBJECT(p_md->p_libvlc_instance->p_libvlc_int);
+    picture_t *p_pic = vlc_thumbnailer_Extract( p_obj, p_md->p_input_item,
+                                                i_time >= 0 ? to_mtime( i_time )
+                                                            : -1,
+                                                f_pos, to_mtime( i_timeout ) );
+    if( p_pic == NULL )
+    {
+        libvlc_printerr( "Cannot extract a thumbnail" );
+        return -1;
+    }
+
+    /* A zero dimension is computed from the other one and the aspect ratio,
+     * both keep the picture size */
+    int i_w = i_width > 0 ? (int)i_width : i_height > 0 ? 0 : -1;
+    int i_h = i_height > 0 ? (int)i_height : i_width > 0 ? 0 : -1;
+    block_t *p_image;
+    int i_ret = picture_Export( p_obj, &p_image, NULL, p_pic, i_format,
+                                i_w, i_h );
+    picture_Release( p_pic );
+    if( i_ret != VLC_SUCCESS )
+    {
+        libvlc_printerr( "Cannot encode the thumbnail" );
+        return -1;
+    }
+
+    *pp_data = malloc( p_image->i_buffer );
+    if( unlikely(*pp_data == NULL) )
+    {
+        block_Release( p_image );
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+    memcpy( *pp_data, p_image->p_buffer, p_image->i_buffer );
+    *pi_size = p_image->i_buffer;
+    block_Release( p_image );
+    return 0;
+}
+
 int libvlc_media_slaves_add( libvlc_media_t *p_md,
                              libvlc_media_slave_type_t i_type,
                              unsigned int i_priority,
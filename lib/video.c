@@ -164,7 +164,11 @@ libvlc_video_take_snapshot( libvlc_media_player_t *p_mi, unsigned num,
     var_SetString( p_vout, "snapshot-path", psz_filepath );
     var_Create( p_vout, "snapshot-format", VLC_VAR_STRING );
     var_SetString( p_vout, "snapshot-format", "png" );
+    /* The snapshot is saved when this returns, as it always was */
+    var_Create( p_vout, "snapshot-wait", VLC_VAR_BOOL );
+    var_SetBool( p_vout, "snapshot-wait", true );
     var_TriggerCallback( p_vout, "video-snapshot" );
+    var_SetBool( p_vout, "snapshot-wait", false );
     vlc_object_release( p_vout );
     return 0;
 }
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * hurry.h: closed-loop decoding degradation, driven by the vout lateness
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AVCODEC_HURRY_H_
+#define VLC_AVCODEC_HURRY_H_
+
+/* Share of late pictures, in percent, above which decoding gets cheaper,
+ * and below which it steps back to full quality */
+#define HURRY_LATENESS_HIGH 20
+#define HURRY_LATENESS_LOW  2
+/* Blocks to wait after a change, for its effect to reach the vout */
+#define HURRY_UP_HOLD       12
+#define HURRY_DOWN_HOLD     50
+
+enum hurry_level
+{
+    HURRY_NONE,
+    HURRY_SKIP_LOOP_FILTER,
+    HURRY_SKIP_NONREF,
+    HURRY_SKIP_BIDIR,
+};
+
+struct hurry_state
+{
+    enum hurry_level level;
+    unsigned i_hold;
+};
+
+static inline void hurry_Init( struct hurry_state *p_hurry )
+{
+    p_hurry->level = HURRY_NONE;
+    p_hurry->i_hold = 0;
+}
+
+/**
+ * Counts one decoded block against the hold of the last change.
+ *
+ * \return true while the level must not change, in which case the lateness
+ * does not need to be queried
+ */
+static inline bool hurry_Hold( struct hurry_state *p_hurry )
+{
+    if( p_hurry->i_hold == 0 )
+        return false;
+    p_hurry->i_hold--;
+    return true;
+}
+
+/**
+ * Steps the level up or down by one, from the share of late pictures.
+ *
+ * Must only be called once hurry_Hold() returned false.
+ * \return true if the level changed
+ */
+static inline bool hurry_Update( struct hurry_state *p_hurry,
+                                 unsigned i_lateness )
+{
+    if( i_lateness >= HURRY_LATENESS_HIGH && p_hurry->level < HURRY_SKIP_BIDIR )
+    {
+        p_hurry->level++;
+        p_hurry->i_hold = HURRY_UP_HOLD;
+        return true;
+    }
+    if( i_lateness <= HURRY_LATENESS_LOW && p_hurry->level > HURRY_NONE )
+    {
+        p_hurry->level--;
+        p_hurry->i_hold = HURRY_DOWN_HOLD;
+        return true;
+    }
+    return false;
+}
+
+#endif
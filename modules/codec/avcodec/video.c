@@ -46,6 +46,7 @@
 
 #include "avcodec.h"
 #include "va.h"
+#include "hurry.h"
 
 #if LIBAVUTIL_VERSION_CHECK( 52, 20, 0, 58, 100 )
 #include <libavutil/stereo3d.h>
@@ -79,6 +80,7 @@ typedef struct
     bool b_show_corrupted;
     bool b_from_preroll;
     enum AVDiscard i_skip_frame;
+    enum AVDiscard i_skip_loop_filter;
 
     struct frame_info_s frame_info[FRAME_INFO_DEPTH];
 
@@ -88,6 +90,8 @@ typedef struct
         FRAMEDROP_NONREF,
         FRAMEDROP_AGGRESSIVE_RECOVER,
     } framedrop;
+    /* closed-loop skipping, driven by the vout lateness */
+    struct hurry_state hurry;
     /* how many decoded frames are late */
     int     i_late_frames;
     int64_t i_last_output_frame;
@@ -96,6 +100,8 @@ typedef struct
     /* for direct rendering */
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
+    unsigned    i_dr_frames;
+    unsigned    i_copied_frames;
 
     /* Hack to force display of still pictures */
     bool b_first_frame;
@@ -170,6 +176,20 @@ static int lavc_GetVideoFormat(decoder_t *dec, video_format_t *restrict fmt,
             fmt->i_chroma = VLC_CODEC_RGB32;
 
         avcodec_align_dimensions2(ctx, &width, &height, aligns);
+
+        /* Every plane pitch must match the libavcodec alignment, not only the
+         * luma one, or direct rendering will fall back to copies */
+        const vlc_chroma_description_t *dsc =
+            vlc_fourcc_GetChromaDescription(fmt->i_chroma);
+        if (dsc != NULL)
+        {
+            unsigned align = 1;
+            for (unsigned i = 0; i < dsc->plane_count && i < 4; i++)
+                if (aligns[i] > 0)
+                    align = __MAX(align, aligns[i] * dsc->p[i].w.den
+                                                   / dsc->p[i].w.num);
+            width = (width + align - 1) / align * align;
+        }
     }
     else /* hardware decoding */
         fmt->i_chroma = vlc_va_GetChroma(pix_fmt, sw_pix_fmt);
@@ -330,6 +350,22 @@ static int lavc_GetVideoFormat(decoder_t *dec, video_format_t *restrict fmt,
     return 0;
 }
 
+/**
+ * Number of pictures libavcodec can hold on top of the reference frames,
+ * which are already accounted for by the core: one per frame thread, plus
+ * the reordering delay.
+ */
+static int lavc_GetExtraPictureBuffers(AVCodecContext *ctx)
+{
+    int thread_type = avcodec_is_open(ctx) ? ctx->active_thread_type
+                                           : ctx->thread_type;
+    int extra = ctx->has_b_frames;
+
+    if (thread_type & FF_THREAD_FRAME)
+        extra += ctx->thread_count;
+    return extra;
+}
+
 static int lavc_UpdateVideoFormat(decoder_t *dec, AVCodecContext *ctx,
                                   enum AVPixelFormat fmt,
                                   enum AVPixelFormat swfmt)
@@ -366,6 +402,9 @@ static int lavc_UpdateVideoFormat(decoder_t *dec, AVCodecContext *ctx,
         dec->fmt_out.video.mastering = dec->fmt_in.video.mastering;
     dec->fmt_out.video.lighting = dec->fmt_in.video.lighting;
 
+    /* The reordering delay is only known once the headers are parsed */
+    dec->i_extra_picture_buffers = lavc_GetExtraPictureBuffers(ctx);
+
     return decoder_UpdateVideoFormat(dec);
 }
 
@@ -518,11 +557,12 @@ int InitVideoDec( vlc_object_t *obj )
     p_context->flags |= AV_CODEC_FLAG_OUTPUT_CORRUPT;
 
     i_val = var_CreateGetInteger( p_dec, "avcodec-skiploopfilter" );
-    if( i_val >= 4 ) p_context->skip_loop_filter = AVDISCARD_ALL;
-    else if( i_val == 3 ) p_context->skip_loop_filter = AVDISCARD_NONKEY;
-    else if( i_val == 2 ) p_context->skip_loop_filter = AVDISCARD_BIDIR;
-    else if( i_val == 1 ) p_context->skip_loop_filter = AVDISCARD_NONREF;
-    else p_context->skip_loop_filter = AVDISCARD_DEFAULT;
+    if( i_val >= 4 ) p_sys->i_skip_loop_filter = AVDISCARD_ALL;
+    else if( i_val == 3 ) p_sys->i_skip_loop_filter = AVDISCARD_NONKEY;
+    else if( i_val == 2 ) p_sys->i_skip_loop_filter = AVDISCARD_BIDIR;
+    else if( i_val == 1 ) p_sys->i_skip_loop_filter = AVDISCARD_NONREF;
+    else p_sys->i_skip_loop_filter = AVDISCARD_DEFAULT;
+    p_context->skip_loop_filter = p_sys->i_skip_loop_filter;
 
     if( var_CreateGetBool( p_dec, "avcodec-fast" ) )
         p_context->flags2 |= AV_CODEC_FLAG2_FAST;
@@ -551,6 +591,8 @@ int InitVideoDec( vlc_object_t *obj )
     /* ***** libavcodec direct rendering ***** */
     p_sys->b_direct_rendering = false;
     atomic_init(&p_sys->b_dr_failure, false);
+    p_sys->i_dr_frames = 0;
+    p_sys->i_copied_frames = 0;
     if( var_CreateGetBool( p_dec, "avcodec-dr" ) &&
        (p_codec->capabilities & AV_CODEC_CAP_DR1) &&
         /* No idea why ... but this fixes flickering on some TSCC streams */
@@ -609,8 +651,7 @@ int InitVideoDec( vlc_object_t *obj )
             break;
     }
 
-    if( p_context->thread_type & FF_THREAD_FRAME )
-        p_dec->i_extra_picture_buffers = 2 * p_context->thread_count;
+    p_dec->i_extra_picture_buffers = lavc_GetExtraPictureBuffers( p_context );
 
     /* ***** misc init ***** */
     date_Init(&p_sys->pts, 1, 30001);
@@ -620,6 +661,7 @@ int InitVideoDec( vlc_object_t *obj )
     p_sys->b_from_preroll = false;
     p_sys->i_last_output_frame = -1;
     p_sys->framedrop = FRAMEDROP_NONE;
+    hurry_Init( &p_sys->hurry );
 
     /* Set output properties */
     if( GetVlcChroma( &p_dec->fmt_out.video, p_context->pix_fmt ) != VLC_SUCCESS )
@@ -673,6 +715,7 @@ static void Flush( decoder_t *p_dec )
     date_Set(&p_sys->pts, VLC_TS_INVALID); /* To make sure we recover properly */
     p_sys->i_late_frames = 0;
     p_sys->framedrop = FRAMEDROP_NONE;
+    hurry_Init( &p_sys->hurry );
     cc_Flush( &p_sys->cc );
 
     /* Abort pictures in order to unblock all avcodec workers threads waiting
@@ -739,6 +782,19 @@ static block_t * filter_earlydropped_blocks( decoder_t *p_dec, block_t *block )
     return block;
 }
 
+static void update_hurry_level( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    if( hurry_Hold( &p_sys->hurry ) )
+        return;
+
+    const unsigned i_lateness = decoder_GetDisplayLateness( p_dec );
+    if( hurry_Update( &p_sys->hurry, i_lateness ) )
+        msg_Dbg( p_dec, "%u%% of late pictures, hurry up level %d",
+                 i_lateness, p_sys->hurry.level );
+}
+
 static void interpolate_next_pts( decoder_t *p_dec, AVFrame *frame )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -991,6 +1047,17 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
     if( p_sys->b_hurry_up )
     {
         p_context->skip_frame = p_sys->i_skip_frame;
+        p_context->skip_loop_filter = p_sys->i_skip_loop_filter;
+
+        /* Degrade gradually while the vout reports late pictures */
+        if( p_block && !(p_block->i_flags & BLOCK_FLAG_PREROLL) )
+            update_hurry_level( p_dec );
+        if( p_sys->hurry.level >= HURRY_SKIP_LOOP_FILTER )
+            p_context->skip_loop_filter = AVDISCARD_ALL;
+        if( p_sys->hurry.level >= HURRY_SKIP_NONREF )
+            p_context->skip_frame = __MAX( p_context->skip_frame, AVDISCARD_NONREF );
+        if( p_sys->hurry.level >= HURRY_SKIP_BIDIR )
+            p_context->skip_frame = __MAX( p_context->skip_frame, AVDISCARD_BIDIR );
 
         /* Check also if we should/can drop the block and move to next block
             as trying to catchup the speed*/
@@ -1228,6 +1295,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                 picture_Release( p_pic );
                 break;
             }
+            p_sys->i_copied_frames++;
         }
         else
         {
@@ -1242,6 +1310,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                 av_frame_free(&frame);
                 break;
             }
+            if( p_sys->p_va == NULL )
+                p_sys->i_dr_frames++;
         }
 
         if( !p_dec->fmt_in.video.i_sar_num || !p_dec->fmt_in.video.i_sar_den )
@@ -1342,6 +1412,10 @@ void EndVideoDec( vlc_object_t *obj )
 
     cc_Flush( &p_sys->cc );
 
+    if( p_sys->i_dr_frames > 0 || p_sys->i_copied_frames > 0 )
+        msg_Dbg( p_dec, "direct rendering: %u frame(s), %u copied",
+                 p_sys->i_dr_frames, p_sys->i_copied_frames );
+
     hwaccel_context = ctx->hwaccel_context;
     avcodec_free_context( &ctx );
 
@@ -1544,7 +1618,9 @@ static int lavc_GetFrame(struct AVCodecContext *ctx, AVFrame *frame, int flags)
     wait_mt(sys);
     if (sys->p_va == NULL)
     {
-        if (!sys->b_direct_rendering)
+        /* Once the pictures were found unsuitable, don't take them from
+         * the pool only to release them */
+        if (!sys->b_direct_rendering || atomic_load(&sys->b_dr_failure))
         {
             post_mt(sys);
             return avcodec_default_get_buffer2(ctx, frame, flags);
@@ -1563,7 +1639,13 @@ static int lavc_GetFrame(struct AVCodecContext *ctx, AVFrame *frame, int flags)
 
     pic = decoder_NewPicture(dec);
     if (pic == NULL)
-        return -ENOMEM;
+    {
+        if (sys->p_va != NULL)
+            return -ENOMEM;
+        /* The pool is exhausted: decode into a libavcodec buffer, the frame
+         * will be copied to an output picture if one is available by then */
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
 
     if (sys->p_va != NULL)
         return lavc_va_GetFrame(ctx, frame, pic);
@@ -49,6 +49,8 @@
 
 #include <assert.h>
 
+#include "x26x_stats.h"
+
 #ifdef MODULE_NAME_IS_x26410b
 #define SOUT_CFG_PREFIX "sout-x26410b-"
 #endif
@@ -408,6 +410,11 @@ static void x264_log( void *, int i_level, const char *psz, va_list );
 #define LOOKAHEAD_LONGTEXT N_("Framecount to use on frametype lookahead. " \
     "Currently default can cause sync-issues on unmuxable output, like rtsp-output without ts-mux" )
 
+#define THROUGHPUT_TEXT N_("Tune threading for throughput")
+#define THROUGHPUT_LONGTEXT N_( "Use frame-based threads sized against " \
+    "the number of CPU cores, and threaded lookahead, instead of sliced " \
+    "threads. This encodes more frames per second at the cost of latency." )
+
 #define HRD_TEXT N_("HRD-timing information")
 #define TUNE_TEXT N_("Default tune setting used" )
 #define PRESET_TEXT N_("Default preset setting used" )
@@ -693,6 +700,9 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "non-deterministic", false, NON_DETERMINISTIC_TEXT,
               NON_DETERMINISTIC_LONGTEXT, true )
 
+    add_bool( SOUT_CFG_PREFIX "throughput", false, THROUGHPUT_TEXT,
+              THROUGHPUT_LONGTEXT, true )
+
     add_bool( SOUT_CFG_PREFIX "asm", true, ASM_TEXT,
               ASM_LONGTEXT, true )
 
@@ -751,12 +761,15 @@ static const char *const ppsz_sout_options[] = {
     "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
     "tune","preset", "opengop", "bluray-compat", "frame-packing", "options",
-    "fullrange",
+    "fullrange", "throughput",
     NULL
 };
 
 static block_t *Encode( encoder_t *, picture_t * );
 
+/* X264_THREAD_MAX is internal to x264, this is its value */
+#define VLC_X264_MAX_THREADS 128
+
 typedef struct
 {
     x264_t          *h;
@@ -768,6 +781,8 @@ typedef struct
     int             i_sei_size;
     uint32_t         i_colorspace;
     uint8_t         *p_sei;
+
+    struct x26x_stats stats;
 } encoder_sys_t;
 
 #ifdef PTW32_STATIC_LIB
@@ -868,6 +883,7 @@ static int  Open ( vlc_object_t *p_this )
     p_sys->psz_stat_name = NULL;
     p_sys->i_sei_size = 0;
     p_sys->p_sei = NULL;
+    x26x_stats_Init( &p_sys->stats );
 
     char *psz_preset = var_GetString( p_enc, SOUT_CFG_PREFIX  "preset" );
     char *psz_tune = var_GetString( p_enc, SOUT_CFG_PREFIX  "tune" );
@@ -1376,6 +1392,24 @@ static int  Open ( vlc_object_t *p_this )
        p_sys->param.rc.i_lookahead = var_GetInteger( p_enc, SOUT_CFG_PREFIX "lookahead" );
     }
 
+    if( var_GetBool( p_enc, SOUT_CFG_PREFIX "throughput" ) )
+    {
+        /* Sliced threads only help latency, frame threads scale further.
+         * Like x264 auto mode, use 1.5 thread per core to cover the stalls
+         * between dependent frames. */
+        p_sys->param.b_sliced_threads = 0;
+        if( p_enc->i_threads <= 0 )
+            p_sys->param.i_threads = __MIN( vlc_GetCPUCount() * 3 / 2,
+                                            VLC_X264_MAX_THREADS );
+        p_sys->param.i_sync_lookahead = X264_SYNC_LOOKAHEAD_AUTO;
+#if X264_BUILD >= 128
+        p_sys->param.i_lookahead_threads = X264_THREADS_AUTO;
+#endif
+        p_sys->param.b_deterministic = 0;
+        msg_Dbg( p_enc, "throughput mode, %d frame threads",
+                 p_sys->param.i_threads );
+    }
+
     /* We don't want repeated headers, we repeat p_extra ourself if needed */
     p_sys->param.b_repeat_headers = 0;
 
@@ -1492,6 +1526,8 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
     /* init pic */
     x264_picture_init( &pic );
     if( likely(p_pict) ) {
+       pic.opaque = (void *)(uintptr_t)x26x_stats_Submit( &p_sys->stats );
+
        pic.i_pts = p_pict->date;
        pic.img.i_csp = p_sys->i_colorspace;
        pic.img.i_plane = p_pict->i_planes;
@@ -1510,6 +1546,8 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
 
     if( !i_nal ) return NULL;
 
+    x26x_stats_Output( VLC_OBJECT(p_enc), &p_sys->stats,
+                       (uintptr_t)pic.opaque );
 
     /* Get size of block we need */
     for( i = 0; i < i_nal; i++ )
@@ -1567,6 +1605,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->psz_stat_name );
     free( p_sys->p_sei );
 
+    x26x_stats_Log( VLC_OBJECT(p_enc), &p_sys->stats );
+
     if( p_sys->h )
     {
         msg_Dbg( p_enc, "framecount still in libx264 buffer: %d", x264_encoder_delayed_frames( p_sys->h ) );
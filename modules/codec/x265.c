@@ -36,6 +36,8 @@
 
 #include <x265.h>
 
+#include "x26x_stats.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -62,6 +64,8 @@ typedef struct
 #ifndef NDEBUG
     mtime_t         start;
 #endif
+
+    struct x26x_stats stats;
 } encoder_sys_t;
 
 static block_t *Encode(encoder_t *p_enc, picture_t *p_pict)
@@ -84,6 +88,8 @@ static block_t *Encode(encoder_t *p_enc, picture_t *p_pict)
             pic.planes[i] = p_pict->p[i].p_pixels;
             pic.stride[i] = p_pict->p[i].i_pitch;
         }
+
+        pic.userData = (void *)(uintptr_t)x26x_stats_Submit(&p_sys->stats);
     }
 
     x265_nal *nal;
@@ -94,6 +100,9 @@ static block_t *Encode(encoder_t *p_enc, picture_t *p_pict)
     if (!i_nal)
         return NULL;
 
+    x26x_stats_Output(VLC_OBJECT(p_enc), &p_sys->stats,
+                      (uintptr_t)pic.userData);
+
     int i_out = 0;
     for (uint32_t i = 0; i < i_nal; i++)
         i_out += nal[i].sizeBytes;
@@ -150,12 +159,17 @@ static int  Open (vlc_object_t *p_this)
     if (!p_sys)
         return VLC_ENOMEM;
 
+    x26x_stats_Init(&p_sys->stats);
+
     p_enc->fmt_in.i_codec = VLC_CODEC_I420;
 
     x265_param *param = &p_sys->param;
     x265_param_default(param);
 
-    param->frameNumThreads = vlc_GetCPUCount();
+    /* Frame threads, sized against the CPU cores unless transcode gives a
+     * thread count */
+    param->frameNumThreads = p_enc->i_threads > 0 ? p_enc->i_threads
+                                                  : (int)vlc_GetCPUCount();
     param->bEnableWavefront = 0; // buggy in x265, use frame threading for now
     param->maxCUSize = 16; /* use smaller macroblock */
 
@@ -241,6 +255,8 @@ static void Close(vlc_object_t *p_this)
     encoder_t     *p_enc = (encoder_t *)p_this;
     encoder_sys_t *p_sys = p_enc->p_sys;
 
+    x26x_stats_Log(VLC_OBJECT(p_enc), &p_sys->stats);
+
     x265_encoder_close(p_sys->h);
 
     free(p_sys);
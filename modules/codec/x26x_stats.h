@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * x26x_stats.h: throughput and latency statistics of the x264/x265 encoders
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_X26X_STATS_H_
+#define VLC_X26X_STATS_H_
+
+/* Must be larger than the maximum number of frames delayed by the encoder */
+#define X26X_SUBMIT_DATES 512
+
+/* Interval between the statistics logged while encoding */
+#define X26X_STATS_PERIOD (10 * CLOCK_FREQ)
+
+struct x26x_stats
+{
+    unsigned        frames_in;
+    unsigned        frames_out;
+    unsigned        queued_max;
+    mtime_t         first_submit;
+    mtime_t         last_output;
+    mtime_t         latency_sum;
+    mtime_t         last_log;
+    mtime_t         submit_dates[X26X_SUBMIT_DATES];
+};
+
+static inline void x26x_stats_Init(struct x26x_stats *stats)
+{
+    stats->frames_in = stats->frames_out = stats->queued_max = 0;
+    stats->first_submit = stats->last_output = 0;
+    stats->latency_sum = 0;
+    stats->last_log = 0;
+}
+
+/* Cumulative statistics, while encoding and at the end */
+static inline void x26x_stats_Log(vlc_object_t *obj, struct x26x_stats *stats)
+{
+    if (stats->frames_out == 0 || stats->last_output <= stats->first_submit)
+        return;
+
+    msg_Dbg(obj, "encoded %u frames at %.2f fps, average latency "
+            "%"PRId64" ms, up to %u frames queued", stats->frames_out,
+            (double)stats->frames_out * CLOCK_FREQ
+                / (stats->last_output - stats->first_submit),
+            stats->latency_sum / stats->frames_out / 1000,
+            stats->queued_max);
+    stats->last_log = stats->last_output;
+}
+
+/**
+ * Records the submission of a picture to the encoder.
+ *
+ * \return the frame number, to pass back to x26x_stats_Output() through the
+ * opaque data of the encoder picture
+ */
+static inline unsigned x26x_stats_Submit(struct x26x_stats *stats)
+{
+    mtime_t now = mdate();
+    if (stats->frames_in == 0)
+        stats->first_submit = stats->last_log = now;
+    stats->submit_dates[stats->frames_in % X26X_SUBMIT_DATES] = now;
+    return stats->frames_in++;
+}
+
+/* Measures how long the output picture spent in the encoder queue */
+static inline void x26x_stats_Output(vlc_object_t *obj,
+                                     struct x26x_stats *stats, unsigned frame)
+{
+    stats->last_output = mdate();
+    if (stats->frames_in - frame <= X26X_SUBMIT_DATES)
+        stats->latency_sum += stats->last_output
+                            - stats->submit_dates[frame % X26X_SUBMIT_DATES];
+    stats->frames_out++;
+
+    unsigned queued = stats->frames_in - stats->frames_out;
+    if (queued > stats->queued_max)
+        stats->queued_max = queued;
+
+    if (stats->last_output - stats->last_log >= X26X_STATS_PERIOD)
+        x26x_stats_Log(obj, stats);
+}
+
+#endif
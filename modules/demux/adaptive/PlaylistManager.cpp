@@ -120,6 +120,7 @@ bool PlaylistManager::setupPeriod()
             SegmentTracker *tracker = new (std::nothrow) SegmentTracker(logic, set);
             if(!tracker)
                 continue;
+            tracker->setPrefetchDepth(var_InheritInteger(p_demux, "adaptive-prefetch"));
 
             AbstractStream *st = streamFactory->create(p_demux, set->getStreamFormat(),
                                                        tracker, conManager);
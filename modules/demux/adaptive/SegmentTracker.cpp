@@ -28,6 +28,7 @@
 #include "playlist/BaseAdaptationSet.h"
 #include "playlist/Segment.h"
 #include "playlist/SegmentChunk.hpp"
+#include "playlist/SegmentTemplate.h"
 #include "logic/AbstractAdaptationLogic.h"
 
 using namespace adaptive;
@@ -60,12 +61,15 @@ SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, bool enabled)
     u.buffering.id = &id;
 }
 
-SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, mtime_t min, mtime_t current, mtime_t target)
+SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, mtime_t min, mtime_t current, mtime_t target,
+                                         size_t bytes, size_t maxbytes)
 {
     type = BUFFERING_LEVEL_CHANGE;
     u.buffering_level.minimum = min;
     u.buffering_level.current = current;
     u.buffering_level.target = target;
+    u.buffering_level.bytes = bytes;
+    u.buffering_level.maxbytes = maxbytes;
     u.buffering.id = &id;
 }
 
@@ -87,6 +91,7 @@ SegmentTracker::SegmentTracker(AbstractAdaptationLogic *logic_, BaseAdaptationSe
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNSUPPORTED;
+    prefetchdepth = 0;
 }
 
 SegmentTracker::~SegmentTracker()
@@ -94,6 +99,11 @@ SegmentTracker::~SegmentTracker()
     reset();
 }
 
+void SegmentTracker::setPrefetchDepth(unsigned depth)
+{
+    prefetchdepth = depth;
+}
+
 void SegmentTracker::setAdaptationLogic(AbstractAdaptationLogic *logic_)
 {
     logic = logic_;
@@ -127,6 +137,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    flushPrefetched();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -165,6 +176,7 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
 
     if(rep != curRepresentation)
     {
+        flushPrefetched();
         notify(SegmentTrackerEvent(curRepresentation, rep));
         prevRep = curRepresentation;
         curRepresentation = rep;
@@ -246,7 +258,9 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(next, rep, connManager);
+    SegmentChunk *chunk = getPrefetched(next, segment, rep);
+    if(!chunk)
+        chunk = segment->toChunk(next, rep, connManager);
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -273,11 +287,94 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     {
         curNumber = next;
         next++;
+        prefetch(connManager);
+    }
+
+    return chunk;
+}
+
+void SegmentTracker::prefetch(AbstractConnectionManager *connManager)
+{
+    BaseRepresentation *rep = curRepresentation;
+    if(!rep || initializing)
+        return;
+
+    /* Requests are queued on the downloader, so the link does not go idle
+     * between segments while the demuxer is still busy with the current one. */
+    uint64_t number = prefetched.empty() ? next : prefetched.back().number + 1;
+    while(prefetched.size() < prefetchdepth)
+    {
+        bool b_gap;
+        uint64_t found;
+        ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                number, &found, &b_gap);
+        if(!segment)
+            break;
+
+        /* Don't guess live templates, segment might not be available yet */
+        if(segment->isTemplate() && rep->getPlaylist()->isLive())
+        {
+            MediaSegmentTemplate *templ = dynamic_cast<MediaSegmentTemplate *>(segment);
+            if(!templ || !templ->segmentTimeline.Get())
+                break;
+        }
+
+        SegmentChunk *chunk = segment->toChunk(found, rep, connManager);
+        if(!chunk)
+            break;
+
+        PrefetchedChunk entry;
+        entry.number = found;
+        entry.segment = segment;
+        entry.rep = rep;
+        entry.chunk = chunk;
+        prefetched.push_back(entry);
+        number = found + 1;
+    }
+}
+
+SegmentChunk * SegmentTracker::getPrefetched(uint64_t number, ISegment *segment,
+                                             BaseRepresentation *rep)
+{
+    while(!prefetched.empty() && prefetched.front().number < number)
+    {
+        delete prefetched.front().chunk;
+        prefetched.pop_front();
+    }
+
+    if(prefetched.empty())
+        return NULL;
+
+    const PrefetchedChunk &entry = prefetched.front();
+    if(entry.number != number || entry.segment != segment || entry.rep != rep)
+    {
+        flushPrefetched();
+        return NULL;
     }
 
+    SegmentChunk *chunk = entry.chunk;
+    prefetched.pop_front();
     return chunk;
 }
 
+size_t SegmentTracker::getPrefetchedBytes() const
+{
+    size_t bytes = 0;
+    std::list<PrefetchedChunk>::const_iterator it;
+    for(it = prefetched.begin(); it != prefetched.end(); ++it)
+        bytes += (*it).chunk->getBufferedBytes();
+    return bytes;
+}
+
+void SegmentTracker::flushPrefetched()
+{
+    while(!prefetched.empty())
+    {
+        delete prefetched.front().chunk;
+        prefetched.pop_front();
+    }
+}
+
 bool SegmentTracker::setPositionByTime(mtime_t time, bool restarted, bool tryonly)
 {
     uint64_t segnumber;
@@ -303,6 +400,7 @@ void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
         index_sent = false;
         init_sent = false;
     }
+    flushPrefetched();
     curNumber = next = segnumber;
 }
 
@@ -337,9 +435,10 @@ void SegmentTracker::notifyBufferingState(bool enabled) const
     notify(SegmentTrackerEvent(adaptationSet->getID(), enabled));
 }
 
-void SegmentTracker::notifyBufferingLevel(mtime_t min, mtime_t current, mtime_t target) const
+void SegmentTracker::notifyBufferingLevel(mtime_t min, mtime_t current, mtime_t target,
+                                          size_t bytes, size_t maxbytes) const
 {
-    notify(SegmentTrackerEvent(adaptationSet->getID(), min, current, target));
+    notify(SegmentTrackerEvent(adaptationSet->getID(), min, current, target, bytes, maxbytes));
 }
 
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
@@ -43,6 +43,7 @@ namespace adaptive
     {
         class BaseAdaptationSet;
         class BaseRepresentation;
+        class ISegment;
         class SegmentChunk;
     }
 
@@ -57,7 +58,7 @@ namespace adaptive
             SegmentTrackerEvent(BaseRepresentation *, BaseRepresentation *);
             SegmentTrackerEvent(const StreamFormat *);
             SegmentTrackerEvent(const ID &, bool);
-            SegmentTrackerEvent(const ID &, mtime_t, mtime_t, mtime_t);
+            SegmentTrackerEvent(const ID &, mtime_t, mtime_t, mtime_t, size_t, size_t);
             SegmentTrackerEvent(const ID &, mtime_t);
             enum
             {
@@ -94,6 +95,8 @@ namespace adaptive
                    mtime_t minimum;
                    mtime_t current;
                    mtime_t target;
+                   size_t bytes; /* queued and prefetched data */
+                   size_t maxbytes; /* budget, 0 if unbounded */
                } buffering_level;
                struct
                {
@@ -124,13 +127,26 @@ namespace adaptive
             mtime_t getPlaybackTime() const; /* Current segment start time if selected */
             mtime_t getMinAheadTime() const;
             void notifyBufferingState(bool) const;
-            void notifyBufferingLevel(mtime_t, mtime_t, mtime_t) const;
+            void notifyBufferingLevel(mtime_t, mtime_t, mtime_t, size_t, size_t) const;
+            size_t getPrefetchedBytes() const;
             void registerListener(SegmentTrackerListenerInterface *);
             void updateSelected();
+            void setPrefetchDepth(unsigned);
 
         private:
+            class PrefetchedChunk
+            {
+                public:
+                    uint64_t number;
+                    ISegment *segment;
+                    BaseRepresentation *rep;
+                    SegmentChunk *chunk;
+            };
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            void prefetch(AbstractConnectionManager *);
+            SegmentChunk * getPrefetched(uint64_t, ISegment *, BaseRepresentation *);
+            void flushPrefetched();
             bool first;
             bool initializing;
             bool index_sent;
@@ -142,6 +158,8 @@ namespace adaptive
             BaseAdaptationSet *adaptationSet;
             BaseRepresentation *curRepresentation;
             std::list<SegmentTrackerListenerInterface *> listeners;
+            std::list<PrefetchedChunk> prefetched; /* next media chunks, already downloading */
+            unsigned prefetchdepth;
     };
 }
 
@@ -30,6 +30,7 @@
 #include "playlist/SegmentChunk.hpp"
 #include "plumbing/SourceStream.hpp"
 #include "plumbing/CommandsQueue.hpp"
+#include "mp4/FragmentedDemuxer.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_demux.h>
 
@@ -55,6 +56,11 @@ AbstractStream::AbstractStream(demux_t * demux_)
     demuxer = NULL;
     fakeesout = NULL;
     last_buffer_status = buffering_lessthanmin;
+    maxbufferbytes = 0;
+    b_backpressure = false;
+    int64_t i_maxbuffer = var_InheritInteger(p_realdemux, "adaptive-maxbuffersize");
+    if(i_maxbuffer > 0)
+        maxbufferbytes = (size_t) i_maxbuffer * 1024 * 1024;
     vlc_mutex_init(&lock);
 }
 
@@ -356,7 +362,9 @@ AbstractStream::buffering_status AbstractStream::doBufferize(mtime_t nz_deadline
     const int64_t i_total_buffering = i_min_buffering + i_extra_buffering;
 
     mtime_t i_demuxed = commandsqueue->getDemuxedAmount();
-    segmentTracker->notifyBufferingLevel(i_min_buffering, i_demuxed, i_total_buffering);
+    size_t i_queued = getQueuedBytes();
+    segmentTracker->notifyBufferingLevel(i_min_buffering, i_demuxed, i_total_buffering,
+                                         i_queued, maxbufferbytes);
     if(i_demuxed < i_total_buffering) /* not already demuxed */
     {
         if(!segmentTracker->segmentsListReady()) /* Live Streams */
@@ -394,11 +402,30 @@ AbstractStream::buffering_status AbstractStream::doBufferize(mtime_t nz_deadline
             return AbstractStream::buffering_end;
         }
         i_demuxed = commandsqueue->getDemuxedAmount();
-        segmentTracker->notifyBufferingLevel(i_min_buffering, i_demuxed, i_total_buffering);
+        i_queued = getQueuedBytes();
+        segmentTracker->notifyBufferingLevel(i_min_buffering, i_demuxed, i_total_buffering,
+                                             i_queued, maxbufferbytes);
+    }
+
+    /* Stop demuxing, and then downloading, once the queued and prefetched
+     * data reaches the memory budget. Never below min buffering or we would
+     * starve. */
+    bool b_overbudget = false;
+    if(maxbufferbytes)
+    {
+        b_overbudget = (i_queued >= maxbufferbytes && i_demuxed >= i_min_buffering);
+        if(b_overbudget != b_backpressure)
+        {
+            b_backpressure = b_overbudget;
+            msg_Dbg(p_realdemux, "%s back-pressure on %s stream %s, %zu/%zu KiB queued, %" PRId64 " ms",
+                    b_overbudget ? "enabling" : "releasing", format.str().c_str(),
+                    description.c_str(), i_queued / 1024, maxbufferbytes / 1024,
+                    i_demuxed / 1000);
+        }
     }
     vlc_mutex_unlock(&lock);
 
-    if(i_demuxed < i_total_buffering) /* need to read more */
+    if(i_demuxed < i_total_buffering && !b_overbudget) /* need to read more */
     {
         if(i_demuxed < i_min_buffering)
             return AbstractStream::buffering_lessthanmin; /* high prio */
@@ -407,6 +434,11 @@ AbstractStream::buffering_status AbstractStream::doBufferize(mtime_t nz_deadline
     return AbstractStream::buffering_full;
 }
 
+size_t AbstractStream::getQueuedBytes() const
+{
+    return commandsqueue->getQueuedBytes() + segmentTracker->getPrefetchedBytes();
+}
+
 AbstractStream::status AbstractStream::dequeue(mtime_t nz_deadline, mtime_t *pi_pcr)
 {
     vlc_mutex_locker locker(&lock);
@@ -592,7 +624,7 @@ AbstractDemuxer *AbstractStream::newDemux(demux_t *p_realdemux, const StreamForm
     switch((unsigned)format)
     {
         case StreamFormat::MP4:
-            ret = new Demuxer(p_realdemux, "mp4", out, source);
+            ret = new mp4::FragmentedDemuxer(p_realdemux, out, source);
             break;
 
         case StreamFormat::MPEG2TS:
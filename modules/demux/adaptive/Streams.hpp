@@ -135,7 +135,10 @@ namespace adaptive
 
     private:
         buffering_status doBufferize(mtime_t, unsigned, unsigned);
+        size_t getQueuedBytes() const;
         buffering_status last_buffer_status;
+        size_t maxbufferbytes; /* memory budget for demuxed and prefetched data, 0 for none */
+        bool b_backpressure;
         bool dead;
         bool disabled;
     };
@@ -76,6 +76,21 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_CACHE_SIZE_TEXT N_("Segments cache size in MiB")
+#define ADAPT_CACHE_SIZE_LONGTEXT N_("Keep downloaded segments on disk for later " \
+                                     "sessions, up to this size. 0 disables the cache.")
+
+#define ADAPT_CACHE_DIR_TEXT N_("Segments cache directory")
+
+#define ADAPT_PREFETCH_TEXT N_("Segments prefetch depth")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of upcoming segments requested ahead " \
+                                   "of the demuxer, to keep the link busy on high latency paths " \
+                                   "(0 disables it).")
+
+#define ADAPT_MAXBUFFER_TEXT N_("Maximum buffer size in MiB")
+#define ADAPT_MAXBUFFER_LONGTEXT N_("Stop fetching segments once the demuxed data " \
+                                    "of a stream uses this much memory. 0 for no limit.")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
@@ -122,6 +137,15 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_integer( "adaptive-cache-size", 0,
+                     ADAPT_CACHE_SIZE_TEXT, ADAPT_CACHE_SIZE_LONGTEXT, true )
+        add_directory( "adaptive-cache-dir", NULL,
+                       ADAPT_CACHE_DIR_TEXT, ADAPT_CACHE_DIR_TEXT )
+        add_integer( "adaptive-prefetch", 0,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true )
+            change_integer_range( 0, 8 )
+        add_integer( "adaptive-maxbuffersize", 0,
+                     ADAPT_MAXBUFFER_TEXT, ADAPT_MAXBUFFER_LONGTEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
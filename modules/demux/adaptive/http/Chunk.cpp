@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -64,6 +65,11 @@ std::string AbstractChunkSource::getContentType() const
     return std::string();
 }
 
+size_t AbstractChunkSource::getBufferedBytes() const
+{
+    return 0;
+}
+
 AbstractChunk::AbstractChunk(AbstractChunkSource *source_)
 {
     bytesRead = 0;
@@ -85,6 +91,11 @@ size_t AbstractChunk::getBytesRead() const
     return this->bytesRead;
 }
 
+size_t AbstractChunk::getBufferedBytes() const
+{
+    return source->getBufferedBytes();
+}
+
 uint64_t AbstractChunk::getStartByteInFile() const
 {
     if(!source || !source->getBytesRange().isValid())
@@ -131,10 +142,16 @@ HTTPChunkSource::HTTPChunkSource(const std::string& url, AbstractConnectionManag
     AbstractChunkSource(),
     connection   (NULL),
     connManager  (manager),
-    consumed     (0)
+    consumed     (0),
+    p_cached     (NULL),
+    p_store      (NULL),
+    pp_store_tail(&p_store),
+    stored       (0)
 {
     prepared = false;
     eof = false;
+    cacheable = false;
+    cachePersistent = false;
     sourceid = id;
     if(!init(url))
         eof = true;
@@ -144,6 +161,10 @@ HTTPChunkSource::~HTTPChunkSource()
 {
     if(connection)
         connection->setUsed(false);
+    if(p_cached)
+        block_Release(p_cached);
+    if(p_store)
+        block_ChainRelease(p_store);
 }
 
 bool HTTPChunkSource::init(const std::string &url)
@@ -185,6 +206,27 @@ block_t * HTTPChunkSource::read(size_t readsize)
     if(contentLength && readsize > contentLength - consumed)
         readsize = contentLength - consumed;
 
+    if(p_cached)
+    {
+        block_t *p_block;
+        if(readsize >= p_cached->i_buffer)
+        {
+            p_block = p_cached;
+            p_cached = NULL;
+            eof = true;
+        }
+        else if((p_block = block_Alloc(readsize)))
+        {
+            memcpy(p_block->p_buffer, p_cached->p_buffer, readsize);
+            p_cached->p_buffer += readsize;
+            p_cached->i_buffer -= readsize;
+        }
+        else eof = true;
+        if(p_block)
+            consumed += p_block->i_buffer;
+        return p_block;
+    }
+
     block_t *p_block = block_Alloc(readsize);
     if(!p_block)
     {
@@ -205,8 +247,12 @@ block_t * HTTPChunkSource::read(size_t readsize)
     {
         p_block->i_buffer = (size_t) ret;
         consumed += p_block->i_buffer;
-        if((size_t)ret < readsize)
+        cacheAppend(p_block);
+        if((size_t)ret < readsize || consumed == contentLength)
+        {
             eof = true;
+            cacheCommit();
+        }
         if(ret && time)
             connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
     }
@@ -216,9 +262,59 @@ block_t * HTTPChunkSource::read(size_t readsize)
 
 std::string HTTPChunkSource::getContentType() const
 {
+    if(!connection)
+        return cachedContentType;
     return connection->getContentType();
 }
 
+void HTTPChunkSource::enableCache(bool persistent)
+{
+    cacheable = !!connManager->getSegmentCache();
+    cachePersistent = persistent;
+}
+
+void HTTPChunkSource::cacheAppend(const block_t *p_block)
+{
+    if(!cacheable || !p_block->i_buffer)
+        return;
+
+    block_t *p_copy = NULL;
+    if(connManager->getSegmentCache()->canStore(stored + p_block->i_buffer))
+        p_copy = block_Alloc(p_block->i_buffer);
+    if(!p_copy)
+    {
+        /* won't fit, give up storing */
+        cacheable = false;
+        block_ChainRelease(p_store);
+        p_store = NULL;
+        pp_store_tail = &p_store;
+        stored = 0;
+        return;
+    }
+
+    memcpy(p_copy->p_buffer, p_block->p_buffer, p_block->i_buffer);
+    block_ChainLastAppend(&pp_store_tail, p_copy);
+    stored += p_copy->i_buffer;
+}
+
+void HTTPChunkSource::cacheCommit()
+{
+    if(!cacheable || !p_store)
+        return;
+
+    /* only store complete responses */
+    if(!contentLength || stored == contentLength)
+        connManager->getSegmentCache()->put(params.getUrl(), bytesRange,
+                                            connection->getContentType(),
+                                            connection->getCacheControl(),
+                                            cachePersistent, p_store);
+    block_ChainRelease(p_store);
+    p_store = NULL;
+    pp_store_tail = &p_store;
+    stored = 0;
+    cacheable = false;
+}
+
 bool HTTPChunkSource::prepare()
 {
     if(prepared)
@@ -227,6 +323,25 @@ bool HTTPChunkSource::prepare()
     if(!connManager)
         return false;
 
+    SegmentCache *cache = connManager->getSegmentCache();
+    if(cacheable && cache)
+    {
+        p_cached = cache->get(params.getUrl(), bytesRange, &cachedContentType);
+
+        unsigned hits, requests;
+        uint64_t bytes;
+        cache->getStats(&hits, &requests, &bytes);
+        connManager->updateCacheStats(hits, requests, bytes);
+
+        if(p_cached)
+        {
+            contentLength = p_cached->i_buffer;
+            cacheable = false;
+            prepared = true;
+            return true;
+        }
+    }
+
     ConnectionParams connparams = params; /* can be changed on 301 */
 
     unsigned int i_redirects = 0;
@@ -283,6 +398,7 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
+    waited = false;
     downloadstart = 0;
 }
 
@@ -315,6 +431,18 @@ bool HTTPChunkBufferedSource::isDone() const
     return done;
 }
 
+bool HTTPChunkBufferedSource::isWaited() const
+{
+    vlc_mutex_locker locker( &lock );
+    return waited;
+}
+
+size_t HTTPChunkBufferedSource::getBufferedBytes() const
+{
+    vlc_mutex_locker locker( &lock );
+    return buffered;
+}
+
 void HTTPChunkBufferedSource::hold()
 {
     vlc_mutex_locker locker( &lock );
@@ -340,6 +468,17 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         return;
     }
 
+    if(p_cached)
+    {
+        buffered += p_cached->i_buffer;
+        block_ChainLastAppend(&pp_tail, p_cached);
+        p_cached = NULL;
+        done = true;
+        vlc_cond_signal(&avail);
+        vlc_mutex_unlock(&lock);
+        return;
+    }
+
     if(readsize < HTTPChunkSource::CHUNK_SIZE)
         readsize = HTTPChunkSource::CHUNK_SIZE;
 
@@ -362,6 +501,12 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     } rate = {0,0};
 
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    if(ret > 0)
+    {
+        p_block->i_buffer = (size_t) ret;
+        cacheAppend(p_block);
+    }
+
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -374,7 +519,6 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     }
     else
     {
-        p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
@@ -387,6 +531,9 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         }
     }
 
+    if(ret >= 0 && (ret == 0 || (size_t) ret < readsize))
+        cacheCommit();
+
     if(rate.size && rate.time)
     {
         connManager->updateDownloadRate(sourceid, rate.size, rate.time);
@@ -417,8 +564,10 @@ block_t * HTTPChunkBufferedSource::readBlock()
 
     vlc_mutex_locker locker(&lock);
 
+    waited = true;
     while(!p_head && !done)
         vlc_cond_wait(&avail, &lock);
+    waited = false;
 
     if(!p_head && done)
     {
@@ -449,8 +598,10 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
 {
     vlc_mutex_locker locker(&lock);
 
+    waited = true;
     while(readsize > buffered && !done)
         vlc_cond_wait(&avail, &lock);
+    waited = false;
 
     block_t *p_block = NULL;
     if(!readsize || !buffered || !(p_block = block_Alloc(readsize)) )
@@ -50,6 +50,7 @@ namespace adaptive
                 virtual block_t *   readBlock       () = 0;
                 virtual block_t *   read            (size_t) = 0;
                 virtual bool        hasMoreData     () const = 0;
+                virtual size_t      getBufferedBytes() const;
                 void                setBytesRange   (const BytesRange &);
                 const BytesRange &  getBytesRange   () const;
                 virtual std::string getContentType  () const;
@@ -66,6 +67,7 @@ namespace adaptive
 
                 std::string         getContentType          ();
                 size_t              getBytesRead            () const;
+                size_t              getBufferedBytes        () const;
                 uint64_t            getStartByteInFile      () const;
                 bool                isEmpty                 () const;
 
@@ -93,21 +95,31 @@ namespace adaptive
                 virtual block_t *   read            (size_t); /* impl */
                 virtual bool        hasMoreData     () const; /* impl */
                 virtual std::string getContentType  () const; /* reimpl */
+                void                enableCache     (bool);
 
                 static const size_t CHUNK_SIZE = 32768;
 
             protected:
                 virtual bool        prepare();
+                void                cacheAppend(const block_t *);
+                void                cacheCommit();
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
                 size_t              consumed; /* read pointer */
                 bool                prepared;
                 bool                eof;
                 ID                  sourceid;
+                block_t            *p_cached; /* data from segment cache */
+                std::string         cachedContentType;
 
             private:
                 bool init(const std::string &);
                 ConnectionParams    params;
+                bool                cacheable;
+                bool                cachePersistent;
+                block_t            *p_store; /* copy of data for segment cache */
+                block_t           **pp_store_tail;
+                size_t              stored;
         };
 
         class HTTPChunkBufferedSource : public HTTPChunkSource
@@ -128,6 +140,8 @@ namespace adaptive
                 virtual bool       prepare(); /* reimpl */
                 void               bufferize(size_t);
                 bool               isDone() const;
+                bool               isWaited() const;
+                virtual size_t     getBufferedBytes() const; /* reimpl */
 
             private:
                 block_t            *p_head; /* read cache buffer */
@@ -139,6 +153,7 @@ namespace adaptive
                 mutable vlc_mutex_t lock;
                 vlc_cond_t          avail;
                 bool                held;
+                bool                waited; /* a reader is blocked on us */
         };
 
         class HTTPChunk : public AbstractChunk
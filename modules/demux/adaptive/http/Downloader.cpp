@@ -106,11 +106,23 @@ void Downloader::Run()
 
         if(!chunks.empty())
         {
+            /* Serve first any source a reader is blocked on, so
+             * prefetched segments never delay what is needed now */
             HTTPChunkBufferedSource *source = chunks.front();
+            std::list<HTTPChunkBufferedSource *>::const_iterator it;
+            for(it = chunks.begin(); it != chunks.end(); ++it)
+            {
+                if((*it)->isWaited())
+                {
+                    source = *it;
+                    break;
+                }
+            }
+
             DownloadSource(source);
             if(source->isDone())
             {
-                chunks.pop_front();
+                chunks.remove(source);
                 source->release();
             }
         }
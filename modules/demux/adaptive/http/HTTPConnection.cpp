@@ -65,6 +65,11 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+const std::string & AbstractConnection::getCacheControl() const
+{
+    return cacheControl;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Transport *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -130,6 +135,7 @@ void HTTPConnection::disconnect()
     chunkLength = 0;
     bytesRange = BytesRange();
     contentType = std::string();
+    cacheControl = std::string();
     transport->disconnect();
 }
 
@@ -139,6 +145,7 @@ int HTTPConnection::request(const std::string &path, const BytesRange &range)
     chunked = false;
     chunked_eof = false;
     chunkLength = 0;
+    cacheControl = std::string();
 
     /* Set new path for this query */
     params.setPath(path);
@@ -393,6 +400,10 @@ void HTTPConnection::onHeader(const std::string &key,
     {
         contentType = value;
     }
+    else if(Helper::icaseEquals(key, "Cache-Control"))
+    {
+        cacheControl = value;
+    }
     else if(Helper::icaseEquals(key, "Location"))
     {
         locationparams = ConnectionParams();
@@ -478,6 +489,7 @@ void StreamUrlConnection::reset()
     bytesRead = 0;
     contentLength = 0;
     contentType = std::string();
+    cacheControl = std::string();
     bytesRange = BytesRange();
 }
 
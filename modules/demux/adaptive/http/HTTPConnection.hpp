@@ -51,6 +51,7 @@ namespace adaptive
 
                 virtual size_t  getContentLength() const;
                 virtual const std::string & getContentType() const;
+                virtual const std::string & getCacheControl() const;
                 virtual void    setUsed( bool ) = 0;
 
             protected:
@@ -59,6 +60,7 @@ namespace adaptive
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
+                std::string        cacheControl;
                 BytesRange         bytesRange;
                 size_t             bytesRead;
         };
@@ -30,6 +30,7 @@
 #include "ConnectionParams.hpp"
 #include "Transport.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
@@ -40,11 +41,12 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = NULL;
+    segmentCache = NULL;
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
 {
-
+    delete segmentCache;
 }
 
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size, mtime_t time)
@@ -53,11 +55,22 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
         rateObserver->updateDownloadRate(sourceid, size, time);
 }
 
+void AbstractConnectionManager::updateCacheStats(unsigned hits, unsigned requests, uint64_t bytes)
+{
+    if(rateObserver)
+        rateObserver->updateCacheStats(hits, requests, bytes);
+}
+
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
 {
     rateObserver = obs;
 }
 
+SegmentCache * AbstractConnectionManager::getSegmentCache() const
+{
+    return segmentCache;
+}
+
 HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, ConnectionFactory *factory_)
     : AbstractConnectionManager( p_object_ )
 {
@@ -77,6 +90,7 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
         factory = new (std::nothrow) StreamUrlConnectionFactory();
     else
         factory = new (std::nothrow) ConnectionFactory( storage );
+    segmentCache = SegmentCache::create(p_object);
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
@@ -42,6 +42,7 @@ namespace adaptive
         class AuthStorage;
         class Downloader;
         class AbstractChunkSource;
+        class SegmentCache;
 
         class AbstractConnectionManager : public IDownloadRateObserver
         {
@@ -54,10 +55,13 @@ namespace adaptive
                 virtual void cancel(AbstractChunkSource *) = 0;
 
                 virtual void updateDownloadRate(const ID &, size_t, mtime_t); /* impl */
+                virtual void updateCacheStats(unsigned, unsigned, uint64_t); /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                SegmentCache * getSegmentCache() const;
 
             protected:
                 vlc_object_t                                       *p_object;
+                SegmentCache                                       *segmentCache;
 
             private:
                 IDownloadRateObserver                              *rateObserver;
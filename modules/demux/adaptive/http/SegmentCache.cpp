@@ -0,0 +1,392 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2018 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+#include "BytesRange.hpp"
+#include "../tools/Helper.h"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+
+#include <sstream>
+#include <list>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace adaptive::http;
+
+#define CACHE_MAGIC         "VSC1"
+#define CACHE_EXT_SEGMENT   ".seg"
+#define CACHE_EXT_INIT      ".init"
+#define CACHE_EXT_PARTIAL   ".part"
+
+struct cache_header_t
+{
+    char     magic[4];
+    uint32_t typelen; /* content type follows header */
+    int64_t  expires; /* wall clock, 0 for never */
+    uint64_t size;
+};
+
+SegmentCache::Entry::Entry()
+{
+    size = 0;
+    lastuse = 0;
+    persistent = false;
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj, const std::string &dir_, uint64_t maxsize_)
+{
+    p_obj = obj;
+    dir = dir_;
+    maxsize = maxsize_;
+    totalsize = 0;
+    hits = 0;
+    requests = 0;
+    hitbytes = 0;
+    vlc_mutex_init(&lock);
+    scan();
+    msg_Dbg(p_obj, "segment cache %s: %zu entries, %" PRIu64 "/%" PRIu64 " KiB used",
+            dir.c_str(), entries.size(), totalsize / 1024, maxsize / 1024);
+}
+
+SegmentCache::~SegmentCache()
+{
+    if(requests)
+        msg_Dbg(p_obj, "segment cache: %u/%u hits (%u%%), %" PRIu64 " KiB served",
+                hits, requests, hits * 100 / requests, hitbytes / 1024);
+    vlc_mutex_destroy(&lock);
+}
+
+SegmentCache * SegmentCache::create(vlc_object_t *obj)
+{
+    int64_t size = var_InheritInteger(obj, "adaptive-cache-size");
+    if(size <= 0)
+        return NULL;
+
+    std::string dir;
+    char *psz_dir = var_InheritString(obj, "adaptive-cache-dir");
+    if(psz_dir)
+    {
+        dir = std::string(psz_dir);
+        free(psz_dir);
+    }
+
+    if(dir.empty())
+    {
+        char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
+        if(!psz_cachedir)
+            return NULL;
+        vlc_mkdir(psz_cachedir, 0700);
+        dir = std::string(psz_cachedir) + DIR_SEP "adaptive";
+        free(psz_cachedir);
+    }
+
+    struct stat st;
+    if(vlc_mkdir(dir.c_str(), 0700) != 0 &&
+       (vlc_stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)))
+    {
+        msg_Warn(obj, "cannot use segment cache directory %s", dir.c_str());
+        return NULL;
+    }
+
+    return new (std::nothrow) SegmentCache(obj, dir, (uint64_t) size * 1024 * 1024);
+}
+
+std::string SegmentCache::getKey(const std::string &url, const BytesRange &range) const
+{
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url;
+    if(range.isValid())
+        ss << "@" << range.getStartByte() << "-" << range.getEndByte();
+    const std::string key = ss.str();
+
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, key.c_str(), key.length());
+    EndMD5(&md5);
+
+    std::string hash;
+    char *psz_hash = psz_md5_hash(&md5);
+    if(psz_hash)
+    {
+        hash = std::string(psz_hash);
+        free(psz_hash);
+    }
+    return hash;
+}
+
+std::string SegmentCache::getPath(const std::string &key, bool persistent) const
+{
+    return dir + DIR_SEP + key + (persistent ? CACHE_EXT_INIT : CACHE_EXT_SEGMENT);
+}
+
+void SegmentCache::scan()
+{
+    DIR *p_dir = vlc_opendir(dir.c_str());
+    if(!p_dir)
+        return;
+
+    const char *psz_name;
+    while((psz_name = vlc_readdir(p_dir)) != NULL)
+    {
+        const std::string name(psz_name);
+        const size_t dot = name.find_last_of('.');
+        if(dot == std::string::npos)
+            continue;
+
+        Entry entry;
+        const std::string ext = name.substr(dot);
+        if(ext == CACHE_EXT_INIT)
+            entry.persistent = true;
+        else if(ext != CACHE_EXT_SEGMENT)
+            continue;
+
+        struct stat st;
+        if(vlc_stat((dir + DIR_SEP + name).c_str(), &st) != 0 ||
+           (size_t) st.st_size < sizeof(cache_header_t))
+            continue;
+
+        entry.size = st.st_size;
+        entry.lastuse = st.st_mtime;
+        entries[name.substr(0, dot)] = entry;
+        totalsize += entry.size;
+    }
+
+    closedir(p_dir);
+}
+
+void SegmentCache::remove(const std::string &key)
+{
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if(it == entries.end())
+        return;
+    vlc_unlink(getPath(key, (*it).second.persistent).c_str());
+    totalsize -= (*it).second.size;
+    entries.erase(it);
+}
+
+void SegmentCache::evict(uint64_t needed)
+{
+    while(!entries.empty() && totalsize + needed > maxsize)
+    {
+        /* least recently used, keeping init segments as long as possible */
+        std::map<std::string, Entry>::const_iterator it, victim = entries.end();
+        for(it = entries.begin(); it != entries.end(); ++it)
+        {
+            if(victim == entries.end() ||
+               (*victim).second.persistent > (*it).second.persistent ||
+               ((*victim).second.persistent == (*it).second.persistent &&
+                (*victim).second.lastuse > (*it).second.lastuse))
+                victim = it;
+        }
+        remove((*victim).first);
+    }
+}
+
+bool SegmentCache::parseCacheControl(const std::string &value, int64_t *expires)
+{
+    *expires = 0;
+
+    std::list<std::string> directives = Helper::tokenize(value, ',');
+    std::list<std::string>::const_iterator it;
+    for(it = directives.begin(); it != directives.end(); ++it)
+    {
+        const size_t start = (*it).find_first_not_of(" \t");
+        if(start == std::string::npos)
+            continue;
+        const std::string directive = (*it).substr(start, (*it).find_last_not_of(" \t") + 1 - start);
+
+        if(Helper::icaseEquals(directive, "no-store") ||
+           Helper::icaseEquals(directive, "no-cache"))
+            return false;
+
+        if(directive.length() > 8 && Helper::icaseEquals(directive.substr(0, 8), "max-age="))
+        {
+            std::istringstream age(directive.substr(8));
+            age.imbue(std::locale("C"));
+            int64_t seconds = 0;
+            age >> seconds;
+            if(seconds <= 0)
+                return false;
+            *expires = time(NULL) + seconds;
+        }
+    }
+    return true;
+}
+
+bool SegmentCache::canStore(size_t size) const
+{
+    /* don't let a single entry flush most of the cache */
+    return size > 0 && size <= maxsize / 4;
+}
+
+block_t * SegmentCache::get(const std::string &url, const BytesRange &range,
+                            std::string *contenttype)
+{
+    const std::string key = getKey(url, range);
+    if(key.empty())
+        return NULL;
+
+    vlc_mutex_locker locker(&lock);
+
+    requests++;
+
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if(it == entries.end())
+    {
+        /* might have been stored by another session */
+        struct stat st;
+        for(int i = 0; i < 2; i++)
+        {
+            if(vlc_stat(getPath(key, !!i).c_str(), &st) == 0 &&
+               (size_t) st.st_size >= sizeof(cache_header_t))
+            {
+                Entry entry;
+                entry.size = st.st_size;
+                entry.persistent = !!i;
+                totalsize += entry.size;
+                it = entries.insert(std::make_pair(key, entry)).first;
+                break;
+            }
+        }
+        if(it == entries.end())
+            return NULL;
+    }
+
+    Entry &entry = (*it).second;
+    int fd = vlc_open(getPath(key, entry.persistent).c_str(), O_RDONLY);
+    if(fd == -1)
+    {
+        totalsize -= entry.size;
+        entries.erase(it);
+        return NULL;
+    }
+
+    block_t *p_block = NULL;
+    cache_header_t header;
+    if(read(fd, &header, sizeof(header)) == sizeof(header) &&
+       !memcmp(header.magic, CACHE_MAGIC, 4) &&
+       header.size + header.typelen + sizeof(header) == entry.size &&
+       (header.expires == 0 || header.expires > time(NULL)) &&
+       (p_block = block_Alloc(header.typelen + header.size)))
+    {
+        size_t total = 0;
+        header.size += header.typelen;
+        while(total < header.size)
+        {
+            ssize_t ret = read(fd, &p_block->p_buffer[total], header.size - total);
+            if(ret <= 0)
+                break;
+            total += ret;
+        }
+        if(total != header.size)
+        {
+            block_Release(p_block);
+            p_block = NULL;
+        }
+        else
+        {
+            *contenttype = std::string((const char *) p_block->p_buffer, header.typelen);
+            p_block->p_buffer += header.typelen;
+            p_block->i_buffer -= header.typelen;
+        }
+    }
+    close(fd);
+
+    if(!p_block)
+    {
+        /* expired or corrupted */
+        remove(key);
+        return NULL;
+    }
+
+    entry.lastuse = time(NULL);
+    hits++;
+    hitbytes += p_block->i_buffer;
+    return p_block;
+}
+
+bool SegmentCache::put(const std::string &url, const BytesRange &range,
+                       const std::string &contenttype, const std::string &cachecontrol,
+                       bool persistent, block_t *p_chain)
+{
+    size_t size;
+    block_ChainProperties(p_chain, NULL, &size, NULL);
+
+    cache_header_t header;
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.typelen = contenttype.length();
+    header.size = size;
+    if(!canStore(size) || !parseCacheControl(cachecontrol, &header.expires))
+        return false;
+
+    const std::string key = getKey(url, range);
+    if(key.empty())
+        return false;
+
+    vlc_mutex_locker locker(&lock);
+
+    remove(key);
+    evict(sizeof(header) + header.typelen + header.size);
+
+    const std::string path = getPath(key, persistent);
+    const std::string partial = path + CACHE_EXT_PARTIAL;
+    int fd = vlc_open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd == -1)
+        return false;
+
+    bool b_ok = vlc_write(fd, &header, sizeof(header)) == sizeof(header) &&
+                vlc_write(fd, contenttype.c_str(), header.typelen) == (ssize_t) header.typelen;
+    for(const block_t *p_block = p_chain; b_ok && p_block; p_block = p_block->p_next)
+        b_ok = vlc_write(fd, p_block->p_buffer, p_block->i_buffer) == (ssize_t) p_block->i_buffer;
+    close(fd);
+
+    if(!b_ok || vlc_rename(partial.c_str(), path.c_str()) != 0)
+    {
+        vlc_unlink(partial.c_str());
+        return false;
+    }
+
+    Entry entry;
+    entry.size = sizeof(header) + header.typelen + header.size;
+    entry.lastuse = time(NULL);
+    entry.persistent = persistent;
+    entries[key] = entry;
+    totalsize += entry.size;
+    return true;
+}
+
+void SegmentCache::getStats(unsigned *pi_hits, unsigned *pi_requests, uint64_t *pi_bytes) const
+{
+    vlc_mutex_locker locker(&lock);
+    *pi_hits = hits;
+    *pi_requests = requests;
+    *pi_bytes = hitbytes;
+}
@@ -0,0 +1,81 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2018 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include <vlc_common.h>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class BytesRange;
+
+        /* Size bounded on-disk store of downloaded segments, keyed by
+         * url and byte range. The directory can be shared by any number
+         * of sessions or processes, as entries are only published by
+         * renaming complete files. */
+        class SegmentCache
+        {
+            public:
+                SegmentCache(vlc_object_t *, const std::string &, uint64_t);
+                ~SegmentCache();
+
+                block_t * get(const std::string &, const BytesRange &, std::string *);
+                bool      put(const std::string &, const BytesRange &, const std::string &,
+                              const std::string &, bool, block_t *);
+                bool      canStore(size_t) const;
+                void      getStats(unsigned *, unsigned *, uint64_t *) const;
+
+                static SegmentCache * create(vlc_object_t *);
+
+            private:
+                class Entry
+                {
+                    public:
+                        Entry();
+                        uint64_t size;
+                        mtime_t  lastuse;
+                        bool     persistent;
+                };
+
+                std::string getKey(const std::string &, const BytesRange &) const;
+                std::string getPath(const std::string &, bool) const;
+                void        scan();
+                void        remove(const std::string &);
+                void        evict(uint64_t);
+                static bool parseCacheControl(const std::string &, int64_t *);
+
+                vlc_object_t *p_obj;
+                std::string dir;
+                uint64_t maxsize;
+                uint64_t totalsize;
+                std::map<std::string, Entry> entries;
+                unsigned hits;
+                unsigned requests;
+                uint64_t hitbytes;
+                mutable vlc_mutex_t lock;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -49,6 +49,7 @@ namespace adaptive
 
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *) = 0;
                 virtual void                updateDownloadRate     (const ID &, size_t, mtime_t);
+                virtual void                updateCacheStats       (unsigned, unsigned, uint64_t) {}
                 virtual void                trackerEvent           (const SegmentTrackerEvent &) {}
                 void                        setMaxDeviceResolution (int, int);
 
@@ -35,6 +35,8 @@ namespace adaptive
     {
         public:
             virtual void updateDownloadRate(const ID &, size_t, mtime_t) = 0;
+            /* segment cache hits, lookups and bytes served */
+            virtual void updateCacheStats(unsigned, unsigned, uint64_t) = 0;
             virtual ~IDownloadRateObserver(){}
     };
 }
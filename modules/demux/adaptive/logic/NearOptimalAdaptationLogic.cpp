@@ -47,6 +47,8 @@ NearOptimalContext::NearOptimalContext()
     : buffering_min( minimumBufferS )
     , buffering_level( 0 )
     , buffering_target( bufferTargetS )
+    , buffering_bytes( 0 )
+    , buffering_maxbytes( 0 )
     , last_download_rate( 0 )
 { }
 
@@ -54,6 +56,9 @@ NearOptimalAdaptationLogic::NearOptimalAdaptationLogic()
     : AbstractAdaptationLogic()
     , currentBps( 0 )
     , usedBps( 0 )
+    , cacheHits( 0 )
+    , cacheRequests( 0 )
+    , cacheBytes( 0 )
 {
     vlc_mutex_init(&lock);
 }
@@ -103,6 +108,9 @@ BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdapta
 
     const unsigned bps = getAvailableBw(currentBps, prevRep);
 
+    BwDebug( msg_Info(p_obj, "segment cache %u/%u hits, %" PRIu64 " KiB",
+                      cacheHits, cacheRequests, cacheBytes / 1024); );
+
     vlc_mutex_unlock(&lock);
 
     const float gammaP = 1.0 + (umax - umin) / ((float)ctxcopy.buffering_target / ctxcopy.buffering_min - 1.0);
@@ -137,8 +145,10 @@ BaseRepresentation *NearOptimalAdaptationLogic::getNextRepresentation(BaseAdapta
         }
     }
 
-    BwDebug( msg_Info(p_obj, "buffering level %.2f% rep %ld kBps %zu kBps",
-             (float) 100 * ctxcopy.buffering_level / ctxcopy.buffering_target, m->getBandwidth()/8000, bps / 8000); );
+    BwDebug( msg_Info(p_obj, "buffering level %.2f% %zu/%zu KiB rep %ld kBps %zu kBps",
+             (float) 100 * ctxcopy.buffering_level / ctxcopy.buffering_target,
+             ctxcopy.buffering_bytes / 1024, ctxcopy.buffering_maxbytes / 1024,
+             m->getBandwidth()/8000, bps / 8000); );
 
     return m;
 }
@@ -177,6 +187,15 @@ unsigned NearOptimalAdaptationLogic::getMaxCurrentBw() const
     return i_max_bitrate;
 }
 
+void NearOptimalAdaptationLogic::updateCacheStats(unsigned hits, unsigned requests, uint64_t bytes)
+{
+    vlc_mutex_lock(&lock);
+    cacheHits = hits;
+    cacheRequests = requests;
+    cacheBytes = bytes;
+    vlc_mutex_unlock(&lock);
+}
+
 void NearOptimalAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
 {
     vlc_mutex_lock(&lock);
@@ -237,6 +256,8 @@ void NearOptimalAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
             NearOptimalContext &ctx = streams[id];
             ctx.buffering_level = event.u.buffering_level.current;
             ctx.buffering_target = event.u.buffering_level.target;
+            ctx.buffering_bytes = event.u.buffering_level.bytes;
+            ctx.buffering_maxbytes = event.u.buffering_level.maxbytes;
             vlc_mutex_unlock(&lock);
         }
         break;
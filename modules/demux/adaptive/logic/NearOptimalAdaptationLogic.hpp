@@ -40,6 +40,8 @@ namespace adaptive
                 mtime_t buffering_min;
                 mtime_t buffering_level;
                 mtime_t buffering_target;
+                size_t buffering_bytes;
+                size_t buffering_maxbytes;
                 unsigned last_download_rate;
                 MovingAverage<unsigned> average;
         };
@@ -53,6 +55,7 @@ namespace adaptive
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
                 virtual void                updateDownloadRate     (const ID &, size_t, mtime_t); /* reimpl */
                 virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
+                virtual void                updateCacheStats       (unsigned, unsigned, uint64_t); /* reimpl */
 
             private:
                 BaseRepresentation *        getNextQualityIndex( BaseAdaptationSet *, RepresentationSelector &,
@@ -65,6 +68,9 @@ namespace adaptive
                 std::map<uint64_t, float>   utilities;
                 unsigned                    currentBps;
                 unsigned                    usedBps;
+                unsigned                    cacheHits;
+                unsigned                    cacheRequests;
+                uint64_t                    cacheBytes;
                 vlc_mutex_t                 lock;
         };
     }
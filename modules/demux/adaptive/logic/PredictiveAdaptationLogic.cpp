@@ -45,6 +45,8 @@ PredictiveStats::PredictiveStats()
     segments_count = 0;
     buffering_level = 0;
     buffering_target = 1;
+    buffering_bytes = 0;
+    buffering_maxbytes = 0;
     last_download_rate = 0;
     last_duration = 1;
 }
@@ -59,6 +61,9 @@ PredictiveAdaptationLogic::PredictiveAdaptationLogic(vlc_object_t *p_obj_)
 {
     p_obj = p_obj_;
     usedBps = 0;
+    cacheHits = 0;
+    cacheRequests = 0;
+    cacheBytes = 0;
     vlc_mutex_init(&lock);
 }
 
@@ -137,10 +142,14 @@ BaseRepresentation *PredictiveAdaptationLogic::getNextRepresentation(BaseAdaptat
         BwDebug( for(it=streams.begin(); it != streams.end(); ++it)
         {
             const PredictiveStats &s = (*it).second;
-            msg_Info(p_obj, "Stream %s buffering level %.2f%",
-                 (*it).first.str().c_str(), (double) s.buffering_level / s.buffering_target);
+            msg_Info(p_obj, "Stream %s buffering level %.2f% %zu/%zu KiB",
+                 (*it).first.str().c_str(), (double) s.buffering_level / s.buffering_target,
+                 s.buffering_bytes / 1024, s.buffering_maxbytes / 1024);
         } );
 
+        BwDebug( msg_Info(p_obj, "Segment cache %u/%u hits, %" PRIu64 " KiB",
+                          cacheHits, cacheRequests, cacheBytes / 1024); );
+
         BwDebug( if( rep != prevRep )
                     msg_Info(p_obj, "Stream %s new bandwidth usage %zu KiB/s",
                          adaptSet->getID().str().c_str(), rep->getBandwidth() / 8000); );
@@ -153,6 +162,15 @@ BaseRepresentation *PredictiveAdaptationLogic::getNextRepresentation(BaseAdaptat
     return rep;
 }
 
+void PredictiveAdaptationLogic::updateCacheStats(unsigned hits, unsigned requests, uint64_t bytes)
+{
+    vlc_mutex_lock(&lock);
+    cacheHits = hits;
+    cacheRequests = requests;
+    cacheBytes = bytes;
+    vlc_mutex_unlock(&lock);
+}
+
 void PredictiveAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
 {
     vlc_mutex_lock(&lock);
@@ -225,6 +243,8 @@ void PredictiveAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
             PredictiveStats &stats = streams[id];
             stats.buffering_level = event.u.buffering_level.current;
             stats.buffering_target = event.u.buffering_level.target;
+            stats.buffering_bytes = event.u.buffering_level.bytes;
+            stats.buffering_maxbytes = event.u.buffering_level.maxbytes;
             vlc_mutex_unlock(&lock);
         }
         break;
@@ -40,6 +40,8 @@ namespace adaptive
                 size_t  segments_count;
                 mtime_t buffering_level;
                 mtime_t buffering_target;
+                size_t  buffering_bytes;
+                size_t  buffering_maxbytes;
                 unsigned last_download_rate;
                 unsigned last_duration;
                 MovingAverage<unsigned> average;
@@ -54,11 +56,15 @@ namespace adaptive
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
                 virtual void                updateDownloadRate     (const ID &, size_t, mtime_t); /* reimpl */
                 virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
+                virtual void                updateCacheStats       (unsigned, unsigned, uint64_t); /* reimpl */
 
             private:
                 unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
                 std::map<adaptive::ID, PredictiveStats> streams;
                 unsigned                    usedBps;
+                unsigned                    cacheHits;
+                unsigned                    cacheRequests;
+                uint64_t                    cacheBytes;
                 vlc_object_t *              p_obj;
                 vlc_mutex_t                 lock;
         };
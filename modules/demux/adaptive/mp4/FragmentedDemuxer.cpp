@@ -0,0 +1,950 @@
+/*
+ * FragmentedDemuxer.cpp
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "FragmentedDemuxer.hpp"
+#include "../plumbing/SourceStream.hpp"
+
+#include <vlc_demux.h>
+#include <vlc_stream.h>
+
+#include <algorithm>
+#include <new>
+
+extern "C" {
+#include "../../mp4/color_config.h"
+}
+
+using namespace adaptive;
+using namespace adaptive::mp4;
+
+/* moov and moof are parsed from a copy, unlike the samples */
+#define MAX_BOX_SIZE (16 * 1024 * 1024)
+#define SKIP_SIZE    (64 * 1024)
+
+namespace
+{
+    /* The source stream as seen from a position, so that the mp4 demux
+     * taking over at an init segment sees it at the start of its stream.
+     * Past the first samples, it takes over at a fragment instead, with a
+     * copy of the init segment before it. */
+    class RebasedSourceStream : public AbstractSourceStream
+    {
+        public:
+            RebasedSourceStream(vlc_object_t *p_obj_, AbstractSourceStream *source_,
+                                uint64_t i_base_, block_t *p_prefix_)
+                : p_obj(p_obj_), source(source_), i_base(i_base_),
+                  p_prefix(p_prefix_), i_prefix_pos(0) {}
+            virtual ~RebasedSourceStream()
+            {
+                if(p_prefix)
+                    block_Release(p_prefix);
+            }
+
+            virtual stream_t *makeStream() /* impl */
+            {
+                stream_t *p_stream = vlc_stream_CommonNew(p_obj, delete_Callback);
+                if(p_stream)
+                {
+                    p_stream->pf_control = control_Callback;
+                    p_stream->pf_read = read_Callback;
+                    p_stream->pf_readdir = NULL;
+                    p_stream->pf_seek = seek_Callback;
+                    p_stream->p_sys = this;
+                }
+                return p_stream;
+            }
+
+            virtual void Reset() /* impl */
+            {
+                source->Reset();
+                i_base = 0;
+                if(p_prefix)
+                    block_Release(p_prefix);
+                p_prefix = NULL;
+                i_prefix_pos = 0;
+            }
+
+            virtual block_t *ReadBlock(size_t i_size) /* impl */
+            {
+                if(p_prefix && i_prefix_pos < p_prefix->i_buffer)
+                {
+                    i_size = std::min(i_size, p_prefix->i_buffer - i_prefix_pos);
+                    block_t *p_block = block_Alloc(i_size);
+                    if(p_block)
+                    {
+                        memcpy(p_block->p_buffer, &p_prefix->p_buffer[i_prefix_pos], i_size);
+                        i_prefix_pos += i_size;
+                    }
+                    return p_block;
+                }
+                return source->ReadBlock(i_size);
+            }
+
+            virtual int Seek(uint64_t i_pos) /* impl */
+            {
+                const size_t i_prefix = p_prefix ? p_prefix->i_buffer : 0;
+                if(i_pos < i_prefix)
+                {
+                    if(source->Seek(i_base) != VLC_SUCCESS)
+                        return VLC_EGENERIC;
+                    i_prefix_pos = i_pos;
+                    return VLC_SUCCESS;
+                }
+                i_prefix_pos = i_prefix;
+                return source->Seek(i_base + i_pos - i_prefix);
+            }
+
+        private:
+            static ssize_t read_Callback(stream_t *s, void *buf, size_t i_size)
+            {
+                RebasedSourceStream *me = reinterpret_cast<RebasedSourceStream *>(s->p_sys);
+                block_t *p_block = me->ReadBlock(i_size);
+                if(!p_block)
+                    return 0;
+                const size_t i_read = p_block->i_buffer;
+                if(buf)
+                    memcpy(buf, p_block->p_buffer, i_read);
+                block_Release(p_block);
+                return i_read;
+            }
+
+            static int seek_Callback(stream_t *s, uint64_t i_pos)
+            {
+                RebasedSourceStream *me = reinterpret_cast<RebasedSourceStream *>(s->p_sys);
+                return me->Seek(i_pos);
+            }
+
+            static int control_Callback(stream_t *, int i_query, va_list args)
+            {
+                switch(i_query)
+                {
+                    case STREAM_GET_SIZE:
+                        *(va_arg(args, uint64_t *)) = 0;
+                        return VLC_SUCCESS;
+
+                    case STREAM_CAN_SEEK:
+                    case STREAM_CAN_FASTSEEK:
+                    case STREAM_CAN_PAUSE:
+                    case STREAM_CAN_CONTROL_PACE:
+                        *va_arg(args, bool *) = false;
+                        return VLC_SUCCESS;
+
+                    case STREAM_GET_PTS_DELAY:
+                        *(va_arg(args, uint64_t *)) = DEFAULT_PTS_DELAY;
+                        return VLC_SUCCESS;
+
+                    default:
+                        break;
+                }
+                return VLC_EGENERIC;
+            }
+
+            static void delete_Callback(stream_t *)
+            {
+            }
+
+            vlc_object_t *p_obj;
+            AbstractSourceStream *source;
+            uint64_t i_base;
+            block_t *p_prefix;
+            size_t i_prefix_pos;
+    };
+}
+
+FragmentedDemuxer::Track::Track()
+{
+    i_id = 0;
+    i_timescale = 0;
+    es_format_Init(&fmt, UNKNOWN_ES, 0);
+    p_es = NULL;
+    i_default_duration = 0;
+    i_default_size = 0;
+    i_default_flags = 0;
+    i_time = 0;
+}
+
+FragmentedDemuxer::Track::~Track()
+{
+    es_format_Clean(&fmt);
+}
+
+FragmentedDemuxer::FragmentedDemuxer(demux_t *p_realdemux_, es_out_t *out,
+                                     AbstractSourceStream *source)
+    : AbstractDemuxer()
+{
+    p_realdemux = p_realdemux_;
+    p_es_out = out;
+    sourcestream = source;
+    fallbackdemuxer = NULL;
+    fallbacksource = NULL;
+    p_init = NULL;
+    i_pos = 0;
+    i_init_pos = 0;
+    b_sent = false;
+    b_eof = false;
+    /* As the mp4 demux, but a new init segment is handled in place */
+    b_startsfromzero = true;
+}
+
+FragmentedDemuxer::~FragmentedDemuxer()
+{
+    delete fallbackdemuxer;
+    delete fallbacksource;
+    if(p_init)
+        block_Release(p_init);
+    clearTracks();
+}
+
+void FragmentedDemuxer::clearTracks()
+{
+    for(std::vector<Track *>::iterator it = tracks.begin(); it != tracks.end(); ++it)
+    {
+        if((*it)->p_es)
+            es_out_Del(p_es_out, (*it)->p_es);
+        delete *it;
+    }
+    tracks.clear();
+    samples.clear();
+}
+
+bool FragmentedDemuxer::readBytes(uint8_t *p_buf, size_t i_size)
+{
+    block_t *p_block = sourcestream->ReadBlock(i_size);
+    if(!p_block)
+        return false;
+    const bool b_ok = p_block->i_buffer == i_size;
+    if(b_ok)
+        memcpy(p_buf, p_block->p_buffer, i_size);
+    i_pos += p_block->i_buffer;
+    block_Release(p_block);
+    return b_ok;
+}
+
+bool FragmentedDemuxer::skip(uint64_t i_size)
+{
+    while(i_size)
+    {
+        block_t *p_block = sourcestream->ReadBlock(std::min(i_size, (uint64_t) SKIP_SIZE));
+        if(!p_block)
+            return false;
+        i_pos += p_block->i_buffer;
+        i_size -= p_block->i_buffer;
+        block_Release(p_block);
+    }
+    return true;
+}
+
+/* A size of 0 means up to the end of the stream */
+bool FragmentedDemuxer::readBoxHeader(uint32_t *pi_type, uint64_t *pi_size,
+                                      unsigned *pi_header)
+{
+    if(!readBytes(header, 8))
+        return false;
+
+    uint64_t i_size = GetDWBE(header);
+    unsigned i_header = 8;
+    if(i_size == 1)
+    {
+        if(!readBytes(&header[8], 8))
+            return false;
+        i_size = GetQWBE(&header[8]);
+        i_header = 16;
+    }
+
+    const uint32_t i_type = VLC_FOURCC(header[4], header[5], header[6], header[7]);
+    if(i_type == ATOM_uuid)
+    {
+        if(!readBytes(&header[i_header], 16))
+            return false;
+        i_header += 16;
+    }
+
+    if(i_size != 0 && i_size < i_header)
+        return false;
+
+    *pi_type = i_type;
+    *pi_size = i_size;
+    *pi_header = i_header;
+    return true;
+}
+
+/* The raw box is returned too when pp_raw is set */
+MP4_Box_t * FragmentedDemuxer::readBox(uint64_t i_size, unsigned i_header, block_t **pp_raw)
+{
+    if(i_size == 0 || i_size > MAX_BOX_SIZE)
+        return NULL;
+
+    block_t *p_box = block_Alloc(i_size);
+    if(!p_box)
+        return NULL;
+
+    memcpy(p_box->p_buffer, header, i_header);
+    if(!readBytes(&p_box->p_buffer[i_header], i_size - i_header))
+    {
+        block_Release(p_box);
+        return NULL;
+    }
+
+    MP4_Box_t *p_root = NULL;
+    stream_t *stream = vlc_stream_MemoryNew(VLC_OBJECT(p_realdemux), p_box->p_buffer,
+                                            p_box->i_buffer, true);
+    if(stream)
+    {
+        p_root = MP4_BoxNew(ATOM_root);
+        if(p_root)
+        {
+            memset(p_root, 0, sizeof(*p_root));
+            p_root->i_type = ATOM_root;
+            p_root->i_size = i_size;
+            if(MP4_ReadBoxContainerChildren(stream, p_root, NULL) != 1)
+            {
+                MP4_BoxFree(p_root);
+                p_root = NULL;
+            }
+        }
+        vlc_stream_Delete(stream);
+    }
+    if(p_root && pp_raw)
+        *pp_raw = p_box;
+    else
+        block_Release(p_box);
+    return p_root;
+}
+
+/* Tells if all the children of a box are of the given types */
+static bool HasOnlyChildren(const MP4_Box_t *p_box, const uint32_t *pi_types, size_t i_types)
+{
+    for(const MP4_Box_t *p_child = p_box->p_first; p_child; p_child = p_child->p_next)
+        if(std::find(pi_types, pi_types + i_types, p_child->i_type) == pi_types + i_types)
+            return false;
+    return true;
+}
+
+/* Only the tracks, codecs and sample entry extensions the es_format is
+ * fully set up from, as the mp4 demux would, are handled in place. Anything
+ * else (edit lists, user data, encryption, field order, projection, channel
+ * layout, other codecs...) is left to the mp4 demux. */
+static const uint32_t rgi_trak_children[] = { ATOM_tkhd, ATOM_mdia };
+static const uint32_t rgi_vide_children[] = { ATOM_avcC, ATOM_hvcC, ATOM_pasp,
+                                              ATOM_colr, ATOM_btrt };
+static const uint32_t rgi_soun_children[] = { ATOM_esds, ATOM_btrt };
+
+static void SetupVideo(es_format_t *fmt, const MP4_Box_t *p_sample,
+                       const MP4_Box_data_tkhd_t *p_tkhd)
+{
+    const MP4_Box_data_sample_vide_t *p_vide = p_sample->data.p_sample_vide;
+    const int i_display_width = p_tkhd->i_width / (1 << 16);
+    const int i_display_height = p_tkhd->i_height / (1 << 16);
+
+    fmt->video.i_width = p_vide->i_width > 0 ? p_vide->i_width : i_display_width;
+    fmt->video.i_height = p_vide->i_height > 0 ? p_vide->i_height : i_display_height;
+    fmt->video.i_visible_width = fmt->video.i_width;
+    fmt->video.i_visible_height = fmt->video.i_height;
+    fmt->video.i_bits_per_pixel = p_vide->i_depth;
+
+    /* As SetupVideoES(): from the display size, then from pasp */
+    if(i_display_width > 0 && i_display_height > 0 && p_vide->i_width != i_display_width)
+    {
+        fmt->video.i_sar_num = i_display_width * fmt->video.i_height;
+        fmt->video.i_sar_den = i_display_height * fmt->video.i_width;
+    }
+    const MP4_Box_t *p_pasp = MP4_BoxGet(p_sample, "pasp");
+    if(p_pasp && BOXDATA(p_pasp) && BOXDATA(p_pasp)->i_horizontal_spacing > 0 &&
+       BOXDATA(p_pasp)->i_vertical_spacing > 0)
+    {
+        fmt->video.i_sar_num = BOXDATA(p_pasp)->i_horizontal_spacing;
+        fmt->video.i_sar_den = BOXDATA(p_pasp)->i_vertical_spacing;
+    }
+
+    const MP4_Box_t *p_colr = MP4_BoxGet(p_sample, "colr");
+    if(p_colr && BOXDATA(p_colr) &&
+       (BOXDATA(p_colr)->i_type == VLC_FOURCC('n','c','l','c') ||
+        BOXDATA(p_colr)->i_type == VLC_FOURCC('n','c','l','x')))
+    {
+        fmt->video.primaries = static_cast<video_color_primaries_t>(
+                iso_23001_8_cp_to_vlc_primaries(BOXDATA(p_colr)->nclc.i_primary_idx));
+        fmt->video.transfer = static_cast<video_transfer_func_t>(
+                iso_23001_8_tc_to_vlc_xfer(BOXDATA(p_colr)->nclc.i_transfer_function_idx));
+        fmt->video.space = static_cast<video_color_space_t>(
+                iso_23001_8_mc_to_vlc_coeffs(BOXDATA(p_colr)->nclc.i_matrix_idx));
+        fmt->video.b_color_range_full = BOXDATA(p_colr)->i_type == VLC_FOURCC('n','c','l','x') &&
+                                        (BOXDATA(p_colr)->nclc.i_full_range >> 7) != 0;
+    }
+
+    switch((int) p_tkhd->f_rotation)
+    {
+        case 90:
+            fmt->video.orientation = ORIENT_ROTATED_90;
+            break;
+        case 180:
+            fmt->video.orientation = ORIENT_ROTATED_180;
+            break;
+        case 270:
+            fmt->video.orientation = ORIENT_ROTATED_270;
+            break;
+    }
+    fmt->video.projection_mode = PROJECTION_MODE_RECTANGULAR;
+
+    const MP4_Box_t *p_btrt = MP4_BoxGet(p_sample, "btrt");
+    if(p_btrt && BOXDATA(p_btrt))
+        fmt->i_bitrate = BOXDATA(p_btrt)->i_avg_bitrate;
+}
+
+FragmentedDemuxer::Track * FragmentedDemuxer::setupTrack(const MP4_Box_t *p_moov,
+                                                         const MP4_Box_t *p_trak)
+{
+    const MP4_Box_t *p_tkhd = MP4_BoxGet(p_trak, "tkhd");
+    const MP4_Box_t *p_mdhd = MP4_BoxGet(p_trak, "mdia/mdhd");
+    const MP4_Box_t *p_hdlr = MP4_BoxGet(p_trak, "mdia/hdlr");
+    const MP4_Box_t *p_stsd = MP4_BoxGet(p_trak, "mdia/minf/stbl/stsd");
+    if(!p_tkhd || !BOXDATA(p_tkhd) || !p_mdhd || !BOXDATA(p_mdhd) ||
+       !BOXDATA(p_mdhd)->i_timescale || !p_hdlr || !BOXDATA(p_hdlr) ||
+       !p_stsd || !p_stsd->p_first || p_stsd->p_first != p_stsd->p_last ||
+       !HasOnlyChildren(p_trak, rgi_trak_children, ARRAY_SIZE(rgi_trak_children)))
+        return NULL;
+
+    Track *track = new (std::nothrow) Track();
+    if(!track)
+        return NULL;
+    track->i_id = BOXDATA(p_tkhd)->i_track_ID;
+    track->i_timescale = BOXDATA(p_mdhd)->i_timescale;
+
+    const MP4_Box_t *p_sample = p_stsd->p_first;
+    es_format_t *fmt = &track->fmt;
+    bool b_ok = false;
+    switch(p_sample->i_type)
+    {
+        case ATOM_avc1:
+        case ATOM_avc3:
+        {
+            const MP4_Box_t *p_avcC = MP4_BoxGet(p_sample, "avcC");
+            if(BOXDATA(p_hdlr)->i_handler_type != ATOM_vide || !p_sample->data.p_sample_vide ||
+               !p_avcC || !BOXDATA(p_avcC) || BOXDATA(p_avcC)->i_avcC <= 0 ||
+               !HasOnlyChildren(p_sample, rgi_vide_children, ARRAY_SIZE(rgi_vide_children)))
+                break;
+            es_format_Change(fmt, VIDEO_ES, VLC_CODEC_H264);
+            fmt->p_extra = malloc(BOXDATA(p_avcC)->i_avcC);
+            if(fmt->p_extra)
+            {
+                fmt->i_extra = BOXDATA(p_avcC)->i_avcC;
+                memcpy(fmt->p_extra, BOXDATA(p_avcC)->p_avcC, fmt->i_extra);
+                b_ok = true;
+            }
+            break;
+        }
+        case VLC_FOURCC('h','v','c','1'):
+        case VLC_FOURCC('h','e','v','1'):
+        {
+            const MP4_Box_t *p_hvcC = MP4_BoxGet(p_sample, "hvcC");
+            if(BOXDATA(p_hdlr)->i_handler_type != ATOM_vide || !p_sample->data.p_sample_vide ||
+               !p_hvcC || !p_hvcC->data.p_binary || !p_hvcC->data.p_binary->i_blob ||
+               !HasOnlyChildren(p_sample, rgi_vide_children, ARRAY_SIZE(rgi_vide_children)))
+                break;
+            es_format_Change(fmt, VIDEO_ES, VLC_CODEC_HEVC);
+            fmt->p_extra = malloc(p_hvcC->data.p_binary->i_blob);
+            if(fmt->p_extra)
+            {
+                fmt->i_extra = p_hvcC->data.p_binary->i_blob;
+                memcpy(fmt->p_extra, p_hvcC->data.p_binary->p_blob, fmt->i_extra);
+                b_ok = true;
+            }
+            break;
+        }
+        case ATOM_mp4a:
+        {
+            const MP4_Box_t *p_esds = MP4_BoxGet(p_sample, "esds");
+            if(BOXDATA(p_hdlr)->i_handler_type != ATOM_soun || !p_sample->data.p_sample_soun ||
+               !p_esds || !BOXDATA(p_esds) || !BOXDATA(p_esds)->es_descriptor.p_decConfigDescr ||
+               !HasOnlyChildren(p_sample, rgi_soun_children, ARRAY_SIZE(rgi_soun_children)))
+                break;
+            const MP4_descriptor_decoder_config_t *p_dec =
+                    BOXDATA(p_esds)->es_descriptor.p_decConfigDescr;
+            /* AAC only, see SetupESDS() */
+            if(p_dec->i_objectProfileIndication != 0x40 &&
+               (p_dec->i_objectProfileIndication < 0x66 || p_dec->i_objectProfileIndication > 0x68))
+                break;
+            /* ALS */
+            if(p_dec->i_decoder_specific_info_len >= 2 &&
+               p_dec->p_decoder_specific_info[0] == 0xF8 &&
+               (p_dec->p_decoder_specific_info[1] & 0xE0) == 0x80)
+                break;
+            es_format_Change(fmt, AUDIO_ES, VLC_CODEC_MP4A);
+            if(p_dec->i_decoder_specific_info_len > 0)
+            {
+                fmt->p_extra = malloc(p_dec->i_decoder_specific_info_len);
+                if(!fmt->p_extra)
+                    break;
+                fmt->i_extra = p_dec->i_decoder_specific_info_len;
+                memcpy(fmt->p_extra, p_dec->p_decoder_specific_info, fmt->i_extra);
+            }
+            fmt->i_bitrate = p_dec->i_avg_bitrate;
+            b_ok = true;
+            break;
+        }
+        default:
+            break;
+    }
+
+    if(!b_ok)
+    {
+        msg_Dbg(p_realdemux, "track %" PRIu32 " %4.4s not handled in place",
+                track->i_id, (const char *) &p_sample->i_type);
+        delete track;
+        return NULL;
+    }
+
+    fmt->i_id = track->i_id;
+    if(!(BOXDATA(p_tkhd)->i_flags & MP4_TRACK_ENABLED))
+        fmt->i_priority = ES_PRIORITY_NOT_DEFAULTABLE;
+
+    char language[4] = { '\0' };
+    memcpy(language, BOXDATA(p_mdhd)->rgs_language, 3);
+    if(*language && strcmp(language, "```") && strcmp(language, "und"))
+        fmt->psz_language = strdup(language);
+
+    if(fmt->i_cat == VIDEO_ES)
+    {
+        fmt->i_original_fourcc = p_sample->i_type;
+        SetupVideo(fmt, p_sample, BOXDATA(p_tkhd));
+    }
+    else
+    {
+        /* As SetupAudioES() and SetupESDS() */
+        const MP4_Box_data_sample_soun_t *p_soun = p_sample->data.p_sample_soun;
+        fmt->audio.i_channels = p_soun->i_channelcount;
+        fmt->audio.i_rate = p_soun->i_sampleratehi;
+        fmt->audio.i_bitspersample = p_soun->i_samplesize;
+        if(!fmt->i_bitrate)
+            fmt->i_bitrate = p_soun->i_channelcount * p_soun->i_sampleratehi *
+                             p_soun->i_samplesize;
+    }
+
+    for(const MP4_Box_t *p_trex = MP4_BoxGet(p_moov, "mvex/trex"); p_trex; p_trex = p_trex->p_next)
+    {
+        if(p_trex->i_type == ATOM_trex && BOXDATA(p_trex) &&
+           BOXDATA(p_trex)->i_track_ID == track->i_id)
+        {
+            track->i_default_duration = BOXDATA(p_trex)->i_default_sample_duration;
+            track->i_default_size = BOXDATA(p_trex)->i_default_sample_size;
+            track->i_default_flags = BOXDATA(p_trex)->i_default_sample_flags;
+            break;
+        }
+    }
+
+    return track;
+}
+
+/* Tracks of a new init segment keep the ES of the previous one when their
+ * format did not change, as on a switch between similar representations */
+bool FragmentedDemuxer::setupTracks(const MP4_Box_t *p_moov)
+{
+    if(!p_moov || !MP4_BoxGet(p_moov, "mvex"))
+        return false;
+
+    std::vector<Track *> newtracks;
+    bool b_ok = true;
+    for(const MP4_Box_t *p_trak = MP4_BoxGet(p_moov, "trak"); p_trak && b_ok; p_trak = p_trak->p_next)
+    {
+        if(p_trak->i_type != ATOM_trak)
+            continue;
+        Track *track = setupTrack(p_moov, p_trak);
+        if(track)
+            newtracks.push_back(track);
+        else
+            b_ok = false;
+    }
+
+    if(!b_ok || newtracks.empty())
+    {
+        for(std::vector<Track *>::iterator it = newtracks.begin(); it != newtracks.end(); ++it)
+            delete *it;
+        return false;
+    }
+
+    for(std::vector<Track *>::iterator it = newtracks.begin(); it != newtracks.end(); ++it)
+    {
+        Track *track = *it;
+        for(std::vector<Track *>::iterator old = tracks.begin(); old != tracks.end(); ++old)
+        {
+            if((*old)->p_es && (*old)->i_id == track->i_id &&
+               es_format_IsSimilar(&(*old)->fmt, &track->fmt) &&
+               (*old)->fmt.i_extra == track->fmt.i_extra &&
+               !memcmp((*old)->fmt.p_extra, track->fmt.p_extra, track->fmt.i_extra))
+            {
+                track->p_es = (*old)->p_es;
+                track->i_time = (*old)->i_time;
+                (*old)->p_es = NULL;
+                break;
+            }
+        }
+    }
+
+    clearTracks();
+    tracks = newtracks;
+
+    for(std::vector<Track *>::iterator it = tracks.begin(); it != tracks.end(); ++it)
+    {
+        if(!(*it)->p_es)
+            (*it)->p_es = es_out_Add(p_es_out, &(*it)->fmt);
+    }
+    return true;
+}
+
+bool FragmentedDemuxer::sampleBefore(const Sample &a, const Sample &b)
+{
+    return a.i_pos < b.i_pos;
+}
+
+static mtime_t Rescale(uint64_t i_value, uint32_t i_timescale)
+{
+    return (i_value / i_timescale) * CLOCK_FREQ +
+           (i_value % i_timescale) * CLOCK_FREQ / i_timescale;
+}
+
+bool FragmentedDemuxer::readFragment(const MP4_Box_t *p_moof, uint64_t i_moof_pos)
+{
+    samples.clear();
+    if(!p_moof)
+        return false;
+
+    /* Without explicit base, the data of a traf follows the previous one */
+    uint64_t i_traf_pos = i_moof_pos;
+    for(const MP4_Box_t *p_traf = MP4_BoxGet(p_moof, "traf"); p_traf; p_traf = p_traf->p_next)
+    {
+        if(p_traf->i_type != ATOM_traf)
+            continue;
+
+        const MP4_Box_t *p_tfhd = MP4_BoxGet(p_traf, "tfhd");
+        if(!p_tfhd || !BOXDATA(p_tfhd))
+            return false;
+        const MP4_Box_data_tfhd_t *tfhd = BOXDATA(p_tfhd);
+
+        /* Offsets from the start of the file are not known to us, as the
+         * segments may be ranges of it */
+        if(tfhd->i_flags & MP4_TFHD_BASE_DATA_OFFSET)
+            return false;
+
+        Track *track = NULL;
+        for(std::vector<Track *>::iterator it = tracks.begin(); it != tracks.end(); ++it)
+            if((*it)->i_id == tfhd->i_track_ID)
+                track = *it;
+        if(!track)
+            continue;
+
+        const MP4_Box_t *p_tfdt = MP4_BoxGet(p_traf, "tfdt");
+        if(p_tfdt && BOXDATA(p_tfdt))
+        {
+            track->i_time = BOXDATA(p_tfdt)->i_base_media_decode_time;
+        }
+        else if(tracks.size() == 1) /* Smooth */
+        {
+            for(const MP4_Box_t *p_uuid = MP4_BoxGet(p_traf, "uuid"); p_uuid; p_uuid = p_uuid->p_next)
+            {
+                if(p_uuid->i_type == ATOM_uuid &&
+                   !CmpUUID(&p_uuid->i_uuid, &TfxdBoxUUID) && p_uuid->data.p_tfxd)
+                {
+                    track->i_time = p_uuid->data.p_tfxd->i_fragment_abs_time;
+                    break;
+                }
+            }
+        }
+
+        const uint64_t i_base = (tfhd->i_flags & MP4_TFHD_DEFAULT_BASE_IS_MOOF) ? i_moof_pos : i_traf_pos;
+        uint64_t i_data = i_base;
+        for(const MP4_Box_t *p_trun = MP4_BoxGet(p_traf, "trun"); p_trun; p_trun = p_trun->p_next)
+        {
+            if(p_trun->i_type != ATOM_trun || !BOXDATA(p_trun))
+                continue;
+            const MP4_Box_data_trun_t *trun = BOXDATA(p_trun);
+
+            if(trun->i_flags & MP4_TRUN_DATA_OFFSET)
+            {
+                if(trun->i_data_offset < 0 && (uint64_t) -(int64_t)trun->i_data_offset > i_base)
+                    return false;
+                i_data = i_base + trun->i_data_offset;
+            }
+
+            for(uint32_t i = 0; i < trun->i_sample_count; i++)
+            {
+                const MP4_descriptor_trun_sample_t *p_entry = &trun->p_samples[i];
+                Sample sample;
+
+                uint32_t i_duration = track->i_default_duration;
+                if(trun->i_flags & MP4_TRUN_SAMPLE_DURATION)
+                    i_duration = p_entry->i_duration;
+                else if(tfhd->i_flags & MP4_TFHD_DFLT_SAMPLE_DURATION)
+                    i_duration = tfhd->i_default_sample_duration;
+
+                sample.i_size = track->i_default_size;
+                if(trun->i_flags & MP4_TRUN_SAMPLE_SIZE)
+                    sample.i_size = p_entry->i_size;
+                else if(tfhd->i_flags & MP4_TFHD_DFLT_SAMPLE_SIZE)
+                    sample.i_size = tfhd->i_default_sample_size;
+
+                int64_t i_offset = 0;
+                if(trun->i_flags & MP4_TRUN_SAMPLE_TIME_OFFSET)
+                    i_offset = trun->i_version ? p_entry->i_composition_time_offset.v1
+                                               : p_entry->i_composition_time_offset.v0;
+
+                sample.i_pos = i_data;
+                sample.track = track;
+                sample.i_dts = VLC_TS_0 + Rescale(track->i_time, track->i_timescale);
+                sample.i_pts = sample.i_dts;
+                if(i_offset > 0)
+                    sample.i_pts += Rescale(i_offset, track->i_timescale);
+                else
+                    sample.i_pts -= Rescale(-i_offset, track->i_timescale);
+                sample.i_length = Rescale(i_duration, track->i_timescale);
+                samples.push_back(sample);
+
+                i_data += sample.i_size;
+                track->i_time += i_duration;
+            }
+        }
+        i_traf_pos = i_data;
+    }
+
+    /* Sent in the order of the data. The PCR must not get past any of the
+     * samples left to send, whatever their track. */
+    std::stable_sort(samples.begin(), samples.end(), sampleBefore);
+    mtime_t i_pcr = INT64_MAX;
+    for(std::vector<Sample>::reverse_iterator it = samples.rbegin(); it != samples.rend(); ++it)
+    {
+        i_pcr = std::min(i_pcr, (*it).i_dts);
+        (*it).i_pcr = i_pcr;
+    }
+    return true;
+}
+
+int FragmentedDemuxer::sendSamples(uint64_t i_end)
+{
+    mtime_t i_pcr = VLC_TS_INVALID;
+    for(std::vector<Sample>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+    {
+        const Sample &sample = *it;
+        if(sample.i_pos < i_pos || sample.i_pos + sample.i_size > i_end)
+        {
+            msg_Warn(p_realdemux, "sample of track %" PRIu32 " out of mdat, dropped",
+                     sample.track->i_id);
+            continue;
+        }
+        if(!skip(sample.i_pos - i_pos))
+            return VLC_DEMUXER_EOF;
+
+        block_t *p_block = sourcestream->ReadBlock(sample.i_size);
+        if(!p_block)
+            return VLC_DEMUXER_EOF;
+        i_pos += p_block->i_buffer;
+        if(p_block->i_buffer < sample.i_size)
+        {
+            block_Release(p_block);
+            return VLC_DEMUXER_EOF;
+        }
+
+        p_block->i_dts = sample.i_dts;
+        p_block->i_pts = sample.i_pts;
+        p_block->i_length = sample.i_length;
+        if(sample.i_pcr != i_pcr)
+        {
+            i_pcr = sample.i_pcr;
+            es_out_Control(p_es_out, ES_OUT_SET_GROUP_PCR, 0, i_pcr);
+        }
+        es_out_Send(p_es_out, sample.track->p_es, p_block);
+        b_sent = true;
+    }
+    samples.clear();
+    return VLC_DEMUXER_SUCCESS;
+}
+
+/* Before any sample of the current init segment was sent, the mp4 demux
+ * takes over at the init segment. Past that, the samples must not be sent
+ * again, and their bytes may have been modified in place: it takes over at
+ * the fragment, after a copy of the init segment. */
+bool FragmentedDemuxer::fallback(uint64_t i_at)
+{
+    block_t *p_prefix = NULL;
+    if(b_sent && (!p_init || !(p_prefix = block_Duplicate(p_init))))
+    {
+        msg_Err(p_realdemux, "can not demux this fragmented mp4 stream");
+        return false;
+    }
+
+    if(sourcestream->Seek(i_at) != VLC_SUCCESS)
+    {
+        if(p_prefix)
+            block_Release(p_prefix);
+        msg_Err(p_realdemux, "can not demux this fragmented mp4 stream");
+        return false;
+    }
+
+    msg_Dbg(p_realdemux, "using the mp4 demux for this stream");
+    clearTracks();
+    i_pos = i_at;
+    b_candetectswitches = false;
+    fallbacksource = new (std::nothrow) RebasedSourceStream(VLC_OBJECT(p_realdemux),
+                                                            sourcestream, i_at, p_prefix);
+    if(!fallbacksource)
+    {
+        if(p_prefix)
+            block_Release(p_prefix);
+        return false;
+    }
+    fallbackdemuxer = new (std::nothrow) Demuxer(p_realdemux, "mp4", p_es_out, fallbacksource);
+    if(fallbackdemuxer && !fallbackdemuxer->create())
+    {
+        delete fallbackdemuxer;
+        fallbackdemuxer = NULL;
+    }
+    return fallbackdemuxer != NULL;
+}
+
+/* Keeps the init segment the tracks were set up from, for fallback() */
+bool FragmentedDemuxer::readInit(uint64_t i_size, unsigned i_header)
+{
+    block_t *p_raw = NULL;
+    MP4_Box_t *p_root = readBox(i_size, i_header, &p_raw);
+    const bool b_ok = p_root && setupTracks(MP4_BoxGet(p_root, "moov"));
+    MP4_BoxFree(p_root);
+    if(b_ok)
+    {
+        if(p_init)
+            block_Release(p_init);
+        p_init = p_raw;
+    }
+    else if(p_raw)
+        block_Release(p_raw);
+    return b_ok;
+}
+
+bool FragmentedDemuxer::create()
+{
+    i_pos = 0;
+    i_init_pos = 0;
+    b_sent = false;
+    b_eof = false;
+    b_candetectswitches = true;
+
+    /* Everything up to the init segment */
+    for(;;)
+    {
+        uint32_t i_type;
+        uint64_t i_size;
+        unsigned i_header;
+        if(!readBoxHeader(&i_type, &i_size, &i_header))
+            return false;
+
+        switch(i_type)
+        {
+            case ATOM_ftyp:
+            case ATOM_styp:
+            case ATOM_free:
+            case ATOM_skip:
+            case ATOM_sidx:
+                if(i_size == 0 || !skip(i_size - i_header))
+                    return false;
+                break;
+
+            case ATOM_moov:
+                return readInit(i_size, i_header) || fallback(0);
+
+            default:
+                return fallback(0);
+        }
+    }
+}
+
+void FragmentedDemuxer::destroy()
+{
+    delete fallbackdemuxer;
+    fallbackdemuxer = NULL;
+    delete fallbacksource;
+    fallbacksource = NULL;
+    if(p_init)
+        block_Release(p_init);
+    p_init = NULL;
+    clearTracks();
+    sourcestream->Reset();
+}
+
+void FragmentedDemuxer::drain()
+{
+    /* Nothing is buffered here, each mdat is sent at once */
+    if(fallbackdemuxer)
+        fallbackdemuxer->drain();
+}
+
+int FragmentedDemuxer::demux(mtime_t i_deadline)
+{
+    if(fallbackdemuxer)
+        return fallbackdemuxer->demux(i_deadline);
+    if(b_eof)
+        return VLC_DEMUXER_EOF;
+
+    const uint64_t i_box_pos = i_pos;
+    uint32_t i_type;
+    uint64_t i_size;
+    unsigned i_header;
+    if(!readBoxHeader(&i_type, &i_size, &i_header))
+    {
+        b_eof = true;
+        return VLC_DEMUXER_EOF;
+    }
+
+    int i_ret = VLC_DEMUXER_SUCCESS;
+    switch(i_type)
+    {
+        case ATOM_moov: /* switch */
+            b_sent = false;
+            if(readInit(i_size, i_header))
+                i_init_pos = i_box_pos;
+            else if(!fallback(i_box_pos))
+                i_ret = VLC_DEMUXER_EGENERIC;
+            break;
+
+        case ATOM_moof:
+        {
+            MP4_Box_t *p_root = readBox(i_size, i_header);
+            const bool b_ok = p_root && readFragment(MP4_BoxGet(p_root, "moof"), i_box_pos);
+            MP4_BoxFree(p_root);
+            if(!b_ok && !fallback(b_sent ? i_box_pos : i_init_pos))
+                i_ret = VLC_DEMUXER_EGENERIC;
+            break;
+        }
+
+        case ATOM_mdat:
+            i_ret = sendSamples(i_size ? i_box_pos + i_size : UINT64_MAX);
+            if(i_ret == VLC_DEMUXER_SUCCESS && i_size)
+                i_ret = skip(i_box_pos + i_size - i_pos) ? VLC_DEMUXER_SUCCESS
+                                                         : VLC_DEMUXER_EOF;
+            break;
+
+        default:
+            if(i_size == 0 || !skip(i_size - i_header))
+                i_ret = VLC_DEMUXER_EOF;
+            break;
+    }
+
+    if(i_ret != VLC_DEMUXER_SUCCESS)
+        b_eof = true;
+    return i_ret;
+}
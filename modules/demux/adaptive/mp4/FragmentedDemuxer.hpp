@@ -0,0 +1,110 @@
+/*
+ * FragmentedDemuxer.hpp
+ *****************************************************************************
+ * Copyright (C) 2018 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef FRAGMENTEDDEMUXER_HPP
+#define FRAGMENTEDDEMUXER_HPP
+
+#include "../plumbing/Demuxer.hpp"
+
+#include <vlc_es.h>
+#include <vector>
+
+extern "C" {
+#include "../../demux/mp4/libmp4.h"
+}
+
+namespace adaptive
+{
+    namespace mp4
+    {
+        /* Demuxes fragmented mp4 (moov, then moof/mdat pairs) in place over
+         * the downloaded blocks: samples are sent as views of those blocks
+         * when they do not span two of them. The mp4 demux module remains
+         * the default: only H.264, HEVC and AAC tracks with no more than
+         * the sample entry extensions carried into their es_format are
+         * handled here. Other streams, and fragments that can not be
+         * handled (absolute data offsets...), go through the mp4 demux. */
+        class FragmentedDemuxer : public AbstractDemuxer
+        {
+            public:
+                FragmentedDemuxer(demux_t *, es_out_t *, AbstractSourceStream *);
+                virtual ~FragmentedDemuxer();
+                virtual int demux(mtime_t); /* impl */
+                virtual void drain(); /* impl */
+                virtual bool create(); /* impl */
+                virtual void destroy(); /* impl */
+
+            private:
+                class Track
+                {
+                    public:
+                        Track();
+                        ~Track();
+                        uint32_t i_id;
+                        uint32_t i_timescale;
+                        es_format_t fmt;
+                        es_out_id_t *p_es;
+                        uint32_t i_default_duration;
+                        uint32_t i_default_size;
+                        uint32_t i_default_flags;
+                        uint64_t i_time; /* next decoding time, in timescale */
+                };
+
+                struct Sample
+                {
+                    uint64_t i_pos;
+                    uint32_t i_size;
+                    Track *track;
+                    mtime_t i_dts;
+                    mtime_t i_pts;
+                    mtime_t i_length;
+                    mtime_t i_pcr; /* lowest dts from this sample on */
+                };
+
+                static bool sampleBefore(const Sample &, const Sample &);
+                bool readBytes(uint8_t *, size_t);
+                bool skip(uint64_t);
+                bool readBoxHeader(uint32_t *, uint64_t *, unsigned *);
+                MP4_Box_t * readBox(uint64_t, unsigned, block_t ** = NULL);
+                bool readInit(uint64_t, unsigned);
+                Track * setupTrack(const MP4_Box_t *, const MP4_Box_t *);
+                bool setupTracks(const MP4_Box_t *);
+                bool readFragment(const MP4_Box_t *, uint64_t);
+                int  sendSamples(uint64_t);
+                bool fallback(uint64_t);
+                void clearTracks();
+
+                demux_t *p_realdemux;
+                es_out_t *p_es_out;
+                AbstractSourceStream *sourcestream;
+                Demuxer *fallbackdemuxer;
+                AbstractSourceStream *fallbacksource;
+                block_t *p_init; /* last moov */
+                std::vector<Track *> tracks;
+                std::vector<Sample> samples;
+                uint8_t header[32];
+                uint64_t i_pos; /* since the source stream reset */
+                uint64_t i_init_pos; /* of the last moov */
+                bool b_sent; /* samples were sent since the last moov */
+                bool b_eof;
+        };
+    }
+}
+
+#endif // FRAGMENTEDDEMUXER_HPP
@@ -76,6 +76,7 @@ SegmentChunk* ISegment::toChunk(size_t index, BaseRepresentation *rep, AbstractC
     {
         if(startByte != endByte)
             source->setBytesRange(BytesRange(startByte, endByte));
+        source->enableCache(classId == InitSegment::CLASSID_INITSEGMENT);
 
         SegmentChunk *chunk = new (std::nothrow) SegmentChunk(this, source, rep);
         if( chunk )
@@ -43,111 +43,85 @@ SegmentTimeline::SegmentTimeline(uint64_t scale)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
 void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
-    {
-        if(!elements.empty() && !t)
-        {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
-        }
-        elements.push_back(element);
-    }
+    Element element(number, d, r, t);
+    if(!elements.empty() && !t)
+        element.t = elements.back().endTime();
+    elements.push_back(element);
 }
 
-mtime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
+stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 {
-    stime_t totalscaledtime = 0;
+    if(elements.empty() || number < minElementNumber() || number > maxElementNumber())
+        return 0;
 
-    std::list<Element *>::const_reverse_iterator it;
-    for(it = elements.rbegin(); it != elements.rend(); ++it)
-    {
-        const Element *el = *it;
+    std::deque<Element>::const_iterator it =
+            std::lower_bound(elements.begin(), elements.end(), number,
+                             Element::compareEndNumber);
 
-        if(number < el->number)
-        {
-            totalscaledtime += (el->d * (el->r + 1));
-            break;
-        }
-        else if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (el->number + el->r - number);
-        }
-        else break;
-    }
+    /* everything after the end of segment number */
+    stime_t segmentend = it->t;
+    if(number >= it->number)
+        segmentend += it->d * (number - it->number + 1);
 
-    return totalscaledtime;
+    return elements.back().endTime() - segmentend;
 }
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    uint64_t prevnumber = 0;
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(it == elements.begin())
-        {
-            scaled -= el->t;
-            prevnumber = el->number;
-        }
-
-        for(uint64_t repeat = 1 + el->r; repeat; repeat--)
-        {
-            if(el->d >= scaled)
-                return prevnumber;
+    if(elements.empty())
+        return 0;
 
-            scaled -= el->d;
-            prevnumber++;
-        }
+    /* first element starting at or after time, boundaries belonging
+       to the previous segment */
+    std::deque<Element>::const_iterator it =
+            std::lower_bound(elements.begin(), elements.end(), scaled,
+                             Element::compareStartTime);
+    if(it == elements.begin())
+        return it->number;
 
+    const Element &el = *(--it);
+    if(scaled > el.endTime())
+    {
         /* might have been discontinuity */
-        prevnumber = el->number;
+        if(++it != elements.end())
+            return it->number;
+        return el.number;
     }
 
-    return prevnumber;
+    const stime_t offset = scaled - el.t;
+    if(offset <= el.d)
+        return el.number;
+    return el.number + std::min(el.r, (uint64_t)((offset - 1) / el.d));
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    stime_t totalscaledtime = 0;
-    stime_t lastduration = 0;
-
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
+    if(elements.empty())
     {
-        const Element *el = *it;
-
-        /* set start time, or from discontinuity */
-        if(it == elements.begin() || el->t)
-        {
-            totalscaledtime = el->t;
-        }
-
-        lastduration = el->d;
-
-        if(number <= el->number)
-            break;
-
-        if(number <= el->number + el->r)
-        {
-            totalscaledtime += el->d * (number - el->number);
-            break;
-        }
+        *time = *duration = 0;
+        return true;
+    }
 
-        totalscaledtime += (el->d * (el->r + 1));
+    std::deque<Element>::const_iterator it =
+            std::lower_bound(elements.begin(), elements.end(), number,
+                             Element::compareEndNumber);
+    if(it == elements.end())
+    {
+        const Element &last = elements.back();
+        *time = last.endTime();
+        *duration = last.d;
+        return true;
     }
 
-    *time = totalscaledtime;
-    *duration = lastduration;
+    *time = it->t;
+    if(number > it->number)
+        *time += it->d * (number - it->number);
+    *duration = it->d;
     return true;
 }
 
@@ -163,15 +137,14 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    return elements.back().endNumber();
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
@@ -183,31 +156,25 @@ void SegmentTimeline::pruneByPlaybackTime(mtime_t time)
 
 size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 {
+    std::deque<Element>::iterator it =
+            std::lower_bound(elements.begin(), elements.end(), number,
+                             Element::compareEndNumber);
+
     size_t prunednow = 0;
-    while(elements.size())
+    for(std::deque<Element>::const_iterator del = elements.begin(); del != it; ++del)
+        prunednow += del->r + 1;
+
+    if(it != elements.end() && it->number < number)
     {
-        Element *el = elements.front();
-        if(el->number >= number)
-        {
-            break;
-        }
-        else if(el->number + el->r >= number)
-        {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
-            prunednow += count;
-            break;
-        }
-        else
-        {
-            prunednow += el->r + 1;
-            elements.pop_front();
-            delete el;
-        }
+        uint64_t count = number - it->number;
+        it->number += count;
+        it->t += count * it->d;
+        it->r -= count;
+        prunednow += count;
     }
 
+    elements.erase(elements.begin(), it);
+
     return prunednow;
 }
 
@@ -215,53 +182,48 @@ void SegmentTimeline::mergeWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
+        other.elements.clear();
         return;
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    std::deque<Element>::const_iterator it;
+    for(it = other.elements.begin(); it != other.elements.end(); ++it)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
+        const Element &el = *it;
+        Element &last = elements.back();
 
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
+        if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
         {
-            const uint64_t count = (el->t - last->t) / last->d;
-            last->r = std::max(last->r, el->r + count);
-            delete el;
+            const uint64_t count = (el.t - last.t) / last.d;
+            last.r = std::max(last.r, el.r + count);
         }
-        else if(el->t < last->t)
+        else if(el.t < last.t)
         {
-            delete el;
+            continue;
         }
         else /* Did not exist in previous list */
         {
+            const uint64_t number = last.endNumber() + 1;
             elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            elements.back().number = number;
         }
     }
+    other.elements.clear();
 }
 
 mtime_t SegmentTimeline::start() const
 {
     if(elements.empty())
         return 0;
-    return inheritTimescale().ToTime(elements.front()->t);
+    return inheritTimescale().ToTime(elements.front().t);
 }
 
 mtime_t SegmentTimeline::end() const
 {
     if(elements.empty())
         return 0;
-    const Element *last = elements.back();
-    stime_t scaled = last->t + last->d * (last->r + 1);
-    return inheritTimescale().ToTime(scaled);
+    return inheritTimescale().ToTime(elements.back().endTime());
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -270,9 +232,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
+    std::deque<Element>::const_iterator it;
     for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+        it->debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -290,6 +252,26 @@ bool SegmentTimeline::Element::contains(stime_t time) const
     return false;
 }
 
+stime_t SegmentTimeline::Element::endTime() const
+{
+    return t + d * (stime_t)(r + 1);
+}
+
+uint64_t SegmentTimeline::Element::endNumber() const
+{
+    return number + r;
+}
+
+bool SegmentTimeline::Element::compareStartTime(const Element &el, stime_t time)
+{
+    return el.t < time;
+}
+
+bool SegmentTimeline::Element::compareEndNumber(const Element &el, uint64_t number)
+{
+    return el.endNumber() < number;
+}
+
 void SegmentTimeline::Element::debug(vlc_object_t *obj, int indent) const
 {
     std::stringstream ss;
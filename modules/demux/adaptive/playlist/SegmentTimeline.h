@@ -26,7 +26,7 @@
 
 #include "SegmentInfoCommon.h"
 #include <vlc_common.h>
-#include <list>
+#include <deque>
 
 namespace adaptive
 {
@@ -55,19 +55,25 @@ namespace adaptive
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t  endTime() const;
+                        uint64_t endNumber() const;
+                        static bool compareStartTime(const Element &, stime_t);
+                        static bool compareEndNumber(const Element &, uint64_t);
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
                 };
+
+                /* Run-length encoded <S> entries, sorted by number and time.
+                 * Random access for binary search and cheap front pruning */
+                std::deque<Element> elements;
         };
     }
 }
@@ -102,6 +102,14 @@ const void * EsOutSendCommand::esIdentifier() const
     return static_cast<const void *>(p_fakeid);
 }
 
+size_t EsOutSendCommand::getBytes() const
+{
+    size_t i_size = 0;
+    for( const block_t *p = p_block; p; p = p->p_next )
+        i_size += p->i_buffer;
+    return i_size;
+}
+
 EsOutDelCommand::EsOutDelCommand( FakeESOutID *p_es ) :
     AbstractFakeEsCommand( ES_OUT_PRIVATE_COMMAND_DEL, p_es )
 {
@@ -244,6 +252,7 @@ CommandsQueue::CommandsQueue( CommandsFactory *f )
 {
     bufferinglevel = VLC_TS_INVALID;
     pcr = VLC_TS_INVALID;
+    queuedbytes = 0;
     b_drop = false;
     b_draining = false;
     b_eof = false;
@@ -272,6 +281,13 @@ static bool compareCommands( AbstractCommand *a, AbstractCommand *b )
     else return (a->getTime() < b->getTime() && a->getTime() != VLC_TS_INVALID);
 }
 
+static size_t commandBytes( const AbstractCommand *command )
+{
+    if( command->getType() != ES_OUT_PRIVATE_COMMAND_SEND )
+        return 0;
+    return static_cast<const EsOutSendCommand *>(command)->getBytes();
+}
+
 void CommandsQueue::Schedule( AbstractCommand *command )
 {
     vlc_mutex_lock(&lock);
@@ -287,6 +303,7 @@ void CommandsQueue::Schedule( AbstractCommand *command )
     }
     else
     {
+        queuedbytes += commandBytes( command );
         incoming.push_back( command );
     }
     vlc_mutex_unlock(&lock);
@@ -330,9 +347,9 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
         if(command->getType() == ES_OUT_SET_GROUP_PCR && command->getTime() > barrier )
             break;
 
-        in.pop_front();
         b_datasent = true;
 
+        /* Move list nodes around, no reallocation for each command */
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
             EsOutSendCommand *sendcommand = dynamic_cast<EsOutSendCommand *>(command);
@@ -345,21 +362,21 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
                 /* ensure no more non dated for that ES is sent
                  * since we're sure that data is above barrier */
                 disabled_esids.insert( id );
-                commands.push_back( command );
+                commands.splice( commands.end(), in, in.begin() );
             }
             else if( command->getTime() == VLC_TS_INVALID )
             {
                 if( disabled_esids.find( id ) == disabled_esids.end() )
-                    output.push_back( command );
+                    output.splice( output.end(), in, in.begin() );
                 else
-                    commands.push_back( command );
+                    commands.splice( commands.end(), in, in.begin() );
             }
             else /* Falls below barrier, send */
             {
-                output.push_back( command );
+                output.splice( output.end(), in, in.begin() );
             }
         }
-        else output.push_back( command ); /* will discard below */
+        else output.splice( output.end(), in, in.begin() ); /* will discard below */
     }
 
     /* push remaining ones if broke above */
@@ -379,6 +396,7 @@ mtime_t CommandsQueue::Process( es_out_t *out, mtime_t barrier )
             mtime_t dts = command->getTime();
             if( dts != VLC_TS_INVALID )
                 lastdts = dts;
+            queuedbytes -= commandBytes( command );
         }
 
         command->Execute( out );
@@ -414,6 +432,7 @@ void CommandsQueue::Abort( bool b_reset )
         delete commands.front();
         commands.pop_front();
     }
+    queuedbytes = 0;
 
     if( b_reset )
     {
@@ -513,6 +532,14 @@ void CommandsQueue::LockedSetDraining()
     b_draining = !commands.empty();
 }
 
+size_t CommandsQueue::getQueuedBytes() const
+{
+    vlc_mutex_lock(const_cast<vlc_mutex_t *>(&lock));
+    size_t i_bytes = queuedbytes;
+    vlc_mutex_unlock(const_cast<vlc_mutex_t *>(&lock));
+    return i_bytes;
+}
+
 mtime_t CommandsQueue::getPCR() const
 {
     vlc_mutex_lock(const_cast<vlc_mutex_t *>(&lock));
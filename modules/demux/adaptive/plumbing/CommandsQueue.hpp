@@ -60,6 +60,7 @@ namespace adaptive
             virtual void Execute( es_out_t *out );
             virtual mtime_t getTime() const;
             const void * esIdentifier() const;
+            size_t getBytes() const;
 
         protected:
             EsOutSendCommand( FakeESOutID *, block_t * );
@@ -168,6 +169,7 @@ namespace adaptive
             mtime_t getBufferingLevel() const;
             mtime_t getFirstDTS() const;
             mtime_t getPCR() const;
+            size_t getQueuedBytes() const;
 
         private:
             CommandsFactory *commandsFactory;
@@ -178,6 +180,7 @@ namespace adaptive
             std::list<AbstractCommand *> commands;
             mtime_t bufferinglevel;
             mtime_t pcr;
+            size_t queuedbytes;
             bool b_draining;
             bool b_drop;
             bool b_eof;
@@ -29,8 +29,78 @@
 #include <vlc_stream.h>
 #include <vlc_demux.h>
 
+#include <algorithm>
+#include <atomic>
+#include <new>
+
 using namespace adaptive;
 
+namespace
+{
+    /* Backend blocks are wrapped into a refcounted owner, as the packetizer
+     * helper does for NAL units, so that ranges lying within a single block
+     * can be handed out as views that outlive the backend cleanup. */
+    struct SharedBlock
+    {
+        block_t self;
+        block_t *p_source;
+        std::atomic<unsigned> refs;
+    };
+
+    struct BlockView
+    {
+        block_t self;
+        SharedBlock *p_shared;
+    };
+
+    void SharedBlockRelease(SharedBlock *p_shared)
+    {
+        if(p_shared->refs.fetch_sub(1) == 1)
+        {
+            block_Release(p_shared->p_source);
+            delete p_shared;
+        }
+    }
+
+    void SharedBlockOwnerRelease(block_t *p_block)
+    {
+        SharedBlockRelease(reinterpret_cast<SharedBlock *>(p_block));
+    }
+
+    void BlockViewRelease(block_t *p_block)
+    {
+        BlockView *p_view = reinterpret_cast<BlockView *>(p_block);
+        SharedBlockRelease(p_view->p_shared);
+        delete p_view;
+    }
+
+    block_t * SharedBlockWrap(block_t *p_block)
+    {
+        SharedBlock *p_shared = new (std::nothrow) SharedBlock;
+        if(!p_shared)
+            return p_block;
+        block_Init(&p_shared->self, p_block->p_buffer, p_block->i_buffer);
+        p_shared->self.pf_release = SharedBlockOwnerRelease;
+        p_shared->p_source = p_block;
+        p_shared->refs = 1;
+        return &p_shared->self;
+    }
+
+    block_t * SharedBlockView(block_t *p_owner, uint8_t *p_data, size_t i_size)
+    {
+        if(p_owner->pf_release != SharedBlockOwnerRelease)
+            return NULL;
+        BlockView *p_view = new (std::nothrow) BlockView;
+        if(!p_view)
+            return NULL;
+        block_Init(&p_view->self, p_data, i_size);
+        p_view->self.pf_release = BlockViewRelease;
+        p_view->p_shared = reinterpret_cast<SharedBlock *>(p_owner);
+        p_view->p_shared->refs++;
+        return &p_view->self;
+    }
+}
+
 ChunksSourceStream::ChunksSourceStream(vlc_object_t *p_obj_, ChunksSource *source_)
     : b_eof( false )
     , p_obj( p_obj_ )
@@ -111,6 +181,21 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
     return i_copied;
 }
 
+block_t * ChunksSourceStream::ReadBlock(size_t size)
+{
+    block_t *p_read = block_Alloc(size);
+    if(!p_read)
+        return NULL;
+    ssize_t i_read = Read(p_read->p_buffer, size);
+    if(i_read <= 0)
+    {
+        block_Release(p_read);
+        return NULL;
+    }
+    p_read->i_buffer = i_read;
+    return p_read;
+}
+
 int ChunksSourceStream::Seek(uint64_t)
 {
     return VLC_EGENERIC;
@@ -175,6 +260,8 @@ BufferedChunksSourceStream::BufferedChunksSourceStream(vlc_object_t *p_obj_, Chu
     i_global_offset = 0;
     i_bytestream_offset = 0;
     block_BytestreamInit( &bs );
+    p_cursor = NULL;
+    i_cursor_offset = 0;
 }
 
 BufferedChunksSourceStream::~BufferedChunksSourceStream()
@@ -187,43 +274,54 @@ void BufferedChunksSourceStream::Reset()
     block_BytestreamEmpty( &bs );
     i_bytestream_offset = 0;
     i_global_offset = 0;
+    p_cursor = NULL;
+    i_cursor_offset = 0;
     b_eof = false;
 }
 
-ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
+void BufferedChunksSourceStream::locateCursor()
 {
-    size_t i_copied = 0;
-    size_t i_toread = size;
+    size_t i_offset = bs.i_block_offset + i_bytestream_offset;
+    block_t *p_block = bs.p_block;
+    while(p_block && p_block->p_next && i_offset >= p_block->i_buffer)
+    {
+        i_offset -= p_block->i_buffer;
+        p_block = p_block->p_next;
+    }
+    p_cursor = p_block;
+    i_cursor_offset = p_block ? i_offset : 0;
+}
 
-    while(i_toread && !b_eof)
+bool BufferedChunksSourceStream::fillCursor()
+{
+    while(!b_eof)
     {
-        size_t i_remain = block_BytestreamRemaining(&bs) - i_bytestream_offset;
+        if(!p_cursor)
+            locateCursor();
 
-        if(i_remain < i_toread)
+        if(p_cursor && p_cursor->i_buffer > i_cursor_offset)
+            return true;
+
+        if(p_cursor && p_cursor->p_next)
         {
-            block_t *p_add = source->readNextBlock();
-            if(!p_add)
-            {
-                b_eof = true;
-                break;
-            }
-            i_remain += p_add->i_buffer;
-            block_BytestreamPush(&bs, p_add);
+            p_cursor = p_cursor->p_next;
+            i_cursor_offset = 0;
+            continue;
         }
 
-        size_t i_read;
-        if(i_remain >= i_toread)
-            i_read = i_toread;
-        else
-            i_read = i_remain;
-
-        if(buf)
-            block_PeekOffsetBytes(&bs, i_bytestream_offset, &buf[i_copied], i_read);
-        i_bytestream_offset += i_read;
-        i_copied += i_read;
-        i_toread -= i_read;
+        block_t *p_add = source->readNextBlock();
+        if(!p_add)
+        {
+            b_eof = true;
+            break;
+        }
+        block_BytestreamPush(&bs, SharedBlockWrap(p_add));
     }
+    return false;
+}
 
+void BufferedChunksSourceStream::cleanupBackend()
+{
     if(i_bytestream_offset > MAX_BACKEND)
     {
         const size_t i_drop = i_bytestream_offset - MAX_BACKEND;
@@ -233,17 +331,57 @@ ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
             block_BytestreamFlush(&bs);
             i_bytestream_offset -= i_drop;
             i_global_offset += i_drop;
+            p_cursor = NULL;
         }
     }
+}
+
+ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
+{
+    size_t i_copied = 0;
+    size_t i_toread = size;
+
+    while(i_toread && fillCursor())
+    {
+        const size_t i_read = std::min(p_cursor->i_buffer - i_cursor_offset, i_toread);
+        if(buf)
+            memcpy(&buf[i_copied], &p_cursor->p_buffer[i_cursor_offset], i_read);
+        i_cursor_offset += i_read;
+        i_bytestream_offset += i_read;
+        i_copied += i_read;
+        i_toread -= i_read;
+    }
+
+    cleanupBackend();
 
     return i_copied;
 }
 
+/* Ranges within one backend block are returned as views of it. Their bytes
+ * may then be modified in place by the receiver, as with any block, and
+ * must not be read again from the backend. */
+block_t * BufferedChunksSourceStream::ReadBlock(size_t size)
+{
+    if(size && fillCursor() && p_cursor->i_buffer - i_cursor_offset >= size)
+    {
+        block_t *p_view = SharedBlockView(p_cursor, &p_cursor->p_buffer[i_cursor_offset], size);
+        if(p_view)
+        {
+            i_cursor_offset += size;
+            i_bytestream_offset += size;
+            cleanupBackend();
+            return p_view;
+        }
+    }
+    return ChunksSourceStream::ReadBlock(size);
+}
+
 int BufferedChunksSourceStream::Seek(uint64_t i_seek)
 {
     if(i_seek < i_global_offset ||
        i_seek - i_global_offset > block_BytestreamRemaining(&bs))
         return VLC_EGENERIC;
     i_bytestream_offset = i_seek - i_global_offset;
+    p_cursor = NULL;
     return VLC_SUCCESS;
 }
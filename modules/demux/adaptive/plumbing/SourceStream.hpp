@@ -35,6 +35,11 @@ namespace adaptive
             virtual ~AbstractSourceStream() {}
             virtual stream_t *makeStream() = 0;
             virtual void Reset() = 0;
+            /* Direct access for demuxers that do not need a stream_t.
+               Do not mix with a stream made by makeStream(), which tracks
+               its own offset. */
+            virtual block_t *ReadBlock(size_t) = 0;
+            virtual int      Seek(uint64_t) = 0;
     };
 
     class ChunksSourceStream : public AbstractSourceStream
@@ -44,11 +49,12 @@ namespace adaptive
             virtual ~ChunksSourceStream();
             virtual stream_t *makeStream(); /* impl */
             virtual void Reset(); /* impl */
+            virtual block_t *ReadBlock(size_t); /* impl */
+            virtual int      Seek(uint64_t); /* impl */
 
         protected:
             std::string getContentType();
             virtual ssize_t Read(uint8_t *, size_t);
-            virtual int     Seek(uint64_t);
             bool b_eof;
             vlc_object_t *p_obj;
             ChunksSource *source;
@@ -67,17 +73,25 @@ namespace adaptive
             BufferedChunksSourceStream(vlc_object_t *, ChunksSource *);
             virtual ~BufferedChunksSourceStream();
             virtual void Reset(); /* reimpl */
+            virtual block_t *ReadBlock(size_t); /* reimpl */
+            virtual int      Seek(uint64_t); /* reimpl */
 
         protected:
             virtual ssize_t Read(uint8_t *, size_t); /* reimpl */
-            virtual int     Seek(uint64_t); /* reimpl */
 
         private:
+            void locateCursor();
+            bool fillCursor();
+            void cleanupBackend();
             static const int MAX_BACKEND = 5 * 1024 * 1024;
             static const int MIN_BACKEND_CLEANUP = 50 * 1024;
             uint64_t i_global_offset;
             size_t i_bytestream_offset;
             block_bytestream_t bs;
+            /* block and offset of i_bytestream_offset, avoids walking
+               the whole backend on each read */
+            block_t *p_cursor;
+            size_t i_cursor_offset;
     };
 }
 #endif // SOURCESTREAM_HPP
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * SegmentTimeline.cpp: SegmentTimeline lookups tests
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include "test.hpp"
+#include "../playlist/SegmentTimeline.h"
+
+using namespace adaptive::playlist;
+
+static void check_lookups()
+{
+    SegmentTimeline timeline(100);
+
+    /* #10-#14 d=10 @100, #15-#16 d=20, #17 d=5 */
+    timeline.addElement(10, 10, 4, 100);
+    timeline.addElement(15, 20, 1);
+    timeline.addElement(17, 5);
+
+    assert(timeline.minElementNumber() == 10);
+    assert(timeline.maxElementNumber() == 17);
+    assert(timeline.start() == CLOCK_FREQ);
+    assert(timeline.end() == CLOCK_FREQ * 195 / 100);
+
+    /* boundaries belong to the previous segment */
+    assert(timeline.getElementNumberByScaledPlaybackTime(0) == 10);
+    assert(timeline.getElementNumberByScaledPlaybackTime(100) == 10);
+    assert(timeline.getElementNumberByScaledPlaybackTime(110) == 10);
+    assert(timeline.getElementNumberByScaledPlaybackTime(111) == 11);
+    assert(timeline.getElementNumberByScaledPlaybackTime(149) == 14);
+    assert(timeline.getElementNumberByScaledPlaybackTime(150) == 14);
+    assert(timeline.getElementNumberByScaledPlaybackTime(151) == 15);
+    assert(timeline.getElementNumberByScaledPlaybackTime(171) == 16);
+    assert(timeline.getElementNumberByScaledPlaybackTime(191) == 17);
+    assert(timeline.getElementNumberByScaledPlaybackTime(1000) == 17);
+
+    stime_t time, duration;
+    assert(timeline.getScaledPlaybackTimeDurationBySegmentNumber(0, &time, &duration));
+    assert(time == 100 && duration == 10);
+    assert(timeline.getScaledPlaybackTimeDurationBySegmentNumber(13, &time, &duration));
+    assert(time == 130 && duration == 10);
+    assert(timeline.getScaledPlaybackTimeDurationBySegmentNumber(16, &time, &duration));
+    assert(time == 170 && duration == 20);
+    assert(timeline.getScaledPlaybackTimeDurationBySegmentNumber(17, &time, &duration));
+    assert(time == 190 && duration == 5);
+    assert(timeline.getScaledPlaybackTimeByElementNumber(18) == 195);
+
+    assert(timeline.getMinAheadScaledTime(9) == 0);
+    assert(timeline.getMinAheadScaledTime(13) == 10 + 40 + 5);
+    assert(timeline.getMinAheadScaledTime(16) == 5);
+    assert(timeline.getMinAheadScaledTime(17) == 0);
+
+    /* prune in the middle of a repeat */
+    assert(timeline.pruneBySequenceNumber(12) == 2);
+    assert(timeline.minElementNumber() == 12);
+    assert(timeline.getScaledPlaybackTimeByElementNumber(12) == 120);
+    assert(timeline.pruneBySequenceNumber(12) == 0);
+    assert(timeline.pruneBySequenceNumber(16) == 4);
+    assert(timeline.getScaledPlaybackTimeByElementNumber(16) == 170);
+    assert(timeline.maxElementNumber() == 17);
+
+    /* overlapping update */
+    SegmentTimeline update(100);
+    update.addElement(0, 20, 0, 170);
+    update.addElement(1, 5, 2);
+    update.addElement(4, 10);
+    timeline.mergeWith(update);
+    assert(timeline.minElementNumber() == 16);
+    assert(timeline.maxElementNumber() == 20);
+    assert(timeline.getScaledPlaybackTimeByElementNumber(20) == 205);
+    assert(timeline.getElementNumberByScaledPlaybackTime(206) == 20);
+    assert(timeline.end() == CLOCK_FREQ * 215 / 100);
+
+    timeline.pruneByPlaybackTime(CLOCK_FREQ * 3);
+    assert(timeline.minElementNumber() == 20);
+}
+
+static void check_long_timeline()
+{
+    /* 12h of 2s segments, with a new <S> every 10 segments */
+    const uint64_t count = 12 * 3600 / 2;
+    SegmentTimeline timeline(1000);
+    for(uint64_t i = 0; i < count; i += 10)
+        timeline.addElement(i, 2000, 9);
+    assert(timeline.minElementNumber() == 0);
+    assert(timeline.maxElementNumber() == count - 1);
+
+    for(uint64_t i = 0; i < count; i += 997)
+    {
+        const stime_t time = timeline.getScaledPlaybackTimeByElementNumber(i);
+        assert(time == (stime_t)i * 2000);
+        assert(timeline.getElementNumberByScaledPlaybackTime(time + 1) == i);
+    }
+
+    /* prune segment by segment, across the runs */
+    for(uint64_t i = 1; i < count; i++)
+        assert(timeline.pruneBySequenceNumber(i) == 1);
+    assert(timeline.minElementNumber() == count - 1);
+    assert(timeline.getScaledPlaybackTimeByElementNumber(count - 1)
+           == (stime_t)(count - 1) * 2000);
+}
+
+int SegmentTimeline_test()
+{
+    check_lookups();
+    check_long_timeline();
+    return 0;
+}
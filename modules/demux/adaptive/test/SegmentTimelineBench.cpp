@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * SegmentTimelineBench.cpp: SegmentTimeline lookups benchmark
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+
+#include <vlc_common.h>
+
+#include "../playlist/SegmentTimeline.h"
+
+using namespace adaptive::playlist;
+
+/* The timeline logs with msg_Dbg() */
+const char vlc_module_name[] = "adaptive_bench";
+
+int main()
+{
+    /* 12h of 2s segments, with a new <S> every 10 segments */
+    const uint64_t count = 12 * 3600 / 2;
+    SegmentTimeline timeline(1000);
+    for(uint64_t i = 0; i < count; i += 10)
+        timeline.addElement(i, 2000, 9);
+    assert(timeline.maxElementNumber() == count - 1);
+
+    const unsigned loops = 1000000;
+    uint64_t sum = 0;
+    mtime_t start = mdate();
+    for(unsigned i = 0; i < loops; i++)
+        sum += timeline.getElementNumberByScaledPlaybackTime((stime_t)(i % count) * 2000);
+    mtime_t ticks = mdate() - start;
+    fprintf(stderr, "time->number: %" PRId64 " ns/lookup\n", ticks * 1000 / loops);
+
+    start = mdate();
+    for(unsigned i = 0; i < loops; i++)
+        sum += timeline.getScaledPlaybackTimeByElementNumber(i % count);
+    ticks = mdate() - start;
+    fprintf(stderr, "number->time: %" PRId64 " ns/lookup\n", ticks * 1000 / loops);
+
+    start = mdate();
+    for(uint64_t i = 0; i < count; i++)
+        sum += timeline.pruneBySequenceNumber(i);
+    ticks = mdate() - start;
+    fprintf(stderr, "pruning: %" PRId64 " ns/segment\n", ticks * 1000 / count);
+
+    assert(sum > 0);
+    assert(timeline.minElementNumber() == count - 1);
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * SourceStream.cpp: source stream block views tests
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include "../test.hpp"
+#include "../../plumbing/SourceStream.hpp"
+#include "../../ChunksSource.hpp"
+
+#include <vlc_block.h>
+
+#include <cstring>
+#include <list>
+#include <vector>
+
+using namespace adaptive;
+
+/* Hands out the data in blocks of the given sizes, and remembers where
+ * they are so that views can be told from copies */
+class TestChunksSource : public ChunksSource
+{
+    public:
+        TestChunksSource(const std::vector<uint8_t> &data_,
+                         const std::vector<size_t> &sizes_)
+            : data(data_), sizes(sizes_), i_next(0), i_offset(0) {}
+
+        virtual block_t *readNextBlock()
+        {
+            if(i_next == sizes.size())
+                return NULL;
+            block_t *p_block = block_Alloc(sizes[i_next]);
+            assert(p_block);
+            memcpy(p_block->p_buffer, &data[i_offset], sizes[i_next]);
+            buffers.push_back(p_block->p_buffer);
+            i_offset += sizes[i_next++];
+            return p_block;
+        }
+
+        virtual std::string getContentType()
+        {
+            return std::string();
+        }
+
+        bool isView(const block_t *p_block) const
+        {
+            for(size_t i = 0; i < buffers.size(); i++)
+            {
+                if(p_block->p_buffer >= buffers[i] &&
+                   p_block->p_buffer + p_block->i_buffer <= buffers[i] + sizes[i])
+                    return true;
+            }
+            return false;
+        }
+
+    private:
+        const std::vector<uint8_t> &data;
+        std::vector<size_t> sizes;
+        std::vector<const uint8_t *> buffers;
+        size_t i_next;
+        size_t i_offset;
+};
+
+static void check_views()
+{
+    std::vector<uint8_t> data(4096);
+    for(size_t i = 0; i < data.size(); i++)
+        data[i] = i * 7 + (i >> 8);
+
+    std::vector<size_t> sizes;
+    sizes.push_back(100);
+    sizes.push_back(1);
+    sizes.push_back(3);
+    sizes.push_back(2000);
+    sizes.push_back(1992);
+
+    TestChunksSource source(data, sizes);
+    BufferedChunksSourceStream stream(NULL, &source);
+
+    /* within the first block */
+    block_t *p_block = stream.ReadBlock(60);
+    assert(p_block && p_block->i_buffer == 60);
+    assert(source.isView(p_block));
+    assert(!memcmp(p_block->p_buffer, &data[0], 60));
+    std::list<block_t *> held;
+    held.push_back(p_block);
+
+    /* across the next three blocks: copied */
+    p_block = stream.ReadBlock(50);
+    assert(p_block && p_block->i_buffer == 50);
+    assert(!source.isView(p_block));
+    assert(!memcmp(p_block->p_buffer, &data[60], 50));
+    block_Release(p_block);
+
+    /* up to the end of a block, then from the start of the next one */
+    p_block = stream.ReadBlock(1994);
+    assert(p_block && source.isView(p_block));
+    assert(!memcmp(p_block->p_buffer, &data[110], 1994));
+    held.push_back(p_block);
+    p_block = stream.ReadBlock(1);
+    assert(p_block && source.isView(p_block));
+    assert(p_block->p_buffer[0] == data[2104]);
+    held.push_back(p_block);
+
+    /* back to a position still buffered, then the same bytes again */
+    assert(stream.Seek(50) == VLC_SUCCESS);
+    p_block = stream.ReadBlock(50);
+    assert(p_block && source.isView(p_block));
+    assert(!memcmp(p_block->p_buffer, &data[50], 50));
+    held.push_back(p_block);
+    assert(stream.Seek(5000) != VLC_SUCCESS);
+
+    /* truncated at the end of the data */
+    assert(stream.Seek(4000) == VLC_SUCCESS);
+    p_block = stream.ReadBlock(200);
+    assert(p_block && p_block->i_buffer == 96);
+    assert(!memcmp(p_block->p_buffer, &data[4000], 96));
+    block_Release(p_block);
+    assert(stream.ReadBlock(1) == NULL);
+
+    /* the views outlive the backend */
+    stream.Reset();
+    size_t i_offsets[] = { 0, 110, 2104, 50 };
+    size_t i = 0;
+    for(std::list<block_t *>::iterator it = held.begin(); it != held.end(); ++it)
+    {
+        assert(!memcmp((*it)->p_buffer, &data[i_offsets[i++]], (*it)->i_buffer));
+        block_Release(*it);
+    }
+}
+
+int SourceStream_test()
+{
+    check_views();
+    return 0;
+}
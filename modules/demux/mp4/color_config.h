@@ -24,6 +24,9 @@
 
 /* no free spec, grabbed from av1 bitstream spec */
 
+/* The tables follow the order of the enums, without designators, so that
+ * C++ demuxers can use them too */
+
 enum iso_23001_8_cp
 {
     ISO_23001_8_CP_BT_709 = 1,
@@ -44,19 +47,19 @@ enum iso_23001_8_cp
 
 static const uint8_t iso_23001_8_cp_to_vlc_primaries_table[] =
 {
-    [0]                             = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_BT_709]         = COLOR_PRIMARIES_BT709,
-    [ISO_23001_8_CP_UNSPECIFIED]    = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_RESERVED0]      = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_BT_470_M]       = COLOR_PRIMARIES_BT470_M,
-    [ISO_23001_8_CP_BT_470_B_G]     = COLOR_PRIMARIES_BT470_BG,
-    [ISO_23001_8_CP_BT_601]         = COLOR_PRIMARIES_SMTPE_170,
-    [ISO_23001_8_CP_SMPTE_240]      = COLOR_PRIMARIES_SMTPE_240,
-    [ISO_23001_8_CP_GENERIC_FILM]   = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_BT_2020]        = COLOR_PRIMARIES_BT2020,
-    [ISO_23001_8_CP_XYZ]            = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_SMPTE_431]      = COLOR_PRIMARIES_UNDEF,
-    [ISO_23001_8_CP_SMPTE_432]      = COLOR_PRIMARIES_UNDEF,
+    COLOR_PRIMARIES_UNDEF,        /* 0 */
+    COLOR_PRIMARIES_BT709,        /* ISO_23001_8_CP_BT_709 */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_UNSPECIFIED */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_RESERVED0 */
+    COLOR_PRIMARIES_BT470_M,      /* ISO_23001_8_CP_BT_470_M */
+    COLOR_PRIMARIES_BT470_BG,     /* ISO_23001_8_CP_BT_470_B_G */
+    COLOR_PRIMARIES_SMTPE_170,    /* ISO_23001_8_CP_BT_601 */
+    COLOR_PRIMARIES_SMTPE_240,    /* ISO_23001_8_CP_SMPTE_240 */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_GENERIC_FILM */
+    COLOR_PRIMARIES_BT2020,       /* ISO_23001_8_CP_BT_2020 */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_XYZ */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_SMPTE_431 */
+    COLOR_PRIMARIES_UNDEF,        /* ISO_23001_8_CP_SMPTE_432 */
     /* [ISO_23001_8_CP_EBU_3213]       = COLOR_PRIMARIES_EBU_3213, see below */
 };
 
@@ -66,7 +69,7 @@ static inline uint8_t iso_23001_8_cp_to_vlc_primaries( uint8_t v )
         return COLOR_PRIMARIES_EBU_3213;
     return v < ARRAY_SIZE(iso_23001_8_cp_to_vlc_primaries_table)
            ? iso_23001_8_cp_to_vlc_primaries_table[v]
-           : COLOR_PRIMARIES_UNDEF;
+           : (uint8_t) COLOR_PRIMARIES_UNDEF;
 }
 
 enum iso_23001_8_tc
@@ -94,32 +97,32 @@ enum iso_23001_8_tc
 
 static const uint8_t iso_23001_8_tc_to_vlc_xfer_table[] =
 {
-    [ISO_23001_8_TC_RESERVED_0]     = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_BT_709]         = TRANSFER_FUNC_BT709,
-    [ISO_23001_8_TC_UNSPECIFIED]    = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_RESERVED_3]     = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_BT_470_M]       = TRANSFER_FUNC_BT470_M,
-    [ISO_23001_8_TC_BT_470_B_G]     = TRANSFER_FUNC_BT470_BG,
-    [ISO_23001_8_TC_BT_601]         = TRANSFER_FUNC_BT709,
-    [ISO_23001_8_TC_SMPTE_240]      = TRANSFER_FUNC_SMPTE_240,
-    [ISO_23001_8_TC_LINEAR]         = TRANSFER_FUNC_LINEAR,
-    [ISO_23001_8_TC_LOG_100]        = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_LOG_100_SQRT10] = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_IEC_61966]      = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_BT_1361]        = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_SRGB]           = TRANSFER_FUNC_SRGB,
-    [ISO_23001_8_TC_BT_2020_10_BIT] = TRANSFER_FUNC_BT2020,
-    [ISO_23001_8_TC_BT_2020_12_BIT] = TRANSFER_FUNC_BT2020,
-    [ISO_23001_8_TC_SMPTE_2084]     = TRANSFER_FUNC_SMPTE_ST2084,
-    [ISO_23001_8_TC_SMPTE_428]      = TRANSFER_FUNC_UNDEF,
-    [ISO_23001_8_TC_HLG]            = TRANSFER_FUNC_HLG,
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_RESERVED_0 */
+    TRANSFER_FUNC_BT709,          /* ISO_23001_8_TC_BT_709 */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_UNSPECIFIED */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_RESERVED_3 */
+    TRANSFER_FUNC_BT470_M,        /* ISO_23001_8_TC_BT_470_M */
+    TRANSFER_FUNC_BT470_BG,       /* ISO_23001_8_TC_BT_470_B_G */
+    TRANSFER_FUNC_BT709,          /* ISO_23001_8_TC_BT_601 */
+    TRANSFER_FUNC_SMPTE_240,      /* ISO_23001_8_TC_SMPTE_240 */
+    TRANSFER_FUNC_LINEAR,         /* ISO_23001_8_TC_LINEAR */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_LOG_100 */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_LOG_100_SQRT10 */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_IEC_61966 */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_BT_1361 */
+    TRANSFER_FUNC_SRGB,           /* ISO_23001_8_TC_SRGB */
+    TRANSFER_FUNC_BT2020,         /* ISO_23001_8_TC_BT_2020_10_BIT */
+    TRANSFER_FUNC_BT2020,         /* ISO_23001_8_TC_BT_2020_12_BIT */
+    TRANSFER_FUNC_SMPTE_ST2084,   /* ISO_23001_8_TC_SMPTE_2084 */
+    TRANSFER_FUNC_UNDEF,          /* ISO_23001_8_TC_SMPTE_428 */
+    TRANSFER_FUNC_HLG,            /* ISO_23001_8_TC_HLG */
 };
 
 static inline uint8_t iso_23001_8_tc_to_vlc_xfer( uint8_t v )
 {
     return v < ARRAY_SIZE(iso_23001_8_tc_to_vlc_xfer_table)
            ? iso_23001_8_tc_to_vlc_xfer_table[v]
-           : TRANSFER_FUNC_UNDEF;
+           : (uint8_t) TRANSFER_FUNC_UNDEF;
 }
 
 enum iso_23001_8_mc
@@ -143,28 +146,28 @@ enum iso_23001_8_mc
 
 static const uint8_t iso_23001_8_mc_to_vlc_coeffs_table[] =
 {
-    [ISO_23001_8_MC_IDENTITY]    = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_BT_709]      = COLOR_SPACE_BT709,
-    [ISO_23001_8_MC_UNSPECIFIED] = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_RESERVED_3]  = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_FCC]         = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_BT_470_B_G]  = COLOR_SPACE_BT601,
-    [ISO_23001_8_MC_BT_601]      = COLOR_SPACE_BT601,
-    [ISO_23001_8_MC_SMPTE_240]   = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_SMPTE_YCGCO] = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_BT_2020_NCL] = COLOR_SPACE_BT2020,
-    [ISO_23001_8_MC_BT_2020_CL]  = COLOR_SPACE_BT2020,
-    [ISO_23001_8_MC_SMPTE_2085]  = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_CHROMAT_NCL] = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_CHROMAT_CL]  = COLOR_SPACE_UNDEF,
-    [ISO_23001_8_MC_ICTCP]       = COLOR_SPACE_UNDEF,
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_IDENTITY */
+    COLOR_SPACE_BT709,            /* ISO_23001_8_MC_BT_709 */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_UNSPECIFIED */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_RESERVED_3 */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_FCC */
+    COLOR_SPACE_BT601,            /* ISO_23001_8_MC_BT_470_B_G */
+    COLOR_SPACE_BT601,            /* ISO_23001_8_MC_BT_601 */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_SMPTE_240 */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_SMPTE_YCGCO */
+    COLOR_SPACE_BT2020,           /* ISO_23001_8_MC_BT_2020_NCL */
+    COLOR_SPACE_BT2020,           /* ISO_23001_8_MC_BT_2020_CL */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_SMPTE_2085 */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_CHROMAT_NCL */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_CHROMAT_CL */
+    COLOR_SPACE_UNDEF,            /* ISO_23001_8_MC_ICTCP */
 };
 
 static inline uint8_t iso_23001_8_mc_to_vlc_coeffs( uint8_t v )
 {
     return v < ARRAY_SIZE(iso_23001_8_mc_to_vlc_coeffs_table)
            ? iso_23001_8_mc_to_vlc_coeffs_table[v]
-           : COLOR_SPACE_UNDEF;
+           : (uint8_t) COLOR_SPACE_UNDEF;
 }
 
 #endif /* VLC_MP4_COLOR_CONFIG_H_ */
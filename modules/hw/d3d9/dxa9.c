@@ -342,7 +342,8 @@ int D3D9OpenConverter( vlc_object_t *obj )
     if (!p_sys)
          return VLC_ENOMEM;
 
-    if (CopyInitCache(&p_sys->cache, p_filter->fmt_in.video.i_width * pixel_bytes))
+    if (CopyInitCacheBands(&p_sys->cache, p_filter->fmt_in.video.i_width * pixel_bytes,
+                           p_filter->fmt_in.video.i_height, obj))
     {
         free(p_sys);
         return VLC_ENOMEM;
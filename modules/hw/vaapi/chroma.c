@@ -374,8 +374,9 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
         filter_sys->dest_pics = NULL;
     }
 
-    if (CopyInitCache(&filter_sys->cache, filter->fmt_in.video.i_width
-                      * pixel_bytes))
+    if (CopyInitCacheBands(&filter_sys->cache, filter->fmt_in.video.i_width
+                           * pixel_bytes, filter->fmt_in.video.i_height,
+                           VLC_OBJECT(filter)))
     {
         if (is_upload)
         {
@@ -32,6 +32,11 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
 
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
@@ -223,6 +228,40 @@ static uint16_t flac_crc16(uint16_t crc, uint8_t byte)
 {
     return (crc << 8) ^ flac_crc16_table[(crc >> 8) ^ byte];
 }
+
+/* Slice-by-8 tables: flac_crc16_slices[k][x] is the CRC of byte x followed by
+ * k zero bytes, so that 8 bytes can be hashed with independent lookups */
+static uint16_t flac_crc16_slices[8][256];
+static vlc_once_t flac_crc16_slices_once = VLC_STATIC_ONCE;
+
+static void flac_crc16_slices_init(void)
+{
+    for (unsigned i = 0; i < 256; i++)
+    {
+        uint16_t crc = flac_crc16_table[i];
+
+        flac_crc16_slices[0][i] = crc;
+        for (unsigned k = 1; k < 8; k++)
+        {
+            crc = (crc << 8) ^ flac_crc16_table[crc >> 8];
+            flac_crc16_slices[k][i] = crc;
+        }
+    }
+}
+
+static uint16_t flac_crc16_buf(uint16_t crc, const uint8_t *p, size_t len)
+{
+    const uint16_t (*t)[256] = flac_crc16_slices;
+
+    for (; len >= 8; len -= 8, p += 8)
+        crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xff)] ^
+              t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^
+              t[1][p[6]] ^ t[0][p[7]];
+
+    while (len--)
+        crc = flac_crc16(crc, *p++);
+    return crc;
+}
 #if 0
 /* Gives the previous CRC value, before hashing last_byte through it */
 static uint16_t flac_crc16_undo(uint16_t crc, const uint8_t last_byte)
@@ -281,13 +320,61 @@ static void Flush(decoder_t *p_dec)
     block_BytestreamEmpty(&p_sys->bytestream);
 }
 
-static const uint8_t * FLACStartcodeHelper(const uint8_t *p, const uint8_t *end)
+/* Rejects sync codes followed by values that FLAC_ParseSyncInfo() would
+ * refuse whatever the stream info, when these bytes are available */
+static inline bool FLACIsValidSyncCandidate(const uint8_t *p, const uint8_t *end)
+{
+    if( end - p < 4 )
+        return true;
+
+    return p[2] != 0xFF && p[3] != 0xFF &&
+           (p[2] & 0x0F) != 0x0F &&    /* invalid sample rate */
+           (p[3] >> 4) < 11 &&         /* reserved channel assignment */
+           (p[3] & 0x06) != 0x06 &&    /* reserved sample sizes */
+           !(p[3] & 0x01);             /* reserved bit */
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static const uint8_t * FLACStartcodeHelper_SSE2(const uint8_t *p, const uint8_t *end)
+{
+    const __m128i ff = _mm_set1_epi8( (char) 0xFF );
+    const __m128i fe = _mm_set1_epi8( (char) 0xFE );
+    const __m128i f8 = _mm_set1_epi8( (char) 0xF8 );
+
+    for( ; end - p >= 16 + 1; p += 16 )
+    {
+        __m128i v0 = _mm_loadu_si128( (const __m128i *) &p[0] );
+        __m128i v1 = _mm_loadu_si128( (const __m128i *) &p[1] );
+        __m128i res = _mm_and_si128( _mm_cmpeq_epi8( v0, ff ),
+                          _mm_cmpeq_epi8( _mm_and_si128( v1, fe ), f8 ) );
+        unsigned match = _mm_movemask_epi8( res );
+
+        while( match )
+        {
+            const uint8_t *c = p + ctz( match );
+            if( FLACIsValidSyncCandidate( c, end ) )
+                return c;
+            match &= match - 1;
+        }
+    }
+
+    for( ; end - p > 1; p++ )
+        if( p[0] == 0xFF && (p[1] & 0xFE) == 0xF8 &&
+            FLACIsValidSyncCandidate( p, end ) )
+            return p;
+    return NULL;
+}
+#endif
+
+static const uint8_t * FLACStartcodeHelper_Bytes(const uint8_t *p, const uint8_t *end)
 {
     while( p && p < end )
     {
         if( (p = memchr(p, 0xFF, end - p)) )
         {
-            if( end - p > 1 && (p[1] & 0xFE) == 0xF8 )
+            if( end - p > 1 && (p[1] & 0xFE) == 0xF8 &&
+                FLACIsValidSyncCandidate( p, end ) )
                 return p;
             else
                 p++;
@@ -296,6 +383,15 @@ static const uint8_t * FLACStartcodeHelper(const uint8_t *p, const uint8_t *end)
     return NULL;
 }
 
+static const uint8_t * FLACStartcodeHelper(const uint8_t *p, const uint8_t *end)
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        return FLACStartcodeHelper_SSE2( p, end );
+#endif
+    return FLACStartcodeHelper_Bytes( p, end );
+}
+
 static bool FLACStartcodeMatcher(uint8_t i, size_t i_pos, const uint8_t *p_startcode)
 {
     VLC_UNUSED(p_startcode);
@@ -326,7 +422,7 @@ static block_t *Packetize(decoder_t *p_dec, block_t **pp_block)
     if (!p_sys->b_stream_info)
         ProcessHeader(p_dec);
 
-    if (p_sys->stream_info.channels > 8) {
+    if (p_sys->b_stream_info && p_sys->stream_info.channels > 8) {
         msg_Err(p_dec, "This stream uses too many audio channels (%d > 8)",
             p_sys->stream_info.channels);
         return NULL;
@@ -453,8 +549,10 @@ static block_t *Packetize(decoder_t *p_dec, block_t **pp_block)
                                     p_sys->i_offset - p_sys->i_frame_size );
 
             /* update crc to include this data chunk */
-            for( size_t i = p_sys->i_frame_size; i < p_sys->i_offset - 2; i++ )
-                p_sys->crc = flac_crc16( p_sys->crc, p_sys->p_buf[i] );
+            if( p_sys->i_offset - 2 > p_sys->i_frame_size )
+                p_sys->crc = flac_crc16_buf( p_sys->crc,
+                                             &p_sys->p_buf[p_sys->i_frame_size],
+                                             p_sys->i_offset - 2 - p_sys->i_frame_size );
 
             p_sys->i_frame_size = p_sys->i_offset;
 
@@ -484,7 +582,7 @@ static block_t *Packetize(decoder_t *p_dec, block_t **pp_block)
     case STATE_SEND_DATA:
         p_dec->fmt_out.audio.i_rate = p_sys->headerinfo.i_rate;
         p_dec->fmt_out.audio.i_channels = p_sys->headerinfo.i_channels;
-        p_dec->fmt_out.audio.i_physical_channels = pi_channels_maps[p_sys->stream_info.channels];
+        p_dec->fmt_out.audio.i_physical_channels = pi_channels_maps[p_sys->headerinfo.i_channels];
 
         if( p_sys->bytestream.p_block->i_pts > date_Get( &p_sys->pts ) &&
             p_sys->bytestream.p_block->i_pts != VLC_TS_INVALID )
@@ -537,6 +635,7 @@ static int Open(vlc_object_t *p_this)
     if (p_dec->fmt_in.i_codec != VLC_CODEC_FLAC)
         return VLC_EGENERIC;
 
+    vlc_once(&flac_crc16_slices_once, flac_crc16_slices_init);
 
     /* */
     p_dec->p_sys = p_sys = malloc(sizeof(*p_sys));
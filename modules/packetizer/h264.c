@@ -152,6 +152,7 @@ static block_t *OutputPicture( decoder_t *p_dec );
 static void PutSPS( decoder_t *p_dec, block_t *p_frag );
 static void PutPPS( decoder_t *p_dec, block_t *p_frag );
 static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slice_t *p_slice );
+static bool IsNextSliceOfPicture( decoder_t *p_dec, const block_t *p_frag );
 static bool ParseSeiCallback( const hxxx_sei_data_t *, void * );
 
 
@@ -187,6 +188,16 @@ static void StorePPS( decoder_sys_t *p_sys, uint8_t i_id,
     p_sys->pps[i_id].p_pps = p_pps;
 }
 
+static bool IsSameXPS( const block_t *p_stored, const uint8_t *p_buffer, size_t i_buffer )
+{
+    if( !p_stored )
+        return false;
+    const uint8_t *p_stored_buffer = p_stored->p_buffer;
+    size_t i_stored_buffer = p_stored->i_buffer;
+    hxxx_strip_AnnexB_startcode( &p_stored_buffer, &i_stored_buffer );
+    return i_stored_buffer == i_buffer && !memcmp( p_stored_buffer, p_buffer, i_buffer );
+}
+
 static void ActivateSets( decoder_t *p_dec, const h264_sequence_parameter_set_t *p_sps,
                                             const h264_picture_parameter_set_t *p_pps )
 {
@@ -618,7 +629,11 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
                 p_sys->i_recoveryfnum = UINT_MAX;
             }
 
-            if( ParseSliceHeader( p_dec, p_frag, &newslice ) )
+            if( IsNextSliceOfPicture( p_dec, p_frag ) )
+            {
+                /* Nothing else to learn from that slice header */
+            }
+            else if( ParseSliceHeader( p_dec, p_frag, &newslice ) )
             {
                 /* Only IDR carries the id, to be propagated */
                 if( newslice.i_idr_pic_id == -1 )
@@ -650,7 +665,9 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
             }
             p_sys->b_slice = true;
 
-            block_ChainLastAppend( &p_sys->frame.pp_append, p_frag );
+            /* Consecutive slices of the same input block stay one view */
+            packetizer_ChainLastAppend( p_sys->frame.p_head,
+                                        &p_sys->frame.pp_append, p_frag );
         } break;
 
         /*** Prefix NALs ***/
@@ -855,7 +872,7 @@ static block_t *OutputPicture( decoder_t *p_dec )
     p_sys->leading.p_head = NULL;
     p_sys->leading.pp_append = &p_sys->leading.p_head;
 
-    p_pic = block_ChainGather( p_pic );
+    p_pic = packetizer_ChainGather( p_pic );
 
     if( !p_pic )
     {
@@ -1035,6 +1052,15 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    /* Repeated SPS don't need to be decoded again */
+    uint8_t i_id;
+    if( h264_get_xps_id( p_buffer, i_buffer, &i_id ) &&
+        IsSameXPS( p_sys->sps[i_id].p_block, p_buffer, i_buffer ) )
+    {
+        block_Release( p_frag );
+        return;
+    }
+
     h264_sequence_parameter_set_t *p_sps = h264_decode_sps( p_buffer, i_buffer, true );
     if( !p_sps )
     {
@@ -1062,6 +1088,14 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    uint8_t i_id;
+    if( h264_get_xps_id( p_buffer, i_buffer, &i_id ) &&
+        IsSameXPS( p_sys->pps[i_id].p_block, p_buffer, i_buffer ) )
+    {
+        block_Release( p_frag );
+        return;
+    }
+
     h264_picture_parameter_set_t *p_pps = h264_decode_pps( p_buffer, i_buffer, true );
     if( !p_pps )
     {
@@ -1114,6 +1148,44 @@ static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slic
     return true;
 }
 
+static bool IsNextSliceOfPicture( decoder_t *p_dec, const block_t *p_frag )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    /* Without arbitrary slice order (Baseline and Extended only), the first
+     * slice of a picture always starts at macroblock 0. For the following
+     * ones, the header prefix is enough and the rest of it is the same for
+     * all the slices of the picture (7.4.3). */
+    if( !p_sys->b_slice || !p_sys->p_active_sps || !p_sys->p_active_pps ||
+        p_sys->p_active_sps->i_profile == PROFILE_H264_BASELINE ||
+        p_sys->p_active_sps->i_profile == PROFILE_H264_EXTENDED )
+        return false;
+
+    const uint8_t *p_stripped = p_frag->p_buffer;
+    size_t i_stripped = p_frag->i_buffer;
+
+    if( !hxxx_strip_AnnexB_startcode( &p_stripped, &i_stripped ) || i_stripped < 2 )
+        return false;
+
+    h264_slice_t slice;
+    unsigned i_first_mb;
+    if( !h264_decode_slice_prefix( p_stripped, i_stripped, GetSPSPPS, p_sys,
+                                   &slice, &i_first_mb ) )
+        return false;
+
+    if( i_first_mb == 0 ||
+        slice.i_nal_type != p_sys->slice.i_nal_type ||
+        !slice.i_nal_ref_idc != !p_sys->slice.i_nal_ref_idc ||
+        slice.i_pic_parameter_set_id != p_sys->slice.i_pic_parameter_set_id ||
+        slice.i_frame_num != p_sys->slice.i_frame_num )
+        return false;
+
+    p_sys->slice.type = slice.type;
+    p_sys->slice.i_nal_ref_idc = slice.i_nal_ref_idc;
+
+    return true;
+}
+
 static bool ParseSeiCallback( const hxxx_sei_data_t *p_sei_data, void *cbdata )
 {
     decoder_t *p_dec = (decoder_t *) cbdata;
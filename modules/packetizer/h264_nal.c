@@ -257,6 +257,36 @@ bool h264_AnnexB_get_spspps( const uint8_t *p_buf, size_t i_buf,
     return (pp_sps && *p_sps_size) || (pp_pps && *p_pps_size);
 }
 
+bool h264_get_xps_id( const uint8_t *p_buf, size_t i_buf, uint8_t *pi_id )
+{
+    if( i_buf < 2 )
+        return false;
+    /* No need to lookup convert from emulation for that data */
+    const uint8_t i_nal_type = p_buf[0] & 0x1f;
+    bs_t bs;
+    uint32_t i_id;
+    if( i_nal_type == H264_NAL_PPS )
+    {
+        bs_init( &bs, &p_buf[1], i_buf - 1 );
+        i_id = bs_read_ue( &bs );
+        if( i_id > H264_PPS_ID_MAX )
+            return false;
+    }
+    else if( i_nal_type == H264_NAL_SPS )
+    {
+        if( i_buf < 5 )
+            return false;
+        /* skip profile_idc, constraint flags and level_idc */
+        bs_init( &bs, &p_buf[4], i_buf - 4 );
+        i_id = bs_read_ue( &bs );
+        if( i_id > H264_SPS_ID_MAX )
+            return false;
+    }
+    else return false;
+    *pi_id = i_id;
+    return true;
+}
+
 void h264_release_sps( h264_sequence_parameter_set_t *p_sps )
 {
     free( p_sps );
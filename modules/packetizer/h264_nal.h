@@ -181,6 +181,9 @@ block_t *h264_NAL_to_avcC( uint8_t i_nal_length_size,
 uint8_t * h264_avcC_to_AnnexB_NAL( const uint8_t *p_buf, size_t i_buf,
                                    size_t *pi_result, uint8_t *pi_nal_length_size );
 
+/* Reads the SPS/PPS id without decoding the whole set */
+bool h264_get_xps_id( const uint8_t *p_nalbuf, size_t i_nalbuf, uint8_t *pi_id );
+
 bool h264_get_dpb_values( const h264_sequence_parameter_set_t *,
                           uint8_t *pi_depth, unsigned *pi_delay );
 
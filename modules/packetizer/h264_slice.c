@@ -28,49 +28,86 @@
 #include "h264_slice.h"
 #include "hxxx_nal.h"
 
-bool h264_decode_slice( const uint8_t *p_buffer, size_t i_buffer,
+/* Decodes the slice header up to frame_num, and binds the parameter sets */
+static bool h264_decode_slice_prefix_bs( bs_t *s,
                         void (* get_sps_pps)(uint8_t, void *,
                                              const h264_sequence_parameter_set_t **,
                                              const h264_picture_parameter_set_t ** ),
-                        void *priv, h264_slice_t *p_slice )
+                        void *priv, h264_slice_t *p_slice, int *pi_slice_type,
+                        unsigned *pi_first_mb,
+                        const h264_sequence_parameter_set_t **pp_sps,
+                        const h264_picture_parameter_set_t **pp_pps )
 {
-    int i_slice_type;
-    h264_slice_init( p_slice );
-    bs_t s;
-    unsigned i_bitflow = 0;
-    bs_init( &s, p_buffer, i_buffer );
-    s.p_fwpriv = &i_bitflow;
-    s.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */
-
     /* nal unit header */
-    bs_skip( &s, 1 );
-    const uint8_t i_nal_ref_idc = bs_read( &s, 2 );
-    const uint8_t i_nal_type = bs_read( &s, 5 );
+    bs_skip( s, 1 );
+    const uint8_t i_nal_ref_idc = bs_read( s, 2 );
+    const uint8_t i_nal_type = bs_read( s, 5 );
 
     /* first_mb_in_slice */
-    /* int i_first_mb = */ bs_read_ue( &s );
+    *pi_first_mb = bs_read_ue( s );
 
     /* slice_type */
-    i_slice_type = bs_read_ue( &s );
-    p_slice->type = i_slice_type % 5;
+    *pi_slice_type = bs_read_ue( s );
+    p_slice->type = *pi_slice_type % 5;
 
     /* */
     p_slice->i_nal_type = i_nal_type;
     p_slice->i_nal_ref_idc = i_nal_ref_idc;
 
-    p_slice->i_pic_parameter_set_id = bs_read_ue( &s );
+    p_slice->i_pic_parameter_set_id = bs_read_ue( s );
     if( p_slice->i_pic_parameter_set_id > H264_PPS_ID_MAX )
         return false;
 
+    /* Bind matched/referred PPS and SPS */
+    get_sps_pps( p_slice->i_pic_parameter_set_id, priv, pp_sps, pp_pps );
+    if( !*pp_sps || !*pp_pps )
+        return false;
+
+    p_slice->i_frame_num = bs_read( s, (*pp_sps)->i_log2_max_frame_num + 4 );
+
+    return true;
+}
+
+bool h264_decode_slice_prefix( const uint8_t *p_buffer, size_t i_buffer,
+                               void (* get_sps_pps)(uint8_t, void *,
+                                                    const h264_sequence_parameter_set_t **,
+                                                    const h264_picture_parameter_set_t ** ),
+                               void *priv, h264_slice_t *p_slice, unsigned *pi_first_mb )
+{
+    int i_slice_type;
     const h264_sequence_parameter_set_t *p_sps;
     const h264_picture_parameter_set_t *p_pps;
+    h264_slice_init( p_slice );
+    bs_t s;
+    unsigned i_bitflow = 0;
+    bs_init( &s, p_buffer, i_buffer );
+    s.p_fwpriv = &i_bitflow;
+    s.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */
 
-    /* Bind matched/referred PPS and SPS */
-    get_sps_pps( p_slice->i_pic_parameter_set_id, priv, &p_sps, &p_pps );
-    if( !p_sps || !p_pps )
-        return false;
+    return h264_decode_slice_prefix_bs( &s, get_sps_pps, priv, p_slice, &i_slice_type,
+                                        pi_first_mb, &p_sps, &p_pps );
+}
+
+bool h264_decode_slice( const uint8_t *p_buffer, size_t i_buffer,
+                        void (* get_sps_pps)(uint8_t, void *,
+                                             const h264_sequence_parameter_set_t **,
+                                             const h264_picture_parameter_set_t ** ),
+                        void *priv, h264_slice_t *p_slice )
+{
+    int i_slice_type;
+    unsigned i_first_mb;
+    const h264_sequence_parameter_set_t *p_sps;
+    const h264_picture_parameter_set_t *p_pps;
+    h264_slice_init( p_slice );
+    bs_t s;
+    unsigned i_bitflow = 0;
+    bs_init( &s, p_buffer, i_buffer );
+    s.p_fwpriv = &i_bitflow;
+    s.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */
 
-    p_slice->i_frame_num = bs_read( &s, p_sps->i_log2_max_frame_num + 4 );
+    if( !h264_decode_slice_prefix_bs( &s, get_sps_pps, priv, p_slice, &i_slice_type,
+                                      &i_first_mb, &p_sps, &p_pps ) )
+        return false;
 
     if( !p_sps->frame_mbs_only_flag )
     {
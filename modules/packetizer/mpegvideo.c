@@ -449,7 +449,7 @@ static block_t *ParseMPEGBlock( decoder_t *p_dec, block_t *p_frag )
             p_frag = NULL;
         }
 
-        p_pic = block_ChainGather( p_sys->p_frame );
+        p_pic = packetizer_ChainGather( p_sys->p_frame );
         if( p_pic == NULL )
             return p_pic;
 
@@ -895,8 +895,9 @@ static block_t *ParseMPEGBlock( decoder_t *p_dec, block_t *p_frag )
         p_sys->b_frame_slice = true;
     }
 
-    /* Append the block */
-    block_ChainLastAppend( &p_sys->pp_last, p_frag );
+    /* Append the block, as a single view with the previous fragments of
+     * the same input block if possible */
+    packetizer_ChainLastAppend( p_sys->p_frame, &p_sys->pp_last, p_frag );
 
     return p_pic;
 }
@@ -25,6 +25,7 @@
 #define VLC_PACKETIZER_HELPER_H_
 
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 enum
 {
@@ -62,6 +63,179 @@ typedef struct
 
 } packetizer_t;
 
+/* Input blocks are wrapped into a refcounted owner, so that a fragment
+ * lying within a single input block can be output as a view of it
+ * instead of a copy. The first views of an input block are carved out of
+ * its owner, the next ones are allocated. */
+#define PACKETIZER_VIEWS 8
+
+typedef struct packetizer_shared_t packetizer_shared_t;
+
+typedef struct
+{
+    block_t self;
+    packetizer_shared_t *p_shared;
+    unsigned i_slot; /* PACKETIZER_VIEWS if allocated */
+} packetizer_view_t;
+
+struct packetizer_shared_t
+{
+    block_t self;
+    block_t *p_source;
+    atomic_uint refs;
+    /* Views are only taken by the packetizer, but can be released from
+     * any thread */
+    atomic_uint free_views;
+    packetizer_view_t views[PACKETIZER_VIEWS];
+};
+
+static inline void packetizer_SharedRelease( packetizer_shared_t *p_shared )
+{
+    if( atomic_fetch_sub( &p_shared->refs, 1 ) == 1 )
+    {
+        block_Release( p_shared->p_source );
+        free( p_shared );
+    }
+}
+
+static inline void packetizer_OwnerRelease( block_t *p_block )
+{
+    packetizer_SharedRelease( container_of( p_block, packetizer_shared_t, self ) );
+}
+
+static inline void packetizer_ViewRelease( block_t *p_block )
+{
+    packetizer_view_t *p_view = container_of( p_block, packetizer_view_t, self );
+    packetizer_shared_t *p_shared = p_view->p_shared;
+
+    if( p_view->i_slot < PACKETIZER_VIEWS )
+        atomic_fetch_or( &p_shared->free_views, 1u << p_view->i_slot );
+    else
+        free( p_view );
+    packetizer_SharedRelease( p_shared );
+}
+
+static inline block_t *packetizer_WrapBlock( block_t *p_block )
+{
+    if( p_block->pf_release == packetizer_OwnerRelease || p_block->p_next )
+        return p_block;
+
+    packetizer_shared_t *p_shared = malloc( sizeof(*p_shared) );
+    if( unlikely(p_shared == NULL) )
+        return p_block;
+
+    block_Init( &p_shared->self, p_block->p_buffer, p_block->i_buffer );
+    block_CopyProperties( &p_shared->self, p_block );
+    p_shared->self.pf_release = packetizer_OwnerRelease;
+    p_shared->p_source = p_block;
+    atomic_init( &p_shared->refs, 1 );
+    atomic_init( &p_shared->free_views, (1u << PACKETIZER_VIEWS) - 1 );
+    return &p_shared->self;
+}
+
+/* The view can't grow in place, as it is bounded to its own payload.
+ * Any realloc will then copy, leaving neighbour data untouched. */
+static inline block_t *packetizer_ViewBlock( block_t *p_owner, uint8_t *p_data, size_t i_size )
+{
+    packetizer_shared_t *p_shared = container_of( p_owner, packetizer_shared_t, self );
+    packetizer_view_t *p_view;
+    unsigned i_free = atomic_load( &p_shared->free_views );
+
+    if( i_free != 0 )
+    {
+        unsigned i_slot = ctz( i_free );
+        atomic_fetch_and( &p_shared->free_views, ~(1u << i_slot) );
+        p_view = &p_shared->views[i_slot];
+        p_view->i_slot = i_slot;
+    }
+    else
+    {
+        p_view = malloc( sizeof(*p_view) );
+        if( unlikely(p_view == NULL) )
+            return NULL;
+        p_view->i_slot = PACKETIZER_VIEWS;
+    }
+
+    block_Init( &p_view->self, p_data, i_size );
+    p_view->self.pf_release = packetizer_ViewRelease;
+    p_view->p_shared = p_shared;
+    atomic_fetch_add( &p_shared->refs, 1 );
+    return &p_view->self;
+}
+
+/* Tells if p_next can extend the view p_prev: both must view the same input
+ * block, p_next ending past p_prev, and any byte in between or shared by
+ * both (trimmed trailing zeros, reused prepend) must be zero. */
+static inline bool packetizer_ViewsAdjacent( const block_t *p_prev, const block_t *p_next )
+{
+    if( p_prev->pf_release != packetizer_ViewRelease ||
+        p_next->pf_release != packetizer_ViewRelease ||
+        container_of( p_prev, packetizer_view_t, self )->p_shared !=
+        container_of( p_next, packetizer_view_t, self )->p_shared )
+        return false;
+
+    const uint8_t *p_end = &p_prev->p_buffer[p_prev->i_buffer];
+    if( p_next->p_buffer < p_prev->p_buffer ||
+        &p_next->p_buffer[p_next->i_buffer] < p_end )
+        return false;
+
+    const uint8_t *p = __MIN( p_end, p_next->p_buffer );
+    const uint8_t *p_stop = __MAX( p_end, p_next->p_buffer );
+    for( ; p < p_stop; p++ )
+        if( *p )
+            return false;
+    return true;
+}
+
+/* Extends the view p_prev up to the end of p_next, and releases p_next */
+static inline void packetizer_ViewsMerge( block_t *p_prev, block_t *p_next )
+{
+    const uint8_t *p_end = &p_next->p_buffer[p_next->i_buffer];
+
+    p_prev->i_buffer = p_end - p_prev->p_buffer;
+    /* Keep the view within its own bounds, as block_TryRealloc() expects */
+    p_prev->i_size = p_end - p_prev->p_start;
+    p_prev->i_length += p_next->i_length;
+    block_Release( p_next );
+}
+
+/* Appends a fragment to a chain as block_ChainLastAppend() does, but merges
+ * it into the last one when both are adjacent views. */
+static inline void packetizer_ChainLastAppend( block_t *p_head, block_t ***ppp_last,
+                                               block_t *p_block )
+{
+    if( p_head != NULL && p_block->p_next == NULL )
+    {
+        block_t *p_last = container_of( *ppp_last, block_t, p_next );
+        if( packetizer_ViewsAdjacent( p_last, p_block ) )
+        {
+            packetizer_ViewsMerge( p_last, p_block );
+            return;
+        }
+    }
+    block_ChainLastAppend( ppp_last, p_block );
+}
+
+/* Gathers a chain as block_ChainGather() does, without copying when the
+ * chain only holds adjacent views of the same input block. */
+static inline block_t *packetizer_ChainGather( block_t *p_list )
+{
+    if( p_list == NULL )
+        return NULL;
+
+    for( const block_t *p = p_list; p->p_next; p = p->p_next )
+        if( !packetizer_ViewsAdjacent( p, p->p_next ) )
+            return block_ChainGather( p_list );
+
+    while( p_list->p_next )
+    {
+        block_t *p_next = p_list->p_next;
+        p_list->p_next = p_next->p_next;
+        packetizer_ViewsMerge( p_list, p_next );
+    }
+    return p_list;
+}
+
 static inline void packetizer_Init( packetizer_t *p_pack,
                                     const uint8_t *p_startcode, int i_startcode,
                                     block_startcode_helper_t pf_start_helper,
@@ -128,7 +302,7 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
     }
 
     if( p_block )
-        block_BytestreamPush( &p_pack->bytestream, p_block );
+        block_BytestreamPush( &p_pack->bytestream, packetizer_WrapBlock( p_block ) );
 
     for( ;; )
     {
@@ -180,16 +354,38 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
 
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
+            const size_t i_block_offset = p_pack->bytestream.i_block_offset;
+            const size_t i_prepend = p_pack->i_au_prepend;
+            uint8_t *p_frag = &p_block_bytestream->p_buffer[i_block_offset];
+
+            /* Avoid the copy if the fragment doesn't cross input blocks.
+             * The prepend must then already be there, as with 4 bytes
+             * startcodes, and is shared with the previous fragment tail
+             * (which might have been popped already, but is still owned). */
+            p_pic = NULL;
+            if( p_block_bytestream->pf_release == packetizer_OwnerRelease &&
+                p_block_bytestream->i_buffer - i_block_offset >= p_pack->i_offset &&
+                (size_t)(p_frag - p_block_bytestream->p_start) >= i_prepend &&
+                ( i_prepend == 0 ||
+                  !memcmp( p_frag - i_prepend, p_pack->p_au_prepend, i_prepend ) ) )
+            {
+                p_pic = packetizer_ViewBlock( p_block_bytestream, p_frag - i_prepend,
+                                              p_pack->i_offset + i_prepend );
+                if( p_pic )
+                    block_SkipBytes( &p_pack->bytestream, p_pack->i_offset );
+            }
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+            if( p_pic == NULL )
+            {
+                p_pic = block_Alloc( p_pack->i_offset + i_prepend );
+                block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[i_prepend],
+                                p_pic->i_buffer - i_prepend );
+                if( i_prepend > 0 )
+                    memcpy( p_pic->p_buffer, p_pack->p_au_prepend, i_prepend );
+            }
             p_pic->i_pts = p_block_bytestream->i_pts;
             p_pic->i_dts = p_block_bytestream->i_dts;
 
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
-
             p_pack->i_offset = 0;
 
             /* Parse the NAL */
@@ -26,6 +26,15 @@
    #include <emmintrin.h>
 #endif
 
+#ifdef HAVE_AVX2_INTRINSICS
+   #include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+   #include <arm_neon.h>
+   #define STARTCODE_HAVE_NEON
+#endif
+
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
 
@@ -140,16 +149,83 @@ static inline const uint8_t * startcode_FindAnnexB_Bits( const uint8_t *p, const
 }
 #undef TRY_MATCH
 
-#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+#ifdef HAVE_AVX2_INTRINSICS
+
+/* Matches 00 00 01 on 32 positions at once, comparing the shifted loads. */
+__attribute__ ((__target__ ("avx2")))
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi8( 0x01 );
+
+    for( ; end - p >= 32 + 2; p += 32 )
+    {
+        __m256i v0 = _mm256_loadu_si256( (const __m256i *) &p[0] );
+        __m256i v1 = _mm256_loadu_si256( (const __m256i *) &p[1] );
+        __m256i v2 = _mm256_loadu_si256( (const __m256i *) &p[2] );
+        __m256i res = _mm256_and_si256( _mm256_cmpeq_epi8( v0, zeros ),
+                                        _mm256_cmpeq_epi8( v1, zeros ) );
+        res = _mm256_and_si256( res, _mm256_cmpeq_epi8( v2, ones ) );
+        unsigned match = (unsigned) _mm256_movemask_epi8( res );
+        if( match )
+            return p + ctz( match );
+    }
+
+    for (end -= 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
+#ifdef STARTCODE_HAVE_NEON
+
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    const uint8x16_t ones = vdupq_n_u8( 0x01 );
+
+    for( ; end - p >= 16 + 2; p += 16 )
+    {
+        uint8x16_t res = vandq_u8( vceqq_u8( vld1q_u8( &p[0] ), zeros ),
+                                   vceqq_u8( vld1q_u8( &p[1] ), zeros ) );
+        res = vandq_u8( res, vceqq_u8( vld1q_u8( &p[2] ), ones ) );
+        uint64x2_t res64 = vreinterpretq_u64_u8( res );
+        if( vgetq_lane_u64( res64, 0 ) | vgetq_lane_u64( res64, 1 ) )
+            break; /* lookup exact position below */
+    }
+
+    for (end -= 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
 static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
 {
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
     if (vlc_CPU_SSE2())
         return startcode_FindAnnexB_SSE2(p, end);
-    else
-        return startcode_FindAnnexB_Bits(p, end);
-}
-#else
-    #define startcode_FindAnnexB startcode_FindAnnexB_Bits
 #endif
+#if defined(STARTCODE_HAVE_NEON) && defined(__aarch64__)
+    if (vlc_CPU_ARM64_NEON())
+        return startcode_FindAnnexB_NEON(p, end);
+#elif defined(STARTCODE_HAVE_NEON)
+    if (vlc_CPU_ARM_NEON())
+        return startcode_FindAnnexB_NEON(p, end);
+#endif
+    return startcode_FindAnnexB_Bits(p, end);
+}
 
 #endif
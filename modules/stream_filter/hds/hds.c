@@ -50,6 +50,9 @@ typedef struct chunk_s
     uint8_t     *data;
     bool        failed;
     bool        eof;
+    bool        downloading; /* claimed by a download thread */
+    unsigned    retries;     /* failed downloads */
+    mtime_t     retry_date;  /* not downloaded again before */
 } chunk_t;
 
 typedef struct segment_run_s
@@ -71,7 +74,6 @@ typedef struct hds_stream_s
     /* linked-list of chunks */
     chunk_t        *chunks_head;
     chunk_t        *chunks_livereadpos;
-    chunk_t        *chunks_downloadpos;
 
     char*          quality_segment_modifier;
 
@@ -117,6 +119,15 @@ typedef struct hds_stream_s
     uint32_t       fragment_run_count;
 } hds_stream_t;
 
+/* Number of fragments downloaded in parallel, so that the link does not
+ * stay idle for a round trip between fragments */
+#define HDS_DOWNLOAD_THREADS 3
+
+/* Delay before downloading a failed fragment again, doubled on each
+ * failure up to the maximum */
+#define HDS_RETRY_DELAY     (CLOCK_FREQ / 2)
+#define HDS_RETRY_DELAY_MAX (8 * CLOCK_FREQ)
+
 /* this is effectively just a sanity check  mechanism */
 #define MAX_REQUEST_SIZE (50*1024*1024)
 
@@ -126,7 +137,8 @@ typedef struct
 {
     char         *base_url;    /* URL common part for chunks */
     vlc_thread_t live_thread;
-    vlc_thread_t dl_thread;
+    vlc_thread_t dl_threads[HDS_DOWNLOAD_THREADS];
+    unsigned     dl_thread_count;
 
     /* we pend on peek until some number of segments arrives; otherwise
      * the downstream system dies in case of playback */
@@ -201,6 +213,7 @@ static unsigned char amf_object_end[] = { 0x0, 0x0, 0x9 };
  *****************************************************************************/
 static int  Open( vlc_object_t * );
 static void Close( vlc_object_t * );
+static void StopDownloads( stream_sys_t * );
 
 vlc_module_begin()
     set_category( CAT_INPUT )
@@ -849,6 +862,28 @@ static uint8_t* download_chunk( stream_t *s,
     return data;
 }
 
+/* First chunk neither downloaded nor being downloaded, and not waiting
+ * for a retry. Otherwise, *pi_retry is set to the earliest retry date, if
+ * any. Called with dl_lock held, as the read and live threads update the
+ * chunk list with it. */
+static chunk_t* next_download_chunk( hds_stream_t* hds_stream,
+                                     mtime_t *pi_retry )
+{
+    const mtime_t now = mdate();
+
+    *pi_retry = VLC_TS_INVALID;
+    for( chunk_t* chunk = hds_stream->chunks_head; chunk; chunk = chunk->next )
+    {
+        if( chunk->data || chunk->downloading )
+            continue;
+        if( chunk->retry_date <= now )
+            return chunk;
+        if( *pi_retry == VLC_TS_INVALID || chunk->retry_date < *pi_retry )
+            *pi_retry = chunk->retry_date;
+    }
+    return NULL;
+}
+
 static void* download_thread( void* p )
 {
     vlc_object_t* p_this = (vlc_object_t*)p;
@@ -867,46 +902,61 @@ static void* download_thread( void* p )
 
     while( ! sys->closed )
     {
-        if( ! hds_stream->chunks_downloadpos )
+        /* The threads claim the chunks in order, and download them
+         * outside of the lock, so that the next ones are fetched while the
+         * first is still in flight */
+        mtime_t retry;
+        chunk_t *chunk = next_download_chunk( hds_stream, &retry );
+        if( ! chunk )
         {
-            chunk_t* chunk = hds_stream->chunks_head;
-            while(chunk && chunk->data )
-            {
-                chunk = chunk->next;
-            }
-
-            if( chunk && ! chunk->data )
-                hds_stream->chunks_downloadpos = chunk;
+            if( retry != VLC_TS_INVALID )
+                vlc_cond_timedwait( & hds_stream->dl_cond,
+                                    & hds_stream->dl_lock, retry );
+            else
+                vlc_cond_wait( & hds_stream->dl_cond,
+                               & hds_stream->dl_lock );
+            continue;
         }
+        chunk->downloading = true;
+        vlc_mutex_unlock( & hds_stream->dl_lock );
 
-        while( hds_stream->chunks_downloadpos )
-        {
-            chunk_t *chunk = hds_stream->chunks_downloadpos;
-
-            uint8_t *data = download_chunk( (stream_t*)p_this,
-                                            sys,
-                                            hds_stream,
-                                            chunk );
+        uint8_t *data = download_chunk( (stream_t*)p_this,
+                                        sys,
+                                        hds_stream,
+                                        chunk );
 
-            if( ! chunk->failed )
-            {
-                chunk->mdat_len =
-                    find_chunk_mdat( p_this,
-                                     data,
-                                     data + chunk->data_len,
-                                     & chunk->mdat_data );
-                if( chunk->mdat_len == 0 ) {
-                    chunk->mdat_len = chunk->data_len - (chunk->mdat_data - data);
-                }
-                hds_stream->chunks_downloadpos = chunk->next;
-                chunk->data = data;
-
-                sys->chunk_count++;
+        if( data && ! chunk->failed )
+        {
+            chunk->mdat_len =
+                find_chunk_mdat( p_this,
+                                 data,
+                                 data + chunk->data_len,
+                                 & chunk->mdat_data );
+            if( chunk->mdat_len == 0 ) {
+                chunk->mdat_len = chunk->data_len - (chunk->mdat_data - data);
             }
         }
 
-        vlc_cond_wait( & hds_stream->dl_cond,
-                       & hds_stream->dl_lock );
+        vlc_mutex_lock( & hds_stream->dl_lock );
+        chunk->downloading = false;
+        if( data && ! chunk->failed )
+        {
+            chunk->data = data;
+            sys->chunk_count++;
+        }
+        else
+        {
+            /* retried later by the next free thread */
+            free( data );
+            unsigned shift = chunk->retries < 4 ? chunk->retries : 4;
+            mtime_t delay = HDS_RETRY_DELAY << shift;
+            if( delay > HDS_RETRY_DELAY_MAX )
+                delay = HDS_RETRY_DELAY_MAX;
+            chunk->retries++;
+            chunk->retry_date = mdate() + delay;
+            msg_Warn( s, "fragment %u retried in %"PRId64" ms",
+                      chunk->frag_num, delay / 1000 );
+        }
     }
 
     vlc_mutex_unlock( & hds_stream->dl_lock );
@@ -1049,6 +1099,9 @@ static void maintain_live_chunks(
     hds_stream_t* hds_stream
     )
 {
+    /* The download threads walk the chunks with the lock */
+    vlc_mutex_lock( & hds_stream->dl_lock );
+
     if( ! hds_stream->chunks_head )
     {
         /* just start with the earliest in the abst
@@ -1079,7 +1132,7 @@ static void maintain_live_chunks(
     }
 
     if( dl )
-        vlc_cond_signal( & hds_stream->dl_cond );
+        vlc_cond_broadcast( & hds_stream->dl_cond );
 
     chunk = hds_stream->chunks_head;
     while( chunk && chunk->data && chunk->mdat_pos >= chunk->mdat_len && chunk->next )
@@ -1093,6 +1146,8 @@ static void maintain_live_chunks(
         hds_stream->chunks_livereadpos = hds_stream->chunks_head;
 
     hds_stream->chunks_head = chunk;
+
+    vlc_mutex_unlock( & hds_stream->dl_lock );
 }
 
 
@@ -1694,7 +1749,14 @@ static int Open( vlc_object_t *p_this )
     s->pf_seek = NULL;
     s->pf_control = Control;
 
-    if( vlc_clone( &p_sys->dl_thread, download_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
+    for( unsigned i = 0; i < HDS_DOWNLOAD_THREADS; i++ )
+    {
+        if( vlc_clone( &p_sys->dl_threads[i], download_thread, s,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        p_sys->dl_thread_count++;
+    }
+    if( p_sys->dl_thread_count == 0 )
     {
         goto error;
     }
@@ -1704,6 +1766,7 @@ static int Open( vlc_object_t *p_this )
 
         if( vlc_clone( &p_sys->live_thread, live_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
         {
+            StopDownloads( p_sys );
             goto error;
         }
     }
@@ -1716,20 +1779,31 @@ error:
     return VLC_EGENERIC;
 }
 
-static void Close( vlc_object_t *p_this )
+static void StopDownloads( stream_sys_t *p_sys )
 {
-    stream_t *s = (stream_t*)p_this;
-    stream_sys_t *p_sys = s->p_sys;
-
     // TODO: Change here for selectable stream
     hds_stream_t *stream = vlc_array_count(&p_sys->hds_streams) ?
         p_sys->hds_streams.pp_elems[0] : NULL;
 
+    if (stream)
+        vlc_mutex_lock( & stream->dl_lock );
     p_sys->closed = true;
     if (stream)
-        vlc_cond_signal( & stream->dl_cond );
+    {
+        vlc_cond_broadcast( & stream->dl_cond );
+        vlc_mutex_unlock( & stream->dl_lock );
+    }
 
-    vlc_join( p_sys->dl_thread, NULL );
+    for( unsigned i = 0; i < p_sys->dl_thread_count; i++ )
+        vlc_join( p_sys->dl_threads[i], NULL );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    stream_t *s = (stream_t*)p_this;
+    stream_sys_t *p_sys = s->p_sys;
+
+    StopDownloads( p_sys );
 
     if( p_sys->live )
     {
@@ -1768,12 +1842,18 @@ static unsigned read_chunk_data(
 {
     stream_t* s = (stream_t*) p_this;
     stream_sys_t* sys = s->p_sys;
-    chunk_t* chunk = stream->chunks_head;
     uint8_t* buffer_start = buffer;
     bool dl = false;
 
+    /* The download threads walk the chunks with the lock */
+    vlc_mutex_lock( & stream->dl_lock );
+
+    chunk_t* chunk = stream->chunks_head;
     if( chunk && chunk->eof && chunk->mdat_pos >= chunk->mdat_len )
+    {
+        vlc_mutex_unlock( & stream->dl_lock );
         return 0;
+    }
 
     while( chunk && chunk->data && read_len > 0 && ! (chunk->eof && chunk->mdat_pos >= chunk->mdat_len ) )
     {
@@ -1849,9 +1929,11 @@ static unsigned read_chunk_data(
         }
 
         if( dl )
-            vlc_cond_signal( & stream->dl_cond );
+            vlc_cond_broadcast( & stream->dl_cond );
     }
 
+    vlc_mutex_unlock( & stream->dl_lock );
+
     return ( ((uint8_t*)buffer) - ((uint8_t*)buffer_start));
 }
 
@@ -35,6 +35,8 @@
 #include <vlc_mouse.h>
 #include <vlc_picture.h>
 
+#include <limits.h>
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -56,10 +58,10 @@ vlc_module_end ()
  *****************************************************************************/
 static picture_t *Chain         ( filter_t *, picture_t * );
 
-static int BuildTransformChain( filter_t *p_filter );
-static int BuildChromaResize( filter_t * );
-static int BuildChromaChain( filter_t *p_filter );
-static int BuildFilterChain( filter_t *p_filter );
+static int BuildTransformChain( filter_t *p_filter, unsigned * );
+static int BuildChromaResize( filter_t *, unsigned * );
+static int BuildChromaChain( filter_t *p_filter, unsigned * );
+static int BuildFilterChain( filter_t *p_filter, unsigned * );
 
 static int CreateChain( filter_t *p_parent, const es_format_t *p_fmt_mid );
 static int CreateResizeChromaChain( filter_t *p_parent, const es_format_t *p_fmt_mid );
@@ -115,6 +117,9 @@ typedef struct
 {
     filter_chain_t *p_chain;
     filter_t *p_video_filter;
+    unsigned i_steps; /* number of chained filters */
+    es_format_t fmt_in; /* input of the chain: the visible area if b_crop */
+    bool b_crop;
 } filter_sys_t;
 
 /* Restart filter callback */
@@ -140,12 +145,199 @@ static picture_t *BufferNew( filter_t *p_filter )
 
 #define CHAIN_LEVEL_MAX 2
 
+/*****************************************************************************
+ * Cropping
+ *****************************************************************************
+ * The chain only converts the visible area: it is given views of it (see
+ * picture_NewView()), so that neither the converters nor the intermediate
+ * pictures spend time on the cropped pixels.
+ *****************************************************************************/
+static bool CanCrop( const video_format_t *p_fmt )
+{
+    if( p_fmt->i_x_offset == 0 && p_fmt->i_y_offset == 0 &&
+        p_fmt->i_visible_width == p_fmt->i_width &&
+        p_fmt->i_visible_height == p_fmt->i_height )
+        return false; /* nothing to crop */
+    if( p_fmt->i_visible_width == 0 || p_fmt->i_visible_height == 0 )
+        return false;
+
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_fmt->i_chroma );
+    if( p_dsc == NULL || p_dsc->plane_count == 0 )
+        return false; /* opaque pictures */
+
+    /* Packed 4:2:2 macropixels cannot be split */
+    if( p_dsc->plane_count == 1 && p_dsc->pixel_size == 2 &&
+        vlc_fourcc_IsYUV( p_fmt->i_chroma ) && ( p_fmt->i_x_offset % 2 ) )
+        return false;
+
+    /* The visible area must start on a sample of every plane */
+    for( unsigned i = 0; i < p_dsc->plane_count; i++ )
+        if( ( p_fmt->i_x_offset * p_dsc->p[i].w.num ) % p_dsc->p[i].w.den ||
+            ( p_fmt->i_y_offset * p_dsc->p[i].h.num ) % p_dsc->p[i].h.den )
+            return false;
+    return true;
+}
+
+static picture_t *Crop( filter_t *p_filter, picture_t *p_pic )
+{
+    const video_format_t *p_fmt = &p_filter->fmt_in.video;
+    picture_t *p_view = picture_NewView( p_pic, p_fmt->i_x_offset,
+                                         p_fmt->i_y_offset,
+                                         p_fmt->i_visible_width,
+                                         p_fmt->i_visible_height, false );
+    if( p_view == NULL )
+        msg_Err( p_filter, "cannot crop picture" );
+    else
+        picture_CopyProperties( p_view, p_pic );
+    picture_Release( p_pic );
+    return p_view;
+}
+
+/*****************************************************************************
+ * Resolved chains cache
+ *****************************************************************************
+ * Each builder tries a list of chains (middle chromas or steps order), and
+ * loading the modules of the failing ones is costly. The successful attempt
+ * is remembered per builder, formats and filter name, and tried first next
+ * time. The cache has a fixed number of entries: the least recently used one
+ * is replaced, and an entry is dropped when its chain cannot be built
+ * anymore.
+ *****************************************************************************/
+#define CHAIN_CACHE_SIZE 16
+#define CHAIN_ATTEMPT_NONE UINT_MAX
+#define CHAIN_NAME_MAX 32
+
+typedef struct
+{
+    int (*pf_build)( filter_t *, unsigned * );
+    video_format_t fmt_in, fmt_out;
+    char psz_name[CHAIN_NAME_MAX]; /* filter of BuildFilterChain */
+    bool b_allow_fmt_out_change;
+} chain_key_t;
+
+static struct
+{
+    vlc_mutex_t lock;
+    uint64_t i_tick; /* last use counter */
+    struct
+    {
+        chain_key_t key;
+        unsigned i_attempt;
+        uint64_t i_used; /* 0 if the entry is free */
+    } entries[CHAIN_CACHE_SIZE];
+} chain_cache = { .lock = VLC_STATIC_MUTEX };
+
+/* Anything a converter may depend on is part of the key */
+static bool FormatEqual( const video_format_t *p_a, const video_format_t *p_b )
+{
+    return video_format_IsSimilar( p_a, p_b )
+        && p_a->primaries == p_b->primaries
+        && p_a->transfer == p_b->transfer
+        && p_a->space == p_b->space
+        && p_a->b_color_range_full == p_b->b_color_range_full
+        && p_a->chroma_location == p_b->chroma_location;
+}
+
+static bool ChainKeyInit( chain_key_t *p_key, filter_t *p_filter,
+                          int (*pf_build)( filter_t *, unsigned * ) )
+{
+    const char *psz_name = pf_build == BuildFilterChain
+                         ? p_filter->psz_name : NULL;
+
+    /* Palettes and long names are not worth the key space: not cached */
+    if( p_filter->fmt_in.video.p_palette != NULL
+     || p_filter->fmt_out.video.p_palette != NULL
+     || ( psz_name != NULL && strlen( psz_name ) >= CHAIN_NAME_MAX ) )
+        return false;
+
+    p_key->pf_build = pf_build;
+    p_key->fmt_in = p_filter->fmt_in.video;
+    p_key->fmt_out = p_filter->fmt_out.video;
+    strcpy( p_key->psz_name, psz_name != NULL ? psz_name : "" );
+    p_key->b_allow_fmt_out_change = p_filter->b_allow_fmt_out_change;
+    return true;
+}
+
+static bool ChainKeyEqual( const chain_key_t *p_a, const chain_key_t *p_b )
+{
+    return p_a->pf_build == p_b->pf_build
+        && p_a->b_allow_fmt_out_change == p_b->b_allow_fmt_out_change
+        && !strcmp( p_a->psz_name, p_b->psz_name )
+        && FormatEqual( &p_a->fmt_in, &p_b->fmt_in )
+        && FormatEqual( &p_a->fmt_out, &p_b->fmt_out );
+}
+
+/* Must be called with the cache lock held */
+static int ChainCacheFind( const chain_key_t *p_key )
+{
+    for( unsigned i = 0; i < CHAIN_CACHE_SIZE; i++ )
+        if( chain_cache.entries[i].i_used != 0
+         && ChainKeyEqual( &chain_cache.entries[i].key, p_key ) )
+            return i;
+    return -1;
+}
+
+static unsigned ChainCacheGet( const chain_key_t *p_key )
+{
+    unsigned i_attempt = CHAIN_ATTEMPT_NONE;
+
+    vlc_mutex_lock( &chain_cache.lock );
+    int i = ChainCacheFind( p_key );
+    if( i >= 0 )
+    {
+        i_attempt = chain_cache.entries[i].i_attempt;
+        chain_cache.entries[i].i_used = ++chain_cache.i_tick;
+    }
+    vlc_mutex_unlock( &chain_cache.lock );
+    return i_attempt;
+}
+
+static void ChainCachePut( const chain_key_t *p_key, unsigned i_attempt )
+{
+    vlc_mutex_lock( &chain_cache.lock );
+    int i = ChainCacheFind( p_key );
+    if( i < 0 )
+    {
+        /* Replace a free entry, or the least recently used one */
+        i = 0;
+        for( unsigned j = 1; j < CHAIN_CACHE_SIZE; j++ )
+            if( chain_cache.entries[j].i_used < chain_cache.entries[i].i_used )
+                i = j;
+        chain_cache.entries[i].key = *p_key;
+    }
+    chain_cache.entries[i].i_attempt = i_attempt;
+    chain_cache.entries[i].i_used = ++chain_cache.i_tick;
+    vlc_mutex_unlock( &chain_cache.lock );
+}
+
+static void ChainCacheDrop( const chain_key_t *p_key )
+{
+    vlc_mutex_lock( &chain_cache.lock );
+    int i = ChainCacheFind( p_key );
+    if( i >= 0 )
+        chain_cache.entries[i].i_used = 0;
+    vlc_mutex_unlock( &chain_cache.lock );
+}
+
+/* Index of the n-th of i_count attempts of a builder: the cached one goes
+ * first */
+static unsigned AttemptIndex( unsigned n, unsigned i_count, unsigned i_cached )
+{
+    if( i_cached >= i_count )
+        return n;
+    if( n == 0 )
+        return i_cached;
+    return ( n - 1 < i_cached ) ? n - 1 : n;
+}
+
 /*****************************************************************************
  * Activate: allocate a chroma function
  *****************************************************************************
  * This function allocates and initializes a chroma function
  *****************************************************************************/
-static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
+static int Activate( filter_t *p_filter,
+                     int (*pf_build)( filter_t *, unsigned * ) )
 {
     filter_sys_t *p_sys;
     int i_ret = VLC_EGENERIC;
@@ -168,6 +360,18 @@ static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
         return VLC_EGENERIC;
     }
 
+    /* Video filters keep their whole pictures: only converters crop */
+    es_format_Copy( &p_sys->fmt_in, &p_filter->fmt_in );
+    if( pf_build != BuildFilterChain && CanCrop( &p_filter->fmt_in.video ) )
+    {
+        video_format_t *p_fmt = &p_sys->fmt_in.video;
+
+        p_fmt->i_width = p_fmt->i_visible_width;
+        p_fmt->i_height = p_fmt->i_visible_height;
+        p_fmt->i_x_offset = p_fmt->i_y_offset = 0;
+        p_sys->b_crop = true;
+    }
+
     int type = VLC_VAR_INTEGER;
     if( var_Type( p_filter->obj.parent, "chain-level" ) != 0 )
         type |= VLC_VAR_DOINHERIT;
@@ -180,7 +384,18 @@ static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
     if( level < 0 || level > CHAIN_LEVEL_MAX )
         msg_Err( p_filter, "Too high level of recursion (%d)", level );
     else
-        i_ret = pf_build( p_filter );
+    {
+        chain_key_t key;
+        const bool b_cache = ChainKeyInit( &key, p_filter, pf_build );
+
+        unsigned i_attempt = b_cache ? ChainCacheGet( &key )
+                                     : CHAIN_ATTEMPT_NONE;
+        i_ret = pf_build( p_filter, &i_attempt );
+        if( b_cache && i_ret == VLC_SUCCESS )
+            ChainCachePut( &key, i_attempt );
+        else if( b_cache )
+            ChainCacheDrop( &key );
+    }
 
     var_Destroy( p_filter, "chain-level" );
 
@@ -191,6 +406,7 @@ static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
             filter_DelProxyCallbacks( p_filter, p_sys->p_video_filter,
                                       RestartFilterCallback );
         filter_chain_Delete( p_sys->p_chain );
+        es_format_Clean( &p_sys->fmt_in );
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -200,6 +416,13 @@ static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
         es_format_Copy( &p_filter->fmt_out,
                         filter_chain_GetFmtOut( p_sys->p_chain ) );
     }
+    /* Nested chains report their own intermediate pictures. The owner can
+     * read the number of steps from the "chain-steps" variable. */
+    msg_Dbg( p_filter, "%u filters chained, %u intermediate picture(s) per "
+             "frame%s", p_sys->i_steps, p_sys->i_steps - 1,
+             p_sys->b_crop ? ", cropped input" : "" );
+    var_Create( p_filter, "chain-steps", VLC_VAR_INTEGER );
+    var_SetInteger( p_filter, "chain-steps", p_sys->i_steps );
     /* */
     p_filter->pf_video_filter = Chain;
     return VLC_SUCCESS;
@@ -249,7 +472,9 @@ static void Destroy( vlc_object_t *p_this )
     if (p_sys->p_video_filter)
         filter_DelProxyCallbacks( p_filter, p_sys->p_video_filter,
                                   RestartFilterCallback );
+    var_Destroy( p_filter, "chain-steps" );
     filter_chain_Delete( p_sys->p_chain );
+    es_format_Clean( &p_sys->fmt_in );
     free( p_sys );
 }
 
@@ -259,6 +484,13 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Chain( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_crop )
+    {
+        p_pic = Crop( p_filter, p_pic );
+        if( p_pic == NULL )
+            return NULL;
+    }
     return filter_chain_VideoFilter( p_sys->p_chain, p_pic );
 }
 
@@ -266,75 +498,103 @@ static picture_t *Chain( filter_t *p_filter, picture_t *p_pic )
  * Builders
  *****************************************************************************/
 
-static int BuildTransformChain( filter_t *p_filter )
+static int BuildTransformChain( filter_t *p_filter, unsigned *pi_attempt )
 {
-
+    filter_sys_t *p_sys = p_filter->p_sys;
     es_format_t fmt_mid;
-    int i_ret;
-
-    /* Lets try transform first, then (potentially) resize+chroma */
-    msg_Dbg( p_filter, "Trying to build transform, then chroma+resize" );
-    es_format_Copy( &fmt_mid, &p_filter->fmt_in );
-    video_format_TransformTo(&fmt_mid.video, p_filter->fmt_out.video.orientation);
-    i_ret = CreateChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
-
-    /* Lets try resize+chroma first, then transform */
-    msg_Dbg( p_filter, "Trying to build chroma+resize" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
-    i_ret = CreateChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
+    const unsigned i_cached = *pi_attempt;
+
+    for( unsigned n = 0; n < 2; n++ )
+    {
+        const unsigned i = AttemptIndex( n, 2, i_cached );
+        int i_ret;
+
+        if( i == 0 )
+        {
+            /* Lets try transform first, then (potentially) resize+chroma */
+            msg_Dbg( p_filter, "Trying to build transform, then chroma+resize" );
+            es_format_Copy( &fmt_mid, &p_sys->fmt_in );
+            video_format_TransformTo(&fmt_mid.video, p_filter->fmt_out.video.orientation);
+        }
+        else
+        {
+            /* Lets try resize+chroma first, then transform */
+            msg_Dbg( p_filter, "Trying to build chroma+resize" );
+            EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_sys->fmt_in );
+        }
+        i_ret = CreateChain( p_filter, &fmt_mid );
+        es_format_Clean( &fmt_mid );
+        if( i_ret == VLC_SUCCESS )
+        {
+            *pi_attempt = i;
+            return VLC_SUCCESS;
+        }
+    }
 
     return VLC_EGENERIC;
 }
 
-static int BuildChromaResize( filter_t *p_filter )
+static int BuildChromaResize( filter_t *p_filter, unsigned *pi_attempt )
 {
+    filter_sys_t *p_sys = p_filter->p_sys;
     es_format_t fmt_mid;
-    int i_ret;
-
-    /* Lets try resizing and then doing the chroma conversion */
-    msg_Dbg( p_filter, "Trying to build resize+chroma" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
-    i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
+    const unsigned i_cached = *pi_attempt;
 
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
+    for( unsigned n = 0; n < 2; n++ )
+    {
+        const unsigned i = AttemptIndex( n, 2, i_cached );
+        int i_ret;
 
-    /* Lets try it the other way arround (chroma and then resize) */
-    msg_Dbg( p_filter, "Trying to build chroma+resize" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
-    i_ret = CreateChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
+        if( i == 0 )
+        {
+            /* Lets try resizing and then doing the chroma conversion */
+            msg_Dbg( p_filter, "Trying to build resize+chroma" );
+            EsFormatMergeSize( &fmt_mid, &p_sys->fmt_in, &p_filter->fmt_out );
+            i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
+        }
+        else
+        {
+            /* Lets try it the other way arround (chroma and then resize) */
+            msg_Dbg( p_filter, "Trying to build chroma+resize" );
+            EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_sys->fmt_in );
+            i_ret = CreateChain( p_filter, &fmt_mid );
+        }
+        es_format_Clean( &fmt_mid );
+        if( i_ret == VLC_SUCCESS )
+        {
+            *pi_attempt = i;
+            return VLC_SUCCESS;
+        }
+    }
 
     return VLC_EGENERIC;
 }
 
-static int BuildChromaChain( filter_t *p_filter )
+static int BuildChromaChain( filter_t *p_filter, unsigned *pi_attempt )
 {
+    filter_sys_t *p_sys = p_filter->p_sys;
     es_format_t fmt_mid;
     int i_ret = VLC_EGENERIC;
+    const unsigned i_cached = *pi_attempt;
 
     /* Now try chroma format list */
     const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    unsigned i_count = 0;
+    while( pi_allowed_chromas[i_count] )
+        i_count++;
+
+    for( unsigned n = 0; n < i_count; n++ )
     {
+        const unsigned i = AttemptIndex( n, i_count, i_cached );
         const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
-        if( i_chroma == p_filter->fmt_in.i_codec ||
+        if( i_chroma == p_sys->fmt_in.i_codec ||
             i_chroma == p_filter->fmt_out.i_codec )
             continue;
 
         msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man",
                  (char*)&i_chroma );
 
-        es_format_Copy( &fmt_mid, &p_filter->fmt_in );
+        es_format_Copy( &fmt_mid, &p_sys->fmt_in );
         fmt_mid.i_codec        =
         fmt_mid.video.i_chroma = i_chroma;
         fmt_mid.video.i_rmask  = 0;
@@ -346,7 +606,10 @@ static int BuildChromaChain( filter_t *p_filter )
         es_format_Clean( &fmt_mid );
 
         if( i_ret == VLC_SUCCESS )
+        {
+            *pi_attempt = i;
             break;
+        }
     }
 
     return i_ret;
@@ -360,17 +623,23 @@ static int ChainMouse( filter_t *p_filter, vlc_mouse_t *p_mouse,
     return filter_chain_MouseFilter( p_sys->p_chain, p_mouse, p_new );
 }
 
-static int BuildFilterChain( filter_t *p_filter )
+static int BuildFilterChain( filter_t *p_filter, unsigned *pi_attempt )
 {
     es_format_t fmt_mid;
     int i_ret = VLC_EGENERIC;
+    const unsigned i_cached = *pi_attempt;
 
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* Now try chroma format list */
     const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    unsigned i_count = 0;
+    while( pi_allowed_chromas[i_count] )
+        i_count++;
+
+    for( unsigned n = 0; n < i_count; n++ )
     {
+        const unsigned i = AttemptIndex( n, i_count, i_cached );
         filter_chain_Reset( p_sys->p_chain, &p_filter->fmt_in, &p_filter->fmt_out );
 
         const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
@@ -404,6 +673,8 @@ static int BuildFilterChain( filter_t *p_filter )
                 if (p_sys->p_video_filter->pf_video_mouse != NULL)
                     p_filter->pf_video_mouse = ChainMouse;
                 es_format_Clean( &fmt_mid );
+                p_sys->i_steps = 2;
+                *pi_attempt = i;
                 i_ret = VLC_SUCCESS;
                 break;
             }
@@ -422,24 +693,32 @@ static int BuildFilterChain( filter_t *p_filter )
 static int CreateChain( filter_t *p_parent, const es_format_t *p_fmt_mid )
 {
     filter_sys_t *p_sys = p_parent->p_sys;
-    filter_chain_Reset( p_sys->p_chain, &p_parent->fmt_in, &p_parent->fmt_out );
+    filter_chain_Reset( p_sys->p_chain, &p_sys->fmt_in, &p_parent->fmt_out );
 
     filter_t *p_filter;
+    unsigned i_steps = 0;
 
-    if( p_parent->fmt_in.video.orientation != p_fmt_mid->video.orientation)
+    if( p_sys->fmt_in.video.orientation != p_fmt_mid->video.orientation)
     {
-        p_filter = AppendTransform( p_sys->p_chain, &p_parent->fmt_in, p_fmt_mid );
+        p_filter = AppendTransform( p_sys->p_chain, &p_sys->fmt_in, p_fmt_mid );
         // Check if filter was enough:
         if( p_filter == NULL )
             return VLC_EGENERIC;
         if( es_format_IsSimilar(&p_filter->fmt_out, &p_parent->fmt_out ))
-           return VLC_SUCCESS;
+        {
+            p_sys->i_steps = 1;
+            return VLC_SUCCESS;
+        }
+        i_steps++;
     }
-    else
+    /* A middle format similar to one end needs no conversion step: skip it
+     * rather than spending a picture copy on it */
+    else if( !es_format_IsSimilar( &p_sys->fmt_in, p_fmt_mid ) )
     {
         if( filter_chain_AppendConverter( p_sys->p_chain,
                                           NULL, p_fmt_mid ) )
             return VLC_EGENERIC;
+        i_steps++;
     }
 
     if( p_fmt_mid->video.orientation != p_parent->fmt_out.video.orientation)
@@ -447,13 +726,20 @@ static int CreateChain( filter_t *p_parent, const es_format_t *p_fmt_mid )
         if( AppendTransform( p_sys->p_chain, p_fmt_mid,
                              &p_parent->fmt_out ) == NULL )
             goto error;
+        i_steps++;
     }
-    else
+    else if( !es_format_IsSimilar( p_fmt_mid, &p_parent->fmt_out ) )
     {
         if( filter_chain_AppendConverter( p_sys->p_chain,
                                           p_fmt_mid, &p_parent->fmt_out ) )
             goto error;
+        i_steps++;
     }
+
+    /* Nothing left: the formats are not different after all */
+    if( i_steps == 0 )
+        return VLC_EGENERIC;
+    p_sys->i_steps = i_steps;
     return VLC_SUCCESS;
 error:
     //Clean up.
@@ -464,7 +750,7 @@ error:
 static int CreateResizeChromaChain( filter_t *p_parent, const es_format_t *p_fmt_mid )
 {
     filter_sys_t *p_sys = p_parent->p_sys;
-    filter_chain_Reset( p_sys->p_chain, &p_parent->fmt_in, &p_parent->fmt_out );
+    filter_chain_Reset( p_sys->p_chain, &p_sys->fmt_in, &p_parent->fmt_out );
 
     int i_ret = filter_chain_AppendConverter( p_sys->p_chain,
                                               NULL, p_fmt_mid );
@@ -492,6 +778,8 @@ static int CreateResizeChromaChain( filter_t *p_parent, const es_format_t *p_fmt
 
     if( i_ret != VLC_SUCCESS )
         filter_chain_Reset( p_sys->p_chain, NULL, NULL );
+    else
+        p_sys->i_steps = 2;
     return i_ret;
 }
 
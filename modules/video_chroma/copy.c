@@ -33,6 +33,7 @@
 #include <vlc_common.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 #include <assert.h>
 
 #include "copy.h"
@@ -52,11 +53,11 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
 #define ASSERT_3PLANES ASSERT_2PLANES; \
     ASSERT_PLANE(2)
 
-int CopyInitCache(copy_cache_t *cache, unsigned width)
+static int CopyAllocCache(copy_cache_t *cache, unsigned width)
 {
 #ifdef CAN_COMPILE_SSE2
     cache->size = __MAX((width + 0x3f) & ~ 0x3f, 16384);
-    cache->buffer = aligned_alloc(64, cache->size);
+    cache->buffer = aligned_alloc(64, cache->size * cache->bands);
     if (!cache->buffer)
         return VLC_EGENERIC;
 #else
@@ -65,6 +66,21 @@ int CopyInitCache(copy_cache_t *cache, unsigned width)
     return VLC_SUCCESS;
 }
 
+int CopyInitCache(copy_cache_t *cache, unsigned width)
+{
+    cache->obj = NULL;
+    cache->bands = 1;
+    return CopyAllocCache(cache, width);
+}
+
+int CopyInitCacheBands(copy_cache_t *cache, unsigned width, unsigned height,
+                       vlc_object_t *obj)
+{
+    cache->obj = obj;
+    cache->bands = vlc_slices_Count(obj, height);
+    return CopyAllocCache(cache, width);
+}
+
 void CopyCleanCache(copy_cache_t *cache)
 {
 #ifdef CAN_COMPILE_SSE2
@@ -76,6 +92,83 @@ void CopyCleanCache(copy_cache_t *cache)
 #endif
 }
 
+/* Copies the given number of lines of the planes */
+typedef void (*copy_band_cb)(picture_t *dst, const uint8_t *src[],
+                             const size_t src_pitch[], unsigned height,
+                             int bitshift, const copy_cache_t *cache);
+
+struct copy_bands
+{
+    copy_band_cb func;
+    picture_t *dst;
+    const uint8_t **src;
+    const size_t *src_pitch;
+    unsigned src_planes;
+    bool subsampled; /* 4:2:0 chroma planes */
+    unsigned height;
+    int bitshift;
+    const copy_cache_t *cache;
+};
+
+static void CopyBand(void *opaque, unsigned index, unsigned count)
+{
+    const struct copy_bands *job = opaque;
+    unsigned begin, end;
+
+    /* Even boundaries, so that the chroma lines are split too */
+    vlc_slice_Rows(job->height, index, count, 2, &begin, &end);
+    if (begin == end)
+        return;
+
+    /* Only the planes of the picture are used by the band copies */
+    picture_t band = *job->dst;
+    const uint8_t *src[3];
+
+    for (int i = 0; i < band.i_planes; i++)
+    {
+        const unsigned lines = (i > 0 && job->subsampled) ? begin / 2 : begin;
+        band.p[i].p_pixels += lines * band.p[i].i_pitch;
+    }
+    for (unsigned i = 0; i < job->src_planes; i++)
+    {
+        const unsigned lines = (i > 0 && job->subsampled) ? begin / 2 : begin;
+        src[i] = job->src[i] + lines * job->src_pitch[i];
+    }
+
+    copy_cache_t cache = *job->cache;
+#ifdef CAN_COMPILE_SSE2
+    cache.buffer += index * cache.size;
+#endif
+    job->func(&band, src, job->src_pitch, end - begin, job->bitshift, &cache);
+}
+
+static void CopyBands(copy_band_cb func, picture_t *dst,
+                      const uint8_t *src[], const size_t src_pitch[],
+                      unsigned src_planes, bool subsampled, unsigned height,
+                      int bitshift, const copy_cache_t *cache)
+{
+    unsigned count = __MIN(cache->bands, height / VLC_SLICE_MIN_ROWS);
+
+    if (count <= 1)
+    {
+        func(dst, src, src_pitch, height, bitshift, cache);
+        return;
+    }
+
+    struct copy_bands job = {
+        .func = func,
+        .dst = dst,
+        .src = src,
+        .src_pitch = src_pitch,
+        .src_planes = src_planes,
+        .subsampled = subsampled,
+        .height = height,
+        .bitshift = bitshift,
+        .cache = cache,
+    };
+    vlc_slices_Run(cache->obj, count, CopyBand, &job);
+}
+
 #ifdef CAN_COMPILE_SSE2
 /* Copy 16/64 bytes from srcp to dstp loading data with the SSE>=2 instruction
  * load and storing data with the SSE>=2 instruction store.
@@ -131,8 +224,189 @@ void CopyCleanCache(copy_cache_t *cache)
 # define vlc_CPU_SSSE3() (0)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
 #endif
 
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+/* Same as CopyFromUswc(), with 32-byte streaming loads. The 16-bit samples
+ * are shifted by variable counts, a null count leaving them unchanged. */
+VLC_TARGET
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    const __m128i shiftr = _mm_cvtsi32_si128(bitshift > 0 ? bitshift : 0);
+    const __m128i shiftl = _mm_cvtsi32_si128(bitshift < 0 ? -bitshift : 0);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f;
+        unsigned x = 0;
+
+        if (unaligned && width >= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)src);
+            v = _mm256_sll_epi16(_mm256_srl_epi16(v, shiftr), shiftl);
+            _mm256_storeu_si256((__m256i *)dst, v);
+            x = unaligned;
+        }
+        for (; x+63 < width; x += 64) {
+            __m256i a = _mm256_stream_load_si256((const __m256i *)&src[x]);
+            __m256i b = _mm256_stream_load_si256((const __m256i *)&src[x+32]);
+            a = _mm256_sll_epi16(_mm256_srl_epi16(a, shiftr), shiftl);
+            b = _mm256_sll_epi16(_mm256_srl_epi16(b, shiftr), shiftl);
+            _mm256_storeu_si256((__m256i *)&dst[x], a);
+            _mm256_storeu_si256((__m256i *)&dst[x+32], b);
+        }
+        if (x < width)
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift);
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    _mm_mfence();
+}
+
+VLC_TARGET
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (((uintptr_t)dst & 0x1f) == 0) {
+            for (; x+63 < width; x += 64) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_loadu_si256((const __m256i *)&src[x+32]);
+                _mm256_stream_si256((__m256i *)&dst[x], a);
+                _mm256_stream_si256((__m256i *)&dst[x+32], b);
+            }
+        } else {
+            for (; x+63 < width; x += 64) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_loadu_si256((const __m256i *)&src[x+32]);
+                _mm256_storeu_si256((__m256i *)&dst[x], a);
+                _mm256_storeu_si256((__m256i *)&dst[x+32], b);
+            }
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_sfence();
+}
+
+VLC_TARGET
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned width, unsigned height,
+                              uint8_t pixel_size)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x+31 < width; x += 32) {
+            const __m256i u = _mm256_loadu_si256((const __m256i *)&srcu[x]);
+            const __m256i v = _mm256_loadu_si256((const __m256i *)&srcv[x]);
+            __m256i lo, hi;
+
+            if (pixel_size == 1) {
+                lo = _mm256_unpacklo_epi8(u, v);
+                hi = _mm256_unpackhi_epi8(u, v);
+            } else {
+                lo = _mm256_unpacklo_epi16(u, v);
+                hi = _mm256_unpackhi_epi16(u, v);
+            }
+            /* Unpacking works within the lanes: put them back in order */
+            _mm256_storeu_si256((__m256i *)&dst[2*x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2*x+32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+}
+
+VLC_TARGET
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    /* U samples to the low half of each lane, V samples to the high half */
+    const __m256i shuffle = pixel_size == 1
+        ? _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15)
+        : _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                           0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x+31 < width; x += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)&src[2*x]);
+            __m256i b = _mm256_loadu_si256((const __m256i *)&src[2*x+32]);
+
+            a = _mm256_shuffle_epi8(a, shuffle);
+            b = _mm256_shuffle_epi8(b, shuffle);
+
+            /* Gather the halves, then put the lanes back in order */
+            const __m256i u = _mm256_permute4x64_epi64(
+                _mm256_unpacklo_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m256i v = _mm256_permute4x64_epi64(
+                _mm256_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+
+            _mm256_storeu_si256((__m256i *)&dstu[x], u);
+            _mm256_storeu_si256((__m256i *)&dstv[x], v);
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        } else {
+            for (; x < width; x+= 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+#undef VLC_TARGET
+#endif /* HAVE_AVX2_INTRINSICS */
+
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
  * as used by some video surface.
  * XXX It is really efficient only when SSE4.1 is available.
@@ -144,6 +418,12 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)dst & 0x0f) == 0 && (dst_pitch & 0x0f) == 0);
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyFromUswc(dst, dst_pitch, src, src_pitch,
+                                 width, height, bitshift);
+#endif
+
     asm volatile ("mfence");
 
 #define SSE_USWC_COPY(shiftstr16, shiftstr64) \
@@ -197,7 +477,7 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
             SSE_USWC_COPY(COPY16_SHIFTR("$4"), COPY64_SHIFTR("$4"))
             break;
         case -4:
-            SSE_USWC_COPY(COPY16_SHIFTL("$2"), COPY64_SHIFTL("$2"))
+            SSE_USWC_COPY(COPY16_SHIFTL("$4"), COPY64_SHIFTL("$4"))
             break;
         default:
             vlc_assert_unreachable();
@@ -214,6 +494,11 @@ static void Copy2d(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)src & 0x0f) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy2d(dst, dst_pitch, src, src_pitch, width, height);
+#endif
+
     for (unsigned y = 0; y < height; y++) {
         unsigned x = 0;
 
@@ -244,6 +529,12 @@ SSE_InterleaveUV(uint8_t *dst, size_t dst_pitch,
     assert(!((intptr_t)srcu & 0xf) && !(srcu_pitch & 0x0f) &&
            !((intptr_t)srcv & 0xf) && !(srcv_pitch & 0x0f));
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_InterleaveUV(dst, dst_pitch, srcu, srcu_pitch,
+                                 srcv, srcv_pitch, width, height, pixel_size);
+#endif
+
     static const uint8_t shuffle_8[] = { 0, 8,
                                          1, 9,
                                          2, 10,
@@ -359,6 +650,12 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     assert(pixel_size == 1 || pixel_size == 2);
     assert(((intptr_t)src & 0xf) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                            src, src_pitch, width, height, pixel_size);
+#endif
+
 #define LOAD64 \
     "movdqa  0(%[src]), %%xmm0\n" \
     "movdqa 16(%[src]), %%xmm1\n" \
@@ -639,29 +936,38 @@ static void CopyPlane(uint8_t *dst, size_t dst_pitch,
     }
 }
 
-void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
-                unsigned height, const copy_cache_t *cache)
+static void CopyPackedBand(picture_t *dst, const uint8_t *src[],
+                           const size_t src_pitch[], unsigned height,
+                           int bitshift, const copy_cache_t *cache)
 {
-    assert(dst);
-    assert(src); assert(src_pitch);
-    assert(height);
-
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE4_1())
-        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        return SSE_CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
                              cache->buffer, cache->size, height, 0);
 #else
     (void) cache;
 #endif
-        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src, src_pitch,
+        CopyPlane(dst->p[0].p_pixels, dst->p[0].i_pitch, src[0], src_pitch[0],
                   height, 0);
 }
 
-void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
-                      const size_t src_pitch[static 2], unsigned height,
-                      const copy_cache_t *cache)
+void CopyPacked(picture_t *dst, const uint8_t *src, const size_t src_pitch,
+                unsigned height, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    assert(dst);
+    assert(src); assert(src_pitch);
+    assert(height);
+
+    CopyBands(CopyPackedBand, dst, &src, &src_pitch, 1, false, height, 0,
+              cache);
+}
+
+static void Copy420_SP_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                  const size_t src_pitch[], unsigned height,
+                                  int bitshift, const copy_cache_t *cache)
+{
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_SP(dst, src, src_pitch, height, cache);
@@ -675,6 +981,15 @@ void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
               src[1], src_pitch[1], (height+1)/2, 0);
 }
 
+void Copy420_SP_to_SP(picture_t *dst, const uint8_t *src[static 2],
+                      const size_t src_pitch[static 2], unsigned height,
+                      const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    CopyBands(Copy420_SP_to_SP_Band, dst, src, src_pitch, 2, true, height, 0,
+              cache);
+}
+
 #define SPLIT_PLANES(type, pitch_den) do { \
     for (unsigned y = 0; y < height; y++) { \
         for (unsigned x = 0; x < src_pitch / pitch_den; x++) { \
@@ -731,11 +1046,11 @@ static void SplitPlanes16(uint8_t *dstu, size_t dstu_pitch,
         SPLIT_PLANES_SHIFTL(uint16_t, 4, (-bitshift) & 0xf);
 }
 
-void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                     const size_t src_pitch[static 2], unsigned height,
-                     const copy_cache_t *cache)
+static void Copy420_SP_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_2PLANES;
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 1, 0, cache);
@@ -750,13 +1065,19 @@ void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                 src[1], src_pitch[1], (height+1)/2);
 }
 
-void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
-                        const size_t src_pitch[static 2], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                     const size_t src_pitch[static 2], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_2PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(Copy420_SP_to_P_Band, dst, src, src_pitch, 2, true, height, 0,
+              cache);
+}
 
+static void Copy420_16_SP_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                    const size_t src_pitch[], unsigned height,
+                                    int bitshift, const copy_cache_t *cache)
+{
 #ifdef CAN_COMPILE_SSE3
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_SP_to_P(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -771,6 +1092,17 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
                   src[1], src_pitch[1], (height+1)/2, bitshift);
 }
 
+void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
+                        const size_t src_pitch[static 2], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
+{
+    ASSERT_2PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+
+    CopyBands(Copy420_16_SP_to_P_Band, dst, src, src_pitch, 2, true, height,
+              bitshift, cache);
+}
+
 #define INTERLEAVE_UV() do { \
     for ( unsigned int line = 0; line < copy_lines; line++ ) { \
         for ( unsigned int col = 0; col < copy_pitch; col++ ) { \
@@ -807,11 +1139,11 @@ void Copy420_16_SP_to_P(picture_t *dst, const uint8_t *src[static 2],
     } \
 }while(0)
 
-void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                     const size_t src_pitch[static 3], unsigned height,
-                     const copy_cache_t *cache)
+static void Copy420_P_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                 const size_t src_pitch[], unsigned height,
+                                 int bitshift, const copy_cache_t *cache)
 {
-    ASSERT_3PLANES;
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 1, 0, cache);
@@ -835,12 +1167,19 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     INTERLEAVE_UV();
 }
 
-void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
-                        const size_t src_pitch[static 3], unsigned height,
-                        int bitshift, const copy_cache_t *cache)
+void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                     const size_t src_pitch[static 3], unsigned height,
+                     const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
-    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+    CopyBands(Copy420_P_to_SP_Band, dst, src, src_pitch, 3, true, height, 0,
+              cache);
+}
+
+static void Copy420_16_P_to_SP_Band(picture_t *dst, const uint8_t *src[],
+                                    const size_t src_pitch[], unsigned height,
+                                    int bitshift, const copy_cache_t *cache)
+{
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSSE3())
         return SSE_Copy420_P_to_SP(dst, src, src_pitch, height, 2, bitshift, cache);
@@ -870,11 +1209,22 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
         INTERLEAVE_UV_SHIFTL((-bitshift) & 0xf);
 }
 
-void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
-                    const size_t src_pitch[static 3], unsigned height,
-                    const copy_cache_t *cache)
+void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
+                        const size_t src_pitch[static 3], unsigned height,
+                        int bitshift, const copy_cache_t *cache)
 {
     ASSERT_3PLANES;
+    assert(bitshift >= -6 && bitshift <= 6 && (bitshift % 2 == 0));
+
+    CopyBands(Copy420_16_P_to_SP_Band, dst, src, src_pitch, 3, true, height,
+              bitshift, cache);
+}
+
+static void Copy420_P_to_P_Band(picture_t *dst, const uint8_t *src[],
+                                const size_t src_pitch[], unsigned height,
+                                int bitshift, const copy_cache_t *cache)
+{
+    VLC_UNUSED(bitshift);
 #ifdef CAN_COMPILE_SSE2
     if (vlc_CPU_SSE2())
         return SSE_Copy420_P_to_P(dst, src, src_pitch, height, cache);
@@ -890,6 +1240,15 @@ void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
                src[2], src_pitch[2], (height+1) / 2, 0);
 }
 
+void Copy420_P_to_P(picture_t *dst, const uint8_t *src[static 3],
+                    const size_t src_pitch[static 3], unsigned height,
+                    const copy_cache_t *cache)
+{
+    ASSERT_3PLANES;
+    CopyBands(Copy420_P_to_P_Band, dst, src, src_pitch, 3, true, height, 0,
+              cache);
+}
+
 int picture_UpdatePlanes(picture_t *picture, uint8_t *data, unsigned pitch)
 {
     /* fill in buffer info in first plane */
@@ -945,11 +1304,16 @@ int picture_UpdatePlanes(picture_t *picture, uint8_t *data, unsigned pitch)
 #ifdef COPY_TEST
 
 #include <vlc_picture.h>
+#include "../../lib/libvlc_internal.h"
+
+/* Number of conversions of the largest size timed for the benchmark */
+#define BENCH_RUNS 20
 
 struct test_dst
 {
     vlc_fourcc_t chroma;
     int bitshift;
+    const char *name;
     union
     {
         void (*conv)(picture_t *, const uint8_t *[], const size_t [], unsigned,
@@ -965,20 +1329,25 @@ struct test_conv
     struct test_dst dsts[3];
 };
 
+#define CONV(f) #f, .conv = f
+#define CONV16(f) #f, .conv16 = f
+
 static const struct test_conv convs[] = {
     { .src_chroma = VLC_CODEC_NV12,
-      .dsts = { { VLC_CODEC_I420, 0, .conv = Copy420_SP_to_P },
-                { VLC_CODEC_NV12, 0, .conv = Copy420_SP_to_SP } },
+      .dsts = { { VLC_CODEC_I420, 0, CONV(Copy420_SP_to_P) },
+                { VLC_CODEC_NV12, 0, CONV(Copy420_SP_to_SP) } },
     },
     { .src_chroma = VLC_CODEC_I420,
-      .dsts = { { VLC_CODEC_I420, 0, .conv = Copy420_P_to_P },
-                { VLC_CODEC_NV12, 0, .conv = Copy420_P_to_SP } },
+      .dsts = { { VLC_CODEC_I420, 0, CONV(Copy420_P_to_P) },
+                { VLC_CODEC_NV12, 0, CONV(Copy420_P_to_SP) } },
     },
     { .src_chroma = VLC_CODEC_P010,
-      .dsts = { { VLC_CODEC_I420_10L, 6, .conv16 = Copy420_16_SP_to_P } },
+      .dsts = { { VLC_CODEC_I420_10L, 6, CONV16(Copy420_16_SP_to_P) },
+                { VLC_CODEC_P010, 0, CONV(Copy420_SP_to_SP) } },
     },
     { .src_chroma = VLC_CODEC_I420_10L,
-      .dsts = { { VLC_CODEC_P010, -6, .conv16 = Copy420_16_P_to_SP } },
+      .dsts = { { VLC_CODEC_P010, -6, CONV16(Copy420_16_P_to_SP) },
+                { VLC_CODEC_I420_10L, 0, CONV(Copy420_P_to_P) } },
     },
 };
 #define NB_CONVS ARRAY_SIZE(convs)
@@ -1096,9 +1465,46 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
+static void conv_run(const struct test_dst *test_dst, picture_t *dst,
+                     const picture_t *src, const copy_cache_t *cache)
+{
+    const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                      src->p[U_PLANE].p_pixels,
+                                      src->p[V_PLANE].p_pixels };
+    const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                       src->p[U_PLANE].i_pitch,
+                                       src->p[V_PLANE].i_pitch };
+
+    if (test_dst->bitshift == 0)
+        test_dst->conv(dst, src_planes, src_pitches,
+                       src->format.i_visible_height, cache);
+    else
+        test_dst->conv16(dst, src_planes, src_pitches,
+                         src->format.i_visible_height, test_dst->bitshift,
+                         cache);
+}
+
+/* Returns the throughput in GB/s, counting the written bytes */
+static double conv_bench(const struct test_dst *test_dst, picture_t *dst,
+                         const picture_t *src, const copy_cache_t *cache)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < dst->i_planes; ++i)
+        bytes += (size_t) dst->p[i].i_visible_pitch * dst->p[i].i_visible_lines;
+
+    conv_run(test_dst, dst, src, cache); /* warm up */
+
+    mtime_t time = mdate();
+    for (unsigned i = 0; i < BENCH_RUNS; ++i)
+        conv_run(test_dst, dst, src, cache);
+    time = __MAX(mdate() - time, 1);
+
+    return (double) bytes * BENCH_RUNS / time * CLOCK_FREQ / 1e9;
+}
+
 int main(void)
 {
-    alarm(10);
+    alarm(30);
 
 #ifndef COPY_TEST_NOOPTIM
     if (!vlc_CPU_SSE2())
@@ -1108,6 +1514,18 @@ int main(void)
     }
 #endif
 
+    /* The band copies need the slice threads of an instance */
+    const char *argv[] = { "copy_test", "--ignore-config", "--quiet",
+                           "--no-plugins-scan", "--no-plugins-cache" };
+    libvlc_int_t *vlc = libvlc_InternalCreate();
+    if (vlc != NULL && libvlc_InternalInit(vlc, ARRAY_SIZE(argv), argv))
+    {
+        libvlc_InternalDestroy(vlc);
+        vlc = NULL;
+    }
+    if (vlc == NULL)
+        fprintf(stderr, "WARNING: could not test the band copies\n");
+
     for (size_t i = 0; i < NB_CONVS; ++i)
     {
         const struct test_conv *conv = &convs[i];
@@ -1130,10 +1548,18 @@ int main(void)
             assert(src);
             piccheck(src, src_dsc, true);
 
-            copy_cache_t cache;
+            copy_cache_t cache, bands;
             int ret = CopyInitCache(&cache, src->format.i_width
                                     * src_dsc->pixel_size);
             assert(ret == VLC_SUCCESS);
+            if (vlc != NULL)
+            {
+                ret = CopyInitCacheBands(&bands, src->format.i_width
+                                         * src_dsc->pixel_size,
+                                         src->format.i_height, VLC_OBJECT(vlc));
+                assert(ret == VLC_SUCCESS);
+            }
+            const bool bench = j == NB_SIZES - 1;
 
             for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
             {
@@ -1146,32 +1572,48 @@ int main(void)
                 picture_t *dst = picture_NewFromFormat(&fmt);
                 assert(dst);
 
-                const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
-                                                  src->p[U_PLANE].p_pixels,
-                                                  src->p[V_PLANE].p_pixels };
-                const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
-                                                   src->p[U_PLANE].i_pitch,
-                                                   src->p[V_PLANE].i_pitch };
-
                 fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s\n",
                         size->i_width, size->i_height,
                         size->i_visible_width, size->i_visible_height,
                         (const char *) &src->format.i_chroma,
                         (const char *) &dst->format.i_chroma);
-                if (test_dst->bitshift == 0)
-                    test_dst->conv(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, &cache);
-                else
-                    test_dst->conv16(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, test_dst->bitshift,
-                                   &cache);
+                conv_run(test_dst, dst, src, &cache);
                 piccheck(dst, dst_dsc, false);
+
+                if (vlc != NULL)
+                {
+                    for (int k = 0; k < dst->i_planes; ++k)
+                        memset(dst->p[k].p_pixels, 0,
+                               dst->p[k].i_pitch * dst->p[k].i_lines);
+                    conv_run(test_dst, dst, src, &bands);
+                    piccheck(dst, dst_dsc, false);
+                }
+
+                if (bench)
+                {
+                    printf("%-18s %4.4s -> %4.4s: %6.2f GB/s",
+                           test_dst->name, (const char *) &src->format.i_chroma,
+                           (const char *) &dst->format.i_chroma,
+                           conv_bench(test_dst, dst, src, &cache));
+                    if (vlc != NULL)
+                        printf(", %u bands: %6.2f GB/s", bands.bands,
+                               conv_bench(test_dst, dst, src, &bands));
+                    printf("\n");
+                }
                 picture_Release(dst);
             }
+            if (vlc != NULL)
+                CopyCleanCache(&bands);
             picture_Release(src);
             CopyCleanCache(&cache);
         }
     }
+
+    if (vlc != NULL)
+    {
+        libvlc_InternalCleanup(vlc);
+        libvlc_InternalDestroy(vlc);
+    }
     return 0;
 }
 
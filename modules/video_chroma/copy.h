@@ -29,11 +29,19 @@
 typedef struct {
 # ifdef CAN_COMPILE_SSE2
     uint8_t *buffer;
-    size_t  size;
+    size_t  size;       /* per band */
 # endif
+    vlc_object_t *obj;  /* owner of the slice threads, NULL for one band */
+    unsigned bands;
 } copy_cache_t;
 
 int  CopyInitCache(copy_cache_t *cache, unsigned width);
+
+/* Same as CopyInitCache(), but the copies of pictures of up to height lines
+ * are split in row bands running on the slice threads of the LibVLC instance
+ * of obj, each band going through a cache of its own. */
+int  CopyInitCacheBands(copy_cache_t *cache, unsigned width, unsigned height,
+                        vlc_object_t *obj);
 void CopyCleanCache(copy_cache_t *cache);
 
 /* YUVY/RGB copies */
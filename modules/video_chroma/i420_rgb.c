@@ -37,6 +37,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 
 #include "i420_rgb.h"
 #ifdef PLAIN
@@ -211,36 +212,51 @@ static int Activate( vlc_object_t *p_this )
         return VLC_EGENERIC;
     p_filter->p_sys = p_sys;
 
+    /* Without vertical scaling, the rows can be converted in parallel. The
+     * dithered 8 bpp conversion is always done serially. */
+    const unsigned i_height = p_filter->fmt_in.video.i_y_offset
+                            + p_filter->fmt_in.video.i_visible_height;
+    if( i_height == p_filter->fmt_out.video.i_y_offset
+                  + p_filter->fmt_out.video.i_visible_height
+     && p_filter->fmt_out.video.i_chroma != VLC_CODEC_RGB8 )
+        p_sys->i_slices = vlc_slices_Count( p_filter, i_height );
+    else
+        p_sys->i_slices = 1;
+
     switch( p_filter->fmt_out.video.i_chroma )
     {
 #ifdef PLAIN
         case VLC_CODEC_RGB8:
-            p_sys->p_buffer = malloc( VOUT_MAX_WIDTH );
+            p_sys->i_buffer_size = VOUT_MAX_WIDTH;
             break;
 #endif
         case VLC_CODEC_RGB15:
         case VLC_CODEC_RGB16:
-            p_sys->p_buffer = malloc( VOUT_MAX_WIDTH * 2 );
+            p_sys->i_buffer_size = VOUT_MAX_WIDTH * 2;
             break;
         case VLC_CODEC_RGB24:
         case VLC_CODEC_RGB32:
-            p_sys->p_buffer = malloc( VOUT_MAX_WIDTH * 4 );
+            p_sys->i_buffer_size = VOUT_MAX_WIDTH * 4;
             break;
         default:
-            p_sys->p_buffer = NULL;
+            p_sys->i_buffer_size = 0;
             break;
     }
 
+    p_sys->p_buffer = NULL;
+    if( p_sys->i_buffer_size > 0 )
+        p_sys->p_buffer = malloc( p_sys->i_buffer_size * p_sys->i_slices );
     if( p_sys->p_buffer == NULL )
     {
         free( p_sys );
         return VLC_EGENERIC;
     }
 
-    p_sys->p_offset = malloc( p_filter->fmt_out.video.i_width
+    p_sys->i_offset_size = p_filter->fmt_out.video.i_width
                     * ( ( p_filter->fmt_out.video.i_chroma
-                           == VLC_CODEC_RGB8 ) ? 2 : 1 )
-                    * sizeof( int ) );
+                           == VLC_CODEC_RGB8 ) ? 2 : 1 );
+    p_sys->p_offset = vlc_alloc( p_sys->i_offset_size * p_sys->i_slices,
+                                 sizeof( int ) );
     if( p_sys->p_offset == NULL )
     {
         free( p_sys->p_buffer );
@@ -296,17 +312,49 @@ static void Deactivate( vlc_object_t *p_this )
     free( p_sys );
 }
 
+struct slice_job
+{
+    filter_t *p_filter;
+    picture_t *p_src;
+    picture_t *p_dest;
+};
+
+/* Same as VIDEO_FILTER_WRAPPER, with the conversion split in slices */
+#define SLICE_FILTER_WRAPPER( name )                                    \
+    static void name ## _Slice ( void *opaque, unsigned i_slice,        \
+                                 unsigned i_slices )                    \
+    {                                                                   \
+        const struct slice_job *job = opaque;                           \
+        name( job->p_filter, job->p_src, job->p_dest, i_slice, i_slices ); \
+    }                                                                   \
+                                                                        \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        filter_sys_t *p_sys = p_filter->p_sys;                          \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            struct slice_job job = { p_filter, p_pic, p_outpic };       \
+            vlc_slices_Run( p_filter, p_sys->i_slices, name ## _Slice,  \
+                            &job );                                     \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
 #ifndef PLAIN
-VIDEO_FILTER_WRAPPER( I420_R5G5B5 )
-VIDEO_FILTER_WRAPPER( I420_R5G6B5 )
-VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
-VIDEO_FILTER_WRAPPER( I420_R8G8B8A8 )
-VIDEO_FILTER_WRAPPER( I420_B8G8R8A8 )
-VIDEO_FILTER_WRAPPER( I420_A8B8G8R8 )
+SLICE_FILTER_WRAPPER( I420_R5G5B5 )
+SLICE_FILTER_WRAPPER( I420_R5G6B5 )
+SLICE_FILTER_WRAPPER( I420_A8R8G8B8 )
+SLICE_FILTER_WRAPPER( I420_R8G8B8A8 )
+SLICE_FILTER_WRAPPER( I420_B8G8R8A8 )
+SLICE_FILTER_WRAPPER( I420_A8B8G8R8 )
 #else
 VIDEO_FILTER_WRAPPER( I420_RGB8 )
-VIDEO_FILTER_WRAPPER( I420_RGB16 )
-VIDEO_FILTER_WRAPPER( I420_RGB32 )
+SLICE_FILTER_WRAPPER( I420_RGB16 )
+SLICE_FILTER_WRAPPER( I420_RGB32 )
 
 /*****************************************************************************
  * SetGammaTable: return intensity table transformed by gamma curve.
@@ -39,6 +39,12 @@ typedef struct
     uint8_t  *p_buffer;
     int *p_offset;
 
+    /**< Row slices converted in parallel, each with its own buffer and
+       offset array (see SLICE_ROWS) */
+    unsigned  i_slices;
+    size_t    i_buffer_size;           /**< buffer size of a slice, in bytes */
+    size_t    i_offset_size;           /**< offset array size of a slice */
+
 #ifdef PLAIN
     /**< Pre-calculated conversion tables */
     void *p_base;                      /**< base for all conversion tables */
@@ -61,17 +67,42 @@ typedef struct
  *****************************************************************************/
 #ifdef PLAIN
 void I420_RGB8         ( filter_t *, picture_t *, picture_t * );
-void I420_RGB16        ( filter_t *, picture_t *, picture_t * );
-void I420_RGB32        ( filter_t *, picture_t *, picture_t * );
+void I420_RGB16        ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_RGB32        ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
 #else
-void I420_R5G5B5       ( filter_t *, picture_t *, picture_t * );
-void I420_R5G6B5       ( filter_t *, picture_t *, picture_t * );
-void I420_A8R8G8B8     ( filter_t *, picture_t *, picture_t * );
-void I420_R8G8B8A8     ( filter_t *, picture_t *, picture_t * );
-void I420_B8G8R8A8     ( filter_t *, picture_t *, picture_t * );
-void I420_A8B8G8R8     ( filter_t *, picture_t *, picture_t * );
+void I420_R5G5B5       ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_R5G6B5       ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_A8R8G8B8     ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_R8G8B8A8     ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_B8G8R8A8     ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
+void I420_A8B8G8R8     ( filter_t *, picture_t *, picture_t *, unsigned, unsigned );
 #endif
 
+/*****************************************************************************
+ * SLICE_ROWS: move the pointers to the first row of a slice
+ *****************************************************************************
+ * This macro computes the [i_begin, i_end) source rows of the i_slice-th of
+ * i_slices slices, and moves the picture pointers accordingly. There is only
+ * more than one slice when the height is not scaled, so that the source and
+ * destination rows match. The slices are aligned on U and V lines.
+ *****************************************************************************/
+#define SLICE_ROWS( i_slice, i_slices )                                       \
+    unsigned i_begin, i_end;                                                  \
+    vlc_slice_Rows( p_filter->fmt_in.video.i_y_offset                         \
+                    + p_filter->fmt_in.video.i_visible_height,                \
+                    i_slice, i_slices, 2, &i_begin, &i_end );                 \
+    p_pic = (void*)((uint8_t*)p_pic + i_begin * p_dest->p->i_pitch);          \
+    p_y += i_begin * p_src->p[Y_PLANE].i_pitch;                               \
+    p_u += i_begin / 2 * p_src->p[U_PLANE].i_pitch;                           \
+    p_v += i_begin / 2 * p_src->p[V_PLANE].i_pitch;
+
+/** Conversion buffer of a slice */
+#define SLICE_BUFFER( p_sys, i_slice ) \
+    ((p_sys)->p_buffer + (i_slice) * (p_sys)->i_buffer_size)
+/** Offset array of a slice */
+#define SLICE_OFFSET( p_sys, i_slice ) \
+    ((p_sys)->p_offset + (i_slice) * (p_sys)->i_offset_size)
+
 /*****************************************************************************
  * CONVERT_*_PIXEL: pixel conversion macros
  *****************************************************************************
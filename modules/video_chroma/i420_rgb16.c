@@ -30,6 +30,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 
 #include "i420_rgb.h"
 #include "i420_rgb_c.h"
@@ -105,7 +106,8 @@ static void SetOffset( int i_width, int i_height, int i_pic_width,
  *  - output: 1 line
  *****************************************************************************/
 
-void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -130,11 +132,11 @@ void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     uint16_t *  p_ybase;                     /* Y dependant conversion table */
 
     /* Conversion buffer pointer */
-    uint16_t *  p_buffer_start = (uint16_t*)p_sys->p_buffer;
+    uint16_t *  p_buffer_start = (uint16_t*)SLICE_BUFFER( p_sys, i_slice );
     uint16_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -144,6 +146,7 @@ void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
@@ -162,7 +165,7 @@ void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     i_scale_count = ( i_vscale == 1 ) ?
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -212,7 +215,8 @@ void I420_RGB16( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
  *  - output: 1 line
  *****************************************************************************/
 
-void I420_RGB32( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_RGB32( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -237,11 +241,11 @@ void I420_RGB32( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     uint32_t *  p_ybase;                     /* Y dependant conversion table */
 
     /* Conversion buffer pointer */
-    uint32_t *  p_buffer_start = (uint32_t*)p_sys->p_buffer;
+    uint32_t *  p_buffer_start = (uint32_t*)SLICE_BUFFER( p_sys, i_slice );
     uint32_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -251,6 +255,7 @@ void I420_RGB32( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
@@ -269,7 +274,7 @@ void I420_RGB32( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     i_scale_count = ( i_vscale == 1 ) ?
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -30,6 +30,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 
 #include "i420_rgb.h"
 #ifdef SSE2
@@ -101,7 +102,8 @@ static void SetOffset( int i_width, int i_height, int i_pic_width,
 }
 
 VLC_TARGET
-void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                 unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -122,11 +124,11 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     uint16_t *  p_pic_start;       /* beginning of the current line for copy */
 
     /* Conversion buffer pointer */
-    uint16_t *  p_buffer_start = (uint16_t*)p_sys->p_buffer;
+    uint16_t *  p_buffer_start = (uint16_t*)SLICE_BUFFER( p_sys, i_slice );
     uint16_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -136,6 +138,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -171,7 +174,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -222,7 +225,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -279,7 +282,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -335,7 +338,8 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                 unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -356,11 +360,11 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     uint16_t *  p_pic_start;       /* beginning of the current line for copy */
 
     /* Conversion buffer pointer */
-    uint16_t *  p_buffer_start = (uint16_t*)p_sys->p_buffer;
+    uint16_t *  p_buffer_start = (uint16_t*)SLICE_BUFFER( p_sys, i_slice );
     uint16_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -370,6 +374,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -405,7 +410,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -456,7 +461,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -513,7 +518,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -569,8 +574,8 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
-                                            picture_t *p_dest )
+void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                   unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -590,11 +595,11 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
     int         i_chroma_width = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 2; /* chroma width */
     uint32_t *  p_pic_start;       /* beginning of the current line for copy */
     /* Conversion buffer pointer */
-    uint32_t *  p_buffer_start = (uint32_t*)p_sys->p_buffer;
+    uint32_t *  p_buffer_start = (uint32_t*)SLICE_BUFFER( p_sys, i_slice );
     uint32_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -604,6 +609,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -638,7 +644,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -689,7 +695,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -746,7 +752,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -802,7 +808,8 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
 }
 
 VLC_TARGET
-void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                   unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -822,11 +829,11 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     int         i_chroma_width = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 2; /* chroma width */
     uint32_t *  p_pic_start;       /* beginning of the current line for copy */
     /* Conversion buffer pointer */
-    uint32_t *  p_buffer_start = (uint32_t*)p_sys->p_buffer;
+    uint32_t *  p_buffer_start = (uint32_t*)SLICE_BUFFER( p_sys, i_slice );
     uint32_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -836,6 +843,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -870,7 +878,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -921,7 +929,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -978,7 +986,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1034,7 +1042,8 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                   unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -1054,11 +1063,11 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     int         i_chroma_width = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 2; /* chroma width */
     uint32_t *  p_pic_start;       /* beginning of the current line for copy */
     /* Conversion buffer pointer */
-    uint32_t *  p_buffer_start = (uint32_t*)p_sys->p_buffer;
+    uint32_t *  p_buffer_start = (uint32_t*)SLICE_BUFFER( p_sys, i_slice );
     uint32_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -1068,6 +1077,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -1102,7 +1112,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1153,7 +1163,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1207,7 +1217,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1263,7 +1273,8 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest,
+                   unsigned i_slice, unsigned i_slices )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -1283,11 +1294,11 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     int         i_chroma_width = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 2; /* chroma width */
     uint32_t *  p_pic_start;       /* beginning of the current line for copy */
     /* Conversion buffer pointer */
-    uint32_t *  p_buffer_start = (uint32_t*)p_sys->p_buffer;
+    uint32_t *  p_buffer_start = (uint32_t*)SLICE_BUFFER( p_sys, i_slice );
     uint32_t *  p_buffer;
 
     /* Offset array pointer */
-    int *       p_offset_start = p_sys->p_offset;
+    int *       p_offset_start = SLICE_OFFSET( p_sys, i_slice );
     int *       p_offset;
 
     const int i_source_margin = p_src->p[0].i_pitch
@@ -1297,6 +1308,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                                  - p_src->p[1].i_visible_pitch
                                  - ( p_filter->fmt_in.video.i_x_offset / 2 );
 
+    SLICE_ROWS( i_slice, i_slices );
     i_right_margin = p_dest->p->i_pitch - p_dest->p->i_visible_pitch;
 
     /* Rule: when a picture of size (x1,y1) with aspect ratio r1 is rendered
@@ -1331,7 +1343,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1382,7 +1394,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_begin; i_y < i_end; i_y++ )
         {
             p_pic_start = p_pic;
             p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1436,7 +1448,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_begin; i_y < i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
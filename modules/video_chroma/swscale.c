@@ -35,6 +35,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include <vlc_cpu.h>
+#include <vlc_slices.h>
 
 #include <libswscale/swscale.h>
 #include <libswscale/version.h>
@@ -58,6 +59,10 @@ static void CloseScaler( vlc_object_t * );
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads converting horizontal bands " \
+    "of the pictures in parallel (0 for automatic, 1 to disable).")
+
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 const char *const ppsz_mode_descriptions[] =
 { N_("Fast bilinear"), N_("Bilinear"), N_("Bicubic (good quality)"),
@@ -74,6 +79,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer( "swscale-threads", 0, THREADS_TEXT, THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
 vlc_module_end ()
 
 /* Version checking */
@@ -82,6 +89,22 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/**
+ * Horizontal band of the pictures converted by its own context.
+ *
+ * The band is converted with margins of source rows above and below, so
+ * that the vertical filter sees the same rows as for the whole picture. The
+ * output of the margins is discarded.
+ */
+typedef struct
+{
+    struct SwsContext *ctx;
+    picture_t *p_dst; /* output of the band and its margins */
+    unsigned i_src_begin, i_src_lines; /* source rows, with margins */
+    unsigned i_dst_skip; /* output rows of the top margin */
+    unsigned i_dst_begin, i_dst_lines; /* rows written to the picture */
+} scaler_slice_t;
+
 /**
  * Internal swscale filter structure.
  */
@@ -89,6 +112,7 @@ typedef struct
 {
     SwsFilter *p_filter;
     int i_cpu_mask, i_sws_flags;
+    unsigned i_threads; /* 0 if automatic */
 
     video_format_t fmt_in;
     video_format_t fmt_out;
@@ -106,6 +130,9 @@ typedef struct
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    scaler_slice_t *p_slices;
+    unsigned i_slices; /* 0 if the whole picture is converted by ctx */
 } filter_sys_t;
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -179,6 +206,7 @@ static int OpenScaler( vlc_object_t *p_this )
     case 10: p_sys->i_sws_flags = SWS_SPLINE; break;
     default: p_sys->i_sws_flags = SWS_BICUBIC; i_sws_mode = 2; break;
     }
+    p_sys->i_threads = var_CreateGetInteger( p_filter, "swscale-threads" );
 
     /* Misc init */
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
@@ -203,6 +231,8 @@ static int OpenScaler( vlc_object_t *p_this )
              p_filter->fmt_out.video.i_width, p_filter->fmt_out.video.i_height,
              (char *)&p_filter->fmt_out.video.i_chroma,
              ppsz_mode_descriptions[i_sws_mode] );
+    if( p_sys->i_slices > 1 )
+        msg_Dbg( p_filter, "converting %u slices in parallel", p_sys->i_slices );
 
     return VLC_SUCCESS;
 }
@@ -350,6 +380,146 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+/* Vertical filter size for the scaling flags, in output rows when
+ * upscaling (as in libswscale initFilter()) */
+static unsigned GetFilterSize( int i_sws_flags )
+{
+    if( i_sws_flags & SWS_POINT )
+        return 1;
+    if( i_sws_flags & (SWS_FAST_BILINEAR | SWS_BILINEAR | SWS_AREA) )
+        return 2;
+    if( i_sws_flags & (SWS_BICUBIC | SWS_BICUBLIN) )
+        return 4;
+    if( i_sws_flags & SWS_LANCZOS )
+        return 6;
+    if( i_sws_flags & (SWS_X | SWS_GAUSS) )
+        return 8;
+    return 20; /* SWS_SINC, SWS_SPLINE */
+}
+
+static unsigned GetVerticalSubsampling( const vlc_chroma_description_t *desc )
+{
+    unsigned i_den = 1;
+
+    for( unsigned i = 0; i < desc->plane_count; i++ )
+        if( desc->p[i].h.den / desc->p[i].h.num > i_den )
+            i_den = desc->p[i].h.den / desc->p[i].h.num;
+    return i_den;
+}
+
+static void CleanSlices( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->i_slices; i++ )
+    {
+        scaler_slice_t *p_slice = &p_sys->p_slices[i];
+
+        if( p_slice->ctx )
+            sws_freeContext( p_slice->ctx );
+        if( p_slice->p_dst )
+            picture_Release( p_slice->p_dst );
+    }
+    free( p_sys->p_slices );
+    p_sys->p_slices = NULL;
+    p_sys->i_slices = 0;
+}
+
+/**
+ * Splits the conversion in bands converted in parallel.
+ *
+ * The bands start on rows where the input and output positions are in the
+ * exact ratio of the heights, and on chroma rows, so that every band is
+ * scaled with the same ratio and phase as the whole picture.
+ * On failure, the whole picture is converted by the main context.
+ */
+static void InitSlices( filter_t *p_filter, const ScalerConfiguration *p_cfg,
+                        unsigned i_src_width, unsigned i_dst_width )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+    const unsigned i_src_height = p_fmti->i_visible_height;
+    const unsigned i_dst_height = p_fmto->i_visible_height;
+
+    unsigned i_count = p_sys->i_threads;
+    if( i_count == 0 )
+        i_count = vlc_slices_Count( p_filter, __MAX( i_src_height,
+                                                     i_dst_height ) );
+    if( i_count <= 1 )
+        return;
+
+    /* Smallest bands with an exact ratio, starting on chroma rows */
+    const unsigned i_gcd = GCD( i_src_height, i_dst_height );
+    const unsigned i_src_ratio = i_src_height / i_gcd;
+    const unsigned i_dst_ratio = i_dst_height / i_gcd;
+    const unsigned i_sub_in = GetVerticalSubsampling( p_sys->desc_in );
+    const unsigned i_sub_out = GetVerticalSubsampling( p_sys->desc_out );
+    const unsigned i_mul_in = i_sub_in / GCD( i_src_ratio, i_sub_in );
+    const unsigned i_mul_out = i_sub_out / GCD( i_dst_ratio, i_sub_out );
+    const unsigned i_mul = i_mul_in / GCD( i_mul_in, i_mul_out ) * i_mul_out;
+    const unsigned i_src_unit = i_mul * i_src_ratio;
+    const unsigned i_dst_unit = i_mul * i_dst_ratio;
+    const unsigned i_units = i_src_height / i_src_unit;
+
+    /* Source rows read by the vertical filter around an output row, in the
+     * coarsest of the planes */
+    const unsigned i_step = ( i_src_height * i_sub_out + i_dst_height - 1 )
+                          / i_dst_height;
+    const unsigned i_margin = ( GetFilterSize( p_cfg->i_sws_flags ) / 2 + 2 )
+                            * __MAX( i_step, 1 ) * i_sub_in;
+    const unsigned i_margin_units = ( i_margin + i_src_unit - 1 ) / i_src_unit;
+
+    /* Margins larger than the bands would convert the rows several times */
+    if( i_count > i_units / i_margin_units )
+        i_count = i_units / i_margin_units;
+    if( i_count <= 1 )
+        return;
+
+    p_sys->p_slices = calloc( i_count, sizeof( *p_sys->p_slices ) );
+    if( !p_sys->p_slices )
+        return;
+    p_sys->i_slices = i_count;
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        scaler_slice_t *p_slice = &p_sys->p_slices[i];
+        const bool b_last = i + 1 == i_count;
+        unsigned i_begin, i_end;
+
+        vlc_slice_Rows( i_units, i, i_count, 1, &i_begin, &i_end );
+
+        const unsigned i_top = i_begin > i_margin_units
+                             ? i_begin - i_margin_units : 0;
+        const bool b_bottom = b_last || i_end + i_margin_units >= i_units;
+        const unsigned i_src_end = b_bottom
+            ? i_src_height : ( i_end + i_margin_units ) * i_src_unit;
+        const unsigned i_dst_end = b_bottom
+            ? i_dst_height : ( i_end + i_margin_units ) * i_dst_unit;
+
+        p_slice->i_src_begin = i_top * i_src_unit;
+        p_slice->i_src_lines = i_src_end - p_slice->i_src_begin;
+        p_slice->i_dst_skip = ( i_begin - i_top ) * i_dst_unit;
+        p_slice->i_dst_begin = i_begin * i_dst_unit;
+        p_slice->i_dst_lines = ( b_last ? i_dst_height : i_end * i_dst_unit )
+                             - p_slice->i_dst_begin;
+
+        const unsigned i_dst_lines = i_dst_end - i_top * i_dst_unit;
+        p_slice->ctx = sws_getContext( i_src_width, p_slice->i_src_lines,
+                                       p_cfg->i_fmti,
+                                       i_dst_width, i_dst_lines,
+                                       p_cfg->i_fmto,
+                                       p_cfg->i_sws_flags | p_sys->i_cpu_mask,
+                                       p_sys->p_filter, NULL, 0 );
+        p_slice->p_dst = picture_New( p_fmto->i_chroma, i_dst_width,
+                                      i_dst_lines, 0, 1 );
+        if( !p_slice->ctx || !p_slice->p_dst )
+        {
+            msg_Warn( p_filter, "cannot convert in slices" );
+            CleanSlices( p_sys );
+            return;
+        }
+    }
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -456,6 +626,12 @@ static int Init( filter_t *p_filter )
         p_fmto->i_sar_den = i_sar_den;
     }
 
+    /* Bands can't share the palette, and tiny pictures are not worth it */
+    if( !cfg.b_copy && p_sys->i_extend_factor == 1 &&
+        p_fmti->i_chroma != VLC_CODEC_RGBP )
+        InitSlices( p_filter, &cfg, i_fmti_visible_width,
+                    i_fmto_visible_width );
+
     p_sys->b_add_a = cfg.b_add_a;
     p_sys->b_copy = cfg.b_copy;
     p_sys->fmt_in  = *p_fmti;
@@ -470,6 +646,8 @@ static void Clean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    CleanSlices( p_sys );
+
     if( p_sys->p_src_e )
         picture_Release( p_sys->p_src_e );
     if( p_sys->p_dst_e )
@@ -615,6 +793,79 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+struct convert_slices
+{
+    filter_t *p_filter;
+    picture_t *p_dst;
+    picture_t *p_src;
+    int i_plane_count;
+};
+
+static void ConvertSlice( void *opaque, unsigned index, unsigned count )
+{
+    const struct convert_slices *job = opaque;
+    filter_t *p_filter = job->p_filter;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const scaler_slice_t *p_slice = &p_sys->p_slices[index];
+    const video_format_t origin = { .i_x_offset = 0, .i_y_offset = 0 };
+    uint8_t *src[4]; int src_stride[4];
+    uint8_t *tmp[4]; int tmp_stride[4];
+    uint8_t *dst[4]; int dst_stride[4];
+
+    assert( count == p_sys->i_slices );
+    (void) count;
+
+    GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
+               job->p_src, job->i_plane_count, p_sys->b_swap_uvi );
+    GetPixels( tmp, tmp_stride, p_sys->desc_out, &origin,
+               p_slice->p_dst, job->i_plane_count, p_sys->b_swap_uvo );
+    GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
+               job->p_dst, job->i_plane_count, p_sys->b_swap_uvo );
+
+    for( unsigned i = 0; i < 4 && src[i] != NULL; i++ )
+    {
+        const vlc_rational_t *h = &p_sys->desc_in->p[i].h;
+        src[i] += p_slice->i_src_begin * h->num / h->den * src_stride[i];
+    }
+
+    sws_scale( p_slice->ctx, (const uint8_t *const *)src, src_stride, 0,
+               p_slice->i_src_lines, tmp, tmp_stride );
+
+    /* Copy the band without its margins */
+    for( unsigned i = 0; i < 4 && dst[i] != NULL; i++ )
+    {
+        const vlc_rational_t *h = &p_sys->desc_out->p[i].h;
+        const unsigned i_begin = p_slice->i_dst_begin * h->num / h->den;
+        const unsigned i_end = ( ( p_slice->i_dst_begin + p_slice->i_dst_lines )
+                                 * h->num + h->den - 1 ) / h->den;
+        const uint8_t *p_in = tmp[i]
+                    + p_slice->i_dst_skip * h->num / h->den * tmp_stride[i];
+        uint8_t *p_out = dst[i] + i_begin * dst_stride[i];
+        const size_t i_size = p_slice->p_dst->p[i].i_visible_pitch;
+
+        for( unsigned y = i_begin; y < i_end; y++ )
+        {
+            memcpy( p_out, p_in, i_size );
+            p_in += tmp_stride[i];
+            p_out += dst_stride[i];
+        }
+    }
+}
+
+static void ConvertSlices( filter_t *p_filter, picture_t *p_dst,
+                           picture_t *p_src, int i_plane_count )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct convert_slices job = {
+        .p_filter = p_filter,
+        .p_dst = p_dst,
+        .p_src = p_src,
+        .i_plane_count = i_plane_count,
+    };
+
+    vlc_slices_Run( p_filter, p_sys->i_slices, ConvertSlice, &job );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -662,8 +913,12 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->i_slices > 1 )
+            ConvertSlices( p_filter, p_dst, p_src, n_planes );
+        else
+            Convert( p_filter, p_sys->ctx, p_dst, p_src,
+                     p_fmti->i_visible_height, n_planes,
+                     p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
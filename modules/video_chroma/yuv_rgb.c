@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * yuv_rgb.c : SIMD 4:2:0 YUV to 32-bit RGB conversions
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+#include <vlc_slices.h>
+
+#include "yuv_rgb.h"
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_description( N_("SIMD I420,YV12,NV12,I010,P010 to RGBA,BGRA,RV32 "
+                        "conversions") )
+    set_capability( "video converter", 200 )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+typedef struct
+{
+    yuv_rgb_row_t pf_row;
+    yuv_rgb_coefs_t coefs;
+    bool b_semi_planar;
+    bool b_swap_uv;
+    unsigned i_slices;
+} filter_sys_t;
+
+struct convert_slices
+{
+    filter_t *p_filter;
+    picture_t *p_src;
+    picture_t *p_dst;
+};
+
+static void ConvertSlice( void *opaque, unsigned index, unsigned count )
+{
+    const struct convert_slices *job = opaque;
+    const filter_t *p_filter = job->p_filter;
+    const filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+    const plane_t *p_y = &job->p_src->p[Y_PLANE];
+    const plane_t *p_u = &job->p_src->p[p_sys->b_swap_uv ? V_PLANE : U_PLANE];
+    const plane_t *p_v = p_sys->b_semi_planar ? NULL
+                       : &job->p_src->p[p_sys->b_swap_uv ? U_PLANE : V_PLANE];
+    const plane_t *p_out = &job->p_dst->p[0];
+    unsigned i_begin, i_end;
+
+    vlc_slice_Rows( p_fmti->i_visible_height, index, count, 2,
+                    &i_begin, &i_end );
+
+    for( unsigned i = i_begin; i < i_end; i++ )
+    {
+        const unsigned i_y = p_fmti->i_y_offset + i;
+        const unsigned i_x = p_fmti->i_x_offset * p_y->i_pixel_pitch;
+        /* Semi-planar chroma rows hold pairs of samples */
+        const unsigned i_cx = p_fmti->i_x_offset / 2 * p_y->i_pixel_pitch
+                            * ( p_sys->b_semi_planar ? 2 : 1 );
+        const uint8_t *y = p_y->p_pixels + i_y * p_y->i_pitch + i_x;
+        const uint8_t *u = p_u->p_pixels + i_y / 2 * p_u->i_pitch + i_cx;
+        const uint8_t *v = p_v != NULL
+                         ? p_v->p_pixels + i_y / 2 * p_v->i_pitch + i_cx
+                         : NULL;
+        uint8_t *out = p_out->p_pixels
+                     + ( p_fmto->i_y_offset + i ) * p_out->i_pitch
+                     + p_fmto->i_x_offset * 4;
+
+        p_sys->pf_row( out, y, u, v, p_fmti->i_visible_width, &p_sys->coefs );
+    }
+}
+
+static void Convert( filter_t *p_filter, picture_t *p_src, picture_t *p_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct convert_slices job = {
+        .p_filter = p_filter,
+        .p_src = p_src,
+        .p_dst = p_dst,
+    };
+
+    vlc_slices_Run( p_filter, p_sys->i_slices, ConvertSlice, &job );
+}
+
+VIDEO_FILTER_WRAPPER( Convert )
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+    enum yuv_rgb_input input;
+    bool b_swap_uv = false;
+    bool b_bgra;
+
+    if( p_fmti->i_visible_width != p_fmto->i_visible_width
+     || p_fmti->i_visible_height != p_fmto->i_visible_height
+     || p_fmti->orientation != p_fmto->orientation )
+        return VLC_EGENERIC;
+
+    /* The rows start on the first luma sample of a chroma pair: leave odd
+     * crops to the other converters */
+    if( (p_fmti->i_x_offset | p_fmti->i_y_offset) & 1 )
+        return VLC_EGENERIC;
+
+    switch( p_fmti->i_chroma )
+    {
+        case VLC_CODEC_YV12:
+            b_swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+            input = YUV_RGB_I420;
+            break;
+        case VLC_CODEC_NV12:
+            input = YUV_RGB_NV12;
+            break;
+        case VLC_CODEC_I420_10L:
+            input = YUV_RGB_I010;
+            break;
+        case VLC_CODEC_P010:
+            input = YUV_RGB_P010;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    switch( p_fmto->i_chroma )
+    {
+        case VLC_CODEC_RGBA:
+            b_bgra = false;
+            break;
+        case VLC_CODEC_BGRA:
+            b_bgra = true;
+            break;
+#ifndef WORDS_BIGENDIAN
+        case VLC_CODEC_RGB32:
+            if( p_fmto->i_rmask == 0x000000ff && p_fmto->i_gmask == 0x0000ff00
+             && p_fmto->i_bmask == 0x00ff0000 )
+                b_bgra = false;
+            else
+            if( p_fmto->i_rmask == 0x00ff0000 && p_fmto->i_gmask == 0x0000ff00
+             && p_fmto->i_bmask == 0x000000ff )
+                b_bgra = true;
+            else
+                return VLC_EGENERIC;
+            break;
+#endif
+        default:
+            return VLC_EGENERIC;
+    }
+
+    yuv_rgb_row_t pf_row = NULL;
+#ifdef HAVE_YUV_RGB_AVX2
+    if( vlc_CPU_AVX2() )
+        pf_row = yuv_rgb_GetRowAVX2( input, b_bgra );
+#endif
+#ifdef HAVE_YUV_RGB_NEON
+    if( vlc_CPU_ARM_NEON() )
+        pf_row = yuv_rgb_GetRowNEON( input, b_bgra );
+#endif
+    /* The C rows are no match for the other converters */
+    if( pf_row == NULL )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    video_color_space_t space = p_fmti->space;
+    if( space == COLOR_SPACE_UNDEF )
+        space = p_fmti->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                               : COLOR_SPACE_BT601;
+
+    p_sys->pf_row = pf_row;
+    yuv_rgb_Coefs( &p_sys->coefs, space, p_fmti->b_color_range_full );
+    p_sys->b_semi_planar = input == YUV_RGB_NV12 || input == YUV_RGB_P010;
+    p_sys->b_swap_uv = b_swap_uv;
+    p_sys->i_slices = vlc_slices_Count( p_filter, p_fmti->i_visible_height );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Convert_Filter;
+
+    msg_Dbg( p_filter, "%4.4s to %4.4s (%s), %u slices",
+             (const char *)&p_fmti->i_chroma, (const char *)&p_fmto->i_chroma,
+             space == COLOR_SPACE_BT2020 ? "BT.2020" :
+             space == COLOR_SPACE_BT709 ? "BT.709" : "BT.601",
+             p_sys->i_slices );
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * yuv_rgb.h : 4:2:0 YUV to 32-bit RGB row converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_YUV_RGB_H
+#define VLC_YUV_RGB_H
+
+/* All the converters compute the same fixed-point results:
+ *  - samples are scaled to 14 bits (8-bit << 6, 10-bit << 4),
+ *  - the black level and chroma zero are subtracted,
+ *  - they are multiplied by Q13 coefficients keeping the 16 high bits of
+ *    the products, which gives the output with 3 fractional bits,
+ *  - the components are rounded and clipped to 8 bits.
+ * The coefficients are even, so that NEON can use a doubling multiply. */
+
+/**
+ * Conversion coefficients, for a matrix and a range
+ */
+typedef struct
+{
+    int16_t i_y_offset; /* scaled black level */
+    int16_t i_c_offset; /* scaled chroma zero */
+    int16_t i_y, i_rv, i_gu, i_gv, i_bu; /* Q13 multipliers */
+} yuv_rgb_coefs_t;
+
+/**
+ * Input layouts (4:2:0)
+ */
+enum yuv_rgb_input
+{
+    YUV_RGB_I420, /* 8-bit planar */
+    YUV_RGB_NV12, /* 8-bit semi-planar */
+    YUV_RGB_I010, /* 10-bit planar, in the low bits */
+    YUV_RGB_P010, /* 10-bit semi-planar, in the high bits */
+};
+
+/**
+ * Converts a row of pixels.
+ *
+ * \param dst output row, 4 bytes per pixel, R G B A or B G R A
+ * \param y luma row
+ * \param u U row, or interleaved UV row for semi-planar inputs
+ * \param v V row (unused for semi-planar inputs)
+ * \param width number of pixels
+ */
+typedef void (*yuv_rgb_row_t)(uint8_t *dst, const void *y, const void *u,
+                              const void *v, unsigned width,
+                              const yuv_rgb_coefs_t *coefs);
+
+void yuv_rgb_Coefs(yuv_rgb_coefs_t *, video_color_space_t, bool b_full_range);
+
+yuv_rgb_row_t yuv_rgb_GetRowC(enum yuv_rgb_input, bool b_bgra);
+
+#ifdef HAVE_AVX2_INTRINSICS
+# define HAVE_YUV_RGB_AVX2
+yuv_rgb_row_t yuv_rgb_GetRowAVX2(enum yuv_rgb_input, bool b_bgra);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define HAVE_YUV_RGB_NEON
+yuv_rgb_row_t yuv_rgb_GetRowNEON(enum yuv_rgb_input, bool b_bgra);
+#endif
+
+#endif
@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * yuv_rgb_rows.c : 4:2:0 YUV to 32-bit RGB row converters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+
+#include "yuv_rgb.h"
+
+/* Even Q13 value */
+#define COEF(f) (2 * lround((f) * 4096.))
+
+void yuv_rgb_Coefs(yuv_rgb_coefs_t *c, video_color_space_t space,
+                   bool b_full_range)
+{
+    double kr, kb;
+
+    switch (space)
+    {
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627; kb = 0.0593;
+            break;
+        case COLOR_SPACE_BT709:
+            kr = 0.2126; kb = 0.0722;
+            break;
+        default:
+            kr = 0.299; kb = 0.114;
+            break;
+    }
+
+    const double kg = 1. - kr - kb;
+    const double ky = b_full_range ? 1. : 255. / 219.;
+    const double kc = b_full_range ? 1. : 255. / 224.;
+
+    c->i_y_offset = b_full_range ? 0 : 16 << 6;
+    c->i_c_offset = 128 << 6;
+    c->i_y  = COEF(ky);
+    c->i_rv = COEF(kc * 2. * (1. - kr));
+    c->i_gu = COEF(kc * 2. * kb * (1. - kb) / kg);
+    c->i_gv = COEF(kc * 2. * kr * (1. - kr) / kg);
+    c->i_bu = COEF(kc * 2. * (1. - kb));
+}
+
+/*****************************************************************************
+ * C
+ *****************************************************************************/
+static inline int MulHi(int a, int b)
+{
+    return (a * b) >> 16;
+}
+
+static inline uint8_t Clip(int v)
+{
+    v >>= 3;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/* Converts the pixels from x (even) to width */
+static inline void ConvertC(enum yuv_rgb_input input, bool b_bgra,
+                            uint8_t *dst, const void *py, const void *pu,
+                            const void *pv, unsigned x, unsigned width,
+                            const yuv_rgb_coefs_t *c)
+{
+    for (; x < width; x++)
+    {
+        const unsigned i = x / 2;
+        int y, u, v;
+
+        switch (input)
+        {
+            case YUV_RGB_I420:
+                y = ((const uint8_t *)py)[x] << 6;
+                u = ((const uint8_t *)pu)[i] << 6;
+                v = ((const uint8_t *)pv)[i] << 6;
+                break;
+            case YUV_RGB_NV12:
+                y = ((const uint8_t *)py)[x] << 6;
+                u = ((const uint8_t *)pu)[2 * i] << 6;
+                v = ((const uint8_t *)pu)[2 * i + 1] << 6;
+                break;
+            case YUV_RGB_I010:
+                y = ((const uint16_t *)py)[x] << 4;
+                u = ((const uint16_t *)pu)[i] << 4;
+                v = ((const uint16_t *)pv)[i] << 4;
+                break;
+            default:
+                y = ((const uint16_t *)py)[x] >> 2;
+                u = ((const uint16_t *)pu)[2 * i] >> 2;
+                v = ((const uint16_t *)pu)[2 * i + 1] >> 2;
+                break;
+        }
+
+        y = MulHi(y - c->i_y_offset, c->i_y) + 4;
+        u -= c->i_c_offset;
+        v -= c->i_c_offset;
+
+        const uint8_t r = Clip(y + MulHi(v, c->i_rv));
+        const uint8_t g = Clip(y - MulHi(u, c->i_gu) - MulHi(v, c->i_gv));
+        const uint8_t b = Clip(y + MulHi(u, c->i_bu));
+
+        dst[4 * x + 0] = b_bgra ? b : r;
+        dst[4 * x + 1] = g;
+        dst[4 * x + 2] = b_bgra ? r : b;
+        dst[4 * x + 3] = 0xff;
+    }
+}
+
+#define ROW_C(input, bgra) \
+static void Row_##input##_##bgra##_C(uint8_t *dst, const void *y, \
+                                     const void *u, const void *v, \
+                                     unsigned width, \
+                                     const yuv_rgb_coefs_t *c) \
+{ \
+    ConvertC(YUV_RGB_##input, bgra, dst, y, u, v, 0, width, c); \
+}
+
+ROW_C(I420, false) ROW_C(I420, true)
+ROW_C(NV12, false) ROW_C(NV12, true)
+ROW_C(I010, false) ROW_C(I010, true)
+ROW_C(P010, false) ROW_C(P010, true)
+
+#define ROWS(suffix) { \
+    { Row_I420_false_##suffix, Row_I420_true_##suffix }, \
+    { Row_NV12_false_##suffix, Row_NV12_true_##suffix }, \
+    { Row_I010_false_##suffix, Row_I010_true_##suffix }, \
+    { Row_P010_false_##suffix, Row_P010_true_##suffix }, \
+}
+
+yuv_rgb_row_t yuv_rgb_GetRowC(enum yuv_rgb_input input, bool b_bgra)
+{
+    static const yuv_rgb_row_t rows[4][2] = ROWS(C);
+    return rows[input][b_bgra];
+}
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef HAVE_YUV_RGB_AVX2
+#include <immintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+/* Duplicates 16 chroma terms for 32 pixels */
+VLC_TARGET
+static inline void DupAVX2(__m256i c, __m256i *lo, __m256i *hi)
+{
+    const __m256i l = _mm256_unpacklo_epi16(c, c);
+    const __m256i h = _mm256_unpackhi_epi16(c, c);
+
+    *lo = _mm256_permute2x128_si256(l, h, 0x20);
+    *hi = _mm256_permute2x128_si256(l, h, 0x31);
+}
+
+/* Rounds, clips and packs the components of 2x16 pixels in order */
+VLC_TARGET
+static inline __m256i PackAVX2(__m256i a, __m256i b)
+{
+    const __m256i p = _mm256_packus_epi16(_mm256_srai_epi16(a, 3),
+                                          _mm256_srai_epi16(b, 3));
+    return _mm256_permute4x64_epi64(p, 0xD8);
+}
+
+/* Deinterleaves 16 pairs of 16-bit samples */
+VLC_TARGET
+static inline void Deinterleave16AVX2(const uint16_t *p, __m256i *u,
+                                      __m256i *v)
+{
+    const __m256i mask = _mm256_set1_epi32(0xffff);
+    const __m256i a = _mm256_loadu_si256((const __m256i *)p);
+    const __m256i b = _mm256_loadu_si256((const __m256i *)(p + 16));
+
+    *u = _mm256_permute4x64_epi64(
+            _mm256_packus_epi32(_mm256_and_si256(a, mask),
+                                _mm256_and_si256(b, mask)), 0xD8);
+    *v = _mm256_permute4x64_epi64(
+            _mm256_packus_epi32(_mm256_srli_epi32(a, 16),
+                                _mm256_srli_epi32(b, 16)), 0xD8);
+}
+
+VLC_TARGET
+static inline void ConvertAVX2(enum yuv_rgb_input input, bool b_bgra,
+                               uint8_t *dst, const void *py, const void *pu,
+                               const void *pv, unsigned width,
+                               const yuv_rgb_coefs_t *c)
+{
+    const __m256i y_offset = _mm256_set1_epi16(c->i_y_offset);
+    const __m256i c_offset = _mm256_set1_epi16(c->i_c_offset);
+    const __m256i ky = _mm256_set1_epi16(c->i_y);
+    const __m256i rv = _mm256_set1_epi16(c->i_rv);
+    const __m256i gu = _mm256_set1_epi16(c->i_gu);
+    const __m256i gv = _mm256_set1_epi16(c->i_gv);
+    const __m256i bu = _mm256_set1_epi16(c->i_bu);
+    const __m256i round = _mm256_set1_epi16(4);
+    const __m256i alpha = _mm256_set1_epi8(-1);
+    unsigned x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i y0, y1, u, v;
+
+        /* 32 luma samples and 16 chroma pairs, scaled to 14 bits */
+        switch (input)
+        {
+            case YUV_RGB_I420:
+            case YUV_RGB_NV12:
+            {
+                const uint8_t *y8 = (const uint8_t *)py + x;
+
+                y0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)y8));
+                y1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y8 + 16)));
+                if (input == YUV_RGB_I420)
+                {
+                    u = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+                            (const __m128i *)((const uint8_t *)pu + x / 2)));
+                    v = _mm256_cvtepu8_epi16(_mm_loadu_si128(
+                            (const __m128i *)((const uint8_t *)pv + x / 2)));
+                }
+                else
+                {
+                    const __m256i uv = _mm256_loadu_si256(
+                            (const __m256i *)((const uint8_t *)pu + x));
+                    u = _mm256_and_si256(uv, _mm256_set1_epi16(0xff));
+                    v = _mm256_srli_epi16(uv, 8);
+                }
+                y0 = _mm256_slli_epi16(y0, 6);
+                y1 = _mm256_slli_epi16(y1, 6);
+                u = _mm256_slli_epi16(u, 6);
+                v = _mm256_slli_epi16(v, 6);
+                break;
+            }
+            case YUV_RGB_I010:
+            {
+                const uint16_t *y16 = (const uint16_t *)py + x;
+
+                y0 = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)y16), 4);
+                y1 = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(y16 + 16)), 4);
+                u = _mm256_slli_epi16(_mm256_loadu_si256(
+                        (const __m256i *)((const uint16_t *)pu + x / 2)), 4);
+                v = _mm256_slli_epi16(_mm256_loadu_si256(
+                        (const __m256i *)((const uint16_t *)pv + x / 2)), 4);
+                break;
+            }
+            default:
+            {
+                const uint16_t *y16 = (const uint16_t *)py + x;
+
+                y0 = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)y16), 2);
+                y1 = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(y16 + 16)), 2);
+                Deinterleave16AVX2((const uint16_t *)pu + x, &u, &v);
+                u = _mm256_srli_epi16(u, 2);
+                v = _mm256_srli_epi16(v, 2);
+                break;
+            }
+        }
+
+        /* Chroma terms, once per chroma sample */
+        u = _mm256_sub_epi16(u, c_offset);
+        v = _mm256_sub_epi16(v, c_offset);
+
+        __m256i r0, r1, g0, g1, b0, b1;
+        DupAVX2(_mm256_mulhi_epi16(v, rv), &r0, &r1);
+        DupAVX2(_mm256_add_epi16(_mm256_mulhi_epi16(u, gu),
+                                 _mm256_mulhi_epi16(v, gv)), &g0, &g1);
+        DupAVX2(_mm256_mulhi_epi16(u, bu), &b0, &b1);
+
+        y0 = _mm256_add_epi16(_mm256_mulhi_epi16(
+                _mm256_sub_epi16(y0, y_offset), ky), round);
+        y1 = _mm256_add_epi16(_mm256_mulhi_epi16(
+                _mm256_sub_epi16(y1, y_offset), ky), round);
+
+        __m256i r = PackAVX2(_mm256_add_epi16(y0, r0), _mm256_add_epi16(y1, r1));
+        __m256i g = PackAVX2(_mm256_sub_epi16(y0, g0), _mm256_sub_epi16(y1, g1));
+        __m256i b = PackAVX2(_mm256_add_epi16(y0, b0), _mm256_add_epi16(y1, b1));
+        if (b_bgra)
+        {
+            const __m256i t = r;
+            r = b;
+            b = t;
+        }
+
+        /* Interleave: each 128-bit lane holds 16 pixels */
+        const __m256i rg_lo = _mm256_unpacklo_epi8(r, g);
+        const __m256i rg_hi = _mm256_unpackhi_epi8(r, g);
+        const __m256i ba_lo = _mm256_unpacklo_epi8(b, alpha);
+        const __m256i ba_hi = _mm256_unpackhi_epi8(b, alpha);
+        const __m256i p0 = _mm256_unpacklo_epi16(rg_lo, ba_lo);
+        const __m256i p1 = _mm256_unpackhi_epi16(rg_lo, ba_lo);
+        const __m256i p2 = _mm256_unpacklo_epi16(rg_hi, ba_hi);
+        const __m256i p3 = _mm256_unpackhi_epi16(rg_hi, ba_hi);
+        __m256i *out = (__m256i *)(dst + 4 * x);
+
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+
+    ConvertC(input, b_bgra, dst, py, pu, pv, x, width, c);
+}
+
+#define ROW_AVX2(input, bgra) \
+VLC_TARGET \
+static void Row_##input##_##bgra##_AVX2(uint8_t *dst, const void *y, \
+                                        const void *u, const void *v, \
+                                        unsigned width, \
+                                        const yuv_rgb_coefs_t *c) \
+{ \
+    ConvertAVX2(YUV_RGB_##input, bgra, dst, y, u, v, width, c); \
+}
+
+ROW_AVX2(I420, false) ROW_AVX2(I420, true)
+ROW_AVX2(NV12, false) ROW_AVX2(NV12, true)
+ROW_AVX2(I010, false) ROW_AVX2(I010, true)
+ROW_AVX2(P010, false) ROW_AVX2(P010, true)
+
+yuv_rgb_row_t yuv_rgb_GetRowAVX2(enum yuv_rgb_input input, bool b_bgra)
+{
+    static const yuv_rgb_row_t rows[4][2] = ROWS(AVX2);
+    return rows[input][b_bgra];
+}
+
+#undef VLC_TARGET
+#endif
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef HAVE_YUV_RGB_NEON
+#include <arm_neon.h>
+
+/* Same as MulHi(), as the coefficients are even */
+#define MulHiNEON(a, k) vqdmulhq_s16(a, vdupq_n_s16((k) / 2))
+
+static inline void ConvertNEON(enum yuv_rgb_input input, bool b_bgra,
+                               uint8_t *dst, const void *py, const void *pu,
+                               const void *pv, unsigned width,
+                               const yuv_rgb_coefs_t *c)
+{
+    const int16x8_t y_offset = vdupq_n_s16(c->i_y_offset);
+    const int16x8_t c_offset = vdupq_n_s16(c->i_c_offset);
+    const int16x8_t round = vdupq_n_s16(4);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        int16x8_t y0, y1, u, v;
+
+        /* 16 luma samples and 8 chroma pairs, scaled to 14 bits */
+        switch (input)
+        {
+            case YUV_RGB_I420:
+            case YUV_RGB_NV12:
+            {
+                const uint8x16_t y8 = vld1q_u8((const uint8_t *)py + x);
+                uint8x8_t u8, v8;
+
+                if (input == YUV_RGB_I420)
+                {
+                    u8 = vld1_u8((const uint8_t *)pu + x / 2);
+                    v8 = vld1_u8((const uint8_t *)pv + x / 2);
+                }
+                else
+                {
+                    const uint8x8x2_t uv = vld2_u8((const uint8_t *)pu + x);
+                    u8 = uv.val[0];
+                    v8 = uv.val[1];
+                }
+                y0 = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(y8), 6));
+                y1 = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(y8), 6));
+                u = vreinterpretq_s16_u16(vshll_n_u8(u8, 6));
+                v = vreinterpretq_s16_u16(vshll_n_u8(v8, 6));
+                break;
+            }
+            case YUV_RGB_I010:
+            {
+                const uint16_t *y16 = (const uint16_t *)py + x;
+
+                y0 = vreinterpretq_s16_u16(vshlq_n_u16(vld1q_u16(y16), 4));
+                y1 = vreinterpretq_s16_u16(vshlq_n_u16(vld1q_u16(y16 + 8), 4));
+                u = vreinterpretq_s16_u16(vshlq_n_u16(
+                        vld1q_u16((const uint16_t *)pu + x / 2), 4));
+                v = vreinterpretq_s16_u16(vshlq_n_u16(
+                        vld1q_u16((const uint16_t *)pv + x / 2), 4));
+                break;
+            }
+            default:
+            {
+                const uint16_t *y16 = (const uint16_t *)py + x;
+                const uint16x8x2_t uv = vld2q_u16((const uint16_t *)pu + x);
+
+                y0 = vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(y16), 2));
+                y1 = vreinterpretq_s16_u16(vshrq_n_u16(vld1q_u16(y16 + 8), 2));
+                u = vreinterpretq_s16_u16(vshrq_n_u16(uv.val[0], 2));
+                v = vreinterpretq_s16_u16(vshrq_n_u16(uv.val[1], 2));
+                break;
+            }
+        }
+
+        /* Chroma terms, once per chroma sample */
+        u = vsubq_s16(u, c_offset);
+        v = vsubq_s16(v, c_offset);
+
+        const int16x8_t rc = MulHiNEON(v, c->i_rv);
+        const int16x8_t gc = vaddq_s16(MulHiNEON(u, c->i_gu),
+                                       MulHiNEON(v, c->i_gv));
+        const int16x8_t bc = MulHiNEON(u, c->i_bu);
+        const int16x8x2_t r2 = vzipq_s16(rc, rc);
+        const int16x8x2_t g2 = vzipq_s16(gc, gc);
+        const int16x8x2_t b2 = vzipq_s16(bc, bc);
+
+        y0 = vaddq_s16(MulHiNEON(vsubq_s16(y0, y_offset), c->i_y), round);
+        y1 = vaddq_s16(MulHiNEON(vsubq_s16(y1, y_offset), c->i_y), round);
+
+        const uint8x16_t r =
+            vcombine_u8(vqshrun_n_s16(vaddq_s16(y0, r2.val[0]), 3),
+                        vqshrun_n_s16(vaddq_s16(y1, r2.val[1]), 3));
+        const uint8x16_t g =
+            vcombine_u8(vqshrun_n_s16(vsubq_s16(y0, g2.val[0]), 3),
+                        vqshrun_n_s16(vsubq_s16(y1, g2.val[1]), 3));
+        const uint8x16_t b =
+            vcombine_u8(vqshrun_n_s16(vaddq_s16(y0, b2.val[0]), 3),
+                        vqshrun_n_s16(vaddq_s16(y1, b2.val[1]), 3));
+        uint8x16x4_t out;
+
+        out.val[0] = b_bgra ? b : r;
+        out.val[1] = g;
+        out.val[2] = b_bgra ? r : b;
+        out.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(dst + 4 * x, out);
+    }
+
+    ConvertC(input, b_bgra, dst, py, pu, pv, x, width, c);
+}
+
+#define ROW_NEON(input, bgra) \
+static void Row_##input##_##bgra##_NEON(uint8_t *dst, const void *y, \
+                                        const void *u, const void *v, \
+                                        unsigned width, \
+                                        const yuv_rgb_coefs_t *c) \
+{ \
+    ConvertNEON(YUV_RGB_##input, bgra, dst, y, u, v, width, c); \
+}
+
+ROW_NEON(I420, false) ROW_NEON(I420, true)
+ROW_NEON(NV12, false) ROW_NEON(NV12, true)
+ROW_NEON(I010, false) ROW_NEON(I010, true)
+ROW_NEON(P010, false) ROW_NEON(P010, true)
+
+yuv_rgb_row_t yuv_rgb_GetRowNEON(enum yuv_rgb_input input, bool b_bgra)
+{
+    static const yuv_rgb_row_t rows[4][2] = ROWS(NEON);
+    return rows[input][b_bgra];
+}
+#endif
@@ -36,40 +36,48 @@
  * @param i_sat Saturation
  * @param i_x Additional value of saturation
  * @param i_y Additional value of saturation
+ * @param i_begin First row of the chroma planes to process
+ * @param i_end Row following the last one of the chroma planes to process
  */
 
 /**
  * Basic C compiler generated function for planar format, i_sat > 256
  */
 int planar_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
-                           int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+                           int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+                           unsigned i_begin, unsigned i_end );
 
 /**
  * Basic C compiler generated function for planar format, i_sat <= 256
  */
 int planar_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
-                      int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+                      int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+                      unsigned i_begin, unsigned i_end );
 /**
  * Basic C compiler generated function for {9,10}-bit planar format, i_sat > {512,1024}
  */
 int planar_sat_hue_clip_C_16( picture_t * p_pic, picture_t * p_outpic,
-        int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+        int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+        unsigned i_begin, unsigned i_end );
 
 /**
  * Basic C compiler generated function for {9,10}-bit planar format, i_sat <= {512,1024}
  */
 int planar_sat_hue_C_16( picture_t * p_pic, picture_t * p_outpic,
-        int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+        int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+        unsigned i_begin, unsigned i_end );
 
 
 /**
  * Basic C compiler generated function for packed format, i_sat > 256
  */
 int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
-                           int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+                           int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+                           unsigned i_begin, unsigned i_end );
 
 /**
  * Basic C compiler generated function for packed format, i_sat <= 256
  */
 int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
-                      int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+                      int i_sin, int i_cos, int i_sat, int i_x, int i_y,
+                      unsigned i_begin, unsigned i_end );
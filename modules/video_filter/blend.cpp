@@ -32,7 +32,9 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
+#include "blend_rows.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -83,6 +85,25 @@ public:
     {
         return true;
     }
+    unsigned getY() const
+    {
+        return y;
+    }
+    /* Address of the current pixel in a plane subsampled by (rx, ry) */
+    uint8_t *getPixels(unsigned plane, unsigned rx = 1, unsigned ry = 1,
+                       unsigned bytes = 1) const
+    {
+        const plane_t *p = &picture->p[plane];
+        return &p->p_pixels[(y / ry) * p->i_pitch + (x / rx) * bytes];
+    }
+    int getPitch(unsigned plane) const
+    {
+        return picture->p[plane].i_pitch;
+    }
+    bool isXEven() const
+    {
+        return (x % 2) == 0;
+    }
 
 protected:
     template <unsigned ry>
@@ -625,11 +646,162 @@ static const struct {
 #undef YUV
 };
 
+/* Row based blending of the common cases: it gives the same results as the
+ * generic one, and returns false to fall back to it when it cannot handle the
+ * placement or the pixel layout. */
+typedef bool (*blend_rows_function_t)(const blend_rows_t *rows,
+                                      const CPicture &dst_data,
+                                      const CPicture &src_data,
+                                      unsigned width, unsigned height,
+                                      int alpha);
+
+template <bool swap_uv>
+bool BlendRowsYUVAToI420(const blend_rows_t *rows,
+                         const CPicture &dst_data, const CPicture &src_data,
+                         unsigned width, unsigned height, int alpha)
+{
+    /* The chroma samples would come from the odd source pixels */
+    if (!dst_data.isXEven())
+        return false;
+
+    const uint8_t *src_y = src_data.getPixels(0);
+    const uint8_t *src_u = src_data.getPixels(1);
+    const uint8_t *src_v = src_data.getPixels(2);
+    const uint8_t *src_a = src_data.getPixels(3);
+    uint8_t *dst_y = dst_data.getPixels(0);
+    uint8_t *dst_u = dst_data.getPixels(swap_uv ? 2 : 1, 2, 2);
+    uint8_t *dst_v = dst_data.getPixels(swap_uv ? 1 : 2, 2, 2);
+
+    for (unsigned y = dst_data.getY(); y < dst_data.getY() + height; y++) {
+        rows->plane(dst_y, src_y, src_a, width, alpha);
+        if ((y % 2) == 0) {
+            rows->chroma(dst_u, dst_v, src_u, src_v, src_a, width, alpha);
+        } else {
+            dst_u += dst_data.getPitch(swap_uv ? 2 : 1);
+            dst_v += dst_data.getPitch(swap_uv ? 1 : 2);
+        }
+        src_y += src_data.getPitch(0);
+        src_u += src_data.getPitch(1);
+        src_v += src_data.getPitch(2);
+        src_a += src_data.getPitch(3);
+        dst_y += dst_data.getPitch(0);
+    }
+    return true;
+}
+
+template <bool swap_uv>
+bool BlendRowsYUVAToNV12(const blend_rows_t *rows,
+                         const CPicture &dst_data, const CPicture &src_data,
+                         unsigned width, unsigned height, int alpha)
+{
+    if (!dst_data.isXEven())
+        return false;
+
+    const uint8_t *src_y = src_data.getPixels(0);
+    const uint8_t *src_u = src_data.getPixels(swap_uv ? 2 : 1);
+    const uint8_t *src_v = src_data.getPixels(swap_uv ? 1 : 2);
+    const uint8_t *src_a = src_data.getPixels(3);
+    uint8_t *dst_y  = dst_data.getPixels(0);
+    uint8_t *dst_uv = dst_data.getPixels(1, 2, 2, 2);
+
+    for (unsigned y = dst_data.getY(); y < dst_data.getY() + height; y++) {
+        rows->plane(dst_y, src_y, src_a, width, alpha);
+        if ((y % 2) == 0)
+            rows->chroma_semi(dst_uv, src_u, src_v, src_a, width, alpha);
+        else
+            dst_uv += dst_data.getPitch(1);
+        src_y += src_data.getPitch(0);
+        src_u += src_data.getPitch(swap_uv ? 2 : 1);
+        src_v += src_data.getPitch(swap_uv ? 1 : 2);
+        src_a += src_data.getPitch(3);
+        dst_y += dst_data.getPitch(0);
+    }
+    return true;
+}
+
+static bool GetRGB32Offsets(const CPicture &dst_data, blend_rgb32_t *offsets)
+{
+    int r, g, b;
+
+    if (GetPackedRgbIndexes(dst_data.getFormat(), &r, &g, &b) != VLC_SUCCESS)
+        return false;
+    if (r < 0 || r > 3 || g < 0 || g > 3 || b < 0 || b > 3 ||
+        r == g || g == b || r == b)
+        return false;
+    offsets->r = r;
+    offsets->g = g;
+    offsets->b = b;
+    return true;
+}
+
+static bool BlendRowsYUVAToRGB32(const blend_rows_t *rows,
+                                 const CPicture &dst_data,
+                                 const CPicture &src_data,
+                                 unsigned width, unsigned height, int alpha)
+{
+    blend_rgb32_t offsets;
+    if (!GetRGB32Offsets(dst_data, &offsets))
+        return false;
+
+    const uint8_t *src_y = src_data.getPixels(0);
+    const uint8_t *src_u = src_data.getPixels(1);
+    const uint8_t *src_v = src_data.getPixels(2);
+    const uint8_t *src_a = src_data.getPixels(3);
+    uint8_t *dst = dst_data.getPixels(0, 1, 1, 4);
+
+    for (unsigned y = 0; y < height; y++) {
+        rows->yuva_rgb32(dst, src_y, src_u, src_v, src_a, width, alpha,
+                         &offsets);
+        src_y += src_data.getPitch(0);
+        src_u += src_data.getPitch(1);
+        src_v += src_data.getPitch(2);
+        src_a += src_data.getPitch(3);
+        dst   += dst_data.getPitch(0);
+    }
+    return true;
+}
+
+static bool BlendRowsRGBAToRGB32(const blend_rows_t *rows,
+                                 const CPicture &dst_data,
+                                 const CPicture &src_data,
+                                 unsigned width, unsigned height, int alpha)
+{
+    blend_rgb32_t offsets;
+    if (!GetRGB32Offsets(dst_data, &offsets))
+        return false;
+
+    const uint8_t *src = src_data.getPixels(0, 1, 1, 4);
+    uint8_t *dst = dst_data.getPixels(0, 1, 1, 4);
+
+    for (unsigned y = 0; y < height; y++) {
+        rows->rgba_rgb32(dst, src, width, alpha, &offsets);
+        src += src_data.getPitch(0);
+        dst += dst_data.getPitch(0);
+    }
+    return true;
+}
+
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_rows_function_t blend;
+} blends_rows[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendRowsYUVAToI420<false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendRowsYUVAToI420<false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendRowsYUVAToI420<true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendRowsYUVAToNV12<false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendRowsYUVAToNV12<true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_YUVA, BlendRowsYUVAToRGB32 },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRowsRGBAToRGB32 },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_rows(NULL)
     {
     }
-    blend_function_t blend;
+    blend_function_t      blend;
+    blend_rows_function_t blend_rows;
+    blend_rows_t          rows;
 };
 
 /**
@@ -657,13 +829,17 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_rows &&
+        sys->blend_rows(&sys->rows, dst_data, src_data, width, height, alpha))
+        return;
+    sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -685,6 +861,26 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    /* The C rows only serve as tails for the SIMD ones: they are no faster
+     * than the generic code for the RGB destinations */
+    bool simd = false;
+#ifdef HAVE_BLEND_SSE4_1
+    if (vlc_CPU_SSE4_1()) {
+        blend_GetRowsSSE4_1(&sys->rows);
+        simd = true;
+    }
+#endif
+#ifdef HAVE_BLEND_AVX2
+    if (vlc_CPU_AVX2()) {
+        blend_GetRowsAVX2(&sys->rows);
+        simd = true;
+    }
+#endif
+    for (size_t i = 0; simd && i < sizeof(blends_rows) / sizeof(*blends_rows); i++) {
+        if (blends_rows[i].src == src && blends_rows[i].dst == dst)
+            sys->blend_rows = blends_rows[i].blend;
+    }
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
@@ -0,0 +1,649 @@
+/*****************************************************************************
+ * blend_rows.c : alpha blending row functions
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "filter_picture.h"
+#include "blend_rows.h"
+
+/* Same fixed-point coefficients as yuv_to_rgb() */
+#define SCALEBITS 10
+#define FIX(x)    ((int) ((x) * (1<<SCALEBITS) + 0.5))
+#define FIX_Y     FIX(255.0/219.0)
+#define FIX_RV    FIX(1.40200*255.0/224.0)
+#define FIX_GU    FIX(0.34414*255.0/224.0)
+#define FIX_GV    FIX(0.71414*255.0/224.0)
+#define FIX_BU    FIX(1.77200*255.0/224.0)
+#define ONE_HALF  (1 << (SCALEBITS - 1))
+
+/*****************************************************************************
+ * C
+ *****************************************************************************/
+static inline unsigned Div255(unsigned v)
+{
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static inline void Merge(uint8_t *dst, unsigned src, unsigned a)
+{
+    *dst = Div255((255 - a) * *dst + src * a);
+}
+
+static void PlaneC(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                   unsigned width, unsigned alpha)
+{
+    for (unsigned x = 0; x < width; x++)
+        Merge(&dst[x], src[x], Div255(alpha * src_a[x]));
+}
+
+static void ChromaC(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u,
+                    const uint8_t *src_v, const uint8_t *src_a,
+                    unsigned width, unsigned alpha)
+{
+    for (unsigned x = 0; x < width; x += 2)
+    {
+        const unsigned a = Div255(alpha * src_a[x]);
+
+        Merge(&dst_u[x / 2], src_u[x], a);
+        Merge(&dst_v[x / 2], src_v[x], a);
+    }
+}
+
+static void ChromaSemiC(uint8_t *dst_uv, const uint8_t *src_u,
+                        const uint8_t *src_v, const uint8_t *src_a,
+                        unsigned width, unsigned alpha)
+{
+    for (unsigned x = 0; x < width; x += 2)
+    {
+        const unsigned a = Div255(alpha * src_a[x]);
+
+        Merge(&dst_uv[x + 0], src_u[x], a);
+        Merge(&dst_uv[x + 1], src_v[x], a);
+    }
+}
+
+static void YUVAToRGB32C(uint8_t *dst, const uint8_t *src_y,
+                         const uint8_t *src_u, const uint8_t *src_v,
+                         const uint8_t *src_a, unsigned width, unsigned alpha,
+                         const blend_rgb32_t *o)
+{
+    for (unsigned x = 0; x < width; x++)
+    {
+        const unsigned a = Div255(alpha * src_a[x]);
+        int r, g, b;
+
+        yuv_to_rgb(&r, &g, &b, src_y[x], src_u[x], src_v[x]);
+        Merge(&dst[4 * x + o->r], r, a);
+        Merge(&dst[4 * x + o->g], g, a);
+        Merge(&dst[4 * x + o->b], b, a);
+    }
+}
+
+static void RGBAToRGB32C(uint8_t *dst, const uint8_t *src, unsigned width,
+                         unsigned alpha, const blend_rgb32_t *o)
+{
+    for (unsigned x = 0; x < width; x++)
+    {
+        const unsigned a = Div255(alpha * src[4 * x + 3]);
+
+        Merge(&dst[4 * x + o->r], src[4 * x + 0], a);
+        Merge(&dst[4 * x + o->g], src[4 * x + 1], a);
+        Merge(&dst[4 * x + o->b], src[4 * x + 2], a);
+    }
+}
+
+void blend_GetRowsC(blend_rows_t *rows)
+{
+    rows->plane = PlaneC;
+    rows->chroma = ChromaC;
+    rows->chroma_semi = ChromaSemiC;
+    rows->yuva_rgb32 = YUVAToRGB32C;
+    rows->rgba_rgb32 = RGBAToRGB32C;
+}
+
+/* The SIMD rows leave the last pixels to the C ones: the chroma rows stop on
+ * an even pixel, so that the C rows resume on a sampled one. */
+
+/*****************************************************************************
+ * SSE4.1
+ *****************************************************************************/
+#ifdef HAVE_BLEND_SSE4_1
+#include <smmintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("sse4.1")))
+
+VLC_TARGET
+static inline __m128i Div255SSE(__m128i v)
+{
+    v = _mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)),
+                      _mm_set1_epi16(1));
+    return _mm_srli_epi16(v, 8);
+}
+
+/* Scales 16 source alphas by the global alpha */
+VLC_TARGET
+static inline __m128i AlphaSSE(__m128i src_a, __m128i alpha)
+{
+    const __m128i lo = _mm_mullo_epi16(_mm_cvtepu8_epi16(src_a), alpha);
+    const __m128i hi = _mm_mullo_epi16(
+        _mm_unpackhi_epi8(src_a, _mm_setzero_si128()), alpha);
+
+    return _mm_packus_epi16(Div255SSE(lo), Div255SSE(hi));
+}
+
+VLC_TARGET
+static inline __m128i MergeSSE(__m128i d, __m128i s, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i alo = _mm_cvtepu8_epi16(a);
+    const __m128i ahi = _mm_unpackhi_epi8(a, zero);
+
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_sub_epi16(c255, alo), _mm_cvtepu8_epi16(d)),
+        _mm_mullo_epi16(alo, _mm_cvtepu8_epi16(s)));
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_sub_epi16(c255, ahi), _mm_unpackhi_epi8(d, zero)),
+        _mm_mullo_epi16(ahi, _mm_unpackhi_epi8(s, zero)));
+
+    return _mm_packus_epi16(Div255SSE(lo), Div255SSE(hi));
+}
+
+/* Keeps the even bytes, as 16-bit words */
+VLC_TARGET
+static inline __m128i EvenSSE(const uint8_t *p)
+{
+    return _mm_and_si128(_mm_loadu_si128((const __m128i *)p),
+                         _mm_set1_epi16(0xff));
+}
+
+VLC_TARGET
+static void PlaneSSE4_1(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                        unsigned width, unsigned alpha)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i a = AlphaSSE(_mm_loadu_si128((const __m128i *)&src_a[x]),
+                                   va);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[x]);
+        const __m128i s = _mm_loadu_si128((const __m128i *)&src[x]);
+
+        _mm_storeu_si128((__m128i *)&dst[x], MergeSSE(d, s, a));
+    }
+    PlaneC(&dst[x], &src[x], &src_a[x], width - x, alpha);
+}
+
+VLC_TARGET
+static void ChromaSSE4_1(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u,
+                         const uint8_t *src_v, const uint8_t *src_a,
+                         unsigned width, unsigned alpha)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+
+    /* 8 U and 8 V samples at once */
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i s = _mm_packus_epi16(EvenSSE(&src_u[x]),
+                                           EvenSSE(&src_v[x]));
+        const __m128i sa = _mm_packus_epi16(EvenSSE(&src_a[x]),
+                                            EvenSSE(&src_a[x]));
+        const __m128i d = _mm_unpacklo_epi64(
+            _mm_loadl_epi64((const __m128i *)&dst_u[x / 2]),
+            _mm_loadl_epi64((const __m128i *)&dst_v[x / 2]));
+        const __m128i r = MergeSSE(d, s, AlphaSSE(sa, va));
+
+        _mm_storel_epi64((__m128i *)&dst_u[x / 2], r);
+        _mm_storel_epi64((__m128i *)&dst_v[x / 2], _mm_unpackhi_epi64(r, r));
+    }
+    ChromaC(&dst_u[x / 2], &dst_v[x / 2], &src_u[x], &src_v[x], &src_a[x],
+            width - x, alpha);
+}
+
+VLC_TARGET
+static void ChromaSemiSSE4_1(uint8_t *dst_uv, const uint8_t *src_u,
+                             const uint8_t *src_v, const uint8_t *src_a,
+                             unsigned width, unsigned alpha)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i s = _mm_or_si128(EvenSSE(&src_u[x]),
+                                       _mm_slli_epi16(EvenSSE(&src_v[x]), 8));
+        const __m128i ea = EvenSSE(&src_a[x]);
+        const __m128i sa = _mm_or_si128(ea, _mm_slli_epi16(ea, 8));
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst_uv[x]);
+
+        _mm_storeu_si128((__m128i *)&dst_uv[x],
+                         MergeSSE(d, s, AlphaSSE(sa, va)));
+    }
+    ChromaSemiC(&dst_uv[x], &src_u[x], &src_v[x], &src_a[x], width - x,
+                alpha);
+}
+
+/* Shuffles the R, G and B bytes of 4 pixels (in this order, A ignored) to
+ * their destination offsets, and the alpha to the same offsets */
+VLC_TARGET
+static inline void ShufflesSSE(const blend_rgb32_t *o, __m128i *rgb,
+                               __m128i *a)
+{
+    int8_t m_rgb[16], m_a[16];
+
+    for (unsigned i = 0; i < 16; i++)
+        m_rgb[i] = m_a[i] = -1;
+    for (unsigned i = 0; i < 16; i += 4)
+    {
+        m_rgb[i + o->r] = i + 0;
+        m_rgb[i + o->g] = i + 1;
+        m_rgb[i + o->b] = i + 2;
+        m_a[i + o->r] = m_a[i + o->g] = m_a[i + o->b] = i + 3;
+    }
+    *rgb = _mm_loadu_si128((const __m128i *)m_rgb);
+    *a = _mm_loadu_si128((const __m128i *)m_a);
+}
+
+VLC_TARGET
+static void RGBAToRGB32SSE4_1(uint8_t *dst, const uint8_t *src, unsigned width,
+                              unsigned alpha, const blend_rgb32_t *o)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    __m128i m_rgb, m_a;
+    unsigned x = 0;
+
+    ShufflesSSE(o, &m_rgb, &m_a);
+    for (; x + 4 <= width; x += 4)
+    {
+        const __m128i p = _mm_loadu_si128((const __m128i *)&src[4 * x]);
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * x]);
+        const __m128i a = AlphaSSE(_mm_shuffle_epi8(p, m_a), va);
+
+        _mm_storeu_si128((__m128i *)&dst[4 * x],
+                         MergeSSE(d, _mm_shuffle_epi8(p, m_rgb), a));
+    }
+    RGBAToRGB32C(&dst[4 * x], &src[4 * x], width - x, alpha, o);
+}
+
+/* Computes one component of 4 pixels from interleaved 16-bit terms */
+VLC_TARGET
+static inline __m128i ComponentSSE(__m128i t0, __m128i k0, __m128i t1,
+                                   __m128i k1)
+{
+    const __m128i v = _mm_add_epi32(_mm_madd_epi16(t0, k0),
+                                    _mm_madd_epi16(t1, k1));
+    return _mm_srai_epi32(v, SCALEBITS);
+}
+
+#define PAIR(lo, hi) _mm_set1_epi32(((uint32_t)(hi) << 16) | ((lo) & 0xffff))
+
+VLC_TARGET
+static void YUVAToRGB32SSE4_1(uint8_t *dst, const uint8_t *src_y,
+                              const uint8_t *src_u, const uint8_t *src_v,
+                              const uint8_t *src_a, unsigned width,
+                              unsigned alpha, const blend_rgb32_t *o)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    /* (y, cr) and (cr, 1) pairs for R, (y, cb) and (cr, 1) for G and B */
+    const __m128i k_r = PAIR(FIX_Y, FIX_RV);
+    const __m128i k_g = PAIR(FIX_Y, -FIX_GU);
+    const __m128i k_g1 = PAIR(-FIX_GV, ONE_HALF);
+    const __m128i k_b = PAIR(FIX_Y, FIX_BU);
+    const __m128i k_1 = PAIR(0, ONE_HALF);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i c255 = _mm_set1_epi16(255);
+    __m128i m_rgb, m_a;
+    unsigned x = 0;
+
+    ShufflesSSE(o, &m_rgb, &m_a);
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i y = _mm_sub_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&src_y[x])),
+            _mm_set1_epi16(16));
+        const __m128i cb = _mm_sub_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&src_u[x])),
+            _mm_set1_epi16(128));
+        const __m128i cr = _mm_sub_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&src_v[x])),
+            _mm_set1_epi16(128));
+        const __m128i ycr[2] = { _mm_unpacklo_epi16(y, cr),
+                                 _mm_unpackhi_epi16(y, cr) };
+        const __m128i ycb[2] = { _mm_unpacklo_epi16(y, cb),
+                                 _mm_unpackhi_epi16(y, cb) };
+        const __m128i cr1[2] = { _mm_unpacklo_epi16(cr, one),
+                                 _mm_unpackhi_epi16(cr, one) };
+        __m128i r, g, b;
+
+        r = _mm_packs_epi32(ComponentSSE(ycr[0], k_r, one, k_1),
+                            ComponentSSE(ycr[1], k_r, one, k_1));
+        g = _mm_packs_epi32(ComponentSSE(ycb[0], k_g, cr1[0], k_g1),
+                            ComponentSSE(ycb[1], k_g, cr1[1], k_g1));
+        b = _mm_packs_epi32(ComponentSSE(ycb[0], k_b, one, k_1),
+                            ComponentSSE(ycb[1], k_b, one, k_1));
+        r = _mm_min_epi16(_mm_max_epi16(r, _mm_setzero_si128()), c255);
+        g = _mm_min_epi16(_mm_max_epi16(g, _mm_setzero_si128()), c255);
+        b = _mm_min_epi16(_mm_max_epi16(b, _mm_setzero_si128()), c255);
+
+        /* R G B A pixels, with the alpha scaled once for the 8 pixels */
+        const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&src_a[x])), 8));
+        const __m128i p[2] = { _mm_unpacklo_epi16(rg, ba),
+                               _mm_unpackhi_epi16(rg, ba) };
+
+        for (unsigned i = 0; i < 2; i++)
+        {
+            __m128i *pd = (__m128i *)&dst[4 * (x + 4 * i)];
+            const __m128i d = _mm_loadu_si128(pd);
+            const __m128i a = AlphaSSE(_mm_shuffle_epi8(p[i], m_a), va);
+
+            _mm_storeu_si128(pd, MergeSSE(d, _mm_shuffle_epi8(p[i], m_rgb), a));
+        }
+    }
+    YUVAToRGB32C(&dst[4 * x], &src_y[x], &src_u[x], &src_v[x], &src_a[x],
+                 width - x, alpha, o);
+}
+
+void blend_GetRowsSSE4_1(blend_rows_t *rows)
+{
+    rows->plane = PlaneSSE4_1;
+    rows->chroma = ChromaSSE4_1;
+    rows->chroma_semi = ChromaSemiSSE4_1;
+    rows->yuva_rgb32 = YUVAToRGB32SSE4_1;
+    rows->rgba_rgb32 = RGBAToRGB32SSE4_1;
+}
+#undef PAIR
+#undef VLC_TARGET
+#endif /* HAVE_BLEND_SSE4_1 */
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef HAVE_BLEND_AVX2
+#include <immintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static inline __m256i Div255AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                         _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+
+/* Unpacking and packing both work within the lanes, so the bytes are kept
+ * in order */
+VLC_TARGET
+static inline __m256i AlphaAVX2(__m256i src_a, __m256i alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(src_a, zero),
+                                          alpha);
+    const __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(src_a, zero),
+                                          alpha);
+
+    return _mm256_packus_epi16(Div255AVX2(lo), Div255AVX2(hi));
+}
+
+VLC_TARGET
+static inline __m256i MergeAVX2(__m256i d, __m256i s, __m256i a)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i alo = _mm256_unpacklo_epi8(a, zero);
+    const __m256i ahi = _mm256_unpackhi_epi8(a, zero);
+
+    __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_sub_epi16(c255, alo),
+                           _mm256_unpacklo_epi8(d, zero)),
+        _mm256_mullo_epi16(alo, _mm256_unpacklo_epi8(s, zero)));
+    __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_sub_epi16(c255, ahi),
+                           _mm256_unpackhi_epi8(d, zero)),
+        _mm256_mullo_epi16(ahi, _mm256_unpackhi_epi8(s, zero)));
+
+    return _mm256_packus_epi16(Div255AVX2(lo), Div255AVX2(hi));
+}
+
+VLC_TARGET
+static inline __m256i EvenAVX2(const uint8_t *p)
+{
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                            _mm256_set1_epi16(0xff));
+}
+
+VLC_TARGET
+static void PlaneAVX2(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                      unsigned width, unsigned alpha)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        const __m256i a = AlphaAVX2(
+            _mm256_loadu_si256((const __m256i *)&src_a[x]), va);
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[x]);
+        const __m256i s = _mm256_loadu_si256((const __m256i *)&src[x]);
+
+        _mm256_storeu_si256((__m256i *)&dst[x], MergeAVX2(d, s, a));
+    }
+    PlaneC(&dst[x], &src[x], &src_a[x], width - x, alpha);
+}
+
+VLC_TARGET
+static void ChromaAVX2(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u,
+                       const uint8_t *src_v, const uint8_t *src_a,
+                       unsigned width, unsigned alpha)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+
+    /* 16 U and 16 V samples at once, each lane holding 8 U then 8 V */
+    for (; x + 32 <= width; x += 32)
+    {
+        const __m256i s = _mm256_packus_epi16(EvenAVX2(&src_u[x]),
+                                              EvenAVX2(&src_v[x]));
+        const __m256i sa = _mm256_packus_epi16(EvenAVX2(&src_a[x]),
+                                               EvenAVX2(&src_a[x]));
+        const __m128i du = _mm_loadu_si128((const __m128i *)&dst_u[x / 2]);
+        const __m128i dv = _mm_loadu_si128((const __m128i *)&dst_v[x / 2]);
+        const __m256i d = _mm256_set_m128i(_mm_unpackhi_epi64(du, dv),
+                                           _mm_unpacklo_epi64(du, dv));
+        const __m256i r = MergeAVX2(d, s, AlphaAVX2(sa, va));
+        const __m128i rlo = _mm256_castsi256_si128(r);
+        const __m128i rhi = _mm256_extracti128_si256(r, 1);
+
+        _mm_storeu_si128((__m128i *)&dst_u[x / 2], _mm_unpacklo_epi64(rlo, rhi));
+        _mm_storeu_si128((__m128i *)&dst_v[x / 2], _mm_unpackhi_epi64(rlo, rhi));
+    }
+    ChromaC(&dst_u[x / 2], &dst_v[x / 2], &src_u[x], &src_v[x], &src_a[x],
+            width - x, alpha);
+}
+
+VLC_TARGET
+static void ChromaSemiAVX2(uint8_t *dst_uv, const uint8_t *src_u,
+                           const uint8_t *src_v, const uint8_t *src_a,
+                           unsigned width, unsigned alpha)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        const __m256i s = _mm256_or_si256(EvenAVX2(&src_u[x]),
+                                          _mm256_slli_epi16(EvenAVX2(&src_v[x]), 8));
+        const __m256i ea = EvenAVX2(&src_a[x]);
+        const __m256i sa = _mm256_or_si256(ea, _mm256_slli_epi16(ea, 8));
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst_uv[x]);
+
+        _mm256_storeu_si256((__m256i *)&dst_uv[x],
+                            MergeAVX2(d, s, AlphaAVX2(sa, va)));
+    }
+    ChromaSemiC(&dst_uv[x], &src_u[x], &src_v[x], &src_a[x], width - x,
+                alpha);
+}
+
+VLC_TARGET
+static inline void ShufflesAVX2(const blend_rgb32_t *o, __m256i *rgb,
+                                __m256i *a)
+{
+    int8_t m_rgb[32], m_a[32];
+
+    for (unsigned i = 0; i < 32; i++)
+        m_rgb[i] = m_a[i] = -1;
+    /* The shuffles index bytes within each lane */
+    for (unsigned i = 0; i < 32; i += 4)
+    {
+        m_rgb[i + o->r] = (i & 15) + 0;
+        m_rgb[i + o->g] = (i & 15) + 1;
+        m_rgb[i + o->b] = (i & 15) + 2;
+        m_a[i + o->r] = m_a[i + o->g] = m_a[i + o->b] = (i & 15) + 3;
+    }
+    *rgb = _mm256_loadu_si256((const __m256i *)m_rgb);
+    *a = _mm256_loadu_si256((const __m256i *)m_a);
+}
+
+VLC_TARGET
+static void RGBAToRGB32AVX2(uint8_t *dst, const uint8_t *src, unsigned width,
+                            unsigned alpha, const blend_rgb32_t *o)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    __m256i m_rgb, m_a;
+    unsigned x = 0;
+
+    ShufflesAVX2(o, &m_rgb, &m_a);
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m256i p = _mm256_loadu_si256((const __m256i *)&src[4 * x]);
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * x]);
+        const __m256i a = AlphaAVX2(_mm256_shuffle_epi8(p, m_a), va);
+
+        _mm256_storeu_si256((__m256i *)&dst[4 * x],
+                            MergeAVX2(d, _mm256_shuffle_epi8(p, m_rgb), a));
+    }
+    RGBAToRGB32C(&dst[4 * x], &src[4 * x], width - x, alpha, o);
+}
+
+VLC_TARGET
+static inline __m256i ComponentAVX2(__m256i t0, __m256i k0, __m256i t1,
+                                    __m256i k1)
+{
+    const __m256i v = _mm256_add_epi32(_mm256_madd_epi16(t0, k0),
+                                       _mm256_madd_epi16(t1, k1));
+    return _mm256_srai_epi32(v, SCALEBITS);
+}
+
+#define PAIR(lo, hi) _mm256_set1_epi32(((uint32_t)(hi) << 16) | ((lo) & 0xffff))
+
+VLC_TARGET
+static inline __m256i LoadAVX2(const uint8_t *p, int offset)
+{
+    return _mm256_sub_epi16(
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p)),
+        _mm256_set1_epi16(offset));
+}
+
+VLC_TARGET
+static void YUVAToRGB32AVX2(uint8_t *dst, const uint8_t *src_y,
+                            const uint8_t *src_u, const uint8_t *src_v,
+                            const uint8_t *src_a, unsigned width,
+                            unsigned alpha, const blend_rgb32_t *o)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    const __m256i k_r = PAIR(FIX_Y, FIX_RV);
+    const __m256i k_g = PAIR(FIX_Y, -FIX_GU);
+    const __m256i k_g1 = PAIR(-FIX_GV, ONE_HALF);
+    const __m256i k_b = PAIR(FIX_Y, FIX_BU);
+    const __m256i k_1 = PAIR(0, ONE_HALF);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c255 = _mm256_set1_epi16(255);
+    __m256i m_rgb, m_a;
+    unsigned x = 0;
+
+    ShufflesAVX2(o, &m_rgb, &m_a);
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m256i y = LoadAVX2(&src_y[x], 16);
+        const __m256i cb = LoadAVX2(&src_u[x], 128);
+        const __m256i cr = LoadAVX2(&src_v[x], 128);
+        const __m256i ycr[2] = { _mm256_unpacklo_epi16(y, cr),
+                                 _mm256_unpackhi_epi16(y, cr) };
+        const __m256i ycb[2] = { _mm256_unpacklo_epi16(y, cb),
+                                 _mm256_unpackhi_epi16(y, cb) };
+        const __m256i cr1[2] = { _mm256_unpacklo_epi16(cr, one),
+                                 _mm256_unpackhi_epi16(cr, one) };
+        __m256i r, g, b;
+
+        /* The packing undoes the unpacking: the pixels stay in order */
+        r = _mm256_packs_epi32(ComponentAVX2(ycr[0], k_r, one, k_1),
+                               ComponentAVX2(ycr[1], k_r, one, k_1));
+        g = _mm256_packs_epi32(ComponentAVX2(ycb[0], k_g, cr1[0], k_g1),
+                               ComponentAVX2(ycb[1], k_g, cr1[1], k_g1));
+        b = _mm256_packs_epi32(ComponentAVX2(ycb[0], k_b, one, k_1),
+                               ComponentAVX2(ycb[1], k_b, one, k_1));
+        r = _mm256_min_epi16(_mm256_max_epi16(r, zero), c255);
+        g = _mm256_min_epi16(_mm256_max_epi16(g, zero), c255);
+        b = _mm256_min_epi16(_mm256_max_epi16(b, zero), c255);
+
+        const __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        const __m256i ba = _mm256_or_si256(b,
+            _mm256_slli_epi16(LoadAVX2(&src_a[x], 0), 8));
+        const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+        const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+        const __m256i p[2] = { _mm256_permute2x128_si256(lo, hi, 0x20),
+                               _mm256_permute2x128_si256(lo, hi, 0x31) };
+
+        for (unsigned i = 0; i < 2; i++)
+        {
+            __m256i *pd = (__m256i *)&dst[4 * (x + 8 * i)];
+            const __m256i d = _mm256_loadu_si256(pd);
+            const __m256i a = AlphaAVX2(_mm256_shuffle_epi8(p[i], m_a), va);
+
+            _mm256_storeu_si256(pd,
+                MergeAVX2(d, _mm256_shuffle_epi8(p[i], m_rgb), a));
+        }
+    }
+    YUVAToRGB32C(&dst[4 * x], &src_y[x], &src_u[x], &src_v[x], &src_a[x],
+                 width - x, alpha, o);
+}
+
+void blend_GetRowsAVX2(blend_rows_t *rows)
+{
+    rows->plane = PlaneAVX2;
+    rows->chroma = ChromaAVX2;
+    rows->chroma_semi = ChromaSemiAVX2;
+    rows->yuva_rgb32 = YUVAToRGB32AVX2;
+    rows->rgba_rgb32 = RGBAToRGB32AVX2;
+}
+#undef PAIR
+#undef VLC_TARGET
+#endif /* HAVE_BLEND_AVX2 */
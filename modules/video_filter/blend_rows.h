@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * blend_rows.h : alpha blending row functions
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_BLEND_ROWS_H
+#define VLC_BLEND_ROWS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* All the rows give the same results as the generic blending of blend.cpp:
+ * the alpha of a pixel is a = div255(alpha * source alpha), and the
+ * components become div255((255 - a) * dst + a * src), which is exact for
+ * 8-bit samples (a null alpha leaves the destination unchanged). */
+
+/**
+ * Byte offsets of the components in a 32-bit RGB destination pixel.
+ * The remaining byte is left untouched.
+ */
+typedef struct
+{
+    uint8_t r, g, b;
+} blend_rgb32_t;
+
+typedef struct
+{
+    /* Blends a plane of a YUVA row onto a full resolution plane */
+    void (*plane)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                  unsigned width, unsigned alpha);
+    /* Blends the even pixels of the chroma of a YUVA row onto horizontally
+     * subsampled chroma planes */
+    void (*chroma)(uint8_t *dst_u, uint8_t *dst_v, const uint8_t *src_u,
+                   const uint8_t *src_v, const uint8_t *src_a,
+                   unsigned width, unsigned alpha);
+    /* Same as chroma, onto an interleaved U/V plane */
+    void (*chroma_semi)(uint8_t *dst_uv, const uint8_t *src_u,
+                        const uint8_t *src_v, const uint8_t *src_a,
+                        unsigned width, unsigned alpha);
+    /* Blends a YUVA row, converted to RGB, onto a 32-bit RGB row */
+    void (*yuva_rgb32)(uint8_t *dst, const uint8_t *src_y,
+                       const uint8_t *src_u, const uint8_t *src_v,
+                       const uint8_t *src_a, unsigned width, unsigned alpha,
+                       const blend_rgb32_t *);
+    /* Blends a RGBA row onto a 32-bit RGB row */
+    void (*rgba_rgb32)(uint8_t *dst, const uint8_t *src, unsigned width,
+                       unsigned alpha, const blend_rgb32_t *);
+} blend_rows_t;
+
+void blend_GetRowsC(blend_rows_t *);
+
+#ifdef HAVE_SSE2_INTRINSICS
+# define HAVE_BLEND_SSE4_1
+void blend_GetRowsSSE4_1(blend_rows_t *);
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+# define HAVE_BLEND_AVX2
+void blend_GetRowsAVX2(blend_rows_t *);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -57,7 +57,9 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
-#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
+#define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto. " \
+    "Without base and blend images, synthetic pictures are blended for " \
+    "each of the common chroma pairs.")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
 #define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
@@ -119,6 +121,134 @@ typedef struct
     vlc_fourcc_t i_blend_chroma;
 } filter_sys_t;
 
+/* Chroma pairs benchmarked without images, with the blend chroma first */
+static const struct
+{
+    vlc_fourcc_t i_blend;
+    vlc_fourcc_t i_base;
+} p_pairs[] = {
+    { VLC_CODEC_YUVA, VLC_CODEC_I420 },
+    { VLC_CODEC_YUVA, VLC_CODEC_YV12 },
+    { VLC_CODEC_YUVA, VLC_CODEC_NV12 },
+    { VLC_CODEC_YUVA, VLC_CODEC_I422 },
+    { VLC_CODEC_YUVA, VLC_CODEC_YUYV },
+    { VLC_CODEC_YUVA, VLC_CODEC_RGB32 },
+    { VLC_CODEC_YUVA, VLC_CODEC_RGBA },
+    { VLC_CODEC_RGBA, VLC_CODEC_I420 },
+    { VLC_CODEC_RGBA, VLC_CODEC_NV12 },
+    { VLC_CODEC_RGBA, VLC_CODEC_RGB32 },
+    { VLC_CODEC_RGBA, VLC_CODEC_RGBA },
+};
+
+#define SYNTHETIC_BASE_WIDTH   1920
+#define SYNTHETIC_BASE_HEIGHT  1080
+#define SYNTHETIC_BLEND_WIDTH  1280
+#define SYNTHETIC_BLEND_HEIGHT  720
+
+/* Creates a picture filled with noise: a quarter of the alphas is null, a
+ * quarter is opaque, like in subtitles */
+static picture_t *blendbench_NewPicture( vlc_fourcc_t i_chroma,
+                                         unsigned i_width, unsigned i_height )
+{
+    video_format_t fmt;
+    unsigned i_seed = i_chroma;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height, i_width, i_height,
+                        1, 1 );
+
+    picture_t *p_pic = picture_NewFromFormat( &fmt );
+    video_format_Clean( &fmt );
+    if( p_pic == NULL )
+        return NULL;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+
+        for( int j = 0; j < p->i_pitch * p->i_lines; j++ )
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+
+            unsigned r = i_seed >> 8;
+            p->p_pixels[j] = ( r & 3 ) == 0 ? 0 : ( r & 3 ) == 1 ? 255 : r >> 4;
+        }
+    }
+    return p_pic;
+}
+
+/* Blends the blend picture onto the base one, and returns the duration */
+static mtime_t blendbench_Run( filter_t *p_filter, picture_t *p_base,
+                               picture_t *p_blend, int x, int y )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_blender;
+
+    p_blender = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_blender )
+        return -1;
+    p_blender->fmt_out.video = p_base->format;
+    p_blender->fmt_in.video = p_blend->format;
+    p_blender->p_module = module_need( p_blender, "video blending", NULL,
+                                       false );
+    if( !p_blender->p_module )
+    {
+        vlc_object_release( p_blender );
+        return -1;
+    }
+
+    mtime_t time = mdate();
+    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    {
+        p_blender->pf_video_blend( p_blender, p_base, p_blend, x, y,
+                                   p_sys->i_alpha );
+    }
+    time = mdate() - time;
+
+    module_unneed( p_blender, p_blender->p_module );
+    vlc_object_release( p_blender );
+    return __MAX(time, 1);
+}
+
+static void blendbench_RunPairs( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const double f_pixels = (double)p_sys->i_loops
+                          * SYNTHETIC_BLEND_WIDTH * SYNTHETIC_BLEND_HEIGHT;
+
+    for( size_t i = 0; i < ARRAY_SIZE(p_pairs); i++ )
+    {
+        const vlc_fourcc_t i_blend = p_pairs[i].i_blend;
+        const vlc_fourcc_t i_base = p_pairs[i].i_base;
+        picture_t *p_base = blendbench_NewPicture( i_base,
+                                                   SYNTHETIC_BASE_WIDTH,
+                                                   SYNTHETIC_BASE_HEIGHT );
+        picture_t *p_blend = blendbench_NewPicture( i_blend,
+                                                    SYNTHETIC_BLEND_WIDTH,
+                                                    SYNTHETIC_BLEND_HEIGHT );
+        mtime_t time = -1;
+
+        /* Subtitles are laid out on even positions */
+        if( p_base != NULL && p_blend != NULL )
+            time = blendbench_Run( p_filter, p_base, p_blend,
+                ( SYNTHETIC_BASE_WIDTH - SYNTHETIC_BLEND_WIDTH ) / 2,
+                SYNTHETIC_BASE_HEIGHT - SYNTHETIC_BLEND_HEIGHT - 64 );
+
+        if( time < 0 )
+            msg_Warn( p_filter, "%4.4s onto %4.4s: cannot blend",
+                      (const char *)&i_blend, (const char *)&i_base );
+        else
+            msg_Info( p_filter, "%4.4s onto %4.4s: %8.2f Mpixels/s",
+                      (const char *)&i_blend, (const char *)&i_base,
+                      f_pixels / time );
+
+        if( p_base != NULL )
+            picture_Release( p_base );
+        if( p_blend != NULL )
+            picture_Release( p_blend );
+    }
+}
+
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
                                  vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
 {
@@ -176,6 +306,19 @@ static int Create( vlc_object_t *p_this )
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
 
+    p_sys->p_base_image = p_sys->p_blend_image = NULL;
+
+    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
+    psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
+    const bool b_synthetic = EMPTY_STR( psz_cmd ) || EMPTY_STR( psz_temp );
+    free( psz_temp );
+    free( psz_cmd );
+    if( b_synthetic )
+    {
+        msg_Dbg( p_filter, "no images, benchmarking the common chromas" );
+        return VLC_SUCCESS;
+    }
+
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
     p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
         VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
@@ -220,8 +363,11 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    if( p_sys->p_base_image != NULL )
+        picture_Release( p_sys->p_base_image );
+    if( p_sys->p_blend_image != NULL )
+        picture_Release( p_sys->p_blend_image );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -230,36 +376,25 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
 
     if( p_sys->b_done )
         return p_pic;
+    p_sys->b_done = true;
 
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
+    if( p_sys->p_base_image == NULL )
     {
-        picture_Release( p_pic );
-        return NULL;
+        blendbench_RunPairs( p_filter );
+        return p_pic;
     }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
+
+    mtime_t time = blendbench_Run( p_filter, p_sys->p_base_image,
+                                   p_sys->p_blend_image, 0, 0 );
+    if( time < 0 )
     {
         picture_Release( p_pic );
-        vlc_object_release( p_blend );
         return NULL;
     }
 
-    mtime_t time = mdate();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
-    {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
-    }
-    time = mdate() - time;
-
     msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
               time / (float)CLOCK_FREQ );
     msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
@@ -267,11 +402,5 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
               (float) p_sys->i_loops / time * CLOCK_FREQ *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
                   p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
-
-    module_unneed( p_blend, p_blend->p_module );
-
-    vlc_object_release( p_blend );
-
-    p_sys->b_done = true;
     return p_pic;
 }
@@ -0,0 +1,458 @@
+/*****************************************************************************
+ * blur_rows.c : separable gaussian blur row functions
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+
+#include "blur_rows.h"
+
+unsigned blur_Kernel(uint32_t *weights, double sigma)
+{
+    const unsigned dim = 3. * sigma;
+    double sum = 1.;
+
+    for (unsigned k = 1; k <= dim; k++)
+        sum += 2. * exp(-(double)(k * k) / (2. * sigma * sigma));
+
+    /* Rounding the cumulated tails rather than each weight keeps the sum of
+     * the weights exact, even for wide kernels of small weights */
+    const double scale = (1 << BLUR_WEIGHT_BITS) / sum;
+    double tail = 0.;
+    uint32_t prev = 0;
+    unsigned radius = 0;
+
+    for (unsigned k = dim; k > 0; k--)
+    {
+        const uint32_t rounded =
+            lround((tail += exp(-(double)(k * k) / (2. * sigma * sigma)))
+                   * scale);
+
+        weights[k] = rounded - prev;
+        prev = rounded;
+        if (radius == 0 && weights[k] != 0)
+            radius = k;
+    }
+    weights[0] = (1 << BLUR_WEIGHT_BITS) - 2 * prev;
+    return radius;
+}
+
+/*****************************************************************************
+ * C
+ *****************************************************************************/
+static void HorizontalC(uint16_t *dst, const uint16_t *src, unsigned width,
+                        const uint32_t *weights, unsigned radius,
+                        unsigned shift)
+{
+    const uint32_t round = (1u << shift) >> 1;
+
+    for (unsigned x = 0; x < width; x++)
+    {
+        const uint16_t *p = &src[x];
+        uint32_t sum = round + weights[0] * p[0];
+
+        for (unsigned k = 1; k <= radius; k++)
+            sum += weights[k] * (uint32_t)(p[-(ptrdiff_t)k] + p[k]);
+        dst[x] = sum >> shift;
+    }
+}
+
+static inline uint32_t VerticalSum(const uint16_t *const *src, unsigned x,
+                                   const uint32_t *weights, unsigned radius,
+                                   unsigned shift)
+{
+    uint32_t sum = ((1u << shift) >> 1) + weights[0] * src[radius][x];
+
+    for (unsigned k = 1; k <= radius; k++)
+        sum += weights[k] * (uint32_t)(src[radius - k][x] +
+                                       src[radius + k][x]);
+    return sum >> shift;
+}
+
+static void Vertical8C(uint8_t *dst, const uint16_t *const *src,
+                       unsigned width, const uint32_t *weights,
+                       unsigned radius, unsigned shift)
+{
+    for (unsigned x = 0; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+static void Vertical16C(uint16_t *dst, const uint16_t *const *src,
+                        unsigned width, const uint32_t *weights,
+                        unsigned radius, unsigned shift)
+{
+    for (unsigned x = 0; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+void blur_GetRowsC(blur_rows_t *rows)
+{
+    rows->horizontal = HorizontalC;
+    rows->vertical8 = Vertical8C;
+    rows->vertical16 = Vertical16C;
+}
+
+/* The SIMD rows sum eight samples at a time, in 32-bit lanes, and leave the
+ * last samples to the C code. */
+
+/*****************************************************************************
+ * SSE4.1
+ *****************************************************************************/
+#ifdef HAVE_BLUR_SSE4_1
+#include <smmintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("sse4.1")))
+
+/* Adds the weighted sums of 8 samples to lo and hi */
+VLC_TARGET
+static inline void MulAddSSE(__m128i *lo, __m128i *hi, __m128i v,
+                             __m128i weight)
+{
+    const __m128i vlo = _mm_cvtepu16_epi32(v);
+    const __m128i vhi = _mm_unpackhi_epi16(v, _mm_setzero_si128());
+
+    *lo = _mm_add_epi32(*lo, _mm_mullo_epi32(vlo, weight));
+    *hi = _mm_add_epi32(*hi, _mm_mullo_epi32(vhi, weight));
+}
+
+/* Adds the weighted sums of the pairs of 8 samples to lo and hi */
+VLC_TARGET
+static inline void MulAddPairSSE(__m128i *lo, __m128i *hi, __m128i a,
+                                 __m128i b, __m128i weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vlo = _mm_add_epi32(_mm_cvtepu16_epi32(a),
+                                      _mm_cvtepu16_epi32(b));
+    const __m128i vhi = _mm_add_epi32(_mm_unpackhi_epi16(a, zero),
+                                      _mm_unpackhi_epi16(b, zero));
+
+    *lo = _mm_add_epi32(*lo, _mm_mullo_epi32(vlo, weight));
+    *hi = _mm_add_epi32(*hi, _mm_mullo_epi32(vhi, weight));
+}
+
+/* Shifts the sums and packs them to 16 bits */
+VLC_TARGET
+static inline __m128i ShiftSSE(__m128i lo, __m128i hi, __m128i count)
+{
+    return _mm_packus_epi32(_mm_srl_epi32(lo, count),
+                            _mm_srl_epi32(hi, count));
+}
+
+VLC_TARGET
+static void HorizontalSSE4_1(uint16_t *dst, const uint16_t *src,
+                             unsigned width, const uint32_t *weights,
+                             unsigned radius, unsigned shift)
+{
+    const __m128i round = _mm_set1_epi32((1u << shift) >> 1);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const uint16_t *p = &src[x];
+        __m128i lo = round, hi = round;
+
+        MulAddSSE(&lo, &hi, _mm_loadu_si128((const __m128i *)p),
+                  _mm_set1_epi32(weights[0]));
+        for (unsigned k = 1; k <= radius; k++)
+            MulAddPairSSE(&lo, &hi, _mm_loadu_si128((const __m128i *)(p - k)),
+                          _mm_loadu_si128((const __m128i *)(p + k)),
+                          _mm_set1_epi32(weights[k]));
+        _mm_storeu_si128((__m128i *)&dst[x], ShiftSSE(lo, hi, count));
+    }
+    HorizontalC(&dst[x], &src[x], width - x, weights, radius, shift);
+}
+
+VLC_TARGET
+static inline __m128i VerticalSSE(const uint16_t *const *src, unsigned x,
+                                  const uint32_t *weights, unsigned radius,
+                                  unsigned shift)
+{
+    const __m128i round = _mm_set1_epi32((1u << shift) >> 1);
+    __m128i lo = round, hi = round;
+
+    MulAddSSE(&lo, &hi, _mm_loadu_si128((const __m128i *)&src[radius][x]),
+              _mm_set1_epi32(weights[0]));
+    for (unsigned k = 1; k <= radius; k++)
+        MulAddPairSSE(&lo, &hi,
+                      _mm_loadu_si128((const __m128i *)&src[radius - k][x]),
+                      _mm_loadu_si128((const __m128i *)&src[radius + k][x]),
+                      _mm_set1_epi32(weights[k]));
+    return ShiftSSE(lo, hi, _mm_cvtsi32_si128(shift));
+}
+
+VLC_TARGET
+static void Vertical8SSE4_1(uint8_t *dst, const uint16_t *const *src,
+                            unsigned width, const uint32_t *weights,
+                            unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i v = VerticalSSE(src, x, weights, radius, shift);
+
+        _mm_storel_epi64((__m128i *)&dst[x], _mm_packus_epi16(v, v));
+    }
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+VLC_TARGET
+static void Vertical16SSE4_1(uint16_t *dst, const uint16_t *const *src,
+                             unsigned width, const uint32_t *weights,
+                             unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+        _mm_storeu_si128((__m128i *)&dst[x],
+                         VerticalSSE(src, x, weights, radius, shift));
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+void blur_GetRowsSSE4_1(blur_rows_t *rows)
+{
+    rows->horizontal = HorizontalSSE4_1;
+    rows->vertical8 = Vertical8SSE4_1;
+    rows->vertical16 = Vertical16SSE4_1;
+}
+
+#undef VLC_TARGET
+#endif /* HAVE_BLUR_SSE4_1 */
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef HAVE_BLUR_AVX2
+#include <immintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static inline __m256i LoadAVX2(const uint16_t *p)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+}
+
+/* Shifts the sums and packs them to 16 bits */
+VLC_TARGET
+static inline __m128i ShiftAVX2(__m256i sum, __m128i count)
+{
+    sum = _mm256_srl_epi32(sum, count);
+    sum = _mm256_packus_epi32(sum, sum);
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(sum, 0x08));
+}
+
+VLC_TARGET
+static void HorizontalAVX2(uint16_t *dst, const uint16_t *src,
+                           unsigned width, const uint32_t *weights,
+                           unsigned radius, unsigned shift)
+{
+    const __m256i round = _mm256_set1_epi32((1u << shift) >> 1);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const uint16_t *p = &src[x];
+        __m256i sum = _mm256_add_epi32(round,
+            _mm256_mullo_epi32(LoadAVX2(p), _mm256_set1_epi32(weights[0])));
+
+        for (unsigned k = 1; k <= radius; k++)
+        {
+            const __m256i pair = _mm256_add_epi32(LoadAVX2(p - k),
+                                                  LoadAVX2(p + k));
+
+            sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(pair,
+                                            _mm256_set1_epi32(weights[k])));
+        }
+        _mm_storeu_si128((__m128i *)&dst[x], ShiftAVX2(sum, count));
+    }
+    HorizontalC(&dst[x], &src[x], width - x, weights, radius, shift);
+}
+
+VLC_TARGET
+static inline __m128i VerticalAVX2(const uint16_t *const *src, unsigned x,
+                                   const uint32_t *weights, unsigned radius,
+                                   unsigned shift)
+{
+    __m256i sum = _mm256_add_epi32(_mm256_set1_epi32((1u << shift) >> 1),
+        _mm256_mullo_epi32(LoadAVX2(&src[radius][x]),
+                           _mm256_set1_epi32(weights[0])));
+
+    for (unsigned k = 1; k <= radius; k++)
+    {
+        const __m256i pair = _mm256_add_epi32(LoadAVX2(&src[radius - k][x]),
+                                              LoadAVX2(&src[radius + k][x]));
+
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(pair,
+                                        _mm256_set1_epi32(weights[k])));
+    }
+    return ShiftAVX2(sum, _mm_cvtsi32_si128(shift));
+}
+
+VLC_TARGET
+static void Vertical8AVX2(uint8_t *dst, const uint16_t *const *src,
+                          unsigned width, const uint32_t *weights,
+                          unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i v = VerticalAVX2(src, x, weights, radius, shift);
+
+        _mm_storel_epi64((__m128i *)&dst[x], _mm_packus_epi16(v, v));
+    }
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+VLC_TARGET
+static void Vertical16AVX2(uint16_t *dst, const uint16_t *const *src,
+                           unsigned width, const uint32_t *weights,
+                           unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+        _mm_storeu_si128((__m128i *)&dst[x],
+                         VerticalAVX2(src, x, weights, radius, shift));
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+void blur_GetRowsAVX2(blur_rows_t *rows)
+{
+    rows->horizontal = HorizontalAVX2;
+    rows->vertical8 = Vertical8AVX2;
+    rows->vertical16 = Vertical16AVX2;
+}
+
+#undef VLC_TARGET
+#endif /* HAVE_BLUR_AVX2 */
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef HAVE_BLUR_NEON
+#include <arm_neon.h>
+
+/* Adds the weighted sums of 8 samples to lo and hi */
+static inline void MulAddNEON(uint32x4_t *lo, uint32x4_t *hi, uint16x8_t v,
+                              uint32_t weight)
+{
+    *lo = vmlaq_n_u32(*lo, vmovl_u16(vget_low_u16(v)), weight);
+    *hi = vmlaq_n_u32(*hi, vmovl_u16(vget_high_u16(v)), weight);
+}
+
+/* Adds the weighted sums of the pairs of 8 samples to lo and hi */
+static inline void MulAddPairNEON(uint32x4_t *lo, uint32x4_t *hi,
+                                  uint16x8_t a, uint16x8_t b, uint32_t weight)
+{
+    *lo = vmlaq_n_u32(*lo, vaddl_u16(vget_low_u16(a), vget_low_u16(b)),
+                      weight);
+    *hi = vmlaq_n_u32(*hi, vaddl_u16(vget_high_u16(a), vget_high_u16(b)),
+                      weight);
+}
+
+/* Shifts the sums and narrows them to 16 bits */
+static inline uint16x8_t ShiftNEON(uint32x4_t lo, uint32x4_t hi,
+                                   unsigned shift)
+{
+    const int32x4_t count = vdupq_n_s32(-(int32_t)shift);
+
+    return vcombine_u16(vmovn_u32(vshlq_u32(lo, count)),
+                        vmovn_u32(vshlq_u32(hi, count)));
+}
+
+static void HorizontalNEON(uint16_t *dst, const uint16_t *src,
+                           unsigned width, const uint32_t *weights,
+                           unsigned radius, unsigned shift)
+{
+    const uint32x4_t round = vdupq_n_u32((1u << shift) >> 1);
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const uint16_t *p = &src[x];
+        uint32x4_t lo = round, hi = round;
+
+        MulAddNEON(&lo, &hi, vld1q_u16(p), weights[0]);
+        for (unsigned k = 1; k <= radius; k++)
+            MulAddPairNEON(&lo, &hi, vld1q_u16(p - k), vld1q_u16(p + k),
+                           weights[k]);
+        vst1q_u16(&dst[x], ShiftNEON(lo, hi, shift));
+    }
+    HorizontalC(&dst[x], &src[x], width - x, weights, radius, shift);
+}
+
+static inline uint16x8_t VerticalNEON(const uint16_t *const *src, unsigned x,
+                                      const uint32_t *weights,
+                                      unsigned radius, unsigned shift)
+{
+    const uint32x4_t round = vdupq_n_u32((1u << shift) >> 1);
+    uint32x4_t lo = round, hi = round;
+
+    MulAddNEON(&lo, &hi, vld1q_u16(&src[radius][x]), weights[0]);
+    for (unsigned k = 1; k <= radius; k++)
+        MulAddPairNEON(&lo, &hi, vld1q_u16(&src[radius - k][x]),
+                       vld1q_u16(&src[radius + k][x]), weights[k]);
+    return ShiftNEON(lo, hi, shift);
+}
+
+static void Vertical8NEON(uint8_t *dst, const uint16_t *const *src,
+                          unsigned width, const uint32_t *weights,
+                          unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+        vst1_u8(&dst[x], vmovn_u16(VerticalNEON(src, x, weights, radius,
+                                                shift)));
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+static void Vertical16NEON(uint16_t *dst, const uint16_t *const *src,
+                           unsigned width, const uint32_t *weights,
+                           unsigned radius, unsigned shift)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+        vst1q_u16(&dst[x], VerticalNEON(src, x, weights, radius, shift));
+    for (; x < width; x++)
+        dst[x] = VerticalSum(src, x, weights, radius, shift);
+}
+
+void blur_GetRowsNEON(blur_rows_t *rows)
+{
+    rows->horizontal = HorizontalNEON;
+    rows->vertical8 = Vertical8NEON;
+    rows->vertical16 = Vertical16NEON;
+}
+#endif /* HAVE_BLUR_NEON */
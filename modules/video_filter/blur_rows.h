@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * blur_rows.h : separable gaussian blur row functions
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_BLUR_ROWS_H
+#define VLC_BLUR_ROWS_H
+
+/* The kernels are symmetric: weights[0] applies to the center sample, and
+ * weights[k] to both samples at distance k, up to the radius. The weights
+ * sum to 1 << BLUR_WEIGHT_BITS, so that the sums of 16-bit samples fit in
+ * 32 bits.
+ *
+ * The rows are blurred horizontally from the samples to 16-bit ones, shifted
+ * right by the depth of the samples, then vertically back to the samples,
+ * shifted right by 2 * BLUR_WEIGHT_BITS minus the depth. The sums are
+ * rounded, and never exceed the largest sample. */
+#define BLUR_WEIGHT_BITS 16
+
+/**
+ * Computes the kernel of a gaussian of the given standard deviation, in
+ * samples. The weights must have room for (int)(3 * sigma) + 1 values.
+ *
+ * \return the radius of the kernel, without its null weights
+ */
+unsigned blur_Kernel(uint32_t *weights, double sigma);
+
+typedef struct
+{
+    /* Blurs a row horizontally. The source row is readable from -radius to
+     * width + radius - 1. */
+    void (*horizontal)(uint16_t *dst, const uint16_t *src, unsigned width,
+                       const uint32_t *weights, unsigned radius,
+                       unsigned shift);
+    /* Blurs a row vertically, from the 2 * radius + 1 rows centered on
+     * src[radius], to 8 or 16-bit samples */
+    void (*vertical8)(uint8_t *dst, const uint16_t *const *src,
+                      unsigned width, const uint32_t *weights,
+                      unsigned radius, unsigned shift);
+    void (*vertical16)(uint16_t *dst, const uint16_t *const *src,
+                       unsigned width, const uint32_t *weights,
+                       unsigned radius, unsigned shift);
+} blur_rows_t;
+
+void blur_GetRowsC(blur_rows_t *);
+
+#ifdef HAVE_SSE2_INTRINSICS
+# define HAVE_BLUR_SSE4_1
+void blur_GetRowsSSE4_1(blur_rows_t *);
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+# define HAVE_BLUR_AVX2
+void blur_GetRowsAVX2(blur_rows_t *);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define HAVE_BLUR_NEON
+void blur_GetRowsNEON(blur_rows_t *);
+#endif
+
+#endif
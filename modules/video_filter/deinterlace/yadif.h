@@ -147,7 +147,137 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     int x;
     uint16_t *prev2= parity ? prev : cur ;
     uint16_t *next2= parity ? cur  : next;
+    w /= 2;
     mrefs /= 2;
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================= AVX2 =================
+#include <immintrin.h>
+
+#define HAVE_YADIF_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#define vec_t __m256i
+#define mask_t __m256i
+#define VAND(m,n) _mm256_and_si256(m, n)
+#define VSEL(m,a,b) _mm256_blendv_epi8(b, a, m)
+
+/* 8-bit samples on 16-bit lanes */
+#define RENAME(a) a ## _avx2
+#define pixel_t uint8_t
+#define VSTEP 16
+#define VLOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define VSTORE(p,v) _mm_storeu_si128((__m128i *)(p), \
+    _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)))
+#define VADD(a,b) _mm256_add_epi16(a, b)
+#define VSUB(a,b) _mm256_sub_epi16(a, b)
+#define VABS(a) _mm256_abs_epi16(a)
+#define VMIN(a,b) _mm256_min_epi16(a, b)
+#define VMAX(a,b) _mm256_max_epi16(a, b)
+#define VNEG(a) _mm256_sub_epi16(_mm256_setzero_si256(), a)
+#define VHALF(a) _mm256_srai_epi16(a, 1)
+#define VLT(a,b) _mm256_cmpgt_epi16(b, a)
+#define VONE _mm256_set1_epi16(1)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel_t
+#undef VSTEP
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VHALF
+#undef VLT
+#undef VONE
+
+/* 9 to 16-bit samples on 32-bit lanes */
+#define RENAME(a) a ## _16bit_avx2
+#define pixel_t uint16_t
+#define VSTEP 8
+#define VLOAD(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define VSTORE(p,v) _mm_storeu_si128((__m128i *)(p), \
+    _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)))
+#define VADD(a,b) _mm256_add_epi32(a, b)
+#define VSUB(a,b) _mm256_sub_epi32(a, b)
+#define VABS(a) _mm256_abs_epi32(a)
+#define VMIN(a,b) _mm256_min_epi32(a, b)
+#define VMAX(a,b) _mm256_max_epi32(a, b)
+#define VNEG(a) _mm256_sub_epi32(_mm256_setzero_si256(), a)
+#define VHALF(a) _mm256_srai_epi32(a, 1)
+#define VLT(a,b) _mm256_cmpgt_epi32(b, a)
+#define VONE _mm256_set1_epi32(1)
+#include "yadif_simd.h"
+#undef RENAME
+#undef pixel_t
+#undef VSTEP
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VHALF
+#undef VLT
+#undef VONE
+
+#undef VLC_TARGET
+#undef vec_t
+#undef mask_t
+#undef VAND
+#undef VSEL
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+// ================= NEON =================
+#include <arm_neon.h>
+
+/* 8-bit samples on 16-bit lanes */
+#define HAVE_YADIF_NEON
+#define VLC_TARGET
+#define RENAME(a) a ## _neon
+#define pixel_t uint8_t
+#define vec_t int16x8_t
+#define mask_t uint16x8_t
+#define VSTEP 8
+#define VLOAD(p) vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)))
+#define VSTORE(p,v) vst1_u8(p, vqmovun_s16(v))
+#define VADD(a,b) vaddq_s16(a, b)
+#define VSUB(a,b) vsubq_s16(a, b)
+#define VABS(a) vabsq_s16(a)
+#define VMIN(a,b) vminq_s16(a, b)
+#define VMAX(a,b) vmaxq_s16(a, b)
+#define VNEG(a) vnegq_s16(a)
+#define VHALF(a) vshrq_n_s16(a, 1)
+#define VLT(a,b) vcltq_s16(a, b)
+#define VAND(m,n) vandq_u16(m, n)
+#define VSEL(m,a,b) vbslq_s16(m, a, b)
+#define VONE vdupq_n_s16(1)
+#include "yadif_simd.h"
+#undef VLC_TARGET
+#undef RENAME
+#undef pixel_t
+#undef vec_t
+#undef mask_t
+#undef VSTEP
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VSUB
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VNEG
+#undef VHALF
+#undef VLT
+#undef VAND
+#undef VSEL
+#undef VONE
+#endif
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * yadif_simd.h : Yadif line filter on compiler vector intrinsics
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/* This template computes the same results as the C FILTER of yadif.h, for
+ * VSTEP samples at once, and uses FILTER for the remaining samples of the
+ * line. The samples are widened to signed lanes large enough for all the
+ * intermediate sums.
+ *
+ * It must be included after FILTER is defined, with:
+ *  - RENAME(a): name of the function,
+ *  - VLC_TARGET: attributes of the function,
+ *  - pixel_t: type of a sample,
+ *  - vec_t, mask_t: types of a vector of signed lanes, and of a comparison
+ *    result,
+ *  - VSTEP: number of lanes,
+ *  - VLOAD(p), VSTORE(p,v): widening load and saturating narrowing store,
+ *  - VADD, VSUB, VABS, VMIN, VMAX, VNEG: lane-wise arithmetic,
+ *  - VHALF(v): arithmetic shift right by one,
+ *  - VLT(a,b): a < b comparison, VAND(m,n): mask intersection,
+ *  - VSEL(m,a,b): a where m is set, b elsewhere,
+ *  - VONE: all lanes set to one.
+ */
+
+/* Score and prediction of the spatial interpolation along direction j */
+#define VSCORE(j) \
+    VADD(VADD(VABS(VSUB(VLOAD(&cur[mrefs-1+(j)]), VLOAD(&cur[prefs-1-(j)]))), \
+              VABS(VSUB(VLOAD(&cur[mrefs  +(j)]), VLOAD(&cur[prefs  -(j)])))), \
+              VABS(VSUB(VLOAD(&cur[mrefs+1+(j)]), VLOAD(&cur[prefs+1-(j)]))))
+#define VPRED(j) \
+    VHALF(VADD(VLOAD(&cur[mrefs+(j)]), VLOAD(&cur[prefs-(j)])))
+
+/* Same as CHECK(j): m is set where the direction is better. The second
+ * direction of each side is only tried where the first one was better, as
+ * the C version nests the checks. */
+#define VCHECK(j, m) \
+    { \
+        vec_t score = VSCORE(j); \
+        m = VLT(score, spatial_score); \
+        spatial_score = VSEL(m, score, spatial_score); \
+        spatial_pred = VSEL(m, VPRED(j), spatial_pred); \
+    }
+#define VCHECK_NESTED(j, m) \
+    { \
+        vec_t score = VSCORE(j); \
+        m = VAND(m, VLT(score, spatial_score)); \
+        spatial_score = VSEL(m, score, spatial_score); \
+        spatial_pred = VSEL(m, VPRED(j), spatial_pred); \
+    }
+
+VLC_TARGET
+static void RENAME(yadif_filter_line)(uint8_t *dst8, uint8_t *prev8,
+                                      uint8_t *cur8, uint8_t *next8, int w,
+                                      int prefs, int mrefs, int parity,
+                                      int mode)
+{
+    pixel_t *dst = (pixel_t *)dst8;
+    pixel_t *prev = (pixel_t *)prev8;
+    pixel_t *cur = (pixel_t *)cur8;
+    pixel_t *next = (pixel_t *)next8;
+    pixel_t *prev2 = parity ? prev : cur ;
+    pixel_t *next2 = parity ? cur  : next;
+    int x;
+
+    w /= sizeof (pixel_t);
+    mrefs /= (int)sizeof (pixel_t);
+    prefs /= (int)sizeof (pixel_t);
+
+    for (; w >= VSTEP; w -= VSTEP) {
+        vec_t c = VLOAD(&cur[mrefs]);
+        vec_t e = VLOAD(&cur[prefs]);
+        vec_t p2 = VLOAD(prev2);
+        vec_t n2 = VLOAD(next2);
+        vec_t d = VHALF(VADD(p2, n2));
+        vec_t temporal_diff0 = VABS(VSUB(p2, n2));
+        vec_t temporal_diff1 = VHALF(VADD(VABS(VSUB(VLOAD(&prev[mrefs]), c)),
+                                          VABS(VSUB(VLOAD(&prev[prefs]), e))));
+        vec_t temporal_diff2 = VHALF(VADD(VABS(VSUB(VLOAD(&next[mrefs]), c)),
+                                          VABS(VSUB(VLOAD(&next[prefs]), e))));
+        vec_t diff = VMAX(VMAX(VHALF(temporal_diff0), temporal_diff1),
+                          temporal_diff2);
+        vec_t spatial_pred = VHALF(VADD(c, e));
+        vec_t spatial_score =
+            VSUB(VADD(VADD(VABS(VSUB(VLOAD(&cur[mrefs-1]), VLOAD(&cur[prefs-1]))),
+                           VABS(VSUB(c, e))),
+                      VABS(VSUB(VLOAD(&cur[mrefs+1]), VLOAD(&cur[prefs+1])))),
+                 VONE);
+        mask_t m;
+
+        VCHECK(-1, m) VCHECK_NESTED(-2, m)
+        VCHECK( 1, m) VCHECK_NESTED( 2, m)
+
+        if (mode < 2) {
+            vec_t b = VHALF(VADD(VLOAD(&prev2[2*mrefs]), VLOAD(&next2[2*mrefs])));
+            vec_t f = VHALF(VADD(VLOAD(&prev2[2*prefs]), VLOAD(&next2[2*prefs])));
+            vec_t de = VSUB(d, e);
+            vec_t dc = VSUB(d, c);
+            vec_t bc = VSUB(b, c);
+            vec_t fe = VSUB(f, e);
+            vec_t max = VMAX(VMAX(de, dc), VMIN(bc, fe));
+            vec_t min = VMIN(VMIN(de, dc), VMAX(bc, fe));
+
+            diff = VMAX(VMAX(diff, min), VNEG(max));
+        }
+
+        /* diff is never negative, so this is the same as the C clipping */
+        spatial_pred = VMAX(VMIN(spatial_pred, VADD(d, diff)), VSUB(d, diff));
+        VSTORE(dst, spatial_pred);
+
+        dst += VSTEP;
+        cur += VSTEP;
+        prev += VSTEP;
+        next += VSTEP;
+        prev2 += VSTEP;
+        next2 += VSTEP;
+    }
+
+    FILTER
+}
+
+#undef VSCORE
+#undef VPRED
+#undef VCHECK
+#undef VCHECK_NESTED
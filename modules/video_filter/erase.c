@@ -214,15 +214,29 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
+    /* If the mask is empty: just pass a view of the image */
+    vlc_mutex_lock( &p_sys->lock );
+    if( !p_sys->p_mask )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+
+        p_outpic = picture_NewView( p_pic, 0, 0,
+                                    p_filter->fmt_in.video.i_width,
+                                    p_filter->fmt_in.video.i_height, false );
+        if( p_outpic )
+            return CopyInfoAndRelease( p_outpic, p_pic );
+
+        vlc_mutex_lock( &p_sys->lock );
+    }
+
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
+        vlc_mutex_unlock( &p_sys->lock );
         picture_Release( p_pic );
         return NULL;
     }
 
-    /* If the mask is empty: just copy the image */
-    vlc_mutex_lock( &p_sys->lock );
     if( p_sys->p_mask )
         FilterErase( p_filter, p_pic, p_outpic );
     else
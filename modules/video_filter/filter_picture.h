@@ -52,6 +52,37 @@
         CASE_PLANAR_YUV_SQUARE              \
         CASE_PLANAR_YUV_NONSQUARE           \
 
+/* Planar YUV with 9 to 16-bit samples in the native byte order */
+#ifdef WORDS_BIGENDIAN
+#   define CASE_PLANAR_YUV_HIGH_DEPTH       \
+        case VLC_CODEC_I420_9B:             \
+        case VLC_CODEC_I420_10B:            \
+        case VLC_CODEC_I420_12B:            \
+        case VLC_CODEC_I420_16B:            \
+        case VLC_CODEC_I422_9B:             \
+        case VLC_CODEC_I422_10B:            \
+        case VLC_CODEC_I422_12B:            \
+        case VLC_CODEC_I422_16B:            \
+        case VLC_CODEC_I444_9B:             \
+        case VLC_CODEC_I444_10B:            \
+        case VLC_CODEC_I444_12B:            \
+        case VLC_CODEC_I444_16B:
+#else
+#   define CASE_PLANAR_YUV_HIGH_DEPTH       \
+        case VLC_CODEC_I420_9L:             \
+        case VLC_CODEC_I420_10L:            \
+        case VLC_CODEC_I420_12L:            \
+        case VLC_CODEC_I420_16L:            \
+        case VLC_CODEC_I422_9L:             \
+        case VLC_CODEC_I422_10L:            \
+        case VLC_CODEC_I422_12L:            \
+        case VLC_CODEC_I422_16L:            \
+        case VLC_CODEC_I444_9L:             \
+        case VLC_CODEC_I444_10L:            \
+        case VLC_CODEC_I444_12L:            \
+        case VLC_CODEC_I444_16L:
+#endif
+
 #define CASE_PACKED_YUV_422                 \
         case VLC_CODEC_UYVY:   \
         case VLC_CODEC_YUYV:   \
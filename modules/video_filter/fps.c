@@ -32,6 +32,10 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
+#include <vlc_cpu.h>
+#include "filter_picture.h"
+#include "fps_mc.h"
 
 static int Open( vlc_object_t *p_this);
 static void Close( vlc_object_t *p_this);
@@ -40,6 +44,13 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture);
 #define CFG_PREFIX "fps-"
 
 #define FPS_TEXT N_( "Frame rate" )
+#define MODE_TEXT N_( "Conversion mode" )
+#define MODE_LONGTEXT N_( "Method used to create the pictures missing " \
+    "from the input when increasing the frame rate." )
+
+static const char *const mode_list[] = { "dup", "blend", "mc" };
+static const char *const mode_list_text[] = {
+    N_("Duplicate"), N_("Blend"), N_("Motion compensated") };
 
 vlc_module_begin ()
     set_description( N_("FPS conversion video filter") )
@@ -50,23 +61,177 @@ vlc_module_begin ()
 
     add_shortcut( "fps" )
     add_string( CFG_PREFIX "fps", NULL, FPS_TEXT, FPS_TEXT, false )
+    add_string( CFG_PREFIX "mode", "dup", MODE_TEXT, MODE_LONGTEXT, false )
+        change_string_list( mode_list, mode_list_text )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "fps",
+    "fps", "mode",
     NULL
 };
 
+enum
+{
+    MODE_DUP,
+    MODE_BLEND,
+    MODE_MC,
+};
+
+/* Input pictures whose output counts make the cadence */
+#define CADENCE_HISTORY 16
+
 /* We'll store pointer for previous picture we have received
-   and copy that if needed on framerate increase (not preferred)*/
+   and copy that if needed on framerate increase (not preferred),
+   or interpolate it with the next one */
 typedef struct
 {
     date_t          next_output_pts; /**< output calculated PTS */
     picture_t       *p_previous_pic;
+    mtime_t         i_previous_date; /**< input PTS of the previous picture */
     int             i_output_frame_interval;
+    int             i_input_frame_interval; /**< 0 if unknown */
+
+    int             i_mode;
+    fps_mc_functions_t functions;
+    fps_mc_field_t  field;
+    unsigned        i_bands;
+    bool            b_predicted; /**< the last vectors predict the motion */
+
+    /* Output pictures of the last input pictures, oldest first */
+    uint8_t         cadence[CADENCE_HISTORY];
+    unsigned        i_cadence;
+    char            psz_cadence[4 * CADENCE_HISTORY];
 } filter_sys_t;
 
+/* Records the output pictures of an input picture, and publishes the
+ * cadence as its repeating pattern, or as the last counts if none */
+static void PushCadence( filter_t *p_filter, unsigned i_outputs )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->i_cadence == CADENCE_HISTORY )
+    {
+        memmove( p_sys->cadence, p_sys->cadence + 1, CADENCE_HISTORY - 1 );
+        p_sys->i_cadence--;
+    }
+    p_sys->cadence[p_sys->i_cadence++] = __MIN( i_outputs, 255 );
+
+    unsigned i_period = p_sys->i_cadence;
+    for( unsigned p = 1; 2 * p <= p_sys->i_cadence; p++ )
+        if( !memcmp( p_sys->cadence, p_sys->cadence + p, p_sys->i_cadence - p ) )
+        {
+            i_period = p;
+            break;
+        }
+    /* The pattern ends with the last input */
+    const uint8_t *p_counts = p_sys->cadence + p_sys->i_cadence - i_period;
+
+    char psz_cadence[sizeof (p_sys->psz_cadence)];
+    size_t i_len = 0;
+    for( unsigned i = 0; i < i_period; i++ )
+        i_len += snprintf( psz_cadence + i_len, sizeof (psz_cadence) - i_len,
+                           i ? ":%u" : "%u", p_counts[i] );
+
+    if( !strcmp( psz_cadence, p_sys->psz_cadence ) )
+        return;
+    if( p_sys->i_cadence == CADENCE_HISTORY && i_period <= CADENCE_HISTORY / 2 )
+        msg_Dbg( p_filter, "cadence %s", psz_cadence );
+    strcpy( p_sys->psz_cadence, psz_cadence );
+    var_SetString( p_filter->obj.parent, CFG_PREFIX "cadence", psz_cadence );
+}
+
+typedef struct
+{
+    filter_sys_t    *p_sys;
+    picture_t       *p_out;
+    const picture_t *p_a, *p_b;
+    unsigned        i_phase;
+} mc_job_t;
+
+static void EstimateSlice( void *opaque, unsigned index, unsigned count )
+{
+    mc_job_t *job = opaque;
+    fps_mc_field_t *field = &job->p_sys->field;
+    unsigned i_begin, i_end;
+
+    /* The bands depend on the picture size only, as the predictors of a
+     * block depend on its band */
+    fps_mc_Band( field, index, &i_begin, &i_end );
+    VLC_UNUSED( count );
+    fps_mc_Estimate( field, job->p_a, job->p_b, job->i_phase, i_begin, i_end );
+}
+
+static void CompensateSlice( void *opaque, unsigned index, unsigned count )
+{
+    mc_job_t *job = opaque;
+    filter_sys_t *p_sys = job->p_sys;
+    unsigned i_begin, i_end;
+
+    fps_mc_Band( &p_sys->field, index, &i_begin, &i_end );
+    VLC_UNUSED( count );
+    fps_mc_Compensate( p_sys->i_mode == MODE_MC ? &p_sys->field : NULL,
+                       &p_sys->functions, job->p_out, job->p_a, job->p_b,
+                       job->i_phase, i_begin, i_end );
+}
+
+/* Creates the picture at i_date between the previous picture and p_next,
+ * or returns NULL if the previous picture should be repeated */
+static picture_t *Interpolate( filter_t *p_filter, picture_t *p_next,
+                               mtime_t i_date )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_prev = p_sys->p_previous_pic;
+    const mtime_t i_span = p_next->date - p_sys->i_previous_date;
+
+    if( p_sys->i_mode == MODE_DUP || i_span <= 0 )
+        return NULL;
+
+    const mtime_t i_phase =
+        ( ( i_date - p_sys->i_previous_date ) * 256 + i_span / 2 ) / i_span;
+    if( i_phase <= 0 )
+        return NULL;
+
+    picture_t *p_out = picture_NewFromFormat( &p_filter->fmt_out.video );
+    if( unlikely( p_out == NULL ) )
+        return NULL;
+
+    mc_job_t job = {
+        .p_sys = p_sys, .p_out = p_out, .p_a = p_prev, .p_b = p_next,
+        .i_phase = __MIN( i_phase, 255 ),
+    };
+
+    if( p_sys->i_mode == MODE_MC )
+    {
+        /* Without vectors to start from, a first pass provides them */
+        for( int i = p_sys->b_predicted ? 1 : 2; i > 0; i-- )
+        {
+            fps_mc_NewPicture( &p_sys->field );
+            vlc_slices_Run( p_filter, p_sys->i_bands, EstimateSlice, &job );
+        }
+
+        /* The motion does not explain most of the picture, as on scene
+         * changes: show the nearest picture rather than a blend of both */
+        unsigned i_estimated;
+        const unsigned i_unmatched =
+            fps_mc_CountUnmatched( &p_sys->field, &i_estimated );
+        if( 2 * i_unmatched > i_estimated )
+        {
+            msg_Dbg( p_filter, "scene change, %u of %u blocks unmatched",
+                     i_unmatched, i_estimated );
+            p_sys->b_predicted = false;
+            picture_CopyPixels( p_out, job.i_phase < 128 ? p_prev : p_next );
+            picture_CopyProperties( p_out, p_prev );
+            return p_out;
+        }
+        p_sys->b_predicted = true;
+    }
+
+    vlc_slices_Run( p_filter, p_sys->i_bands, CompensateSlice, &job );
+    picture_CopyProperties( p_out, p_prev );
+    return p_out;
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -84,9 +249,11 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
     p_picture->format.i_frame_rate_base = p_filter->fmt_out.video.i_frame_rate_base;
 
     /* First time we get some valid timestamp, we'll take it as base for output
-        later on we retake new timestamp if it has jumped too much */
+        later on we retake new timestamp if it has jumped too much, that is
+        more than an input interval after the next output */
     if( unlikely( ( date_Get( &p_sys->next_output_pts ) == VLC_TS_INVALID ) ||
-                   ( p_picture->date > ( date_Get( &p_sys->next_output_pts ) + (mtime_t)p_sys->i_output_frame_interval ) )
+                   ( p_picture->date > ( date_Get( &p_sys->next_output_pts ) + (mtime_t)p_sys->i_output_frame_interval
+                                         + p_sys->i_input_frame_interval ) )
                 ) )
     {
         msg_Dbg( p_filter, "Resetting timestamps" );
@@ -94,6 +261,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
         if( p_sys->p_previous_pic )
             picture_Release( p_sys->p_previous_pic );
         p_sys->p_previous_pic = picture_Hold( p_picture );
+        p_sys->i_previous_date = p_picture->date;
         date_Increment( &p_sys->next_output_pts, 1 );
         return p_picture;
     }
@@ -105,32 +273,49 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_picture)
         if( p_sys->p_previous_pic )
             picture_Release( p_sys->p_previous_pic );
         p_sys->p_previous_pic = p_picture;
+        p_sys->i_previous_date = p_picture->date;
+        PushCadence( p_filter, 0 );
         return NULL;
     }
 
-    p_sys->p_previous_pic->date = date_Get( &p_sys->next_output_pts );
+    picture_t *p_first = Interpolate( p_filter, p_picture,
+                                      date_Get( &p_sys->next_output_pts ) );
+    if( p_first == NULL )
+        p_first = picture_Hold( p_sys->p_previous_pic );
+    p_first->date = date_Get( &p_sys->next_output_pts );
+    p_first->p_next = NULL;
     date_Increment( &p_sys->next_output_pts, 1 );
 
-    picture_t *last_pic = p_sys->p_previous_pic;
+    picture_t *last_pic = p_first;
+    unsigned i_outputs = 1;
     /* Duplicating pictures are not that effective and framerate increase
-        should be avoided, it's only here as filter should work in that direction too*/
-    while( unlikely( (date_Get( &p_sys->next_output_pts ) + p_sys->i_output_frame_interval ) < p_picture->date ) )
+        should be avoided, it's only here as filter should work in that direction too.
+        The output pictures nearer to the new input are left to it */
+    while( unlikely( (date_Get( &p_sys->next_output_pts ) + p_sys->i_output_frame_interval / 2 ) < p_picture->date ) )
     {
-        picture_t *p_tmp = NULL;
-        p_tmp = picture_NewFromFormat( &p_filter->fmt_out.video );
-
-        picture_Copy( p_tmp, p_sys->p_previous_pic);
+        picture_t *p_tmp = Interpolate( p_filter, p_picture,
+                                        date_Get( &p_sys->next_output_pts ) );
+        if( p_tmp == NULL )
+        {
+            p_tmp = picture_NewFromFormat( &p_filter->fmt_out.video );
+            if( unlikely( p_tmp == NULL ) )
+                break;
+            picture_Copy( p_tmp, p_sys->p_previous_pic);
+        }
         p_tmp->date = date_Get( &p_sys->next_output_pts );
         p_tmp->p_next = NULL;
 
         last_pic->p_next = p_tmp;
         last_pic = p_tmp;
+        i_outputs++;
         date_Increment( &p_sys->next_output_pts, 1 );
     }
 
-    last_pic = p_sys->p_previous_pic;
+    picture_Release( p_sys->p_previous_pic );
     p_sys->p_previous_pic = p_picture;
-    return last_pic;
+    p_sys->i_previous_date = p_picture->date;
+    PushCadence( p_filter, i_outputs );
+    return p_first;
 }
 
 static int Open( vlc_object_t *p_this)
@@ -165,12 +350,74 @@ static int Open( vlc_object_t *p_this)
             p_filter->fmt_out.video.i_frame_rate, p_filter->fmt_out.video.i_frame_rate_base );
 
     p_sys->i_output_frame_interval = p_filter->fmt_out.video.i_frame_rate_base * CLOCK_FREQ / p_filter->fmt_out.video.i_frame_rate;
+    p_sys->i_input_frame_interval = 0;
+    if( p_filter->fmt_in.video.i_frame_rate != 0 )
+        p_sys->i_input_frame_interval = p_filter->fmt_in.video.i_frame_rate_base * CLOCK_FREQ / p_filter->fmt_in.video.i_frame_rate;
 
     date_Init( &p_sys->next_output_pts,
                p_filter->fmt_out.video.i_frame_rate, p_filter->fmt_out.video.i_frame_rate_base );
 
     date_Set( &p_sys->next_output_pts, VLC_TS_INVALID );
     p_sys->p_previous_pic = NULL;
+    p_sys->i_cadence = 0;
+    p_sys->psz_cadence[0] = '\0';
+
+    char *psz_mode = var_InheritString( p_filter, CFG_PREFIX "mode" );
+    p_sys->i_mode = MODE_DUP;
+    if( psz_mode != NULL && !strcmp( psz_mode, "blend" ) )
+        p_sys->i_mode = MODE_BLEND;
+    else if( psz_mode != NULL && !strcmp( psz_mode, "mc" ) )
+        p_sys->i_mode = MODE_MC;
+    free( psz_mode );
+
+    /* Pictures are only interpolated in 8-bit planar YUV */
+    const vlc_chroma_description_t *p_chroma =
+        vlc_fourcc_GetChromaDescription( p_filter->fmt_in.video.i_chroma );
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        CASE_PLANAR_YUV
+            if( p_chroma != NULL && p_chroma->pixel_size == 1 )
+                break;
+            /* fall through */
+        default:
+            if( p_sys->i_mode != MODE_DUP )
+            {
+                msg_Warn( p_filter, "Unsupported chroma (%4.4s), "
+                          "duplicating pictures",
+                          (char *)&p_filter->fmt_in.video.i_chroma );
+                p_sys->i_mode = MODE_DUP;
+            }
+    }
+
+    if( p_sys->i_mode != MODE_DUP )
+    {
+        fps_mc_GetFunctionsC( &p_sys->functions );
+#ifdef HAVE_FPS_MC_SSE2
+        if( vlc_CPU_SSE2() )
+            fps_mc_GetFunctionsSSE2( &p_sys->functions );
+#endif
+#ifdef HAVE_FPS_MC_AVX2
+        if( vlc_CPU_AVX2() )
+            fps_mc_GetFunctionsAVX2( &p_sys->functions );
+#endif
+#ifdef HAVE_FPS_MC_NEON
+        if( vlc_CPU_ARM_NEON() )
+            fps_mc_GetFunctionsNEON( &p_sys->functions );
+#endif
+        if( fps_mc_Init( &p_sys->field, p_filter->fmt_in.video.i_visible_width,
+                         p_filter->fmt_in.video.i_visible_height, p_chroma,
+                         &p_sys->functions ) )
+        {
+            free( p_sys );
+            return VLC_ENOMEM;
+        }
+        p_sys->i_bands = fps_mc_CountBands( &p_sys->field );
+        p_sys->b_predicted = false;
+    }
+
+    /* The cadence is published on the parent, the video output for filters
+     * of its chains, where monitoring interfaces can read it */
+    var_Create( p_filter->obj.parent, CFG_PREFIX "cadence", VLC_VAR_STRING );
 
     p_filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
@@ -182,5 +429,8 @@ static void Close( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
     if( p_sys->p_previous_pic )
         picture_Release( p_sys->p_previous_pic );
+    if( p_sys->i_mode != MODE_DUP )
+        fps_mc_Clean( &p_sys->field );
+    var_Destroy( p_filter->obj.parent, CFG_PREFIX "cadence" );
     free( p_sys );
 }
@@ -0,0 +1,521 @@
+/*****************************************************************************
+ * fps_mc.c : motion compensated frame interpolation for the fps filter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+#include <vlc_fourcc.h>
+
+#include "fps_mc.h"
+
+/* Cost of a pixel of displacement, in SAD units, so that noise in flat
+ * areas does not pull the vectors away from smooth fields */
+#define LAMBDA 4
+
+/*****************************************************************************
+ * C
+ *****************************************************************************/
+static unsigned SAD16C(const uint8_t *a, ptrdiff_t a_pitch,
+                       const uint8_t *b, ptrdiff_t b_pitch)
+{
+    unsigned sad = 0;
+
+    for (unsigned y = 0; y < 16; y++, a += a_pitch, b += b_pitch)
+        for (unsigned x = 0; x < 16; x++)
+            sad += abs(a[x] - b[x]);
+    return sad;
+}
+
+static void BlendC(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                   unsigned width, unsigned phase)
+{
+    for (unsigned x = 0; x < width; x++)
+        dst[x] = (a[x] * (256 - phase) + b[x] * phase + 128) >> 8;
+}
+
+void fps_mc_GetFunctionsC(fps_mc_functions_t *f)
+{
+    f->sad16 = SAD16C;
+    f->blend = BlendC;
+}
+
+/*****************************************************************************
+ * SSE2
+ *****************************************************************************/
+#ifdef HAVE_FPS_MC_SSE2
+#include <emmintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("sse2")))
+
+VLC_TARGET
+static unsigned SAD16SSE2(const uint8_t *a, ptrdiff_t a_pitch,
+                          const uint8_t *b, ptrdiff_t b_pitch)
+{
+    __m128i sum = _mm_setzero_si128();
+
+    for (unsigned y = 0; y < 16; y++, a += a_pitch, b += b_pitch)
+        sum = _mm_add_epi64(sum,
+                            _mm_sad_epu8(_mm_loadu_si128((const __m128i *)a),
+                                         _mm_loadu_si128((const __m128i *)b)));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+    return _mm_cvtsi128_si32(sum);
+}
+
+/* Blends 8 pixels, as 16-bit lanes */
+VLC_TARGET
+static inline __m128i Blend8SSE2(__m128i a, __m128i b, __m128i wa, __m128i wb)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), wa),
+                              _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), wb));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(128)), 8);
+}
+
+VLC_TARGET
+static void BlendSSE2(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                      unsigned width, unsigned phase)
+{
+    const __m128i wa = _mm_set1_epi16(256 - phase);
+    const __m128i wb = _mm_set1_epi16(phase);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i *)&a[x]);
+        const __m128i vb = _mm_loadu_si128((const __m128i *)&b[x]);
+        const __m128i lo = Blend8SSE2(va, vb, wa, wb);
+        const __m128i hi = Blend8SSE2(_mm_srli_si128(va, 8),
+                                      _mm_srli_si128(vb, 8), wa, wb);
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_packus_epi16(lo, hi));
+    }
+    for (; x + 8 <= width; x += 8)
+    {
+        const __m128i v = Blend8SSE2(_mm_loadl_epi64((const __m128i *)&a[x]),
+                                     _mm_loadl_epi64((const __m128i *)&b[x]),
+                                     wa, wb);
+        _mm_storel_epi64((__m128i *)&dst[x], _mm_packus_epi16(v, v));
+    }
+    BlendC(&dst[x], &a[x], &b[x], width - x, phase);
+}
+
+void fps_mc_GetFunctionsSSE2(fps_mc_functions_t *f)
+{
+    f->sad16 = SAD16SSE2;
+    f->blend = BlendSSE2;
+}
+
+#undef VLC_TARGET
+#endif /* HAVE_FPS_MC_SSE2 */
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef HAVE_FPS_MC_AVX2
+#include <immintrin.h>
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+/* Loads two rows of 16 pixels */
+VLC_TARGET
+static inline __m256i Load2x16(const uint8_t *p, ptrdiff_t pitch)
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+        _mm_loadu_si128((const __m128i *)(p + pitch)), 1);
+}
+
+VLC_TARGET
+static unsigned SAD16AVX2(const uint8_t *a, ptrdiff_t a_pitch,
+                          const uint8_t *b, ptrdiff_t b_pitch)
+{
+    __m256i sum = _mm256_setzero_si256();
+
+    for (unsigned y = 0; y < 16; y += 2, a += 2 * a_pitch, b += 2 * b_pitch)
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(Load2x16(a, a_pitch),
+                                                    Load2x16(b, b_pitch)));
+
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum),
+                              _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+    return _mm_cvtsi128_si32(s);
+}
+
+VLC_TARGET
+static void BlendAVX2(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                      unsigned width, unsigned phase)
+{
+    const __m256i wa = _mm256_set1_epi16(256 - phase);
+    const __m256i wb = _mm256_set1_epi16(phase);
+    const __m256i round = _mm256_set1_epi16(128);
+    unsigned x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m256i va = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&a[x]));
+        const __m256i vb = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&b[x]));
+        __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(va, wa),
+                                     _mm256_mullo_epi16(vb, wb));
+        v = _mm256_srli_epi16(_mm256_add_epi16(v, round), 8);
+        v = _mm256_packus_epi16(v, _mm256_permute2x128_si256(v, v, 0x01));
+        _mm_storeu_si128((__m128i *)&dst[x], _mm256_castsi256_si128(v));
+    }
+    BlendC(&dst[x], &a[x], &b[x], width - x, phase);
+}
+
+void fps_mc_GetFunctionsAVX2(fps_mc_functions_t *f)
+{
+    f->sad16 = SAD16AVX2;
+    f->blend = BlendAVX2;
+}
+
+#undef VLC_TARGET
+#endif /* HAVE_FPS_MC_AVX2 */
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef HAVE_FPS_MC_NEON
+#include <arm_neon.h>
+
+static unsigned SAD16NEON(const uint8_t *a, ptrdiff_t a_pitch,
+                          const uint8_t *b, ptrdiff_t b_pitch)
+{
+    /* At most 32 differences per lane, which fit 16 bits */
+    uint16x8_t sum = vdupq_n_u16(0);
+
+    for (unsigned y = 0; y < 16; y++, a += a_pitch, b += b_pitch)
+    {
+        const uint8x16_t va = vld1q_u8(a), vb = vld1q_u8(b);
+
+        sum = vabal_u8(sum, vget_low_u8(va), vget_low_u8(vb));
+        sum = vabal_u8(sum, vget_high_u8(va), vget_high_u8(vb));
+    }
+
+    const uint64x2_t s = vpaddlq_u32(vpaddlq_u16(sum));
+    return vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1);
+}
+
+static void BlendNEON(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                      unsigned width, unsigned phase)
+{
+    const uint8x8_t wa = vdup_n_u8(256 - phase);
+    const uint8x8_t wb = vdup_n_u8(phase);
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const uint16x8_t v = vmlal_u8(vmull_u8(vld1_u8(&a[x]), wa),
+                                      vld1_u8(&b[x]), wb);
+        vst1_u8(&dst[x], vrshrn_n_u16(v, 8));
+    }
+    BlendC(&dst[x], &a[x], &b[x], width - x, phase);
+}
+
+void fps_mc_GetFunctionsNEON(fps_mc_functions_t *f)
+{
+    f->sad16 = SAD16NEON;
+    f->blend = BlendNEON;
+}
+#endif /* HAVE_FPS_MC_NEON */
+
+/*****************************************************************************
+ * Motion estimation and compensation
+ *****************************************************************************/
+int fps_mc_Init(fps_mc_field_t *field, unsigned width, unsigned height,
+                const vlc_chroma_description_t *dsc,
+                const fps_mc_functions_t *functions)
+{
+    field->blocks_x = (width + FPS_MC_BLOCK - 1) / FPS_MC_BLOCK;
+    field->blocks_y = (height + FPS_MC_BLOCK - 1) / FPS_MC_BLOCK;
+    field->whole_x = width / FPS_MC_BLOCK;
+    field->whole_y = height / FPS_MC_BLOCK;
+    field->vectors = calloc(field->blocks_x * field->blocks_y,
+                            sizeof (*field->vectors));
+    field->previous = calloc(field->blocks_x * field->blocks_y,
+                             sizeof (*field->previous));
+    if (unlikely(field->vectors == NULL || field->previous == NULL))
+    {
+        free(field->vectors);
+        free(field->previous);
+        return VLC_ENOMEM;
+    }
+
+    field->functions = functions;
+    field->planes = dsc->plane_count;
+    for (unsigned i = 0; i < dsc->plane_count; i++)
+    {
+        field->sub_x[i] = dsc->p[i].w.den / dsc->p[i].w.num;
+        field->sub_y[i] = dsc->p[i].h.den / dsc->p[i].h.num;
+    }
+    return VLC_SUCCESS;
+}
+
+void fps_mc_Clean(fps_mc_field_t *field)
+{
+    free(field->vectors);
+    free(field->previous);
+}
+
+void fps_mc_NewPicture(fps_mc_field_t *field)
+{
+    fps_mc_vector_t *vectors = field->previous;
+
+    field->previous = field->vectors;
+    field->vectors = vectors;
+}
+
+/* Rounds v * phase / 256 to the nearest, symmetrically around 0 */
+static inline int Scale(int v, unsigned phase)
+{
+    const int p = v * (int)phase;
+    return (p >= 0 ? p + 128 : p - 128) / 256;
+}
+
+/* Rounds v / d to the nearest, symmetrically around 0 */
+static inline int DivRound(int v, int d)
+{
+    return (v >= 0 ? v + d / 2 : v - d / 2) / d;
+}
+
+typedef struct
+{
+    const plane_t *a, *b;
+    int width, height;
+    unsigned phase;
+    unsigned (*sad16)(const uint8_t *, ptrdiff_t, const uint8_t *, ptrdiff_t);
+} search_t;
+
+static inline bool Inside(const search_t *s, int x, int y)
+{
+    return x >= 0 && y >= 0 && x + FPS_MC_BLOCK <= s->width
+        && y + FPS_MC_BLOCK <= s->height;
+}
+
+/* Cost of the vector (vx, vy) for the block at (x, y), or UINT32_MAX if the
+ * vector points outside of the pictures */
+static uint32_t Cost(const search_t *s, int x, int y, int vx, int vy)
+{
+    if (abs(vx) > FPS_MC_RANGE || abs(vy) > FPS_MC_RANGE)
+        return UINT32_MAX;
+
+    const int ax = x + Scale(vx, s->phase), ay = y + Scale(vy, s->phase);
+    const int bx = ax - vx, by = ay - vy;
+
+    if (!Inside(s, ax, ay) || !Inside(s, bx, by))
+        return UINT32_MAX;
+    return s->sad16(&s->a->p_pixels[ay * s->a->i_pitch + ax], s->a->i_pitch,
+                    &s->b->p_pixels[by * s->b->i_pitch + bx], s->b->i_pitch)
+         + LAMBDA * (abs(vx) + abs(vy));
+}
+
+void fps_mc_Estimate(fps_mc_field_t *field, const picture_t *a,
+                     const picture_t *b, unsigned phase,
+                     unsigned begin, unsigned end)
+{
+    static const int8_t directions[4][2] = {
+        { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+    };
+    const search_t s = {
+        .a = &a->p[Y_PLANE], .b = &b->p[Y_PLANE],
+        .width = a->p[Y_PLANE].i_visible_pitch,
+        .height = a->p[Y_PLANE].i_visible_lines,
+        .phase = phase, .sad16 = field->functions->sad16,
+    };
+    const unsigned blocks_x = field->blocks_x;
+
+    for (unsigned by = begin; by < end; by++)
+        for (unsigned bx = 0; bx < blocks_x; bx++)
+        {
+            const size_t index = by * blocks_x + bx;
+            fps_mc_vector_t *v = &field->vectors[index];
+            const int x = bx * FPS_MC_BLOCK, y = by * FPS_MC_BLOCK;
+
+            /* Partial blocks on the right and bottom edges are still */
+            if (x + FPS_MC_BLOCK > s.width || y + FPS_MC_BLOCK > s.height)
+            {
+                *v = (fps_mc_vector_t){ 0, 0, 0 };
+                continue;
+            }
+
+            /* The predictors are the vectors of the previous picture around
+             * this block, and the new vectors of the neighbours within this
+             * band of rows, as the other bands are estimated concurrently */
+            const fps_mc_vector_t *prev = &field->previous[index];
+            fps_mc_vector_t predictors[8];
+            unsigned count = 0;
+
+            predictors[count++] = prev[0];
+            if (bx > 0)
+            {
+                predictors[count++] = prev[-1];
+                predictors[count++] = v[-1];
+            }
+            if (bx + 1 < blocks_x)
+                predictors[count++] = prev[1];
+            if (by > 0)
+                predictors[count++] = prev[-(ptrdiff_t)blocks_x];
+            if (by + 1 < field->blocks_y)
+                predictors[count++] = prev[blocks_x];
+            if (by > begin)
+            {
+                predictors[count++] = v[-(ptrdiff_t)blocks_x];
+                if (bx + 1 < blocks_x)
+                    predictors[count++] = v[1 - (ptrdiff_t)blocks_x];
+            }
+
+            int best_x = 0, best_y = 0;
+            uint32_t best = Cost(&s, x, y, 0, 0);
+
+            for (unsigned i = 0; i < count; i++)
+            {
+                const uint32_t cost = Cost(&s, x, y, predictors[i].x,
+                                           predictors[i].y);
+                if (cost < best)
+                {
+                    best = cost;
+                    best_x = predictors[i].x;
+                    best_y = predictors[i].y;
+                }
+            }
+
+            /* Refine with diamonds of decreasing sizes */
+            for (int step = 8; step > 0; step /= 2)
+                for (unsigned moves = 0; moves < 8; moves++)
+                {
+                    const int cx = best_x, cy = best_y;
+
+                    for (unsigned i = 0; i < 4; i++)
+                    {
+                        const int vx = cx + step * directions[i][0];
+                        const int vy = cy + step * directions[i][1];
+                        const uint32_t cost = Cost(&s, x, y, vx, vy);
+
+                        if (cost < best)
+                        {
+                            best = cost;
+                            best_x = vx;
+                            best_y = vy;
+                        }
+                    }
+                    if (best_x == cx && best_y == cy)
+                        break;
+                }
+
+            v->x = best_x;
+            v->y = best_y;
+            v->sad = best - LAMBDA * (abs(best_x) + abs(best_y));
+        }
+}
+
+unsigned fps_mc_CountUnmatched(const fps_mc_field_t *field,
+                               unsigned *estimated)
+{
+    const unsigned threshold = FPS_MC_UNMATCHED * FPS_MC_BLOCK * FPS_MC_BLOCK;
+    unsigned unmatched = 0;
+
+    for (unsigned by = 0; by < field->whole_y; by++)
+        for (unsigned bx = 0; bx < field->whole_x; bx++)
+            if (field->vectors[by * field->blocks_x + bx].sad > threshold)
+                unmatched++;
+
+    *estimated = field->whole_x * field->whole_y;
+    return unmatched;
+}
+
+/* Clamps the displacement d of a span [x, x + size) within [0, max) */
+static inline int Clamp(int d, int x, int size, int max)
+{
+    return VLC_CLIP(d, -x, max - size - x);
+}
+
+void fps_mc_Compensate(const fps_mc_field_t *field,
+                       const fps_mc_functions_t *functions,
+                       picture_t *dst, const picture_t *a, const picture_t *b,
+                       unsigned phase, unsigned begin, unsigned end)
+{
+    const unsigned threshold = FPS_MC_UNMATCHED * FPS_MC_BLOCK * FPS_MC_BLOCK;
+
+    for (int i = 0; i < dst->i_planes; i++)
+    {
+        const plane_t *d = &dst->p[i], *pa = &a->p[i], *pb = &b->p[i];
+        const int width = d->i_visible_pitch, height = d->i_visible_lines;
+        const int sub_x = field != NULL ? (int)field->sub_x[i] : 1;
+        const int sub_y = field != NULL ? (int)field->sub_y[i] : 1;
+        const int block_w = FPS_MC_BLOCK / sub_x;
+        const int block_h = FPS_MC_BLOCK / sub_y;
+        const int y_end = __MIN((int)end * block_h, height);
+
+        if (field == NULL)
+        {
+            /* Whole rows, without motion */
+            for (int y = begin * block_h; y < y_end; y++)
+                functions->blend(&d->p_pixels[y * d->i_pitch],
+                                 &pa->p_pixels[y * pa->i_pitch],
+                                 &pb->p_pixels[y * pb->i_pitch],
+                                 width, phase);
+            continue;
+        }
+
+        for (unsigned by = begin; by < end; by++)
+        {
+            const int y = by * block_h;
+            if (y >= height)
+                break;
+            const int rows = __MIN(block_h, height - y);
+
+            for (unsigned bx = 0; bx < field->blocks_x; bx++)
+            {
+                const int x = bx * block_w;
+                if (x >= width)
+                    break;
+                const int cols = __MIN(block_w, width - x);
+                fps_mc_vector_t v = field->vectors[by * field->blocks_x + bx];
+
+                if (v.sad > threshold)
+                    v.x = v.y = 0;
+
+                const int ax = Scale(v.x, phase), ay = Scale(v.y, phase);
+                const int dax = Clamp(DivRound(ax, sub_x), x, cols, width);
+                const int day = Clamp(DivRound(ay, sub_y), y, rows, height);
+                const int dbx = Clamp(DivRound(ax - v.x, sub_x), x, cols,
+                                      width);
+                const int dby = Clamp(DivRound(ay - v.y, sub_y), y, rows,
+                                      height);
+                const uint8_t *src_a =
+                    &pa->p_pixels[(y + day) * pa->i_pitch + x + dax];
+                const uint8_t *src_b =
+                    &pb->p_pixels[(y + dby) * pb->i_pitch + x + dbx];
+                uint8_t *out = &d->p_pixels[y * d->i_pitch + x];
+
+                for (int r = 0; r < rows; r++)
+                    functions->blend(&out[r * d->i_pitch],
+                                     &src_a[r * pa->i_pitch],
+                                     &src_b[r * pb->i_pitch], cols, phase);
+            }
+        }
+    }
+}
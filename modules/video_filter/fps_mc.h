@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * fps_mc.h : motion compensated frame interpolation for the fps filter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FPS_MC_H
+#define VLC_FPS_MC_H
+
+/* A picture between pictures A and B is interpolated at a phase, from 0 for
+ * A to 256 for B. Its luma is split into blocks, each with a vector v such
+ * that the block content is found at the block position plus phase * v / 256
+ * in A, and minus (256 - phase) * v / 256 in B. The vectors are estimated
+ * from the interpolated picture, so that they leave no holes. */
+
+#define FPS_MC_BLOCK  16          /* side of the luma blocks */
+#define FPS_MC_RANGE  64          /* largest vector component, in pixels */
+#define FPS_MC_BAND   4           /* rows of blocks of the parallel bands */
+
+/* Mean absolute difference, per luma pixel, above which a block is not
+ * considered matched, as the motion detection threshold */
+#define FPS_MC_UNMATCHED 15
+
+typedef struct
+{
+    /* Sum of absolute differences of two 16x16 blocks */
+    unsigned (*sad16)(const uint8_t *a, ptrdiff_t a_pitch,
+                      const uint8_t *b, ptrdiff_t b_pitch);
+    /* dst = (a * (256 - phase) + b * phase + 128) >> 8, phase in [1, 255] */
+    void (*blend)(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                  unsigned width, unsigned phase);
+} fps_mc_functions_t;
+
+void fps_mc_GetFunctionsC(fps_mc_functions_t *);
+
+#ifdef HAVE_SSE2_INTRINSICS
+# define HAVE_FPS_MC_SSE2
+void fps_mc_GetFunctionsSSE2(fps_mc_functions_t *);
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+# define HAVE_FPS_MC_AVX2
+void fps_mc_GetFunctionsAVX2(fps_mc_functions_t *);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define HAVE_FPS_MC_NEON
+void fps_mc_GetFunctionsNEON(fps_mc_functions_t *);
+#endif
+
+typedef struct
+{
+    int16_t x, y;
+    uint32_t sad;                   /* of the block, without the bias */
+} fps_mc_vector_t;
+
+typedef struct
+{
+    unsigned blocks_x, blocks_y;
+    unsigned whole_x, whole_y;      /* blocks inside the picture */
+    fps_mc_vector_t *vectors;
+    /* Vectors of the previous picture, predicting the next ones */
+    fps_mc_vector_t *previous;
+    const fps_mc_functions_t *functions;
+    /* Subsampling of the planes */
+    unsigned planes;
+    unsigned sub_x[PICTURE_PLANE_MAX];
+    unsigned sub_y[PICTURE_PLANE_MAX];
+} fps_mc_field_t;
+
+/**
+ * Allocates the vectors of pictures of the given luma size and chroma.
+ */
+int fps_mc_Init(fps_mc_field_t *, unsigned width, unsigned height,
+                const vlc_chroma_description_t *, const fps_mc_functions_t *);
+void fps_mc_Clean(fps_mc_field_t *);
+
+/**
+ * Returns the number of bands of FPS_MC_BAND rows of blocks, which may be
+ * estimated and compensated concurrently.
+ */
+static inline unsigned fps_mc_CountBands(const fps_mc_field_t *field)
+{
+    return (field->blocks_y + FPS_MC_BAND - 1) / FPS_MC_BAND;
+}
+
+/**
+ * Computes the rows of blocks [begin, end) of a band.
+ */
+static inline void fps_mc_Band(const fps_mc_field_t *field, unsigned index,
+                               unsigned *begin, unsigned *end)
+{
+    *begin = index * FPS_MC_BAND;
+    *end = __MIN(*begin + FPS_MC_BAND, field->blocks_y);
+}
+
+/**
+ * Keeps the estimated vectors as predictors, before estimating a new picture.
+ */
+void fps_mc_NewPicture(fps_mc_field_t *);
+
+/**
+ * Estimates the vectors of the rows of blocks [begin, end) of the picture
+ * interpolated between a and b at the given phase. The bands of rows may be
+ * estimated concurrently. The vectors of a block depend on the first row of
+ * its band: use the bands of fps_mc_Band() for reproducible results.
+ */
+void fps_mc_Estimate(fps_mc_field_t *, const picture_t *a, const picture_t *b,
+                     unsigned phase, unsigned begin, unsigned end);
+
+/**
+ * Counts the blocks that the estimated vectors do not match, and the blocks
+ * that were estimated.
+ */
+unsigned fps_mc_CountUnmatched(const fps_mc_field_t *, unsigned *estimated);
+
+/**
+ * Interpolates the rows of blocks [begin, end) of all the planes, along the
+ * estimated vectors, or without motion if the field is NULL. The unmatched
+ * blocks are blended without motion.
+ */
+void fps_mc_Compensate(const fps_mc_field_t *, const fps_mc_functions_t *,
+                       picture_t *dst, const picture_t *a, const picture_t *b,
+                       unsigned phase, unsigned begin, unsigned end);
+
+#endif
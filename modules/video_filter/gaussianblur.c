@@ -33,9 +33,10 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
-
-#include <math.h>                                          /* exp(), sqrt() */
+#include "blur_rows.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -79,98 +80,129 @@ static const char *const ppsz_filter_options[] = {
     "sigma", NULL
 };
 
-/* Comment this to use floats instead of integers (faster for bigger sigma
- * values)
- * For sigma = 2 ints are faster
- * For sigma = 4 floats are faster
- */
-#define DONT_USE_FLOATS
-
-#ifdef DONT_USE_FLOATS
-#   define type_t int
-#else
-#   define type_t float
-#endif
+/* The gaussian is separable: the planes are blurred horizontally into 16-bit
+ * samples, then vertically back into the output picture. The edge samples
+ * are repeated beyond the edges. */
+typedef struct
+{
+    uint32_t *pi_weights;
+    unsigned i_radius;
+} blur_kernel_t;
 
 typedef struct
 {
     double f_sigma;
-    int i_dim;
-
-    type_t *pt_distribution;
-    type_t *pt_buffer;
-    type_t *pt_scale;
+    unsigned i_planes;
+    unsigned i_size;                        /* bytes per sample */
+    unsigned i_bits;                        /* bits per sample */
+
+    /* Horizontal and vertical kernels of each plane, depending on its
+     * subsampling */
+    blur_kernel_t h[PICTURE_PLANE_MAX];
+    blur_kernel_t v[PICTURE_PLANE_MAX];
+    unsigned i_radius_max;
+    blur_rows_t rows;
+
+    /* Allocated with the first picture */
+    unsigned i_slices;
+    unsigned i_width;
+    unsigned i_lines;
+    uint16_t *p_buffer;                     /* horizontally blurred plane */
+    uint16_t *p_lines;                      /* padded line of each slice */
+    const uint16_t **pp_rows;               /* rows of each slice */
 } filter_sys_t;
 
-static void gaussianblur_InitDistribution( filter_sys_t *p_sys )
+static int InitKernel( blur_kernel_t *p_kernel, double f_sigma )
 {
-    double f_sigma = p_sys->f_sigma;
-    int i_dim = (int)(3.*f_sigma);
-    type_t *pt_distribution = xmalloc( (2*i_dim+1) * sizeof( type_t ) );
-
-    for( int x = -i_dim; x <= i_dim; x++ )
-    {
-        const float f_distribution = sqrt( exp(-(x*x)/(f_sigma*f_sigma) ) / (2.*M_PI*f_sigma*f_sigma) );
-#ifdef DONT_USE_FLOATS
-        const float f_factor = 1 << 8;
-#else
-        const float f_factor = 1;
-#endif
-
-        pt_distribution[i_dim+x] = (type_t)( f_distribution * f_factor );
-        //printf("%f\n",(float)pt_distribution[i_dim+x]);
-    }
-    p_sys->i_dim = i_dim;
-    p_sys->pt_distribution = pt_distribution;
+    p_kernel->pi_weights = vlc_alloc( (unsigned)(3. * f_sigma) + 1,
+                                      sizeof( uint32_t ) );
+    if( p_kernel->pi_weights == NULL )
+        return VLC_ENOMEM;
+    p_kernel->i_radius = blur_Kernel( p_kernel->pi_weights, f_sigma );
+    return VLC_SUCCESS;
 }
 
 static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    const vlc_fourcc_t i_chroma = p_filter->fmt_in.video.i_chroma;
 
-    if(   p_filter->fmt_in.video.i_chroma != VLC_CODEC_I420
-       && p_filter->fmt_in.video.i_chroma != VLC_CODEC_J420
-       && p_filter->fmt_in.video.i_chroma != VLC_CODEC_YV12
-
-       && p_filter->fmt_in.video.i_chroma != VLC_CODEC_I422
-       && p_filter->fmt_in.video.i_chroma != VLC_CODEC_J422
-      )
+    switch( i_chroma )
     {
-        /* We only want planar YUV 4:2:0 or 4:2:2 */
-        msg_Err( p_filter, "Unsupported input chroma (%4.4s)",
-                 (char*)&(p_filter->fmt_in.video.i_chroma) );
-        return VLC_EGENERIC;
+        CASE_PLANAR_YUV
+        CASE_PLANAR_YUV_HIGH_DEPTH
+            break;
+        default:
+            msg_Err( p_filter, "Unsupported input chroma (%4.4s)",
+                     (char*)&i_chroma );
+            return VLC_EGENERIC;
     }
 
-    if( p_filter->fmt_in.video.i_chroma != p_filter->fmt_out.video.i_chroma )
+    if( i_chroma != p_filter->fmt_out.video.i_chroma )
     {
         msg_Err( p_filter, "Input and output chromas don't match" );
         return VLC_EGENERIC;
     }
 
-    filter_sys_t *p_sys = malloc( sizeof( filter_sys_t ) );
-    if( p_sys == NULL )
-        return VLC_ENOMEM;
-    p_filter->p_sys = p_sys;
+    const vlc_chroma_description_t *p_chroma =
+        vlc_fourcc_GetChromaDescription( i_chroma );
+    if( p_chroma == NULL )
+        return VLC_EGENERIC;
 
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                        p_filter->p_cfg );
 
-    p_filter->pf_video_filter = Filter;
-
-    p_sys->f_sigma =
-        var_CreateGetFloat( p_filter, FILTER_PREFIX "sigma" );
-    if( p_sys->f_sigma <= 0. )
+    const double f_sigma = var_CreateGetFloat( p_filter, FILTER_PREFIX "sigma" );
+    if( f_sigma <= 0. )
     {
         msg_Err( p_filter, "sigma must be greater than zero" );
         return VLC_EGENERIC;
     }
-    gaussianblur_InitDistribution( p_sys );
-    msg_Dbg( p_filter, "gaussian distribution is %d pixels wide",
-             p_sys->i_dim*2+1 );
 
-    p_sys->pt_buffer = NULL;
-    p_sys->pt_scale = NULL;
+    filter_sys_t *p_sys = calloc( 1, sizeof( filter_sys_t ) );
+    if( p_sys == NULL )
+        return VLC_ENOMEM;
+    p_filter->p_sys = p_sys;
+
+    p_sys->f_sigma = f_sigma;
+    p_sys->i_planes = p_chroma->plane_count;
+    p_sys->i_size = p_chroma->pixel_size;
+    p_sys->i_bits = p_chroma->pixel_bits;
+
+    /* The kernels of the subsampled planes are narrower, so that all the
+     * planes are blurred alike */
+    for( unsigned i = 0; i < p_sys->i_planes; i++ )
+    {
+        const vlc_rational_t *w = &p_chroma->p[i].w, *h = &p_chroma->p[i].h;
+
+        if( InitKernel( &p_sys->h[i], f_sigma * w->num / w->den )
+         || InitKernel( &p_sys->v[i], f_sigma * h->num / h->den ) )
+        {
+            Destroy( p_this );
+            return VLC_ENOMEM;
+        }
+        p_sys->i_radius_max = __MAX( p_sys->i_radius_max,
+                                     __MAX( p_sys->h[i].i_radius,
+                                            p_sys->v[i].i_radius ) );
+    }
+    msg_Dbg( p_filter, "gaussian distribution is %u pixels wide",
+             p_sys->h[0].i_radius * 2 + 1 );
+
+    blur_GetRowsC( &p_sys->rows );
+#ifdef HAVE_BLUR_SSE4_1
+    if( vlc_CPU_SSE4_1() )
+        blur_GetRowsSSE4_1( &p_sys->rows );
+#endif
+#ifdef HAVE_BLUR_AVX2
+    if( vlc_CPU_AVX2() )
+        blur_GetRowsAVX2( &p_sys->rows );
+#endif
+#ifdef HAVE_BLUR_NEON
+    if( vlc_CPU_ARM_NEON() )
+        blur_GetRowsNEON( &p_sys->rows );
+#endif
+
+    p_filter->pf_video_filter = Filter;
 
     return VLC_SUCCESS;
 }
@@ -180,118 +212,164 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    free( p_sys->pt_distribution );
-    free( p_sys->pt_buffer );
-    free( p_sys->pt_scale );
+    for( unsigned i = 0; i < p_sys->i_planes; i++ )
+    {
+        free( p_sys->h[i].pi_weights );
+        free( p_sys->v[i].pi_weights );
+    }
+    free( p_sys->p_buffer );
+    free( p_sys->p_lines );
+    free( p_sys->pp_rows );
 
     free( p_sys );
 }
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+/* The horizontal pass of a plane must be complete before its vertical pass
+ * starts, so each pass is a separate slice job. */
+struct blur_job
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
-    const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
-    type_t *pt_scale;
-    const type_t *pt_distribution = p_sys->pt_distribution;
+    const filter_sys_t *p_sys;
+    const plane_t *p_in;
+    plane_t *p_out;
+    const blur_kernel_t *p_h;
+    const blur_kernel_t *p_v;
+    unsigned i_width;
+    unsigned i_lines;
+};
 
-    if( !p_pic ) return NULL;
+static void BlurHorizontal( void *opaque, unsigned index, unsigned count )
+{
+    const struct blur_job *job = opaque;
+    const filter_sys_t *p_sys = job->p_sys;
+    const unsigned i_radius = job->p_h->i_radius;
+    const unsigned i_width = job->i_width;
+    uint16_t *p_line = &p_sys->p_lines[index *
+                                       (p_sys->i_width + 2 * p_sys->i_radius_max)];
+    unsigned i_begin, i_end;
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    if( !p_sys->pt_buffer )
+    vlc_slice_Rows( job->i_lines, index, count, 1, &i_begin, &i_end );
+
+    for( unsigned i_line = i_begin; i_line < i_end; i_line++ )
     {
-        p_sys->pt_buffer = realloc_or_free( p_sys->pt_buffer,
-                               p_pic->p[Y_PLANE].i_visible_lines *
-                               p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
+        const uint8_t *p_in = &job->p_in->p_pixels[i_line * job->p_in->i_pitch];
+        uint16_t *p_center = &p_line[i_radius];
+
+        if( p_sys->i_size == 1 )
+            for( unsigned x = 0; x < i_width; x++ )
+                p_center[x] = p_in[x];
+        else
+            memcpy( p_center, p_in, i_width * 2 );
+        for( unsigned k = 1; k <= i_radius; k++ )
+        {
+            p_center[-(ptrdiff_t)k] = p_center[0];
+            p_center[i_width - 1 + k] = p_center[i_width - 1];
+        }
+
+        p_sys->rows.horizontal( &p_sys->p_buffer[i_line * i_width], p_center,
+                                i_width, job->p_h->pi_weights, i_radius,
+                                p_sys->i_bits );
     }
+}
 
-    pt_buffer = p_sys->pt_buffer;
-    if( !p_sys->pt_scale )
+static void BlurVertical( void *opaque, unsigned index, unsigned count )
+{
+    const struct blur_job *job = opaque;
+    const filter_sys_t *p_sys = job->p_sys;
+    const unsigned i_radius = job->p_v->i_radius;
+    const unsigned i_width = job->i_width;
+    const uint16_t **pp_rows = &p_sys->pp_rows[index *
+                                               (2 * p_sys->i_radius_max + 1)];
+    const unsigned i_shift = 2 * BLUR_WEIGHT_BITS - p_sys->i_bits;
+    unsigned i_begin, i_end;
+
+    vlc_slice_Rows( job->i_lines, index, count, 1, &i_begin, &i_end );
+
+    for( unsigned i_line = i_begin; i_line < i_end; i_line++ )
     {
-        const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
-        const int i_pitch = p_pic->p[Y_PLANE].i_pitch;
-
-        p_sys->pt_scale = xmalloc( i_visible_lines * i_pitch * sizeof( type_t ) );
-        pt_scale = p_sys->pt_scale;
+        uint8_t *p_out = &job->p_out->p_pixels[i_line * job->p_out->i_pitch];
 
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
+        for( unsigned k = 0; k <= 2 * i_radius; k++ )
         {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-
-                for( int y = __MAX( -i_dim, -i_line );
-                     y <= __MIN( i_dim, i_visible_lines - i_line - 1 );
-                     y++ )
-                {
-                    for( int x = __MAX( -i_dim, -i_col );
-                         x <= __MIN( i_dim, i_visible_pitch - i_col + 1 );
-                         x++ )
-                    {
-                        t_value += pt_distribution[y+i_dim] *
-                                   pt_distribution[x+i_dim];
-                    }
-                }
-                pt_scale[i_line*i_pitch+i_col] = t_value;
-            }
+            const int y = VLC_CLIP( (int)(i_line + k) - (int)i_radius,
+                                    0, (int)job->i_lines - 1 );
+            pp_rows[k] = &p_sys->p_buffer[y * i_width];
         }
+
+        if( p_sys->i_size == 1 )
+            p_sys->rows.vertical8( p_out, pp_rows, i_width,
+                                   job->p_v->pi_weights, i_radius, i_shift );
+        else
+            p_sys->rows.vertical16( (uint16_t *)p_out, pp_rows, i_width,
+                                    job->p_v->pi_weights, i_radius, i_shift );
     }
+}
 
-    pt_scale = p_sys->pt_scale;
-    for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
+static int AllocateBuffers( filter_t *p_filter, const plane_t *p_plane )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_width = p_plane->i_visible_pitch / p_sys->i_size;
+    const unsigned i_slices =
+        vlc_slices_Count( p_filter, p_plane->i_visible_lines );
+
+    p_sys->p_buffer = vlc_alloc( i_width * p_plane->i_visible_lines,
+                                 sizeof( uint16_t ) );
+    p_sys->p_lines = vlc_alloc( i_slices * (i_width + 2 * p_sys->i_radius_max),
+                                sizeof( uint16_t ) );
+    p_sys->pp_rows = vlc_alloc( i_slices * (2 * p_sys->i_radius_max + 1),
+                                sizeof( *p_sys->pp_rows ) );
+    if( !p_sys->p_buffer || !p_sys->p_lines || !p_sys->pp_rows )
     {
+        free( p_sys->p_buffer );
+        free( p_sys->p_lines );
+        free( p_sys->pp_rows );
+        p_sys->p_buffer = NULL;
+        p_sys->p_lines = NULL;
+        p_sys->pp_rows = NULL;
+        return VLC_ENOMEM;
+    }
+    p_sys->i_slices = i_slices;
+    p_sys->i_width = i_width;
+    p_sys->i_lines = p_plane->i_visible_lines;
+    return VLC_SUCCESS;
+}
 
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+    if( !p_pic ) return NULL;
 
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
+    /* The first plane is the largest one */
+    if( !p_sys->p_buffer
+     && AllocateBuffers( p_filter, &p_pic->p[Y_PLANE] ) )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
 
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    struct blur_job job = { .p_sys = p_sys };
+
+    for( unsigned i_plane = 0; i_plane < p_sys->i_planes; i_plane++ )
+    {
+        job.p_in = &p_pic->p[i_plane];
+        job.p_out = &p_outpic->p[i_plane];
+        job.p_h = &p_sys->h[i_plane];
+        job.p_v = &p_sys->v[i_plane];
+        job.i_width = __MIN( p_sys->i_width,
+                             (unsigned)job.p_in->i_visible_pitch / p_sys->i_size );
+        job.i_lines = __MIN( p_sys->i_lines,
+                             (unsigned)job.p_in->i_visible_lines );
+
+        vlc_slices_Run( p_filter, p_sys->i_slices, BlurHorizontal, &job );
+        vlc_slices_Run( p_filter, p_sys->i_slices, BlurVertical, &job );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -36,6 +36,7 @@
 #include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -174,6 +175,42 @@ static void Close(vlc_object_t *object)
     free(sys);
 }
 
+struct gradfun_job
+{
+    filter_sys_t *sys;
+    const video_format_t *fmt;
+    picture_t *src;
+    picture_t *dst;
+    size_t buf_size;
+};
+
+/* The blur slides along the rows of a whole plane, so the planes are the
+ * slices. */
+static void FilterPlane(void *opaque, unsigned i, unsigned count)
+{
+    const struct gradfun_job *job = opaque;
+    const filter_sys_t *sys = job->sys;
+    const video_format_t *fmt = job->fmt;
+    const plane_t *srcp = &job->src->p[i];
+    plane_t       *dstp = &job->dst->p[i];
+    struct vf_priv_s cfg = sys->cfg;
+    VLC_UNUSED(count);
+
+    const vlc_chroma_description_t *chroma = sys->chroma;
+    int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+    int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+    int r = (cfg.radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+             cfg.radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+    r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+    if (__MIN(w, h) > 2 * r && cfg.buf) {
+        cfg.buf += i * job->buf_size;
+        filter_plane(&cfg, dstp->p_pixels, srcp->p_pixels,
+                     w, h, dstp->i_pitch, srcp->i_pitch, r);
+    } else {
+        plane_CopyPixels(dstp, srcp);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -193,29 +230,20 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     struct vf_priv_s *cfg = &sys->cfg;
 
     cfg->thresh = (1 << 15) / strength;
+    /* Each plane has its own blur buffer, so that they can be filtered
+     * concurrently */
+    size_t buf_size = ((fmt->i_width + 15) & ~15) * (radius + 1) / 2 + 32;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = aligned_alloc(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
+        aligned_free(cfg->buf);
+        cfg->buf    = aligned_alloc(16, PICTURE_PLANE_MAX * buf_size
+                                        * sizeof(*cfg->buf));
     }
 
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
-        }
-    }
+    struct gradfun_job job = {
+        .sys = sys, .fmt = fmt, .src = src, .dst = dst, .buf_size = buf_size,
+    };
+    vlc_slices_Run(filter, dst->i_planes, FilterPlane, &job);
 
     picture_CopyProperties(dst, src);
     picture_Release(src);
@@ -33,6 +33,8 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
 
@@ -91,6 +93,9 @@ typedef struct
 {
     const vlc_chroma_description_t *chroma;
     int w[3], h[3];
+    int wmax;
+    int size, shift;
+    denoise_t denoise;
 
     struct vf_priv_s cfg;
     bool   b_recalc_coefs;
@@ -112,9 +117,17 @@ static int Open(vlc_object_t *this)
     const vlc_fourcc_t fourcc_out = fmt_out->i_chroma;
     int wmax = 0;
 
+    unsigned pixel_size = 1;
+    switch (fourcc_in) {
+        CASE_PLANAR_YUV_HIGH_DEPTH
+            pixel_size = 2;
+            break;
+    }
+
     const vlc_chroma_description_t *chroma =
             vlc_fourcc_GetChromaDescription(fourcc_in);
-    if (!chroma || chroma->plane_count != 3 || chroma->pixel_size != 1) {
+    if (!chroma || chroma->plane_count != 3
+     || chroma->pixel_size != pixel_size) {
         msg_Err(filter, "Unsupported chroma (%4.4s)", (char*)&fourcc_in);
         return VLC_EGENERIC;
     }
@@ -132,17 +145,30 @@ static int Open(vlc_object_t *this)
     cfg = &sys->cfg;
 
     sys->chroma = chroma;
+    sys->size = chroma->pixel_size;
+    sys->shift = 24 - chroma->pixel_bits;
+    sys->denoise = deNoise;
 
     for (int i = 0; i < 3; ++i) {
         sys->w[i] = fmt_in->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
+    /* Each plane needs its own line buffer */
+    sys->wmax = wmax;
+    cfg->Line = vlc_alloc(wmax * 3, sizeof(unsigned int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
     }
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2()) {
+        cfg->Rows = vlc_alloc(wmax * 3 * HQDN3D_ROWS,
+                              sizeof(unsigned int));
+        if (cfg->Rows)
+            sys->denoise = deNoiseAVX2;
+    }
+#endif
 
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
@@ -186,12 +212,46 @@ static void Close(vlc_object_t *this)
         free(cfg->Frame[i]);
     }
     free(cfg->Line);
+    free(cfg->Rows);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+struct denoise_job
+{
+    filter_sys_t *sys;
+    picture_t *src;
+    picture_t *dst;
+};
+
+/* The spatial filter is recursive from the top of the plane, so a plane can
+ * not be split in bands without changing the output: the planes are
+ * filtered in parallel instead. */
+static void DenoisePlane(void *opaque, unsigned index, unsigned count)
+{
+    const struct denoise_job *job = opaque;
+    filter_sys_t *sys = job->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    const plane_t *srcp = &job->src->p[index];
+    const plane_t *dstp = &job->dst->p[index];
+    int *spat = cfg->Coefs[index == 0 ? 0 : 2];
+    int *temp = cfg->Coefs[index == 0 ? 1 : 3];
+    unsigned int *rows = NULL;
+
+    assert(count == 3);
+    (void) count;
+    if (cfg->Rows)
+        rows = &cfg->Rows[index * sys->wmax * HQDN3D_ROWS];
+
+    sys->denoise(srcp->p_pixels, dstp->p_pixels,
+                 &cfg->Line[index * sys->wmax], rows, cfg->Frame[index],
+                 sys->w[index], sys->h[index],
+                 srcp->i_pitch, dstp->i_pitch, sys->size, sys->shift,
+                 spat, spat, temp);
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -221,32 +281,21 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-
-    if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
-    {
-        picture_Release( src );
-        picture_Release( dst );
-        return NULL;
+    for (int i = 0; i < 3; ++i) {
+        if (cfg->Frame[i] == NULL)
+            cfg->Frame[i] = deNoiseInit(src->p[i].p_pixels, sys->w[i],
+                                        sys->h[i], src->p[i].i_pitch,
+                                        sys->size, sys->shift);
+        if (unlikely(cfg->Frame[i] == NULL)) {
+            picture_Release( src );
+            picture_Release( dst );
+            return NULL;
+        }
     }
 
+    struct denoise_job job = { .sys = sys, .src = src, .dst = dst };
+    vlc_slices_Run(filter, 3, DenoisePlane, &job);
+
     return CopyInfoAndRelease(dst, src);
 }
 
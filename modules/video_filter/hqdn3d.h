@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <math.h>
 
 #define PARAM1_DEFAULT 4.0
@@ -33,6 +34,7 @@
 struct vf_priv_s {
         int Coefs[4][512*16];
         unsigned int *Line;
+        unsigned int *Rows;
         unsigned short *Frame[3];
 };
 
@@ -46,136 +48,263 @@ static /*inline*/ unsigned int LowPassMul(unsigned int PrevMul, unsigned int Cur
     return CurrMul + Coef[d];
 }
 
-static void deNoiseTemporal(
-                    unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned short *FrameAnt,
-                    int W, int H, int sStride, int dStride,
-                    int *Temporal)
+/* Samples of any depth are handled in the 8.16 fixed point scale of 8-bit
+ * samples, so that the coefficients do not depend on the depth: a sample of
+ * Depth bits is shifted left by Shift = 24 - Depth. */
+
+static inline unsigned int LoadPixel(const unsigned char *Line, long X,
+                                     int Size)
 {
-    unsigned int PixelDst;
+    return Size == 1 ? Line[X] : ((const uint16_t *)Line)[X];
+}
+
+static inline void StorePixel(unsigned char *Line, long X, int Size,
+                              unsigned int Pixel)
+{
+    if (Size == 1)
+        Line[X] = Pixel;
+    else
+        ((uint16_t *)Line)[X] = Pixel;
+}
+
+/* Lines buffered by the vectorized low passes */
+#define HQDN3D_ROWS 8
+
+typedef void (*denoise_t)(const unsigned char *Frame,
+                          unsigned char *FrameDest,
+                          unsigned int *LineAnt, unsigned int *Rows,
+                          unsigned short *FrameAnt,
+                          int W, int H, int sStride, int dStride,
+                          int Size, int Shift,
+                          int *Horizontal, int *Vertical, int *Temporal);
+
+/* A null first coefficient disables a low pass. A pixel low-passed with
+ * itself is left unchanged, so the first pixel of a line needs no special
+ * case horizontally. */
+static inline void deNoisePixels(const unsigned char *Frame,
+                                 unsigned char *FrameDest,
+                                 unsigned int *LineAnt,
+                                 unsigned short *FrameAnt,
+                                 int W, int H, int sStride, int dStride,
+                                 int Size, int Shift,
+                                 int *Horizontal, int *Vertical, int *Temporal)
+{
+    const unsigned int Round = 0x10000000 + (1 << (Shift - 1)) - 1;
+    const unsigned int Mask = (1 << (24 - Shift)) - 1;
+    const bool Horiz = Horizontal[0], Temp = Temporal[0];
 
     for (long Y = 0; Y < H; Y++){
+        const unsigned char *Line = &Frame[Y*sStride];
+        unsigned char *LineDest = &FrameDest[Y*dStride];
+        unsigned short *LinePrev = &FrameAnt[Y*W];
+        /* First line has no top neighbor */
+        const bool Vert = Y > 0 && Vertical[0];
+        unsigned int PixelAnt = LoadPixel(Line, 0, Size) << Shift;
+
         for (long X = 0; X < W; X++){
-            PixelDst = LowPassMul(FrameAnt[X]<<8, Frame[X]<<16, Temporal);
-            FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+            unsigned int PixelDst = LoadPixel(Line, X, Size) << Shift;
+
+            if (Horiz)
+                PixelDst = PixelAnt = LowPassMul(PixelAnt, PixelDst, Horizontal);
+            if (Vert)
+                PixelDst = LowPassMul(LineAnt[X], PixelDst, Vertical);
+            LineAnt[X] = PixelDst;
+            if (Temp){
+                PixelDst = LowPassMul(LinePrev[X]<<8, PixelDst, Temporal);
+                LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            }
+            StorePixel(LineDest, X, Size, ((PixelDst+Round)>>Shift) & Mask);
         }
-        Frame += sStride;
-        FrameDest += dStride;
-        FrameAnt += W;
     }
 }
 
-static void deNoiseSpacial(
-                    unsigned char *Frame,        // mpi->planes[x]
+static void deNoise(const unsigned char *Frame,  // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,       // vf->priv->Line (width bytes)
+                    unsigned int *LineAnt,       // vf->priv->Line (W pixels)
+                    unsigned int *Rows,          // unused
+                    unsigned short *FrameAnt,
                     int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical)
+                    int Size, int Shift,
+                    int *Horizontal, int *Vertical, int *Temporal)
+{
+    (void) Rows;
+    /* Constant sizes spare a test per pixel */
+    if (Size == 1)
+        deNoisePixels(Frame, FrameDest, LineAnt, FrameAnt, W, H, sStride,
+                      dStride, 1, Shift, Horizontal, Vertical, Temporal);
+    else
+        deNoisePixels(Frame, FrameDest, LineAnt, FrameAnt, W, H, sStride,
+                      dStride, 2, Shift, Horizontal, Vertical, Temporal);
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+/* The horizontal recursion cannot be vectorized, unlike the vertical and
+ * temporal low passes where the pixels of a line are independent. So the
+ * lines are first low-passed horizontally HQDN3D_ROWS at a time, interleaved
+ * so that their recursions overlap, then vertically and temporally with the
+ * coefficients gathered eight at a time. */
+
+static inline void deNoiseHorizontalRows(const unsigned char *Frame,
+                                         unsigned int *Dest,
+                                         int W, int n, int sStride,
+                                         int Size, int Shift,
+                                         int *Horizontal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor, only left. */
-    for (long X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+    unsigned int PixelAnt[HQDN3D_ROWS];
+
+    if (!Horizontal[0]){
+        for (int r = 0; r < n; r++)
+            for (long X = 0; X < W; X++)
+                Dest[r*W+X] = LoadPixel(&Frame[r*sStride], X, Size) << Shift;
+        return;
     }
 
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+    for (int r = 0; r < n; r++)
+        PixelAnt[r] = LoadPixel(&Frame[r*sStride], 0, Size) << Shift;
+
+    for (long X = 0; X < W; X++){
+        for (int r = 0; r < n; r++){
+            unsigned int Pixel = LoadPixel(&Frame[r*sStride], X, Size) << Shift;
+            Dest[r*W+X] = PixelAnt[r] = LowPassMul(PixelAnt[r], Pixel,
+                                                   Horizontal);
         }
     }
 }
 
-static void deNoise(unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical, int *Temporal)
+static void deNoiseHorizontal(const unsigned char *Frame, unsigned int *Dest,
+                              int W, int n, int sStride, int Size, int Shift,
+                              int *Horizontal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-    unsigned short* FrameAnt=(*FrameAntPtr);
-
-    if(!FrameAnt){
-        (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
-        if(!FrameAnt)
-            return;
-        for (long Y = 0; Y < H; Y++){
-            unsigned short* dst=&FrameAnt[Y*W];
-            unsigned char* src=Frame+Y*sStride;
-            for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
+    /* Constant counts let the compiler keep the rows in registers */
+    if (n == HQDN3D_ROWS && Size == 1)
+        deNoiseHorizontalRows(Frame, Dest, W, HQDN3D_ROWS, sStride, 1, Shift,
+                              Horizontal);
+    else if (n == HQDN3D_ROWS)
+        deNoiseHorizontalRows(Frame, Dest, W, HQDN3D_ROWS, sStride, 2, Shift,
+                              Horizontal);
+    else
+        deNoiseHorizontalRows(Frame, Dest, W, n, sStride, Size, Shift,
+                              Horizontal);
+}
+
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static inline __m256i LowPassMulAVX2(__m256i PrevMul, __m256i CurrMul,
+                                     const int *Coef)
+{
+    __m256i d = _mm256_sub_epi32(PrevMul, CurrMul);
+    d = _mm256_srli_epi32(_mm256_add_epi32(d, _mm256_set1_epi32(0x10007FF)),
+                          12);
+    return _mm256_add_epi32(CurrMul, _mm256_i32gather_epi32(Coef, d, 4));
+}
+
+/* Packs eight 32-bit values below 0x10000 to 16 bits */
+VLC_TARGET
+static inline __m128i Pack16AVX2(__m256i v)
+{
+    v = _mm256_packus_epi32(v, v);
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(v, 0x08));
+}
+
+/* Low passes a horizontally low-passed line vertically and temporally */
+VLC_TARGET
+static void deNoiseRowAVX2(const unsigned int *Horiz, unsigned int *LineAnt,
+                           unsigned short *FrameAnt, unsigned char *FrameDest,
+                           int W, int Size, int Shift, bool Vert,
+                           int *Vertical, int *Temporal)
+{
+    const unsigned int Round = 0x10000000 + (1 << (Shift - 1)) - 1;
+    const unsigned int Mask = (1 << (24 - Shift)) - 1;
+    const __m128i Count = _mm_cvtsi32_si128(Shift);
+    const bool Temp = Temporal[0];
+    long X = 0;
+
+    for (; X + 8 <= W; X += 8){
+        __m256i PixelDst = _mm256_loadu_si256((const __m256i *)&Horiz[X]);
+
+        if (Vert)
+            PixelDst = LowPassMulAVX2(
+                _mm256_loadu_si256((const __m256i *)&LineAnt[X]),
+                PixelDst, Vertical);
+        _mm256_storeu_si256((__m256i *)&LineAnt[X], PixelDst);
+        if (Temp){
+            __m256i Ant = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i *)&FrameAnt[X]));
+
+            PixelDst = LowPassMulAVX2(_mm256_slli_epi32(Ant, 8), PixelDst,
+                                      Temporal);
+            Ant = _mm256_add_epi32(PixelDst, _mm256_set1_epi32(0x1000007F));
+            Ant = _mm256_and_si256(_mm256_srli_epi32(Ant, 8),
+                                   _mm256_set1_epi32(0xFFFF));
+            _mm_storeu_si128((__m128i *)&FrameAnt[X], Pack16AVX2(Ant));
         }
-    }
 
-    if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
+        __m256i Pixel = _mm256_add_epi32(PixelDst, _mm256_set1_epi32(Round));
+        __m128i Packed = Pack16AVX2(
+            _mm256_and_si256(_mm256_srl_epi32(Pixel, Count),
+                             _mm256_set1_epi32(Mask)));
+        if (Size == 1)
+            _mm_storel_epi64((__m128i *)&FrameDest[X],
+                             _mm_packus_epi16(Packed, Packed));
+        else
+            _mm_storeu_si128((__m128i *)&FrameDest[2*X], Packed);
     }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
-        return;
+
+    for (; X < W; X++){
+        unsigned int PixelDst = Horiz[X];
+
+        if (Vert)
+            PixelDst = LowPassMul(LineAnt[X], PixelDst, Vertical);
+        LineAnt[X] = PixelDst;
+        if (Temp){
+            PixelDst = LowPassMul(FrameAnt[X]<<8, PixelDst, Temporal);
+            FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
+        }
+        StorePixel(FrameDest, X, Size, ((PixelDst+Round)>>Shift) & Mask);
     }
+}
+
+VLC_TARGET
+static void deNoiseAVX2(const unsigned char *Frame, unsigned char *FrameDest,
+                        unsigned int *LineAnt,
+                        unsigned int *Rows,      // HQDN3D_ROWS lines of W pixels
+                        unsigned short *FrameAnt,
+                        int W, int H, int sStride, int dStride,
+                        int Size, int Shift,
+                        int *Horizontal, int *Vertical, int *Temporal)
+{
+    for (long Y = 0; Y < H; Y += HQDN3D_ROWS){
+        int n = H - Y < HQDN3D_ROWS ? H - Y : HQDN3D_ROWS;
 
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (long X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+        deNoiseHorizontal(&Frame[Y*sStride], Rows, W, n, sStride, Size, Shift,
+                          Horizontal);
+        for (int r = 0; r < n; r++)
+            deNoiseRowAVX2(&Rows[r*W], LineAnt, &FrameAnt[(Y+r)*W],
+                           &FrameDest[(Y+r)*dStride], W, Size, Shift,
+                           Y+r > 0 && Vertical[0], Vertical, Temporal);
     }
+}
 
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
-        }
+#undef VLC_TARGET
+#endif
+
+
+static unsigned short *deNoiseInit(const unsigned char *Frame,
+                                   int W, int H, int sStride,
+                                   int Size, int Shift)
+{
+    unsigned short *FrameAnt = malloc(W*H*sizeof(unsigned short));
+    if(!FrameAnt)
+        return NULL;
+    for (long Y = 0; Y < H; Y++){
+        unsigned short* dst=&FrameAnt[Y*W];
+        const unsigned char* src=Frame+Y*sStride;
+        for (long X = 0; X < W; X++) dst[X]=LoadPixel(src, X, Size)<<(Shift-8);
     }
+    return FrameAnt;
 }
 
 
@@ -116,9 +116,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     {
         /* We don't want to invert the alpha plane */
         i_planes = p_pic->i_planes - 1;
-        memcpy(
-            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
-            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
+        plane_CopyPixels( &p_outpic->p[A_PLANE], &p_pic->p[A_PLANE] );
     }
     else
     {
@@ -127,15 +125,14 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     for( int i_index = 0 ; i_index < i_planes ; i_index++ )
     {
-        uint8_t *p_in, *p_in_end, *p_line_end, *p_out;
+        uint8_t *p_in, *p_line_end, *p_out;
 
         p_in = p_pic->p[i_index].p_pixels;
-        p_in_end = p_in + p_pic->p[i_index].i_visible_lines
-                           * p_pic->p[i_index].i_pitch;
-
         p_out = p_outpic->p[i_index].p_pixels;
 
-        while( p_in < p_in_end )
+        /* Count the lines: the pitch of a view may be negative */
+        for( int i_line = 0; i_line < p_pic->p[i_index].i_visible_lines;
+             i_line++ )
         {
             uint64_t *p_in64, *p_out64;
 
@@ -132,9 +132,12 @@ typedef struct scene_t {
 /*****************************************************************************
  * filter_sys_t: private data
  *****************************************************************************/
+/* Maximum number of images waiting to be encoded and written */
+#define SCENE_QUEUE_SIZE 16
+
 typedef struct
 {
-    image_handler_t *p_image;
+    image_writer_t *p_writer;
     scene_t scene;
 
     char *psz_path;
@@ -168,8 +171,13 @@ static int Create( vlc_object_t *p_this )
     if( p_filter->p_sys == NULL )
         return VLC_ENOMEM;
 
-    p_sys->p_image = image_HandlerCreate( p_this );
-    if( !p_sys->p_image )
+    /* The images are encoded and written off the video output thread.
+     * A replaced image is written by a single thread, so that an older
+     * picture never overwrites a newer one. */
+    p_sys->b_replace = var_CreateGetBool( p_this, CFG_PREFIX "replace" );
+    p_sys->p_writer = image_WriterCreate( p_this, p_sys->b_replace ? 1 : 0,
+                                          SCENE_QUEUE_SIZE );
+    if( !p_sys->p_writer )
     {
         msg_Err( p_this, "Couldn't get handle to image conversion routines." );
         free( p_sys );
@@ -182,7 +190,7 @@ static int Create( vlc_object_t *p_this )
     {
         msg_Err( p_filter, "Could not find FOURCC for image type '%s'",
                  p_sys->psz_format );
-        image_HandlerDelete( p_sys->p_image );
+        image_WriterDelete( p_sys->p_writer );
         free( p_sys->psz_format );
         free( p_sys );
         return VLC_EGENERIC;
@@ -192,7 +200,6 @@ static int Create( vlc_object_t *p_this )
     p_sys->i_ratio = var_CreateGetInteger( p_this, CFG_PREFIX "ratio" );
     if( p_sys->i_ratio <= 0)
         p_sys->i_ratio = 1;
-    p_sys->b_replace = var_CreateGetBool( p_this, CFG_PREFIX "replace" );
     p_sys->psz_prefix = var_CreateGetString( p_this, CFG_PREFIX "prefix" );
     p_sys->psz_path = var_GetNonEmptyString( p_this, CFG_PREFIX "path" );
     if( p_sys->psz_path == NULL )
@@ -211,7 +218,8 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    image_HandlerDelete( p_sys->p_image );
+    /* Waits for the images being written */
+    image_WriterDelete( p_sys->p_writer );
 
     if( p_sys->scene.p_pic )
         picture_Release( p_sys->scene.p_pic );
@@ -272,14 +280,53 @@ static void SnapshotRatio( filter_t *p_filter, picture_t *p_pic )
 /*****************************************************************************
  * Save Picture to disk
  *****************************************************************************/
+struct scene_save
+{
+    filter_t *p_filter;
+    char *psz_filename;
+    char *psz_temp;
+};
+
+/* Called from the image writer threads */
+static void SavePictureDone( void *opaque, int i_ret )
+{
+    struct scene_save *save = opaque;
+    filter_t *p_filter = save->p_filter;
+
+    if( i_ret != VLC_SUCCESS )
+    {
+        msg_Err( p_filter, "could not create snapshot %s", save->psz_temp );
+        vlc_unlink( save->psz_temp );
+    }
+    else
+    {
+        /* switch to the final destination */
+#if defined (_WIN32) || defined(__OS2__)
+        vlc_unlink( save->psz_filename );
+#endif
+        if( vlc_rename( save->psz_temp, save->psz_filename ) == -1 )
+            msg_Err( p_filter, "could not rename snapshot %s: %s",
+                     save->psz_filename, vlc_strerror_c(errno) );
+    }
+
+    free( save->psz_temp );
+    free( save->psz_filename );
+    free( save );
+}
+
 static void SavePicture( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
     video_format_t fmt_in, fmt_out;
-    char *psz_filename = NULL;
-    char *psz_temp = NULL;
     int i_ret;
 
+    struct scene_save *save = malloc( sizeof(*save) );
+    if( unlikely(save == NULL) )
+        return;
+    save->p_filter = p_filter;
+    save->psz_filename = NULL;
+    save->psz_temp = NULL;
+
     memset( &fmt_out, 0, sizeof(video_format_t) );
 
     /* Save snapshot psz_format to a memory zone */
@@ -294,50 +341,44 @@ static void SavePicture( filter_t *p_filter, picture_t *p_pic )
      * switch it to the real name afterwards.
      */
     if( p_sys->b_replace )
-        i_ret = asprintf( &psz_filename, "%s" DIR_SEP "%s.%s",
+        i_ret = asprintf( &save->psz_filename, "%s" DIR_SEP "%s.%s",
                           p_sys->psz_path, p_sys->psz_prefix,
                           p_sys->psz_format );
     else
-        i_ret = asprintf( &psz_filename, "%s" DIR_SEP "%s%05d.%s",
+        i_ret = asprintf( &save->psz_filename, "%s" DIR_SEP "%s%05d.%s",
                           p_sys->psz_path, p_sys->psz_prefix,
                           p_sys->i_frames, p_sys->psz_format );
 
     if( i_ret == -1 )
     {
-        msg_Err( p_filter, "could not create snapshot %s", psz_filename );
+        save->psz_filename = NULL;
+        msg_Err( p_filter, "could not create snapshot" );
         goto error;
     }
 
-    i_ret = asprintf( &psz_temp, "%s.swp", psz_filename );
+    /* Images are written concurrently: the temporary files must differ,
+     * even if the final one is replaced */
+    i_ret = asprintf( &save->psz_temp, "%s.%d.swp", save->psz_filename,
+                      p_sys->i_frames );
     if( i_ret == -1 )
     {
-        msg_Err( p_filter, "could not create snapshot temporarily file %s", psz_temp );
+        save->psz_temp = NULL;
+        msg_Err( p_filter, "could not create snapshot temporarily file" );
         goto error;
     }
 
     /* Save the image */
-    i_ret = image_WriteUrl( p_sys->p_image, p_pic, &fmt_in, &fmt_out,
-                            psz_temp );
-    if( i_ret != VLC_SUCCESS )
+    if( image_WriterQueue( p_sys->p_writer, p_pic, &fmt_in, &fmt_out,
+                           save->psz_temp, SavePictureDone, save ) )
     {
-        msg_Err( p_filter, "could not create snapshot %s", psz_temp );
-    }
-    else
-    {
-        /* switch to the final destination */
-#if defined (_WIN32) || defined(__OS2__)
-        vlc_unlink( psz_filename );
-#endif
-        i_ret = vlc_rename( psz_temp, psz_filename );
-        if( i_ret == -1 )
-        {
-            msg_Err( p_filter, "could not rename snapshot %s: %s",
-                     psz_filename, vlc_strerror_c(errno) );
-            goto error;
-        }
+        msg_Warn( p_filter, "too many pending images, dropping %s",
+                  save->psz_filename );
+        goto error;
     }
+    return;
 
 error:
-    free( psz_temp );
-    free( psz_filename );
+    free( save->psz_temp );
+    free( save->psz_filename );
+    free( save );
 }
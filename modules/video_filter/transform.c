@@ -37,6 +37,7 @@
 #include <vlc_filter.h>
 #include <vlc_mouse.h>
 #include <vlc_picture.h>
+#include <vlc_slices.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -116,7 +117,8 @@ static void R270(int *sx, int *sy, int w, int h, int dx, int dy)
 typedef void (*convert_t)(int *, int *, int, int, int, int);
 
 #define PLANE(f,bits) \
-static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                              int begin, int end) \
 { \
     const uint##bits##_t *src_pixels = (const void *)src->p_pixels; \
     uint##bits##_t *restrict dst_pixels = (void *)dst->p_pixels; \
@@ -124,7 +126,7 @@ static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src
     const unsigned dst_width = dst->i_pitch / sizeof (*dst_pixels); \
     const unsigned dst_visible_width = dst->i_visible_pitch / sizeof (*dst_pixels); \
  \
-    for (int y = 0; y < dst->i_visible_lines; y++) { \
+    for (int y = begin; y < end; y++) { \
         for (unsigned x = 0; x < dst_visible_width; x++) { \
             int sx, sy; \
             (f)(&sx, &sy, dst_visible_width, dst->i_visible_lines, x, y); \
@@ -134,13 +136,15 @@ static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src
     } \
 }
 
-static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src)
+static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src,
+                        int begin, int end)
 {
     const uint8_t *src_pixels = src->p_pixels;
     uint8_t *restrict dst_pixels = dst->p_pixels;
 
-    dst_pixels += dst->i_pitch * dst->i_visible_lines;
-    for (int y = 0; y < dst->i_visible_lines; y++) {
+    src_pixels += src->i_pitch * (dst->i_visible_lines - end);
+    dst_pixels += dst->i_pitch * end;
+    for (int y = begin; y < end; y++) {
         dst_pixels -= dst->i_pitch;
         memcpy(dst_pixels, src_pixels, dst->i_visible_pitch);
         src_pixels += src->i_pitch;
@@ -148,9 +152,10 @@ static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src)
 }
 
 #define I422(f) \
-static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                         int begin, int end) \
 { \
-    for (int y = 0; y < dst->i_visible_lines; y += 2) { \
+    for (int y = begin; y < end; y += 2) { \
         for (int x = 0; x < dst->i_visible_pitch; x++) { \
             int sx, sy, uv; \
             (f)(&sx, &sy, dst->i_visible_pitch, dst->i_visible_lines / 2, \
@@ -164,11 +169,12 @@ static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src) \
 }
 
 #define YUY2(f) \
-static void PlaneYUY2_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void PlaneYUY2_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                          int begin, int end) \
 { \
     unsigned dst_visible_width = dst->i_visible_pitch / 2; \
  \
-    for (int y = 0; y < dst->i_visible_lines; y += 2) { \
+    for (int y = begin; y < end; y += 2) { \
         for (unsigned x = 0; x < dst_visible_width; x+= 2) { \
             int sx0, sy0, sx1, sy1; \
             (f)(&sx0, &sy0, dst_visible_width, dst->i_visible_lines, x, y); \
@@ -232,11 +238,11 @@ typedef struct {
     convert_t convert;
     convert_t iconvert;
     video_transform_t operation;
-    void      (*plane8) (plane_t *dst, const plane_t *src);
-    void      (*plane16)(plane_t *dst, const plane_t *src);
-    void      (*plane32)(plane_t *dst, const plane_t *src);
-    void      (*i422)(plane_t *dst, const plane_t *src);
-    void      (*yuyv)(plane_t *dst, const plane_t *src);
+    void      (*plane8) (plane_t *dst, const plane_t *src, int, int);
+    void      (*plane16)(plane_t *dst, const plane_t *src, int, int);
+    void      (*plane32)(plane_t *dst, const plane_t *src, int, int);
+    void      (*i422)(plane_t *dst, const plane_t *src, int, int);
+    void      (*yuyv)(plane_t *dst, const plane_t *src, int, int);
 } transform_description_t;
 
 #define DESC(str, f, invf, op) \
@@ -264,23 +270,59 @@ static const size_t n_transforms =
 typedef struct
 {
     const vlc_chroma_description_t *chroma;
-    void (*plane[PICTURE_PLANE_MAX])(plane_t *, const plane_t *);
+    void (*plane[PICTURE_PLANE_MAX])(plane_t *, const plane_t *, int, int);
     convert_t convert;
+    bool vflip_view;
 } filter_sys_t;
 
+struct transform_job
+{
+    const filter_sys_t *sys;
+    picture_t *dst;
+    const picture_t *src;
+};
+
+/* Transforms a band of rows of every destination plane. The bands are
+ * aligned on two rows for the 4:2:2 and YUY2 functions. */
+static void TransformSlice(void *opaque, unsigned index, unsigned count)
+{
+    const struct transform_job *job = opaque;
+    const filter_sys_t *sys = job->sys;
+
+    for (unsigned i = 0; i < sys->chroma->plane_count; i++) {
+        plane_t *dst = &job->dst->p[i];
+        unsigned begin, end;
+
+        vlc_slice_Rows(dst->i_visible_lines, index, count, 2, &begin, &end);
+        (sys->plane[i])(dst, &job->src->p[i], begin, end);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
 
+    if (sys->vflip_view) {
+        const video_format_t *fmt = &filter->fmt_in.video;
+        picture_t *view = picture_NewView(src, 0, 0, fmt->i_visible_width,
+                                          fmt->i_visible_height, true);
+        if (view != NULL) {
+            picture_CopyProperties(view, src);
+            picture_Release(src);
+            return view;
+        }
+    }
+
     picture_t *dst = filter_NewPicture(filter);
     if (!dst) {
         picture_Release(src);
         return NULL;
     }
 
-    const vlc_chroma_description_t *chroma = sys->chroma;
-    for (unsigned i = 0; i < chroma->plane_count; i++)
-         (sys->plane[i])(&dst->p[i], &src->p[i]);
+    struct transform_job job = { .sys = sys, .dst = dst, .src = src };
+    vlc_slices_Run(filter,
+                   vlc_slices_Count(filter, dst->p[0].i_visible_lines),
+                   TransformSlice, &job);
 
     picture_CopyProperties(dst, src);
     picture_Release(src);
@@ -432,6 +474,15 @@ static int Open(vlc_object_t *object)
             goto error;
     }
 
+    /* Flipping packed pictures vertically only reverses the order of their
+     * lines: the output can be a view of the input with a negative pitch, if
+     * the visible area is the whole picture (so that the flipped format has
+     * no offsets either). */
+    sys->vflip_view = dsc->operation == TRANSFORM_VFLIP
+                   && chroma->plane_count == 1
+                   && src->i_x_offset == 0 && src->i_y_offset == 0
+                   && src->i_visible_height == src->i_height;
+
     filter->p_sys           = sys;
     filter->pf_video_filter = Filter;
     filter->pf_video_mouse  = Mouse;
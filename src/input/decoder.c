@@ -141,6 +141,21 @@ struct decoder_owner
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Smoothed share of late video pictures, in percent */
+    atomic_uint display_lateness;
+
+    /* Contiguous audio buffers held back to be played at once
+     * (only accessed by the decoder thread, see decoder_current) */
+    struct
+    {
+        block_t *p_first;
+        block_t **pp_last;
+        mtime_t i_length;
+        unsigned i_count;
+    } audio_batch;
+    /* Recycled buffers for the gathered batches */
+    struct decoder_audio_pool *audio_pool;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -149,6 +164,14 @@ struct decoder_owner
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION   (CLOCK_FREQ/5)
+
+/* Short PCM buffers are gathered up to this duration before being played,
+ * when the decoder has a backlog, to amortize the per buffer output cost */
+#define DECODER_AUDIO_BATCH_LENGTH       (CLOCK_FREQ/25)
+/* Audio blocks already queued are decoded back to back, up to this count */
+#define DECODER_AUDIO_BATCH_BLOCKS       16
+/* Gathered batch buffers kept for reuse */
+#define DECODER_AUDIO_POOL_MAX           8
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
 #define VLC_TS_OLDEST  (VLC_TS_INVALID + 1)
@@ -158,6 +181,179 @@ static inline struct decoder_owner *dec_get_owner( decoder_t *p_dec )
     return container_of( p_dec, struct decoder_owner, dec );
 }
 
+/* Owner of the decoder thread running, if any: some decoders (mediacodec)
+ * output audio from their own thread, which must not touch the batch */
+static thread_local struct decoder_owner *decoder_current;
+
+static void DecoderResetAudioBatch( struct decoder_owner *p_owner )
+{
+    block_ChainRelease( p_owner->audio_batch.p_first );
+    p_owner->audio_batch.p_first = NULL;
+    p_owner->audio_batch.pp_last = &p_owner->audio_batch.p_first;
+    p_owner->audio_batch.i_length = 0;
+    p_owner->audio_batch.i_count = 0;
+}
+
+static void DecoderPlayAudioBatch( decoder_t *p_dec );
+
+/* The audio output may release the batch buffers after the decoder is gone,
+ * so the pool is refcounted by the decoder and by each buffer in use. */
+struct decoder_audio_pool
+{
+    vlc_mutex_t lock;
+    unsigned refs;
+    bool alive;
+    size_t size; /* of the recycled buffers */
+    unsigned count;
+    block_t *p_free;
+};
+
+struct decoder_audio_buffer
+{
+    block_t self;
+    block_t *p_storage;
+    struct decoder_audio_pool *pool;
+};
+
+static void DecoderAudioPoolRelease( struct decoder_audio_pool *pool )
+{
+    vlc_mutex_lock( &pool->lock );
+    bool last = --pool->refs == 0;
+    vlc_mutex_unlock( &pool->lock );
+
+    if( last )
+    {
+        assert( pool->p_free == NULL );
+        vlc_mutex_destroy( &pool->lock );
+        free( pool );
+    }
+}
+
+static void DecoderAudioBufferDestroy( struct decoder_audio_buffer *buf )
+{
+    block_Release( buf->p_storage );
+    free( buf );
+}
+
+static void DecoderAudioBufferRelease( block_t *p_block )
+{
+    struct decoder_audio_buffer *buf =
+        container_of( p_block, struct decoder_audio_buffer, self );
+    struct decoder_audio_pool *pool = buf->pool;
+
+    vlc_mutex_lock( &pool->lock );
+    if( pool->alive && pool->count < DECODER_AUDIO_POOL_MAX
+     && buf->p_storage->i_buffer >= pool->size )
+    {
+        buf->self.p_next = pool->p_free;
+        pool->p_free = &buf->self;
+        pool->count++;
+        buf = NULL;
+    }
+    vlc_mutex_unlock( &pool->lock );
+
+    if( buf != NULL )
+        DecoderAudioBufferDestroy( buf );
+    DecoderAudioPoolRelease( pool );
+}
+
+static block_t *DecoderAudioPoolGet( struct decoder_owner *p_owner, size_t size )
+{
+    struct decoder_audio_pool *pool = p_owner->audio_pool;
+
+    if( pool == NULL )
+    {
+        pool = malloc( sizeof(*pool) );
+        if( unlikely(pool == NULL) )
+            return NULL;
+        vlc_mutex_init( &pool->lock );
+        pool->refs = 1;
+        pool->alive = true;
+        pool->size = 0;
+        pool->count = 0;
+        pool->p_free = NULL;
+        p_owner->audio_pool = pool;
+    }
+
+    struct decoder_audio_buffer *buf = NULL;
+    block_t *p_stale = NULL;
+
+    vlc_mutex_lock( &pool->lock );
+    if( size > pool->size )
+    {   /* Bigger batches: the recycled buffers are too small */
+        pool->size = size;
+        p_stale = pool->p_free;
+        pool->p_free = NULL;
+        pool->count = 0;
+    }
+    else if( pool->p_free != NULL )
+    {
+        buf = container_of( pool->p_free, struct decoder_audio_buffer, self );
+        pool->p_free = buf->self.p_next;
+        pool->count--;
+    }
+    size = pool->size;
+    pool->refs++;
+    vlc_mutex_unlock( &pool->lock );
+
+    while( p_stale != NULL )
+    {
+        block_t *p_next = p_stale->p_next;
+        DecoderAudioBufferDestroy( container_of( p_stale,
+                                   struct decoder_audio_buffer, self ) );
+        p_stale = p_next;
+    }
+
+    if( buf == NULL )
+    {
+        buf = malloc( sizeof(*buf) );
+        if( likely(buf != NULL) )
+        {
+            buf->p_storage = block_Alloc( size );
+            if( unlikely(buf->p_storage == NULL) )
+            {
+                free( buf );
+                buf = NULL;
+            }
+        }
+        if( unlikely(buf == NULL) )
+        {
+            DecoderAudioPoolRelease( pool );
+            return NULL;
+        }
+        buf->pool = pool;
+    }
+
+    block_Init( &buf->self, buf->p_storage->p_buffer, buf->p_storage->i_buffer );
+    buf->self.pf_release = DecoderAudioBufferRelease;
+    return &buf->self;
+}
+
+static void DecoderAudioPoolDelete( struct decoder_owner *p_owner )
+{
+    struct decoder_audio_pool *pool = p_owner->audio_pool;
+
+    if( pool == NULL )
+        return;
+
+    vlc_mutex_lock( &pool->lock );
+    block_t *p_free = pool->p_free;
+    pool->alive = false;
+    pool->p_free = NULL;
+    pool->count = 0;
+    vlc_mutex_unlock( &pool->lock );
+
+    while( p_free != NULL )
+    {
+        block_t *p_next = p_free->p_next;
+        DecoderAudioBufferDestroy( container_of( p_free,
+                                   struct decoder_audio_buffer, self ) );
+        p_free = p_next;
+    }
+    DecoderAudioPoolRelease( pool );
+    p_owner->audio_pool = NULL;
+}
+
 /**
  * Load a decoder module
  */
@@ -240,6 +436,8 @@ static int ReloadDecoder( decoder_t *p_dec, bool b_packetizer,
         assert( p_owner->fmt.i_cat == AUDIO_ES );
         audio_output_t *p_aout = p_owner->p_aout;
 
+        DecoderResetAudioBatch( p_owner );
+
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_aout = NULL;
         vlc_mutex_unlock( &p_owner->lock );
@@ -325,6 +523,9 @@ static int aout_update_format( decoder_t *p_dec )
     {
         audio_output_t *p_aout = p_owner->p_aout;
 
+        /* Play what was decoded with the previous parameters */
+        DecoderPlayAudioBatch( p_dec );
+
         /* Parameters changed, restart the aout */
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_aout = NULL;
@@ -652,6 +853,13 @@ static int DecoderGetDisplayRate( decoder_t *p_dec )
     return input_clock_GetRate( p_owner->p_clock );
 }
 
+static unsigned DecoderGetDisplayLateness( decoder_t *p_dec )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+
+    return atomic_load( &p_owner->display_lateness );
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -1056,18 +1264,31 @@ static void DecoderUpdateStatVideo( struct decoder_owner *p_owner,
     input_thread_t *p_input = p_owner->p_input;
     unsigned displayed = 0;
 
-    /* Update ugly stat */
-    if( p_input == NULL )
-        return;
-
     if( p_owner->p_vout != NULL )
     {
         unsigned vout_lost = 0;
+        unsigned vout_late = 0;
+
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                &vout_late );
+
+        /* Feedback for the decoder, smoothed over the last pictures */
+        const unsigned total = displayed + vout_lost;
+        if( total > 0 )
+        {
+            const unsigned late = __MIN( vout_late + vout_lost, total );
+            unsigned lateness = atomic_load( &p_owner->display_lateness );
+            lateness = ( lateness * 7 + late * 100 / total ) / 8;
+            atomic_store( &p_owner->display_lateness, lateness );
+        }
 
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
         lost += vout_lost;
     }
 
+    /* Update ugly stat */
+    if( p_input == NULL )
+        return;
+
     struct input_stats *stats = input_priv(p_input)->stats;
 
     if( stats != NULL )
@@ -1206,11 +1427,100 @@ static void DecoderUpdateStatAudio( struct decoder_owner *p_owner,
     }
 }
 
+static void DecoderPlayAudioBatch( decoder_t *p_dec )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+    block_t *p_audio = p_owner->audio_batch.p_first;
+    unsigned count = p_owner->audio_batch.i_count;
+    unsigned lost = 0;
+
+    if( p_audio == NULL )
+        return;
+
+    p_owner->audio_batch.p_first = NULL;
+    DecoderResetAudioBatch( p_owner );
+
+    if( p_audio->p_next != NULL )
+    {
+        unsigned samples = 0;
+        size_t size;
+        mtime_t length;
+
+        for( const block_t *p = p_audio; p != NULL; p = p->p_next )
+            samples += p->i_nb_samples;
+        block_ChainProperties( p_audio, NULL, &size, &length );
+
+        /* As block_ChainGather(), into a recycled buffer */
+        block_t *p_gather = DecoderAudioPoolGet( p_owner, size );
+        if( unlikely(p_gather == NULL) )
+        {
+            block_ChainRelease( p_audio );
+            p_owner->pf_update_stat( p_owner, count, count );
+            return;
+        }
+        p_gather->i_buffer = size;
+        block_ChainExtract( p_audio, p_gather->p_buffer, size );
+        p_gather->i_flags = p_audio->i_flags;
+        p_gather->i_pts = p_audio->i_pts;
+        p_gather->i_dts = p_audio->i_dts;
+        p_gather->i_length = length;
+        p_gather->i_nb_samples = samples;
+        block_ChainRelease( p_audio );
+        p_audio = p_gather;
+    }
+
+    DecoderPlayAudio( p_dec, p_audio, &lost );
+
+    p_owner->pf_update_stat( p_owner, count, lost > 0 ? count : 0 );
+}
+
+static bool DecoderCanBatchAudio( decoder_t *p_dec, const block_t *p_audio )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+
+    if( p_owner->p_aout == NULL || !AOUT_FMT_LINEAR( &p_dec->fmt_out.audio )
+     || p_audio->i_pts == VLC_TS_INVALID || p_audio->i_length <= 0
+     || p_audio->i_length >= DECODER_AUDIO_BATCH_LENGTH
+     || (p_audio->i_flags & BLOCK_FLAG_DISCONTINUITY) )
+        return false;
+
+    /* Keep the preroll accurate to the buffer */
+    vlc_mutex_lock( &p_owner->lock );
+    bool prerolled = p_owner->i_preroll_end == (mtime_t)INT64_MIN;
+    vlc_mutex_unlock( &p_owner->lock );
+    return prerolled;
+}
+
 static void DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
 {
     unsigned lost = 0;
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    if( decoder_current != p_owner )
+    {   /* Not the decoder thread: play as is */
+        DecoderPlayAudio( p_dec, p_aout_buf, &lost );
+        p_owner->pf_update_stat( p_owner, 1, lost );
+        return;
+    }
+
+    if( DecoderCanBatchAudio( p_dec, p_aout_buf ) )
+    {
+        const block_t *p_first = p_owner->audio_batch.p_first;
+        if( p_first != NULL
+         && p_first->i_pts + p_owner->audio_batch.i_length != p_aout_buf->i_pts )
+            DecoderPlayAudioBatch( p_dec );
+
+        block_ChainLastAppend( &p_owner->audio_batch.pp_last, p_aout_buf );
+        p_owner->audio_batch.i_length += p_aout_buf->i_length;
+        p_owner->audio_batch.i_count++;
+
+        /* The rest is played once the decoder runs out of input */
+        if( p_owner->audio_batch.i_length >= DECODER_AUDIO_BATCH_LENGTH )
+            DecoderPlayAudioBatch( p_dec );
+        return;
+    }
+
+    DecoderPlayAudioBatch( p_dec );
     DecoderPlayAudio( p_dec, p_aout_buf, &lost );
 
     p_owner->pf_update_stat( p_owner, 1, lost );
@@ -1431,6 +1741,8 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
     decoder_t *p_packetizer = p_owner->p_packetizer;
 
+    DecoderResetAudioBatch( p_owner );
+
     if( p_owner->error )
         return;
 
@@ -1466,6 +1778,7 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     {
         if( p_owner->p_vout )
             vout_Flush( p_owner->p_vout, VLC_TS_OLDEST );
+        atomic_store( &p_owner->display_lateness, 0 );
     }
     else if( p_dec->fmt_out.i_cat == SPU_ES )
     {
@@ -1540,6 +1853,8 @@ static void *DecoderThread( void *p_data )
     float rate = 1.f;
     bool paused = false;
 
+    decoder_current = p_owner;
+
     /* The decoder's main loop */
     vlc_fifo_Lock( p_owner->p_fifo );
     vlc_fifo_CleanupPush( p_owner->p_fifo );
@@ -1610,6 +1925,16 @@ static void *DecoderThread( void *p_data )
         block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
         if( p_block == NULL )
         {
+            if( p_owner->audio_batch.p_first != NULL )
+            {   /* Play the held back audio before waiting */
+                int canc = vlc_savecancel();
+
+                vlc_fifo_Unlock( p_owner->p_fifo );
+                DecoderPlayAudioBatch( p_dec );
+                vlc_fifo_Lock( p_owner->p_fifo );
+                vlc_restorecancel( canc );
+                continue;
+            }
             if( likely(!p_owner->b_draining) )
             {   /* Wait for a block to decode (or a request to drain) */
                 p_owner->b_idle = true;
@@ -1622,14 +1947,48 @@ static void *DecoderThread( void *p_data )
              * drain. Pass p_block = NULL to decoder just once. */
         }
 
+        /* Decode the audio blocks already queued back to back, without
+         * checking for the other requests nor acknowledging in between */
+        block_t *p_batch = NULL;
+        if( p_block != NULL && p_dec->fmt_out.i_cat == AUDIO_ES
+         && !p_owner->paused )
+        {
+            block_t **pp_batch = &p_batch;
+            for( unsigned i = 1; i < DECODER_AUDIO_BATCH_BLOCKS; i++ )
+            {
+                block_t *p_next = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+                if( p_next == NULL )
+                    break;
+                block_ChainLastAppend( &pp_batch, p_next );
+            }
+        }
+
         vlc_fifo_Unlock( p_owner->p_fifo );
 
         int canc = vlc_savecancel();
         DecoderProcess( p_dec, p_block );
 
+        while( p_batch != NULL )
+        {
+            vlc_fifo_Lock( p_owner->p_fifo );
+            bool flushing = p_owner->flushing;
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            if( flushing )
+            {   /* Dropped as the rest of the fifo */
+                block_ChainRelease( p_batch );
+                break;
+            }
+
+            block_t *p_next = p_batch->p_next;
+            p_batch->p_next = NULL;
+            DecoderProcess( p_dec, p_batch );
+            p_batch = p_next;
+        }
+
         if( p_block == NULL && p_dec->fmt_out.i_cat == AUDIO_ES )
         {   /* Draining: the decoder is drained and all decoded buffers are
              * queued to the output at this point. Now drain the output. */
+            DecoderPlayAudioBatch( p_dec );
             if( p_owner->p_aout != NULL )
                 aout_DecFlush( p_owner->p_aout, true );
         }
@@ -1658,7 +2017,8 @@ static const struct decoder_owner_callbacks dec_video_cbs =
         DecoderQueueVideo,
         DecoderQueueCc,
         DecoderGetDisplayDate,
-        DecoderGetDisplayRate
+        DecoderGetDisplayRate,
+        DecoderGetDisplayLateness,
     },
     DecoderGetInputAttachments,
 };
@@ -1731,7 +2091,11 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_draining = false;
     p_owner->drained = false;
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
+    atomic_init( &p_owner->display_lateness, 0 );
     p_owner->b_idle = false;
+    p_owner->audio_batch.p_first = NULL;
+    DecoderResetAudioBatch( p_owner );
+    p_owner->audio_pool = NULL;
 
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
@@ -1838,6 +2202,8 @@ static void DeleteDecoder( decoder_t * p_dec )
 
     const enum es_format_category_e i_cat =p_dec->fmt_out.i_cat;
     UnloadDecoder( p_dec );
+    DecoderResetAudioBatch( p_owner );
+    DecoderAudioPoolDelete( p_owner );
 
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
@@ -0,0 +1,508 @@
+/*****************************************************************************
+ * thumbnailer.c: Thumbnails extraction
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The thumbnailer runs a bare demuxer with its own ES output: only the first
+ * video ES is packetized and decoded, and no clock, audio or video output is
+ * created. The demuxer is seeked in fast (keyframe) mode, and the blocks
+ * preceding the first keyframe are dropped, so that usually a single picture
+ * has to be decoded.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_codec.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_input_item.h>
+#include <vlc_interrupt.h>
+#include <vlc_modules.h>
+#include <vlc_thumbnailer.h>
+
+#include "../libvlc.h"
+#include "demux.h"
+#include "stream.h"
+
+struct es_out_id_t
+{
+    es_out_id_t *next;
+    es_format_t fmt;
+    decoder_t  *packetizer;
+    decoder_t  *decoder;
+};
+
+typedef struct
+{
+    es_out_t       out;
+    vlc_object_t  *obj;
+    es_out_id_t   *es;      /* all the ES added by the demuxer */
+    es_out_id_t   *video;   /* the only ES being decoded */
+    picture_t     *picture;
+    bool           keyframe; /* a keyframe was sent to the decoder */
+    bool           error;
+} thumbnailer_t;
+
+struct thumbnailer_decoder
+{
+    decoder_t      dec;
+    thumbnailer_t *thumbnailer;
+};
+
+/*****************************************************************************
+ * Decoder
+ *****************************************************************************/
+static int ThumbnailerUpdateFormat( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *ThumbnailerNewPicture( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static void ThumbnailerQueuePicture( decoder_t *p_dec, picture_t *p_pic )
+{
+    thumbnailer_t *th =
+        container_of( p_dec, struct thumbnailer_decoder, dec )->thumbnailer;
+
+    if( th->picture == NULL )
+        th->picture = p_pic;
+    else
+        picture_Release( p_pic );
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    if( p_dec->p_module != NULL )
+        module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( thumbnailer_t *th, const es_format_t *fmt )
+{
+    struct thumbnailer_decoder *owner =
+        vlc_custom_create( th->obj, sizeof( *owner ), "thumbnailer decoder" );
+    if( owner == NULL )
+        return NULL;
+
+    decoder_t *p_dec = &owner->dec;
+    owner->thumbnailer = th;
+
+    p_dec->p_module = NULL;
+    es_format_Copy( &p_dec->fmt_in, fmt );
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_frame_drop_allowed = false;
+
+    static const struct decoder_owner_callbacks dec_cbs =
+    {
+        .video = {
+            ThumbnailerUpdateFormat,
+            ThumbnailerNewPicture,
+            ThumbnailerQueuePicture,
+        },
+    };
+    p_dec->cbs = &dec_cbs;
+
+    p_dec->p_module = module_need_var( p_dec, "video decoder", "codec" );
+    if( p_dec->p_module == NULL )
+    {
+        msg_Err( p_dec, "no suitable decoder module for fourcc `%4.4s'",
+                 (char *)&fmt->i_codec );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static decoder_t *CreatePacketizer( thumbnailer_t *th, const es_format_t *fmt )
+{
+    decoder_t *p_pack = vlc_custom_create( th->obj, sizeof( *p_pack ),
+                                           "thumbnailer packetizer" );
+    if( p_pack == NULL )
+        return NULL;
+
+    p_pack->pf_decode = NULL;
+    p_pack->pf_packetize = NULL;
+
+    es_format_Copy( &p_pack->fmt_in, fmt );
+    p_pack->fmt_in.b_packetized = false;
+    es_format_Init( &p_pack->fmt_out, fmt->i_cat, 0 );
+
+    p_pack->p_module = module_need( p_pack, "packetizer", NULL, false );
+    if( p_pack->p_module == NULL )
+    {
+        es_format_Clean( &p_pack->fmt_in );
+        vlc_object_release( p_pack );
+        return NULL;
+    }
+    return p_pack;
+}
+
+/* Decodes one packetized block, or drains the decoder if p_block is NULL */
+static void ThumbnailerDecode( thumbnailer_t *th, es_out_id_t *es,
+                               block_t *p_block )
+{
+    if( th->picture != NULL || th->error )
+        goto drop;
+
+    if( es->decoder == NULL )
+    {
+        if( p_block == NULL )
+            return;
+
+        es->decoder = CreateDecoder( th, es->packetizer != NULL
+                                         ? &es->packetizer->fmt_out
+                                         : &es->fmt );
+        if( es->decoder == NULL )
+        {
+            th->error = true;
+            goto drop;
+        }
+    }
+
+    if( p_block != NULL && !th->keyframe )
+    {
+        /* Blocks preceding the keyframe reached by the seek would only
+         * decode to broken pictures, if at all. */
+        if( ( p_block->i_flags & BLOCK_FLAG_TYPE_MASK )
+         && !( p_block->i_flags & BLOCK_FLAG_TYPE_I ) )
+            goto drop;
+        th->keyframe = true;
+    }
+
+    if( es->decoder->pf_decode( es->decoder, p_block ) == VLCDEC_ECRITICAL )
+        th->error = true;
+    return;
+
+drop:
+    if( p_block != NULL )
+        block_Release( p_block );
+}
+
+/* Packetizes and decodes a block, or drains both if pp_block is NULL */
+static void ThumbnailerPacketize( thumbnailer_t *th, es_out_id_t *es,
+                                  block_t **pp_block )
+{
+    if( es->packetizer == NULL )
+    {
+        ThumbnailerDecode( th, es, pp_block != NULL ? *pp_block : NULL );
+        return;
+    }
+
+    block_t *p_chain;
+    while( ( p_chain = es->packetizer->pf_packetize( es->packetizer,
+                                                     pp_block ) ) != NULL )
+    {
+        while( p_chain != NULL )
+        {
+            block_t *p_next = p_chain->p_next;
+            p_chain->p_next = NULL;
+            ThumbnailerDecode( th, es, p_chain );
+            p_chain = p_next;
+        }
+    }
+
+    if( pp_block == NULL )
+        ThumbnailerDecode( th, es, NULL );
+}
+
+static void ThumbnailerFlush( thumbnailer_t *th )
+{
+    es_out_id_t *es = th->video;
+
+    if( es != NULL )
+    {
+        if( es->packetizer != NULL && es->packetizer->pf_flush != NULL )
+            es->packetizer->pf_flush( es->packetizer );
+        if( es->decoder != NULL && es->decoder->pf_flush != NULL )
+            es->decoder->pf_flush( es->decoder );
+    }
+    if( th->picture != NULL )
+    {
+        picture_Release( th->picture );
+        th->picture = NULL;
+    }
+    th->keyframe = false;
+}
+
+/*****************************************************************************
+ * ES output
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    thumbnailer_t *th = out->p_sys;
+    es_out_id_t *es = malloc( sizeof( *es ) );
+    if( unlikely(es == NULL) )
+        return NULL;
+
+    es_format_Copy( &es->fmt, fmt );
+    es->packetizer = NULL;
+    es->decoder = NULL;
+    es->next = th->es;
+    th->es = es;
+
+    if( fmt->i_cat != VIDEO_ES || th->video != NULL )
+        return es;
+
+    if( !fmt->b_packetized )
+    {
+        es->packetizer = CreatePacketizer( th, fmt );
+        if( es->packetizer == NULL )
+            msg_Warn( th->obj, "no packetizer for fourcc `%4.4s'",
+                      (char *)&fmt->i_codec );
+    }
+    th->video = es;
+    return es;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
+{
+    thumbnailer_t *th = out->p_sys;
+
+    if( es != th->video || th->picture != NULL || th->error )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    ThumbnailerPacketize( th, es, &p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *es )
+{
+    thumbnailer_t *th = out->p_sys;
+    es_out_id_t **pp;
+
+    for( pp = &th->es; *pp != es; pp = &(*pp)->next )
+        assert( *pp != NULL );
+    *pp = es->next;
+
+    if( es->decoder != NULL )
+        DeleteDecoder( es->decoder );
+    if( es->packetizer != NULL )
+        demux_PacketizerDestroy( es->packetizer );
+    if( th->video == es )
+        th->video = NULL;
+    es_format_Clean( &es->fmt );
+    free( es );
+}
+
+static int EsOutControl( es_out_t *out, int query, va_list args )
+{
+    thumbnailer_t *th = out->p_sys;
+
+    switch( query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *es = va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = es == th->video;
+            break;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            break;
+        case ES_OUT_POST_SUBNODE:
+            input_item_node_Delete( va_arg( args, input_item_node_t * ) );
+            break;
+        case ES_OUT_SET_ES:
+        case ES_OUT_RESTART_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_CAT_POLICY:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_ES_FMT:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_SET_GROUP_EPG_EVENT:
+        case ES_OUT_SET_EPG_TIME:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        case ES_OUT_SET_META:
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void EsOutDestroy( es_out_t *out )
+{
+    thumbnailer_t *th = out->p_sys;
+
+    /* Some demuxers leave their ES behind */
+    while( th->es != NULL )
+        EsOutDel( out, th->es );
+}
+
+/*****************************************************************************
+ * Extraction
+ *****************************************************************************/
+static void ThumbnailerTimeout( void *data )
+{
+    vlc_interrupt_kill( data );
+}
+
+static int ThumbnailerSeek( demux_t *p_demux, mtime_t i_time, double f_pos )
+{
+    if( i_time >= 0 )
+    {
+        if( demux_Control( p_demux, DEMUX_SET_TIME, i_time, false )
+                == VLC_SUCCESS )
+            return VLC_SUCCESS;
+
+        /* Fall back to the position if the demuxer cannot seek by time */
+        mtime_t i_length;
+        if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length )
+                != VLC_SUCCESS || i_length <= 0 )
+            return VLC_EGENERIC;
+        f_pos = (double)i_time / i_length;
+    }
+
+    if( f_pos <= 0. )
+        return VLC_SUCCESS;
+    return demux_Control( p_demux, DEMUX_SET_POSITION, VLC_CLIP( f_pos, 0., 1. ),
+                          false );
+}
+
+static picture_t *Extract( thumbnailer_t *th, const char *psz_url,
+                           mtime_t i_time, double f_pos )
+{
+    stream_t *p_stream = stream_AccessNew( th->obj, NULL, &th->out, false,
+                                           psz_url );
+    if( p_stream == NULL )
+    {
+        es_out_Delete( &th->out );
+        return NULL;
+    }
+
+    demux_t *p_demux;
+    if( p_stream->pf_read == NULL && p_stream->pf_block == NULL
+     && p_stream->pf_readdir == NULL )
+        p_demux = p_stream; /* Combined access/demux */
+    else
+    {
+        p_stream = stream_FilterAutoNew( p_stream );
+        p_demux = demux_NewAdvanced( th->obj, NULL, "any", psz_url, p_stream,
+                                     &th->out, false );
+        if( p_demux == NULL )
+        {
+            vlc_stream_Delete( p_stream );
+            es_out_Delete( &th->out );
+            return NULL;
+        }
+    }
+
+    if( ThumbnailerSeek( p_demux, i_time, f_pos ) != VLC_SUCCESS )
+        msg_Warn( th->obj, "cannot seek, using the first picture" );
+    /* Discard whatever the demuxer sent while opening */
+    ThumbnailerFlush( th );
+
+    while( th->picture == NULL && !th->error && !vlc_killed() )
+    {
+        int ret = demux_Demux( p_demux );
+        if( ret == VLC_DEMUXER_EOF || ret == VLC_DEMUXER_EGENERIC )
+        {
+            /* Pictures may still be held by the packetizer and decoder */
+            if( th->video != NULL && !vlc_killed() )
+                ThumbnailerPacketize( th, th->video, NULL );
+            break;
+        }
+    }
+
+    picture_t *p_pic = th->picture;
+    th->picture = NULL;
+
+    demux_Delete( p_demux );
+    es_out_Delete( &th->out );
+    return p_pic;
+}
+
+#undef vlc_thumbnailer_Extract
+picture_t *vlc_thumbnailer_Extract( vlc_object_t *obj, input_item_t *item,
+                                    mtime_t i_time, double f_pos,
+                                    mtime_t i_timeout )
+{
+    char *psz_url = input_item_GetURI( item );
+    if( psz_url == NULL )
+        return NULL;
+
+    thumbnailer_t th = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+            .pf_destroy = EsOutDestroy,
+            .p_sys = &th,
+        },
+        .obj = obj,
+        .es = NULL,
+        .video = NULL,
+        .picture = NULL,
+        .keyframe = false,
+        .error = false,
+    };
+
+    vlc_interrupt_t *ctx = vlc_interrupt_create();
+    if( unlikely(ctx == NULL) )
+    {
+        free( psz_url );
+        return NULL;
+    }
+
+    vlc_timer_t timer;
+    bool b_timer = i_timeout > 0
+                && vlc_timer_create( &timer, ThumbnailerTimeout, ctx ) == 0;
+    if( b_timer )
+        vlc_timer_schedule( timer, false, i_timeout, 0 );
+
+    vlc_interrupt_t *oldctx = vlc_interrupt_set( ctx );
+    picture_t *p_pic = Extract( &th, psz_url, i_time, f_pos );
+    vlc_interrupt_set( oldctx );
+
+    if( b_timer )
+        vlc_timer_destroy( timer );
+    vlc_interrupt_destroy( ctx );
+    free( psz_url );
+
+    if( p_pic == NULL )
+        msg_Warn( obj, "no thumbnail extracted" );
+    return p_pic;
+}
@@ -93,6 +93,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->slices = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -407,6 +408,7 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
 
+    vlc_slices_Destroy( p_libvlc );
     libvlc_InternalActionsClean( p_libvlc );
 
     /* Save the configuration */
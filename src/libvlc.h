@@ -185,6 +185,7 @@ typedef struct libvlc_priv_t
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
     vlc_actions_t *actions; ///< Hotkeys handler
+    struct vlc_slices *slices; ///< Slice jobs worker threads (or NULL)
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -199,6 +200,11 @@ int intf_InsertItem(libvlc_int_t *, const char *mrl, unsigned optc,
                     const char * const *optv, unsigned flags);
 void intf_DestroyAll( libvlc_int_t * );
 
+/*
+ * Slice jobs
+ */
+void vlc_slices_Destroy( libvlc_int_t * );
+
 /*
  * Variables stuff
  */
@@ -28,9 +28,11 @@
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
+#include <vlc_picture_pool.h>
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
+#include "picture.h"
 
 typedef struct chained_filter_t
 {
@@ -40,6 +42,8 @@ typedef struct chained_filter_t
     struct chained_filter_t *prev, *next;
     vlc_mouse_t *mouse;
     picture_t *pending;
+    picture_pool_t *pool; /**< Output pictures, if not the last filter */
+    video_format_t pool_fmt; /**< Format of the pool pictures */
 } chained_filter_t;
 
 /* Only use this with filter objects from _this_ C module */
@@ -82,6 +86,8 @@ static filter_chain_t *filter_chain_NewInner( const filter_owner_t *callbacks,
     chain->callbacks = *callbacks;
     if( owner != NULL )
         chain->owner = *owner;
+    else
+        memset( &chain->owner, 0, sizeof (chain->owner) );
     chain->first = NULL;
     chain->last = NULL;
     es_format_Init( &chain->fmt_in, cat, 0 );
@@ -106,12 +112,39 @@ filter_chain_t *filter_chain_New( vlc_object_t *obj, const char *cap,
     return filter_chain_NewInner( &callbacks, cap, NULL, false, NULL, cat );
 }
 
+/* Intermediate pictures recycled per chained filter. The next filter usually
+ * releases each of them before the following one is requested; if it holds
+ * more, the extra ones are allocated on the fly. The pool is replaced when
+ * the output format of the filter changes; pictures still held from the old
+ * one are freed when released. */
+#define CHAIN_POOL_SIZE 2
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
-    if( chained(filter)->next != NULL )
+    chained_filter_t *cf = chained(filter);
+
+    if( cf->next != NULL )
     {
-        picture_t *pic = picture_NewFromFormat( &filter->fmt_out.video );
+        picture_t *pic = NULL;
+
+        if( cf->pool != NULL
+         && !video_format_IsSimilar( &cf->pool_fmt, &filter->fmt_out.video ) )
+        {
+            picture_pool_Release( cf->pool );
+            cf->pool = NULL;
+        }
+        if( cf->pool == NULL )
+        {
+            cf->pool = picture_pool_NewFromFormat( &filter->fmt_out.video,
+                                                   CHAIN_POOL_SIZE );
+            cf->pool_fmt = filter->fmt_out.video;
+            cf->pool_fmt.p_palette = NULL;
+        }
+        if( cf->pool != NULL )
+            pic = picture_pool_Get( cf->pool );
+        if( pic == NULL )
+            pic = picture_NewFromFormat( &filter->fmt_out.video );
         if( pic == NULL )
             msg_Err( filter, "Failed to allocate picture" );
         return pic;
@@ -247,6 +280,7 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
         vlc_mouse_Init( mouse );
     chained->mouse = mouse;
     chained->pending = NULL;
+    chained->pool = NULL;
 
     msg_Dbg( parent, "Filter '%s' (%p) appended to chain",
              (name != NULL) ? name : module_get_name(filter->p_module, false),
@@ -306,6 +340,8 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
     msg_Dbg( obj, "Filter %p removed from chain", (void *)filter );
     FilterDeletePictures( chained->pending );
 
+    if( chained->pool != NULL )
+        picture_pool_Release( chained->pool );
     free( chained->mouse );
     es_format_Clean( &filter->fmt_out );
     es_format_Clean( &filter->fmt_in );
@@ -391,11 +427,37 @@ const es_format_t *filter_chain_GetFmtOut( filter_chain_t *p_chain )
     return &p_chain->fmt_out;
 }
 
+/**
+ * Most filters walk the lines up to an end pointer, and assume positive
+ * pitches. Vertically flipped views are thus copied before being passed to
+ * the next filter, into a picture of the filter that returned them.
+ */
+static picture_t *FilterChainInput( chained_filter_t *f, picture_t *pic )
+{
+    if( f->prev == NULL )
+        return pic;
+
+    bool flipped = false;
+    for( int i = 0; i < pic->i_planes; i++ )
+        flipped |= pic->p[i].i_pitch < 0;
+    if( !flipped )
+        return pic;
+
+    picture_t *out = filter_NewPicture( &f->prev->filter );
+    if( out != NULL )
+        picture_Copy( out, pic );
+    picture_Release( pic );
+    return out;
+}
+
 static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic )
 {
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        p_pic = FilterChainInput( f, p_pic );
+        if( !p_pic )
+            break;
         p_pic = p_filter->pf_video_filter( p_filter, p_pic );
         if( !p_pic )
             break;
@@ -410,13 +472,32 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
     return p_pic;
 }
 
+/**
+ * Views of pictures (see picture_NewView()) are passed as is between chained
+ * filters, unless flipped (see FilterChainInput()). If the owner allocates
+ * the output pictures, it gets the pixels in one of its own, as it may need
+ * them in its buffers (display pool...).
+ */
+static picture_t *FilterChainOutput( filter_chain_t *chain, picture_t *pic )
+{
+    if( pic == NULL || chain->last == NULL
+     || chain->owner.video.buffer_new == NULL || !picture_IsView( pic ) )
+        return pic;
+
+    picture_t *out = filter_NewPicture( &chain->last->filter );
+    if( out != NULL )
+        picture_Copy( out, pic );
+    picture_Release( pic );
+    return out;
+}
+
 picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
 {
     if( p_pic )
     {
         p_pic = FilterChainVideoFilter( p_chain->first, p_pic );
         if( p_pic )
-            return p_pic;
+            return FilterChainOutput( p_chain, p_pic );
     }
     for( chained_filter_t *b = p_chain->last; b != NULL; b = b->prev )
     {
@@ -428,7 +509,7 @@ picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
 
         p_pic = FilterChainVideoFilter( b->next, p_pic );
         if( p_pic )
-            return p_pic;
+            return FilterChainOutput( p_chain, p_pic );
     }
     return NULL;
 }
@@ -34,6 +34,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <errno.h>
 #include <limits.h>
 
@@ -46,6 +47,7 @@
 #include <vlc_stream.h>
 #include <vlc_fs.h>
 #include <vlc_sout.h>
+#include <vlc_cpu.h>
 #include <libvlc.h>
 #include <vlc_modules.h>
 
@@ -573,6 +575,180 @@ static picture_t *ImageConvert( image_handler_t *p_image, picture_t *p_pic,
     return p_pif;
 }
 
+/**
+ * Image writer
+ *
+ */
+struct image_writer_request
+{
+    struct image_writer_request *next;
+    picture_t *pic;
+    video_format_t fmt_in;
+    video_format_t fmt_out;
+    char *url;
+    void (*pf_done)( void *, int );
+    void *opaque;
+};
+
+struct image_writer_t
+{
+    vlc_object_t *p_parent;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool closing;
+    unsigned count;
+    unsigned queue_size;
+    struct image_writer_request *first;
+    struct image_writer_request **last;
+    unsigned thread_count;
+    vlc_thread_t threads[];
+};
+
+static void *ImageWriterThread( void *data )
+{
+    image_writer_t *writer = data;
+    image_handler_t *p_image = image_HandlerCreate( writer->p_parent );
+
+    vlc_mutex_lock( &writer->lock );
+    for( ;; )
+    {
+        struct image_writer_request *req = writer->first;
+        if( req == NULL )
+        {
+            if( writer->closing )
+                break;
+            vlc_cond_wait( &writer->wait, &writer->lock );
+            continue;
+        }
+
+        writer->first = req->next;
+        if( req->next == NULL )
+            writer->last = &writer->first;
+        writer->count--;
+        vlc_mutex_unlock( &writer->lock );
+
+        int i_ret = VLC_ENOMEM;
+        if( likely(p_image != NULL) )
+            i_ret = image_WriteUrl( p_image, req->pic, &req->fmt_in,
+                                    &req->fmt_out, req->url );
+        if( req->pf_done != NULL )
+            req->pf_done( req->opaque, i_ret );
+
+        picture_Release( req->pic );
+        video_format_Clean( &req->fmt_in );
+        video_format_Clean( &req->fmt_out );
+        free( req->url );
+        free( req );
+
+        vlc_mutex_lock( &writer->lock );
+    }
+    vlc_mutex_unlock( &writer->lock );
+
+    image_HandlerDelete( p_image );
+    return NULL;
+}
+
+#undef image_WriterCreate
+image_writer_t *image_WriterCreate( vlc_object_t *p_this, unsigned threads,
+                                    unsigned queue_size )
+{
+    if( threads == 0 )
+        threads = vlc_GetCPUCount();
+
+    image_writer_t *writer = malloc( sizeof(*writer)
+                                     + threads * sizeof(writer->threads[0]) );
+    if( unlikely(writer == NULL) )
+        return NULL;
+
+    writer->p_parent = p_this;
+    vlc_mutex_init( &writer->lock );
+    vlc_cond_init( &writer->wait );
+    writer->closing = false;
+    writer->count = 0;
+    writer->queue_size = queue_size;
+    writer->first = NULL;
+    writer->last = &writer->first;
+
+    for( writer->thread_count = 0; writer->thread_count < threads;
+         writer->thread_count++ )
+        if( vlc_clone( &writer->threads[writer->thread_count],
+                       ImageWriterThread, writer, VLC_THREAD_PRIORITY_LOW ) )
+            break;
+
+    if( writer->thread_count == 0 )
+    {
+        vlc_cond_destroy( &writer->wait );
+        vlc_mutex_destroy( &writer->lock );
+        free( writer );
+        return NULL;
+    }
+    return writer;
+}
+
+void image_WriterDelete( image_writer_t *writer )
+{
+    vlc_mutex_lock( &writer->lock );
+    writer->closing = true;
+    vlc_cond_broadcast( &writer->wait );
+    vlc_mutex_unlock( &writer->lock );
+
+    for( unsigned i = 0; i < writer->thread_count; i++ )
+        vlc_join( writer->threads[i], NULL );
+
+    assert( writer->first == NULL );
+    vlc_cond_destroy( &writer->wait );
+    vlc_mutex_destroy( &writer->lock );
+    free( writer );
+}
+
+int image_WriterQueue( image_writer_t *writer, picture_t *p_pic,
+                       const video_format_t *p_fmt_in,
+                       const video_format_t *p_fmt_out, const char *psz_url,
+                       void (*pf_done)( void *, int ), void *opaque )
+{
+    struct image_writer_request *req = malloc( sizeof(*req) );
+    if( unlikely(req == NULL) )
+        return VLC_ENOMEM;
+
+    req->url = strdup( psz_url );
+    if( unlikely(req->url == NULL) )
+    {
+        free( req );
+        return VLC_ENOMEM;
+    }
+    if( video_format_Copy( &req->fmt_in, p_fmt_in ) != VLC_SUCCESS )
+        goto error;
+    if( video_format_Copy( &req->fmt_out, p_fmt_out ) != VLC_SUCCESS )
+    {
+        video_format_Clean( &req->fmt_in );
+        goto error;
+    }
+    req->next = NULL;
+    req->pf_done = pf_done;
+    req->opaque = opaque;
+
+    vlc_mutex_lock( &writer->lock );
+    if( writer->count >= writer->queue_size )
+    {
+        vlc_mutex_unlock( &writer->lock );
+        video_format_Clean( &req->fmt_out );
+        video_format_Clean( &req->fmt_in );
+        goto error;
+    }
+    req->pic = picture_Hold( p_pic );
+    *writer->last = req;
+    writer->last = &req->next;
+    writer->count++;
+    vlc_cond_signal( &writer->wait );
+    vlc_mutex_unlock( &writer->lock );
+    return VLC_SUCCESS;
+
+error:
+    free( req->url );
+    free( req );
+    return VLC_EGENERIC;
+}
+
 /**
  * Misc functions
  *
@@ -272,7 +272,11 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
     if (unlikely(pic_size >= PICTURE_SW_SIZE_MAX))
         goto error;
 
-    uint8_t *buf = aligned_alloc(16, pic_size);
+    /* Planes with a pitch multiple of 64 end up 64 bytes aligned, as needed
+     * by SIMD decoders rendering directly into the picture */
+    pic_size = (pic_size + 63) & ~(size_t)63;
+
+    uint8_t *buf = aligned_alloc(64, pic_size);
     if (unlikely(buf == NULL))
         goto error;
 
@@ -343,7 +347,7 @@ void plane_CopyPixels( plane_t *p_dst, const plane_t *p_src )
        1) Makes field plane_t's work correctly (see the deinterlacer module)
        2) Moves less data if the pitch and visible pitch differ much.
     */
-    if( p_src->i_pitch == p_dst->i_pitch  &&
+    if( p_src->i_pitch == p_dst->i_pitch  && p_src->i_pitch > 0 &&
         p_src->i_pitch < 2*p_src->i_visible_pitch )
     {
         /* There are margins, but with the same width : perfect ! */
@@ -428,6 +432,87 @@ picture_t *picture_Clone(picture_t *picture)
     return clone;
 }
 
+static void picture_DestroyView(picture_t *view)
+{
+    picture_DestroyClone(view);
+}
+
+bool picture_IsView(const picture_t *picture)
+{
+    return ((const picture_priv_t *)picture)->gc.destroy == picture_DestroyView;
+}
+
+picture_t *picture_NewView(picture_t *picture, unsigned x, unsigned y,
+                           unsigned width, unsigned height, bool vflip)
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(picture->format.i_chroma);
+
+    /* Opaque pictures have no planes to point into */
+    if (dsc == NULL || dsc->plane_count == 0
+     || (unsigned)picture->i_planes != dsc->plane_count
+     || width == 0 || height == 0)
+        return NULL;
+
+    /* Packed 4:2:2 macropixels cannot be split */
+    if (dsc->plane_count == 1 && dsc->pixel_size == 2
+     && vlc_fourcc_IsYUV(picture->format.i_chroma) && (x % 2) != 0)
+        return NULL;
+
+    video_format_t fmt = picture->format;
+    fmt.i_width = fmt.i_visible_width = width;
+    fmt.i_height = fmt.i_visible_height = height;
+    fmt.i_x_offset = fmt.i_y_offset = 0;
+
+    picture_resource_t res = {
+        .p_sys = NULL,
+        .pf_destroy = picture_DestroyView,
+    };
+
+    for (unsigned i = 0; i < dsc->plane_count; i++) {
+        const plane_t *p = &picture->p[i];
+        const vlc_rational_t *w = &dsc->p[i].w;
+        const vlc_rational_t *h = &dsc->p[i].h;
+
+        /* The rectangle must start on a sample of every plane */
+        if ((x * w->num) % w->den != 0 || (y * h->num) % h->den != 0)
+            return NULL;
+
+        const unsigned offset = x * w->num / w->den * dsc->pixel_size;
+        const unsigned line = y * h->num / h->den;
+        const unsigned bytes = (width + (w->den - 1)) / w->den * w->num
+                             * dsc->pixel_size;
+        const unsigned lines = (height + (h->den - 1)) / h->den * h->num;
+
+        if (p->p_pixels == NULL
+         || offset + bytes > (unsigned)abs(p->i_pitch)
+         || line + lines > (unsigned)p->i_lines)
+            return NULL;
+
+        uint8_t *pixels = p->p_pixels + (ptrdiff_t)line * p->i_pitch + offset;
+        if (vflip) {
+            res.p[i].p_pixels = pixels + (ptrdiff_t)(lines - 1) * p->i_pitch;
+            res.p[i].i_pitch = -p->i_pitch;
+            res.p[i].i_lines = lines;
+        } else {
+            res.p[i].p_pixels = pixels;
+            res.p[i].i_pitch = p->i_pitch;
+            res.p[i].i_lines = p->i_lines - line;
+        }
+    }
+
+    picture_t *view = picture_NewFromResource(&fmt, &res);
+    if (unlikely(view == NULL))
+        return NULL;
+
+    ((picture_priv_t *)view)->gc.opaque = picture;
+    picture_Hold(picture);
+
+    if (picture->context != NULL)
+        view->context = picture->context->copy(picture->context);
+    return view;
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -32,3 +32,8 @@ typedef struct
         void *opaque;
     } gc;
 } picture_priv_t;
+
+/**
+ * Tells whether a picture is a view created by picture_NewView().
+ */
+bool picture_IsView(const picture_t *);
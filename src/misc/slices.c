@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * slices.c: slice-parallel jobs
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_slices.h>
+
+#include "libvlc.h"
+
+/* More threads than that would mostly fight for the memory bandwidth */
+#define SLICES_MAX_THREADS 15
+
+struct vlc_slice_job
+{
+    struct vlc_slice_job *next;
+    vlc_slice_cb func;
+    void *opaque;
+    unsigned count; /**< total number of slices */
+    unsigned taken; /**< number of slices assigned to a thread */
+    unsigned pending; /**< number of slices not completed yet */
+};
+
+struct vlc_slices
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< wait for jobs (worker threads) */
+    vlc_cond_t done; /**< wait for the slices to complete (callers) */
+    struct vlc_slice_job *jobs; /**< jobs with slices left to assign */
+    bool closing;
+    unsigned count;
+    vlc_thread_t threads[];
+};
+
+/* Takes the next slice of a job, and dequeues the job once it has none left.
+ * The lock must be held. */
+static unsigned TakeSlice(struct vlc_slices *pool, struct vlc_slice_job *job)
+{
+    unsigned index = job->taken++;
+
+    if (job->taken == job->count)
+    {
+        struct vlc_slice_job **pp = &pool->jobs;
+
+        while (*pp != job)
+            pp = &(*pp)->next;
+        *pp = job->next;
+    }
+    return index;
+}
+
+static void *Thread(void *data)
+{
+    struct vlc_slices *pool = data;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (pool->jobs == NULL && !pool->closing)
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        if (pool->closing)
+            break;
+
+        struct vlc_slice_job *job = pool->jobs;
+        unsigned index = TakeSlice(pool, job);
+
+        vlc_mutex_unlock(&pool->lock);
+        job->func(job->opaque, index, job->count);
+        vlc_mutex_lock(&pool->lock);
+
+        /* The job belongs to the caller stack: do not touch it after this */
+        if (--job->pending == 0)
+            vlc_cond_broadcast(&pool->done);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static struct vlc_slices *Create(vlc_object_t *obj)
+{
+    unsigned count = vlc_GetCPUCount();
+
+    count = (count > 1) ? count - 1 : 0;
+    if (count > SLICES_MAX_THREADS)
+        count = SLICES_MAX_THREADS;
+
+    struct vlc_slices *pool = malloc(sizeof (*pool)
+                                     + count * sizeof (pool->threads[0]));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
+    vlc_cond_init(&pool->done);
+    pool->jobs = NULL;
+    pool->closing = false;
+
+    for (pool->count = 0; pool->count < count; pool->count++)
+        if (vlc_clone(&pool->threads[pool->count], Thread, pool,
+                      VLC_THREAD_PRIORITY_VIDEO))
+            break;
+
+    msg_Dbg(obj, "%u slice worker threads", pool->count);
+    return pool;
+}
+
+static struct vlc_slices *GetPool(vlc_object_t *obj)
+{
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+    libvlc_priv_t *priv = libvlc_priv(obj->obj.libvlc);
+    struct vlc_slices *pool;
+
+    vlc_mutex_lock(&lock);
+    pool = priv->slices;
+    if (pool == NULL)
+        pool = priv->slices = Create(VLC_OBJECT(obj->obj.libvlc));
+    vlc_mutex_unlock(&lock);
+    return pool;
+}
+
+#undef vlc_slices_Count
+unsigned vlc_slices_Count(vlc_object_t *obj, unsigned rows)
+{
+    struct vlc_slices *pool = GetPool(obj);
+    unsigned count = (pool != NULL) ? pool->count + 1 : 1;
+
+    if (count > rows / VLC_SLICE_MIN_ROWS)
+        count = rows / VLC_SLICE_MIN_ROWS;
+    return (count > 0) ? count : 1;
+}
+
+#undef vlc_slices_Run
+void vlc_slices_Run(vlc_object_t *obj, unsigned count,
+                    vlc_slice_cb func, void *opaque)
+{
+    struct vlc_slices *pool = (count > 1) ? GetPool(obj) : NULL;
+
+    if (pool == NULL || pool->count == 0)
+    {
+        for (unsigned i = 0; i < count; i++)
+            func(opaque, i, count);
+        return;
+    }
+
+    struct vlc_slice_job job = {
+        .func = func,
+        .opaque = opaque,
+        .count = count,
+        .taken = 0,
+        .pending = count,
+    };
+
+    vlc_mutex_lock(&pool->lock);
+    job.next = pool->jobs;
+    pool->jobs = &job;
+    vlc_cond_broadcast(&pool->wait);
+
+    /* The caller processes slices of its own job, so that it makes progress
+     * even if all the worker threads are busy. */
+    while (job.taken < job.count)
+    {
+        unsigned index = TakeSlice(pool, &job);
+
+        vlc_mutex_unlock(&pool->lock);
+        func(opaque, index, count);
+        vlc_mutex_lock(&pool->lock);
+        job.pending--;
+    }
+
+    while (job.pending > 0)
+        vlc_cond_wait(&pool->done, &pool->lock);
+    vlc_mutex_unlock(&pool->lock);
+}
+
+void vlc_slices_Destroy(libvlc_int_t *libvlc)
+{
+    libvlc_priv_t *priv = libvlc_priv(libvlc);
+    struct vlc_slices *pool = priv->slices;
+
+    if (pool == NULL)
+        return;
+
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->jobs == NULL);
+    pool->closing = true;
+    vlc_cond_broadcast(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->count; i++)
+        vlc_join(pool->threads[i], NULL);
+
+    vlc_cond_destroy(&pool->done);
+    vlc_cond_destroy(&pool->wait);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+    priv->slices = NULL;
+}
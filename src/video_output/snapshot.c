@@ -79,10 +79,20 @@ picture_t *vout_snapshot_Get(vout_snapshot_t *snap, mtime_t timeout)
 {
     const mtime_t deadline = mdate() + timeout;
 
-    vlc_mutex_lock(&snap->lock);
+    vout_snapshot_Request(snap);
+    return vout_snapshot_Wait(snap, deadline);
+}
 
-    /* */
+void vout_snapshot_Request(vout_snapshot_t *snap)
+{
+    vlc_mutex_lock(&snap->lock);
     snap->request_count++;
+    vlc_mutex_unlock(&snap->lock);
+}
+
+picture_t *vout_snapshot_Wait(vout_snapshot_t *snap, mtime_t deadline)
+{
+    vlc_mutex_lock(&snap->lock);
 
     /* */
     while (snap->is_available && !snap->picture &&
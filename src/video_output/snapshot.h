@@ -45,6 +45,13 @@ void vout_snapshot_End(vout_snapshot_t *);
 /* */
 picture_t *vout_snapshot_Get(vout_snapshot_t *, mtime_t timeout);
 
+/**
+ * It registers a snapshot request, to be collected later with
+ * vout_snapshot_Wait(). The next displayed picture is kept for it.
+ */
+void vout_snapshot_Request(vout_snapshot_t *);
+picture_t *vout_snapshot_Wait(vout_snapshot_t *, mtime_t deadline);
+
 /**
  * It tells if they are pending snapshot request
  */
@@ -25,18 +25,20 @@
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
 
-/* NOTE: Both statistics are atomic on their own, so one might be older than
- * the other one. Currently, only one of them is updated at a time, so this
+/* NOTE: All statistics are atomic on their own, so one might be older than
+ * the other ones. Currently, only one of them is updated at a time, so this
  * is a non-issue. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint late; /* displayed, but after their date */
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->late, 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -46,10 +48,12 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
 
 static inline void vout_statistic_GetReset(vout_statistic_t *stat,
                                            unsigned *restrict displayed,
-                                           unsigned *restrict lost)
+                                           unsigned *restrict lost,
+                                           unsigned *restrict late)
 {
     *displayed = atomic_exchange(&stat->displayed, 0);
     *lost      = atomic_exchange(&stat->lost, 0);
+    *late      = atomic_exchange(&stat->late, 0);
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -63,4 +67,9 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add(&stat->lost, lost);
 }
 
+static inline void vout_statistic_AddLate(vout_statistic_t *stat, int late)
+{
+    atomic_fetch_add(&stat->late, late);
+}
+
 #endif
@@ -178,6 +178,7 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
         vout_window_t *window = vout_display_window_New(vout, &wcfg);
         if (unlikely(window == NULL)) {
+            vout_IntfDeinit(vout);
             spu_Destroy(vout->p->spu);
             vlc_object_release(vout);
             return NULL;
@@ -198,6 +199,7 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
     /* */
     if (vlc_clone(&vout->p->thread, Thread, vout,
                   VLC_THREAD_PRIORITY_OUTPUT)) {
+        vout_IntfDeinit(vout);
         if (vout->p->window != NULL)
             vout_display_window_Delete(vout->p->window);
         spu_Destroy(vout->p->spu);
@@ -270,6 +272,7 @@ void vout_Close(vout_thread_t *vout)
         spu_Attach(vout->p->spu, vout->p->input, false);
 
     vout_snapshot_End(&vout->p->snapshot);
+    vout_IntfDeinit(vout);
 
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_CLEAN);
     vlc_join(vout->p->thread, NULL);
@@ -326,9 +329,9 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
 }
 
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost)
+                            unsigned *restrict lost, unsigned *restrict late)
 {
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, late );
 }
 
 void vout_Flush(vout_thread_t *vout, mtime_t date)
@@ -858,8 +861,11 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
                         picture_Release(decoded);
                         vout_statistic_AddLost(&vout->p->statistic, 1);
                         continue;
-                    } else if (late > 0) {
+                    } else if (late > late_threshold / 2) {
+                        /* Below a quarter of a frame, the jitter of the
+                         * display loop alone would feed the decoder hurry */
                         msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", late/1000);
+                        vout_statistic_AddLate(&vout->p->statistic, 1);
                     }
                 }
                 if (!VideoFormatIsCropArEqual(&decoded->format, &vout->p->filter.format))
@@ -69,6 +69,18 @@ struct vout_thread_sys_t
     /* Snapshot interface */
     vout_snapshot_t snapshot;
 
+    /* Snapshots being encoded and saved, off the requesting thread */
+    struct {
+        vlc_mutex_t lock;
+        vlc_cond_t  wait;
+        vlc_thread_t thread;
+        bool        started;
+        bool        closing;
+        unsigned    count;
+        struct vout_snapshot_request *first;
+        struct vout_snapshot_request **last;
+    } snapshot_saver;
+
     /* Statistics */
     vout_statistic_t statistic;
 
@@ -207,6 +219,7 @@ void vout_ControlChangeViewpoint( vout_thread_t *, const vlc_viewpoint_t *);
 /* */
 void vout_IntfInit( vout_thread_t * );
 void vout_IntfReinit( vout_thread_t * );
+void vout_IntfDeinit( vout_thread_t * );
 
 /* */
 int  vout_OpenWrapper (vout_thread_t *, const char *, const vout_display_state_t *);
@@ -240,7 +253,7 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, mtime_t i_duration );
  * This function will return and reset internal statistics.
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost );
+                             unsigned *pi_lost, unsigned *pi_late );
 
 /**
  * This function will ensure that all ready/displayed pictures have at most
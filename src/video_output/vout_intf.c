@@ -39,6 +39,7 @@
 
 #include <vlc_vout.h>
 #include <vlc_vout_osd.h>
+#include <vlc_image.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
 #include "vout_internal.h"
@@ -155,6 +156,8 @@ void vout_IntfInit( vout_thread_t *p_vout )
     /* Create a few object variables we'll need later on */
     var_Create( p_vout, "snapshot-num", VLC_VAR_INTEGER );
     var_SetInteger( p_vout, "snapshot-num", 1 );
+    /* Not an option: only set by callers waiting for the file */
+    var_Create( p_vout, "snapshot-wait", VLC_VAR_BOOL );
 
     var_Create( p_vout, "width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
     var_Create( p_vout, "height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
@@ -270,6 +273,14 @@ void vout_IntfInit( vout_thread_t *p_vout )
     var_AddCallback( p_vout, "fullscreen", FullscreenCallback, NULL );
 
     /* Add a snapshot variable */
+    vlc_mutex_init( &p_vout->p->snapshot_saver.lock );
+    vlc_cond_init( &p_vout->p->snapshot_saver.wait );
+    p_vout->p->snapshot_saver.started = false;
+    p_vout->p->snapshot_saver.closing = false;
+    p_vout->p->snapshot_saver.count = 0;
+    p_vout->p->snapshot_saver.first = NULL;
+    p_vout->p->snapshot_saver.last = &p_vout->p->snapshot_saver.first;
+
     var_Create( p_vout, "video-snapshot", VLC_VAR_VOID | VLC_VAR_ISCOMMAND );
     text.psz_string = _("Snapshot");
     var_Change( p_vout, "video-snapshot", VLC_VAR_SETTEXT, &text, NULL );
@@ -371,24 +382,57 @@ static void VoutOsdSnapshot( vout_thread_t *p_vout, picture_t *p_pic, const char
     }
 }
 
+/* Maximum number of snapshots waiting to be encoded and saved */
+#define SNAPSHOT_QUEUE_MAX 8
+
+/* The settings are captured when the snapshot is requested, as they may be
+ * changed for the next one before this one is saved */
+struct vout_snapshot_request
+{
+    struct vout_snapshot_request *next;
+    vlc_sem_t *done; /* posted once saved, for synchronous requests */
+    mtime_t deadline;
+    char *path;
+    char *format;
+    char *prefix;
+    int width;
+    int height;
+    bool is_sequential;
+};
+
+static void VoutSnapshotRequestDelete( struct vout_snapshot_request *req )
+{
+    free( req->prefix );
+    free( req->format );
+    free( req->path );
+    free( req );
+}
+
 /**
  * This function will handle a snapshot request
  */
-static void VoutSaveSnapshot( vout_thread_t *p_vout )
+static void VoutSaveSnapshot( vout_thread_t *p_vout,
+                              const struct vout_snapshot_request *req )
 {
-    char *psz_path = var_InheritString( p_vout, "snapshot-path" );
-    char *psz_format = var_InheritString( p_vout, "snapshot-format" );
-    char *psz_prefix = var_InheritString( p_vout, "snapshot-prefix" );
+    char *psz_path = req->path;
+    block_t *p_image = NULL;
+
+    picture_t *p_picture = vout_snapshot_Wait( &p_vout->p->snapshot,
+                                               req->deadline );
+    if( !p_picture )
+    {
+        msg_Err( p_vout, "Failed to grab a snapshot" );
+        return;
+    }
 
-    /* */
-    picture_t *p_picture;
-    block_t *p_image;
+    vlc_fourcc_t codec = VLC_CODEC_PNG;
+    if( req->format && image_Type2Fourcc( req->format ) )
+        codec = image_Type2Fourcc( req->format );
 
-    /* 500ms timeout
-     * XXX it will cause trouble with low fps video (< 2fps) */
-    if( vout_GetSnapshot( p_vout, &p_image, &p_picture, NULL, psz_format, CLOCK_FREQ/2 ) )
+    if( picture_Export( VLC_OBJECT(p_vout), &p_image, NULL, p_picture,
+                        codec, req->width, req->height ) )
     {
-        p_picture = NULL;
+        msg_Err( p_vout, "Failed to convert image for snapshot" );
         p_image = NULL;
         goto exit;
     }
@@ -405,11 +449,11 @@ static void VoutSaveSnapshot( vout_thread_t *p_vout )
 
     vout_snapshot_save_cfg_t cfg;
     memset( &cfg, 0, sizeof(cfg) );
-    cfg.is_sequential = var_InheritBool( p_vout, "snapshot-sequential" );
+    cfg.is_sequential = req->is_sequential;
     cfg.sequence = var_GetInteger( p_vout, "snapshot-num" );
     cfg.path = psz_path;
-    cfg.format = psz_format;
-    cfg.prefix_fmt = psz_prefix;
+    cfg.format = req->format;
+    cfg.prefix_fmt = req->prefix;
 
     char *psz_filename;
     int  i_sequence;
@@ -429,11 +473,119 @@ static void VoutSaveSnapshot( vout_thread_t *p_vout )
 exit:
     if( p_image )
         block_Release( p_image );
-    if( p_picture )
-        picture_Release( p_picture );
-    free( psz_prefix );
-    free( psz_format );
-    free( psz_path );
+    picture_Release( p_picture );
+    if( psz_path != req->path )
+        free( psz_path );
+}
+
+static void *VoutSnapshotThread( void *data )
+{
+    vout_thread_t *p_vout = data;
+    vlc_mutex_t *lock = &p_vout->p->snapshot_saver.lock;
+
+    vlc_mutex_lock( lock );
+    for( ;; )
+    {
+        struct vout_snapshot_request *req = p_vout->p->snapshot_saver.first;
+        if( req == NULL )
+        {
+            if( p_vout->p->snapshot_saver.closing )
+                break;
+            vlc_cond_wait( &p_vout->p->snapshot_saver.wait, lock );
+            continue;
+        }
+
+        p_vout->p->snapshot_saver.first = req->next;
+        if( req->next == NULL )
+            p_vout->p->snapshot_saver.last = &p_vout->p->snapshot_saver.first;
+        p_vout->p->snapshot_saver.count--;
+        vlc_mutex_unlock( lock );
+
+        VoutSaveSnapshot( p_vout, req );
+        if( req->done != NULL )
+            vlc_sem_post( req->done );
+        VoutSnapshotRequestDelete( req );
+
+        vlc_mutex_lock( lock );
+    }
+    vlc_mutex_unlock( lock );
+    return NULL;
+}
+
+/**
+ * This function queues a snapshot request, so that the caller never waits for
+ * the next picture nor for the image compression, unless it asks to: then
+ * done is posted once the snapshot is saved, if this returns true.
+ */
+static bool VoutRequestSnapshot( vout_thread_t *p_vout, vlc_sem_t *done )
+{
+    struct vout_snapshot_request *req = malloc( sizeof(*req) );
+    if( unlikely(req == NULL) )
+        return false;
+
+    /* 500ms timeout
+     * XXX it will cause trouble with low fps video (< 2fps) */
+    req->next = NULL;
+    req->done = done;
+    req->deadline = mdate() + CLOCK_FREQ/2;
+    req->path = var_InheritString( p_vout, "snapshot-path" );
+    req->format = var_InheritString( p_vout, "snapshot-format" );
+    req->prefix = var_InheritString( p_vout, "snapshot-prefix" );
+    req->width = var_InheritInteger( p_vout, "snapshot-width" );
+    req->height = var_InheritInteger( p_vout, "snapshot-height" );
+    req->is_sequential = var_InheritBool( p_vout, "snapshot-sequential" );
+
+    /* A caller waiting for its snapshot bounds its own requests */
+    vlc_mutex_lock( &p_vout->p->snapshot_saver.lock );
+    if( done == NULL
+     && p_vout->p->snapshot_saver.count >= SNAPSHOT_QUEUE_MAX )
+    {
+        msg_Warn( p_vout, "too many pending snapshots, dropping request" );
+        goto error;
+    }
+
+    if( !p_vout->p->snapshot_saver.started )
+    {
+        if( vlc_clone( &p_vout->p->snapshot_saver.thread, VoutSnapshotThread,
+                       p_vout, VLC_THREAD_PRIORITY_LOW ) )
+        {
+            msg_Err( p_vout, "cannot spawn snapshot thread" );
+            goto error;
+        }
+        p_vout->p->snapshot_saver.started = true;
+    }
+
+    /* Keep the next picture for this request right now */
+    vout_snapshot_Request( &p_vout->p->snapshot );
+
+    *p_vout->p->snapshot_saver.last = req;
+    p_vout->p->snapshot_saver.last = &req->next;
+    p_vout->p->snapshot_saver.count++;
+    vlc_cond_signal( &p_vout->p->snapshot_saver.wait );
+    vlc_mutex_unlock( &p_vout->p->snapshot_saver.lock );
+    return true;
+
+error:
+    vlc_mutex_unlock( &p_vout->p->snapshot_saver.lock );
+    VoutSnapshotRequestDelete( req );
+    return false;
+}
+
+void vout_IntfDeinit( vout_thread_t *p_vout )
+{
+    var_DelCallback( p_vout, "video-snapshot", SnapshotCallback, NULL );
+
+    /* Pending requests are still saved, if their picture was grabbed */
+    vlc_mutex_lock( &p_vout->p->snapshot_saver.lock );
+    p_vout->p->snapshot_saver.closing = true;
+    vlc_cond_signal( &p_vout->p->snapshot_saver.wait );
+    vlc_mutex_unlock( &p_vout->p->snapshot_saver.lock );
+
+    if( p_vout->p->snapshot_saver.started )
+        vlc_join( p_vout->p->snapshot_saver.thread, NULL );
+
+    vlc_cond_destroy( &p_vout->p->snapshot_saver.wait );
+    vlc_mutex_destroy( &p_vout->p->snapshot_saver.lock );
 }
 
 /*****************************************************************************
@@ -564,7 +716,19 @@ static int SnapshotCallback( vlc_object_t *p_this, char const *psz_cmd,
     VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
     VLC_UNUSED(newval); VLC_UNUSED(p_data);
 
-    VoutSaveSnapshot( p_vout );
+    /* "snapshot-wait" is set by callers that expect the file to be written
+     * when the trigger returns */
+    if( var_GetBool( p_vout, "snapshot-wait" ) )
+    {
+        vlc_sem_t done;
+
+        vlc_sem_init( &done, 0 );
+        if( VoutRequestSnapshot( p_vout, &done ) )
+            vlc_sem_wait( &done );
+        vlc_sem_destroy( &done );
+    }
+    else
+        VoutRequestSnapshot( p_vout, NULL );
     return VLC_SUCCESS;
 }
 
@@ -175,6 +175,58 @@ static void test_input_metadata_timeout(libvlc_instance_t *vlc, int timeout,
     vlc_close(p_pipe[1]);
 }
 
+static void test_media_thumbnail(libvlc_instance_t *vlc)
+{
+    log ("test_media_thumbnail\n");
+
+    libvlc_media_t *media = libvlc_media_new_path(vlc, test_default_video);
+    assert(media != NULL);
+
+    unsigned char *p_data;
+    size_t i_size;
+    int i_ret;
+
+    /* Unknown image format */
+    i_ret = libvlc_media_thumbnail(media, -1, 0.f, 0, 0, "nonexistent",
+                                   5000, &p_data, &i_size);
+    assert(i_ret == -1);
+
+#ifdef ENABLE_SOUT
+    /* PNG by default */
+    i_ret = libvlc_media_thumbnail(media, -1, 0.f, 0, 0, NULL, 5000,
+                                   &p_data, &i_size);
+    assert(i_ret == 0);
+    assert(i_size > 8 && !memcmp(p_data, "\x89PNG\r\n\x1a\n", 8));
+    libvlc_free(p_data);
+
+    /* Scaled, by time */
+    i_ret = libvlc_media_thumbnail(media, 0, 0.f, 16, 0, "png", 5000,
+                                   &p_data, &i_size);
+    assert(i_ret == 0);
+    assert(i_size > 8 && !memcmp(p_data, "\x89PNG\r\n\x1a\n", 8));
+    libvlc_free(p_data);
+
+    i_ret = libvlc_media_thumbnail(media, -1, 0.f, 0, 0, "jpg", 5000,
+                                   &p_data, &i_size);
+    assert(i_ret == 0);
+    assert(i_size > 2 && p_data[0] == 0xff && p_data[1] == 0xd8);
+    libvlc_free(p_data);
+#else
+    /* The picture is extracted, but cannot be encoded */
+    i_ret = libvlc_media_thumbnail(media, -1, 0.f, 0, 0, NULL, 5000,
+                                   &p_data, &i_size);
+    assert(i_ret == -1);
+#endif
+    libvlc_media_release(media);
+
+    media = libvlc_media_new_path(vlc, "/nonexistent/thumbnail.jpg");
+    assert(media != NULL);
+    i_ret = libvlc_media_thumbnail(media, -1, 0.f, 0, 0, NULL, 5000,
+                                   &p_data, &i_size);
+    assert(i_ret == -1);
+    libvlc_media_release(media);
+}
+
 #define TEST_SUBITEMS_COUNT 6
 static struct
 {
@@ -375,6 +427,8 @@ int main(int i_argc, char *ppsz_argv[])
     test_input_metadata_timeout (vlc, 100, 0);
     test_input_metadata_timeout (vlc, 0, 100);
 
+    test_media_thumbnail (vlc);
+
     libvlc_release (vlc);
 
     return 0;
@@ -0,0 +1,412 @@
+/*****************************************************************************
+ * avcodec.c: avcodec video decoder direct rendering test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Encodes a short MPEG-2 stream with B-frames with libavcodec, decodes it
+ * with the avcodec module into pictures from a pool, like the video output
+ * one, and checks which frames were rendered directly into the pool
+ * pictures, and which were copied:
+ *  - with a pool sized like the core does, all frames are rendered directly;
+ *  - with a pool too small, the decoder falls back to libavcodec buffers
+ *    instead of failing the frames;
+ *  - with pictures libavcodec can not use, all frames are copied, and the
+ *    pool is not asked for a picture per frame only to release it.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavcodec/avcodec.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define WIDTH    352
+#define HEIGHT   288
+#define FRAMES   48
+#define DURATION 40000 /* 25 fps */
+#define DTS_BASE (VLC_TS_0 + 10 * DURATION) /* B-frames start with DTS < 0 */
+#define DPB_SIZE 2 /* as the core for MPEG-2 */
+
+/* Quantization errors only, at the highest quality */
+#define MAX_MEAN_DIFF 3.
+
+struct test_decoder
+{
+    decoder_t dec;
+
+    unsigned pool_size; /* 0 to size it like the core */
+    bool misaligned;    /* pitches libavcodec can not use */
+    picture_pool_t *pool;
+    video_format_t fmt;
+
+    picture_t *last;    /* last picture handed out */
+    unsigned requested, refused;
+    unsigned queued, copied;
+    bool mismatch;
+};
+
+static struct test_decoder *test_decoder(decoder_t *dec)
+{
+    return container_of(dec, struct test_decoder, dec);
+}
+
+static uint8_t Sample(unsigned frame, unsigned plane, int x, int y)
+{
+    if (plane > 0)
+        return 128 + lround(20. * sin((x + frame) * .1 + plane));
+    return 128 + lround(60. * sin((x + 2. * frame) * .06)
+                        + 40. * cos((y - frame) * .09));
+}
+
+/*****************************************************************************
+ * Stream
+ *****************************************************************************/
+static block_t *Encode(void)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG2VIDEO);
+    if (codec == NULL)
+        return NULL;
+
+    AVCodecContext *ctx = avcodec_alloc_context3(codec);
+    assert(ctx != NULL);
+    ctx->width = WIDTH;
+    ctx->height = HEIGHT;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->time_base = (AVRational) { 1, 25 };
+    ctx->framerate = (AVRational) { 25, 1 };
+    ctx->gop_size = 12;
+    ctx->max_b_frames = 2;
+    ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    ctx->global_quality = FF_QP2LAMBDA * 2;
+    if (avcodec_open2(ctx, codec, NULL) < 0)
+    {
+        avcodec_free_context(&ctx);
+        return NULL;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *pkt = av_packet_alloc();
+    assert(frame != NULL && pkt != NULL);
+    frame->format = ctx->pix_fmt;
+    frame->width = WIDTH;
+    frame->height = HEIGHT;
+    int ret = av_frame_get_buffer(frame, 0);
+    assert(ret == 0);
+
+    block_t *stream = NULL, **last = &stream;
+    for (unsigned i = 0; i <= FRAMES; i++)
+    {
+        if (i < FRAMES)
+        {
+            ret = av_frame_make_writable(frame);
+            assert(ret == 0);
+            for (unsigned p = 0; p < 3; p++)
+            {
+                const int shift = p > 0;
+                for (int y = 0; y < HEIGHT >> shift; y++)
+                    for (int x = 0; x < WIDTH >> shift; x++)
+                        frame->data[p][y * frame->linesize[p] + x] =
+                            Sample(i, p, x, y);
+            }
+            frame->pts = i;
+            ret = avcodec_send_frame(ctx, frame);
+        }
+        else
+            ret = avcodec_send_frame(ctx, NULL); /* drain */
+        assert(ret == 0);
+
+        while ((ret = avcodec_receive_packet(ctx, pkt)) == 0)
+        {
+            block_t *block = block_Alloc(pkt->size);
+            assert(block != NULL);
+            memcpy(block->p_buffer, pkt->data, pkt->size);
+            block->i_pts = DTS_BASE + pkt->pts * DURATION;
+            block->i_dts = DTS_BASE + pkt->dts * DURATION;
+            block->i_length = DURATION;
+            block_ChainLastAppend(&last, block);
+            av_packet_unref(pkt);
+        }
+        assert(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
+    }
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    return stream;
+}
+
+/*****************************************************************************
+ * Decoder owner
+ *****************************************************************************/
+static picture_t *NewMisalignedPicture(const video_format_t *fmt)
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(fmt->i_chroma);
+    assert(dsc != NULL);
+
+    picture_resource_t res = { .p_sys = NULL };
+    size_t offsets[PICTURE_PLANE_MAX], size = 0;
+    for (unsigned i = 0; i < dsc->plane_count; i++)
+    {
+        res.p[i].i_lines = fmt->i_height * dsc->p[i].h.num / dsc->p[i].h.den;
+        /* 8 modulo 16 */
+        res.p[i].i_pitch = (fmt->i_width * dsc->p[i].w.num / dsc->p[i].w.den
+                            * dsc->pixel_size + 15) / 16 * 16 + 8;
+        offsets[i] = size;
+        size += res.p[i].i_pitch * res.p[i].i_lines;
+    }
+
+    /* freed with the picture */
+    res.p_sys = malloc(size);
+    assert(res.p_sys != NULL);
+    for (unsigned i = 0; i < dsc->plane_count; i++)
+        res.p[i].p_pixels = (uint8_t *)res.p_sys + offsets[i];
+
+    picture_t *pic = picture_NewFromResource(fmt, &res);
+    assert(pic != NULL);
+    return pic;
+}
+
+static int FormatUpdate(decoder_t *dec)
+{
+    struct test_decoder *td = test_decoder(dec);
+    video_format_t fmt = dec->fmt_out.video;
+
+    fmt.i_chroma = dec->fmt_out.i_codec;
+    assert(fmt.i_chroma == VLC_CODEC_I420);
+
+    /* Like the core, only re-create the pool if the format changes: the
+     * extra pictures must be known by the first update, which libavcodec
+     * triggers once it has parsed the headers */
+    if (td->pool != NULL && video_format_IsSimilar(&fmt, &td->fmt)
+     && fmt.i_width == td->fmt.i_width && fmt.i_height == td->fmt.i_height)
+        return 0;
+
+    const unsigned size = td->pool_size ? td->pool_size
+                        : DPB_SIZE + (unsigned)dec->i_extra_picture_buffers + 1;
+    if (td->pool != NULL)
+        picture_pool_Release(td->pool);
+
+    if (td->misaligned)
+    {
+        picture_t *pics[size];
+        for (unsigned i = 0; i < size; i++)
+            pics[i] = NewMisalignedPicture(&fmt);
+        td->pool = picture_pool_New(size, pics);
+    }
+    else
+        td->pool = picture_pool_NewFromFormat(&fmt, size);
+    assert(td->pool != NULL);
+    td->fmt = fmt;
+    return 0;
+}
+
+static picture_t *BufferNew(decoder_t *dec)
+{
+    struct test_decoder *td = test_decoder(dec);
+
+    assert(td->pool != NULL);
+    picture_t *pic = picture_pool_Get(td->pool);
+    td->requested++;
+    if (pic == NULL)
+        td->refused++;
+    td->last = pic;
+    return pic;
+}
+
+static void Queue(decoder_t *dec, picture_t *pic)
+{
+    struct test_decoder *td = test_decoder(dec);
+
+    /* Direct rendering queues a clone of a picture handed out while
+     * decoding, copies queue the picture handed out last */
+    if (pic == td->last)
+        td->copied++;
+    td->last = NULL;
+    td->queued++;
+
+    const unsigned frame = (pic->date - DTS_BASE) / DURATION;
+    const plane_t *p = &pic->p[Y_PLANE];
+    unsigned long diff = 0;
+
+    assert(frame < FRAMES);
+    assert(pic->format.i_visible_width == WIDTH);
+    assert(pic->format.i_visible_height == HEIGHT);
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < WIDTH; x++)
+            diff += abs(p->p_pixels[y * p->i_pitch + x] - Sample(frame, 0, x, y));
+    if (diff > MAX_MEAN_DIFF * WIDTH * HEIGHT)
+    {
+        fprintf(stderr, "frame %u: mean difference %.2f\n", frame,
+                (double)diff / (WIDTH * HEIGHT));
+        td->mismatch = true;
+    }
+    picture_Release(pic);
+}
+
+static const struct decoder_owner_callbacks callbacks =
+{
+    .video = {
+        .format_update = FormatUpdate,
+        .buffer_new = BufferNew,
+        .queue = Queue,
+    },
+};
+
+static int Decode(vlc_object_t *parent, block_t *stream,
+                  struct test_decoder *result)
+{
+    struct test_decoder *td = vlc_object_create(parent, sizeof(*td));
+    assert(td != NULL);
+    decoder_t *dec = &td->dec;
+
+    td->pool_size = result->pool_size;
+    td->misaligned = result->misaligned;
+    td->pool = NULL;
+    td->last = NULL;
+    td->requested = td->refused = td->queued = td->copied = 0;
+    td->mismatch = false;
+
+    dec->cbs = &callbacks;
+    dec->b_frame_drop_allowed = false;
+    dec->i_extra_picture_buffers = 0;
+    dec->pf_decode = NULL;
+    dec->pf_flush = NULL;
+    es_format_Init(&dec->fmt_in, VIDEO_ES, VLC_CODEC_MPGV);
+    dec->fmt_in.video.i_width = dec->fmt_in.video.i_visible_width = WIDTH;
+    dec->fmt_in.video.i_height = dec->fmt_in.video.i_visible_height = HEIGHT;
+    dec->fmt_in.b_packetized = true;
+    es_format_Init(&dec->fmt_out, VIDEO_ES, 0);
+
+    /* One thread, so that the pictures are handed out and queued in the
+     * decoding order, and no hardware decoding */
+    var_Create(dec, "avcodec-threads", VLC_VAR_INTEGER);
+    var_SetInteger(dec, "avcodec-threads", 1);
+    var_Create(dec, "avcodec-hw", VLC_VAR_STRING);
+    var_SetString(dec, "avcodec-hw", "none");
+
+    dec->p_module = module_need(dec, "video decoder", "avcodec", true);
+    if (dec->p_module == NULL)
+    {
+        es_format_Clean(&dec->fmt_in);
+        vlc_object_release(dec);
+        return VLC_ENOITEM;
+    }
+
+    for (block_t *b = stream; b != NULL; b = b->p_next)
+    {
+        block_t *block = block_Duplicate(b);
+        assert(block != NULL);
+        int ret = dec->pf_decode(dec, block);
+        assert(ret == VLCDEC_SUCCESS);
+    }
+    dec->pf_decode(dec, NULL); /* drain */
+
+    module_unneed(dec, dec->p_module);
+    es_format_Clean(&dec->fmt_in);
+    es_format_Clean(&dec->fmt_out);
+    if (td->pool != NULL)
+        picture_pool_Release(td->pool);
+
+    *result = *td;
+    vlc_object_release(dec);
+    return VLC_SUCCESS;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+
+    block_t *stream = Encode();
+    if (stream == NULL)
+    {
+        printf("no MPEG-2 encoder, skipped\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    /* Pool sized like the core: all frames are rendered directly */
+    struct test_decoder r = { .pool_size = 0 };
+    if (Decode(parent, stream, &r) != VLC_SUCCESS)
+    {
+        printf("no avcodec decoder, skipped\n");
+        block_ChainRelease(stream);
+        libvlc_release(vlc);
+        return 77;
+    }
+    printf("pool: %u frames, %u copied, %u pictures requested\n",
+           r.queued, r.copied, r.requested);
+    assert(!r.mismatch);
+    assert(r.queued == FRAMES);
+    assert(r.copied == 0);
+    assert(r.refused == 0);
+    assert(r.requested == FRAMES);
+
+    /* Exhausted pool: the frames the pool could not take are decoded into
+     * libavcodec buffers, and copied when a picture is available, instead of
+     * being lost with an error */
+    r = (struct test_decoder) { .pool_size = 2 };
+    assert(Decode(parent, stream, &r) == VLC_SUCCESS);
+    printf("exhausted pool: %u frames, %u copied, %u of %u pictures "
+           "refused\n", r.queued, r.copied, r.refused, r.requested);
+    assert(!r.mismatch);
+    assert(r.refused > 0);
+    assert(r.queued > r.copied); /* some rendered directly */
+    assert(r.queued <= FRAMES);
+
+    /* Unusable pictures: one is tried, then all frames are copied */
+    r = (struct test_decoder) { .misaligned = true };
+    assert(Decode(parent, stream, &r) == VLC_SUCCESS);
+    printf("misaligned pool: %u frames, %u copied, %u pictures requested\n",
+           r.queued, r.copied, r.requested);
+    assert(!r.mismatch);
+    assert(r.queued == FRAMES);
+    assert(r.copied == FRAMES);
+    assert(r.requested == FRAMES + 1);
+
+    block_ChainRelease(stream);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * hurry.c: test of the avcodec closed-loop hurry up levels
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+
+#include "../modules/codec/avcodec/hurry.h"
+
+/* Feeds i_blocks decoded blocks at a constant lateness, the way
+ * update_hurry_level() does, and returns the number of level changes */
+static unsigned feed( struct hurry_state *p_hurry, unsigned i_lateness,
+                      unsigned i_blocks )
+{
+    unsigned i_changes = 0;
+    for( unsigned i = 0; i < i_blocks; i++ )
+    {
+        if( hurry_Hold( p_hurry ) )
+            continue;
+        if( hurry_Update( p_hurry, i_lateness ) )
+            i_changes++;
+    }
+    return i_changes;
+}
+
+int main( void )
+{
+    struct hurry_state hurry;
+    hurry_Init( &hurry );
+
+    /* Nothing changes within the hysteresis band, nor at full quality */
+    assert( feed( &hurry, HURRY_LATENESS_HIGH - 1, 1000 ) == 0 );
+    assert( feed( &hurry, 0, 1000 ) == 0 );
+    assert( hurry.level == HURRY_NONE );
+
+    /* Escalation: one level right away, then one per hold */
+    assert( feed( &hurry, 100, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_LOOP_FILTER );
+    assert( feed( &hurry, 100, HURRY_UP_HOLD ) == 0 );
+    assert( hurry.level == HURRY_SKIP_LOOP_FILTER );
+    assert( feed( &hurry, 100, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_NONREF );
+
+    /* The lateness in between keeps the level */
+    assert( feed( &hurry, HURRY_LATENESS_LOW + 1, 1000 ) == 0 );
+    assert( hurry.level == HURRY_SKIP_NONREF );
+
+    /* Saturates at the top level */
+    assert( feed( &hurry, HURRY_LATENESS_HIGH, 1000 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_BIDIR );
+
+    /* Recovery is slower than the escalation: one level per down hold */
+    assert( feed( &hurry, HURRY_LATENESS_LOW, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_NONREF );
+    assert( feed( &hurry, 0, HURRY_DOWN_HOLD ) == 0 );
+    assert( hurry.level == HURRY_SKIP_NONREF );
+    assert( feed( &hurry, 0, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_LOOP_FILTER );
+
+    /* Late pictures again during the recovery hold wait for it to end */
+    assert( feed( &hurry, 100, HURRY_DOWN_HOLD ) == 0 );
+    assert( hurry.level == HURRY_SKIP_LOOP_FILTER );
+    assert( feed( &hurry, 100, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_NONREF );
+
+    /* And back down to full quality */
+    assert( feed( &hurry, 0, 1000 ) == 2 );
+    assert( hurry.level == HURRY_NONE );
+    assert( feed( &hurry, 0, 1000 ) == 0 );
+
+    /* A flush restarts from full quality, without a pending hold */
+    hurry.level = HURRY_SKIP_BIDIR;
+    hurry_Init( &hurry );
+    assert( feed( &hurry, 100, 1 ) == 1 );
+    assert( hurry.level == HURRY_SKIP_LOOP_FILTER );
+
+    return 0;
+}
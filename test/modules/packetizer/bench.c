@@ -0,0 +1,828 @@
+/*****************************************************************************
+ * bench.c: packetizers throughput benchmark
+ *****************************************************************************
+ * Copyright (C) 2018 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Runs the packetizer modules over elementary streams, like the decoder
+ * would, and reports their throughput.
+ *
+ * Without arguments, synthetic streams are generated for every codec, and
+ * the number of frames output is checked against the number generated. Any
+ * packetizer can also be benchmarked over a sample elementary stream with:
+ *   test_modules_packetizer_bench <h264|hevc|mpgv|mp4a|a52|dts|flac|mlp> file
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+# define bench_cycles() __rdtsc()
+#else
+# define bench_cycles() UINT64_C(0)
+#endif
+
+#define BENCH_INPUT_BLOCK_SIZE 4096
+/* As demuxers holding several slices or pictures per block would send */
+#define BENCH_LARGE_BLOCK_SIZE  (1 << 20)
+
+/*****************************************************************************
+ * Allocations accounting (glibc only)
+ *****************************************************************************/
+/* The plugins only bind to these if the executable exports them, hence
+ * -export-dynamic in the test LDFLAGS */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+# define BENCH_COUNT_ALLOCS
+#include <stdatomic.h>
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static atomic_ulong allocs;
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+static unsigned long bench_allocs(void)
+{
+    return atomic_load_explicit(&allocs, memory_order_relaxed);
+}
+#else
+static unsigned long bench_allocs(void)
+{
+    return 0;
+}
+#endif
+
+/*****************************************************************************
+ * Synthetic streams
+ *****************************************************************************/
+struct buffer
+{
+    uint8_t *p;
+    size_t i_size;
+    size_t i_alloc;
+};
+
+static void buffer_Append(struct buffer *b, const void *p, size_t i_size)
+{
+    if(b->i_size + i_size > b->i_alloc)
+    {
+        b->i_alloc = (b->i_size + i_size) * 2;
+        b->p = realloc(b->p, b->i_alloc);
+        if(!b->p)
+            abort();
+    }
+    memcpy(&b->p[b->i_size], p, i_size);
+    b->i_size += i_size;
+}
+
+/* Payload which can't emulate any startcode or sync word */
+static void buffer_AppendPayload(struct buffer *b, size_t i_size, unsigned i_seed)
+{
+    uint8_t chunk[256];
+    while(i_size)
+    {
+        size_t i_chunk = __MIN(i_size, sizeof(chunk));
+        for(size_t i=0; i<i_chunk; i++)
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+            chunk[i] = 0x10 + (i_seed >> 16) % 0xE0;
+        }
+        buffer_Append(b, chunk, i_chunk);
+        i_size -= i_chunk;
+    }
+}
+
+/* Bitstream writer, for the headers */
+struct bits_writer
+{
+    uint8_t p[256];
+    size_t i_bits;
+};
+
+static void bits_Put(struct bits_writer *w, unsigned i_count, uint32_t i_value)
+{
+    while(i_count--)
+    {
+        if(w->i_bits % 8 == 0)
+            w->p[w->i_bits / 8] = 0;
+        if((i_value >> i_count) & 1)
+            w->p[w->i_bits / 8] |= 0x80 >> (w->i_bits % 8);
+        w->i_bits++;
+    }
+}
+
+static void bits_PutUE(struct bits_writer *w, uint32_t i_value)
+{
+    unsigned i_len = 0;
+    for(uint32_t v = i_value + 1; v > 1; v >>= 1)
+        i_len++;
+    bits_Put(w, i_len, 0);
+    bits_Put(w, i_len + 1, i_value + 1);
+}
+
+/* Appends the bytes written so far, zero padded */
+static void bits_Write(struct buffer *b, struct bits_writer *w)
+{
+    while(w->i_bits % 8)
+        bits_Put(w, 1, 0);
+    buffer_Append(b, w->p, w->i_bits / 8);
+    w->i_bits = 0;
+}
+
+/* H.264/HEVC NAL with startcode and emulation prevention */
+static void nal_Write(struct buffer *b, struct bits_writer *w, bool b_trailing)
+{
+    if(b_trailing)
+        bits_Put(w, 1, 1);
+    while(w->i_bits % 8)
+        bits_Put(w, 1, 0);
+
+    static const uint8_t startcode[4] = { 0, 0, 0, 1 };
+    buffer_Append(b, startcode, 4);
+
+    unsigned i_zeros = 0;
+    for(size_t i=0; i<w->i_bits / 8; i++)
+    {
+        if(i_zeros == 2 && w->p[i] <= 3)
+        {
+            buffer_Append(b, "\x03", 1);
+            i_zeros = 0;
+        }
+        buffer_Append(b, &w->p[i], 1);
+        i_zeros = w->p[i] ? 0 : i_zeros + 1;
+    }
+    w->i_bits = 0;
+}
+
+#define H264_SLICES 32
+#define H264_MB_WIDTH 120 /* 1920x1088 */
+#define H264_MB_HEIGHT 68
+
+static void generate_h264(struct buffer *b, unsigned i_frames)
+{
+    struct bits_writer w = { .i_bits = 0 };
+
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const bool b_idr = (i_frame % 50) == 0;
+        if(b_idr)
+        {
+            /* SPS */
+            bits_Put(&w, 8, 0x67);
+            bits_Put(&w, 8, 100); /* profile high */
+            bits_Put(&w, 8, 0);
+            bits_Put(&w, 8, 41); /* level */
+            bits_PutUE(&w, 0); /* sps id */
+            bits_PutUE(&w, 1); /* chroma_format_idc */
+            bits_PutUE(&w, 0); /* bit_depth_luma_minus8 */
+            bits_PutUE(&w, 0); /* bit_depth_chroma_minus8 */
+            bits_Put(&w, 1, 0); /* qpprime_y_zero_transform_bypass */
+            bits_Put(&w, 1, 0); /* seq_scaling_matrix_present */
+            bits_PutUE(&w, 0); /* log2_max_frame_num_minus4 */
+            bits_PutUE(&w, 2); /* pic_order_cnt_type */
+            bits_PutUE(&w, 1); /* max_num_ref_frames */
+            bits_Put(&w, 1, 0); /* gaps_in_frame_num_allowed */
+            bits_PutUE(&w, H264_MB_WIDTH - 1);
+            bits_PutUE(&w, H264_MB_HEIGHT - 1);
+            bits_Put(&w, 1, 1); /* frame_mbs_only */
+            bits_Put(&w, 1, 1); /* direct_8x8_inference */
+            bits_Put(&w, 1, 0); /* frame_cropping */
+            bits_Put(&w, 1, 0); /* vui */
+            nal_Write(b, &w, true);
+
+            /* PPS */
+            bits_Put(&w, 8, 0x68);
+            bits_PutUE(&w, 0); /* pps id */
+            bits_PutUE(&w, 0); /* sps id */
+            bits_Put(&w, 1, 0); /* entropy_coding_mode */
+            bits_Put(&w, 1, 0); /* bottom_field_pic_order_in_frame_present */
+            bits_PutUE(&w, 0); /* num_slice_groups_minus1 */
+            bits_PutUE(&w, 0); /* num_ref_idx_l0_default_active_minus1 */
+            bits_PutUE(&w, 0); /* num_ref_idx_l1_default_active_minus1 */
+            bits_Put(&w, 1, 0); /* weighted_pred */
+            bits_Put(&w, 2, 0); /* weighted_bipred_idc */
+            bits_PutUE(&w, 0); /* pic_init_qp_minus26 (se 0) */
+            bits_PutUE(&w, 0); /* pic_init_qs_minus26 (se 0) */
+            bits_PutUE(&w, 0); /* chroma_qp_index_offset (se 0) */
+            bits_Put(&w, 1, 1); /* deblocking_filter_control_present */
+            bits_Put(&w, 1, 0); /* constrained_intra_pred */
+            bits_Put(&w, 1, 0); /* redundant_pic_cnt_present */
+            nal_Write(b, &w, true);
+        }
+
+        /* AUD */
+        bits_Put(&w, 8, 0x09);
+        bits_Put(&w, 3, b_idr ? 0 : 1);
+        nal_Write(b, &w, true);
+
+        const unsigned i_mbs = H264_MB_WIDTH * H264_MB_HEIGHT;
+        for(unsigned i_slice=0; i_slice<H264_SLICES; i_slice++)
+        {
+            bits_Put(&w, 8, b_idr ? 0x65 : 0x41);
+            bits_PutUE(&w, i_mbs * i_slice / H264_SLICES); /* first_mb_in_slice */
+            bits_PutUE(&w, b_idr ? 7 : 5); /* slice_type I / P */
+            bits_PutUE(&w, 0); /* pps id */
+            bits_Put(&w, 4, i_frame % 50); /* frame_num */
+            if(b_idr)
+            {
+                bits_PutUE(&w, i_frame / 50 % 2); /* idr_pic_id */
+            }
+            else
+            {
+                bits_Put(&w, 1, 0); /* num_ref_idx_active_override */
+                bits_Put(&w, 1, 0); /* ref_pic_list_modification_flag_l0 */
+            }
+            /* dec_ref_pic_marking */
+            if(b_idr)
+                bits_Put(&w, 2, 0);
+            else
+                bits_Put(&w, 1, 0);
+            bits_PutUE(&w, 0); /* slice_qp_delta (se 0) */
+            bits_PutUE(&w, 1); /* disable_deblocking_filter_idc */
+            nal_Write(b, &w, false);
+            buffer_AppendPayload(b, b_idr ? 8000 : 2000, i_frame * H264_SLICES + i_slice);
+        }
+    }
+}
+
+#define HEVC_SLICES 8
+#define HEVC_CTB_WIDTH 30 /* 1920x1088, 64x64 CTBs */
+#define HEVC_CTB_HEIGHT 17
+
+static void hevc_PutNALHeader(struct bits_writer *w, unsigned i_type)
+{
+    bits_Put(w, 1, 0);
+    bits_Put(w, 6, i_type);
+    bits_Put(w, 6, 0); /* nuh_layer_id */
+    bits_Put(w, 3, 1); /* nuh_temporal_id_plus1 */
+}
+
+static void hevc_PutProfileTierLevel(struct bits_writer *w)
+{
+    bits_Put(w, 2, 0); /* profile_space */
+    bits_Put(w, 1, 0); /* tier */
+    bits_Put(w, 5, 1); /* profile main */
+    bits_Put(w, 32, 0x60000000); /* profile_compatibility_flags */
+    bits_Put(w, 4, 0x9); /* progressive_source, frame_only_constraint */
+    bits_Put(w, 32, 0); /* reserved 44 bits */
+    bits_Put(w, 12, 0);
+    bits_Put(w, 8, 123); /* level 4.1 */
+}
+
+static void generate_hevc(struct buffer *b, unsigned i_frames)
+{
+    struct bits_writer w = { .i_bits = 0 };
+
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const bool b_idr = (i_frame % 50) == 0;
+
+        /* AUD */
+        hevc_PutNALHeader(&w, 35);
+        bits_Put(&w, 3, b_idr ? 0 : 1); /* pic_type */
+        nal_Write(b, &w, true);
+
+        if(b_idr)
+        {
+            /* VPS */
+            hevc_PutNALHeader(&w, 32);
+            bits_Put(&w, 4, 0); /* vps id */
+            bits_Put(&w, 2, 3); /* base_layer_internal, base_layer_available */
+            bits_Put(&w, 6, 0); /* max_layers_minus1 */
+            bits_Put(&w, 3, 0); /* max_sub_layers_minus1 */
+            bits_Put(&w, 1, 1); /* temporal_id_nesting */
+            bits_Put(&w, 16, 0xFFFF);
+            hevc_PutProfileTierLevel(&w);
+            bits_Put(&w, 1, 1); /* sub_layer_ordering_info_present */
+            bits_PutUE(&w, 1); /* max_dec_pic_buffering_minus1 */
+            bits_PutUE(&w, 0); /* max_num_reorder_pics */
+            bits_PutUE(&w, 0); /* max_latency_increase_plus1 */
+            bits_Put(&w, 6, 0); /* max_layer_id */
+            bits_PutUE(&w, 0); /* num_layer_sets_minus1 */
+            bits_Put(&w, 1, 0); /* timing_info_present */
+            bits_Put(&w, 1, 0); /* extension */
+            nal_Write(b, &w, true);
+
+            /* SPS */
+            hevc_PutNALHeader(&w, 33);
+            bits_Put(&w, 4, 0); /* vps id */
+            bits_Put(&w, 3, 0); /* max_sub_layers_minus1 */
+            bits_Put(&w, 1, 1); /* temporal_id_nesting */
+            hevc_PutProfileTierLevel(&w);
+            bits_PutUE(&w, 0); /* sps id */
+            bits_PutUE(&w, 1); /* chroma_format_idc */
+            bits_PutUE(&w, HEVC_CTB_WIDTH * 64);
+            bits_PutUE(&w, HEVC_CTB_HEIGHT * 64);
+            bits_Put(&w, 1, 0); /* conformance_window */
+            bits_PutUE(&w, 0); /* bit_depth_luma_minus8 */
+            bits_PutUE(&w, 0); /* bit_depth_chroma_minus8 */
+            bits_PutUE(&w, 4); /* log2_max_pic_order_cnt_lsb_minus4 */
+            bits_Put(&w, 1, 1); /* sub_layer_ordering_info_present */
+            bits_PutUE(&w, 1); /* max_dec_pic_buffering_minus1 */
+            bits_PutUE(&w, 0); /* max_num_reorder_pics */
+            bits_PutUE(&w, 0); /* max_latency_increase_plus1 */
+            bits_PutUE(&w, 0); /* log2_min_luma_coding_block_size_minus3 */
+            bits_PutUE(&w, 3); /* log2_diff_max_min_luma_coding_block_size */
+            bits_PutUE(&w, 0); /* log2_min_luma_transform_block_size_minus2 */
+            bits_PutUE(&w, 3); /* log2_diff_max_min_luma_transform_block_size */
+            bits_PutUE(&w, 0); /* max_transform_hierarchy_depth_inter */
+            bits_PutUE(&w, 0); /* max_transform_hierarchy_depth_intra */
+            bits_Put(&w, 1, 0); /* scaling_list_enabled */
+            bits_Put(&w, 1, 0); /* amp_enabled */
+            bits_Put(&w, 1, 0); /* sample_adaptive_offset_enabled */
+            bits_Put(&w, 1, 0); /* pcm_enabled */
+            bits_PutUE(&w, 0); /* num_short_term_ref_pic_sets */
+            bits_Put(&w, 1, 0); /* long_term_ref_pics_present */
+            bits_Put(&w, 1, 0); /* temporal_mvp_enabled */
+            bits_Put(&w, 1, 0); /* strong_intra_smoothing_enabled */
+            bits_Put(&w, 1, 0); /* vui_parameters_present */
+            bits_Put(&w, 1, 0); /* extension_present */
+            nal_Write(b, &w, true);
+
+            /* PPS */
+            hevc_PutNALHeader(&w, 34);
+            bits_PutUE(&w, 0); /* pps id */
+            bits_PutUE(&w, 0); /* sps id */
+            bits_Put(&w, 1, 0); /* dependent_slice_segments_enabled */
+            bits_Put(&w, 1, 0); /* output_flag_present */
+            bits_Put(&w, 3, 0); /* num_extra_slice_header_bits */
+            bits_Put(&w, 1, 0); /* sign_data_hiding_enabled */
+            bits_Put(&w, 1, 0); /* cabac_init_present */
+            bits_PutUE(&w, 0); /* num_ref_idx_l0_default_active_minus1 */
+            bits_PutUE(&w, 0); /* num_ref_idx_l1_default_active_minus1 */
+            bits_PutUE(&w, 0); /* init_qp_minus26 (se 0) */
+            bits_Put(&w, 1, 0); /* constrained_intra_pred */
+            bits_Put(&w, 1, 0); /* transform_skip_enabled */
+            bits_Put(&w, 1, 0); /* cu_qp_delta_enabled */
+            bits_PutUE(&w, 0); /* cb_qp_offset (se 0) */
+            bits_PutUE(&w, 0); /* cr_qp_offset (se 0) */
+            bits_Put(&w, 1, 0); /* slice_chroma_qp_offsets_present */
+            bits_Put(&w, 1, 0); /* weighted_pred */
+            bits_Put(&w, 1, 0); /* weighted_bipred */
+            bits_Put(&w, 1, 0); /* transquant_bypass_enabled */
+            bits_Put(&w, 1, 0); /* tiles_enabled */
+            bits_Put(&w, 1, 0); /* entropy_coding_sync_enabled */
+            bits_Put(&w, 1, 0); /* loop_filter_across_slices_enabled */
+            bits_Put(&w, 1, 0); /* deblocking_filter_control_present */
+            bits_Put(&w, 1, 0); /* scaling_list_data_present */
+            bits_Put(&w, 1, 0); /* lists_modification_present */
+            bits_PutUE(&w, 0); /* log2_parallel_merge_level_minus2 */
+            bits_Put(&w, 1, 0); /* slice_segment_header_extension_present */
+            bits_Put(&w, 1, 0); /* extension_present */
+            nal_Write(b, &w, true);
+        }
+
+        const unsigned i_ctbs = HEVC_CTB_WIDTH * HEVC_CTB_HEIGHT;
+        for(unsigned i_slice=0; i_slice<HEVC_SLICES; i_slice++)
+        {
+            hevc_PutNALHeader(&w, b_idr ? 19 /* IDR_W_RADL */ : 1 /* TRAIL_R */);
+            bits_Put(&w, 1, i_slice == 0); /* first_slice_segment_in_pic */
+            if(b_idr)
+                bits_Put(&w, 1, 0); /* no_output_of_prior_pics */
+            bits_PutUE(&w, 0); /* pps id */
+            if(i_slice)
+                bits_Put(&w, 9, i_ctbs * i_slice / HEVC_SLICES); /* address */
+            bits_PutUE(&w, b_idr ? 2 : 1); /* slice_type I / P */
+            if(!b_idr)
+            {
+                bits_Put(&w, 8, i_frame % 50); /* pic_order_cnt_lsb */
+                bits_Put(&w, 1, 0); /* short_term_ref_pic_set_sps */
+                bits_PutUE(&w, 1); /* num_negative_pics */
+                bits_PutUE(&w, 0); /* num_positive_pics */
+                bits_PutUE(&w, 0); /* delta_poc_s0_minus1 */
+                bits_Put(&w, 1, 1); /* used_by_curr_pic_s0 */
+                bits_Put(&w, 1, 0); /* num_ref_idx_active_override */
+                bits_PutUE(&w, 0); /* five_minus_max_num_merge_cand */
+            }
+            bits_PutUE(&w, 0); /* slice_qp_delta (se 0) */
+            nal_Write(b, &w, true); /* byte_alignment() */
+            buffer_AppendPayload(b, b_idr ? 30000 : 6000, i_frame * HEVC_SLICES + i_slice);
+        }
+    }
+}
+
+static void generate_mpgv(struct buffer *b, unsigned i_frames)
+{
+    /* MPEG-1, 720x576, 4:3, 25fps */
+    static const uint8_t seqhdr[] = { 0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x23,
+                                      0xFF, 0xFF, 0xE0, 0x18 };
+    static const uint8_t gophdr[] = { 0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x00 };
+
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const bool b_intra = (i_frame % 12) == 0;
+        if(b_intra)
+        {
+            buffer_Append(b, seqhdr, sizeof(seqhdr));
+            buffer_Append(b, gophdr, sizeof(gophdr));
+        }
+
+        /* temporal_reference(10) picture_coding_type(3) vbv_delay(16) */
+        const unsigned i_tref = i_frame % 12;
+        const uint8_t pichdr[] = { 0x00, 0x00, 0x01, 0x00,
+                                   i_tref >> 2,
+                                   ((i_tref & 3) << 6) | ((b_intra ? 1 : 2) << 3) | 0x07,
+                                   0xFF,
+                                   0xF8, /* then full_pel_forward_vector, forward_f_code */
+                                   b_intra ? 0x00 : 0x80 };
+        buffer_Append(b, pichdr, sizeof(pichdr));
+
+        for(unsigned i_slice=1; i_slice<=36; i_slice++)
+        {
+            const uint8_t slicehdr[] = { 0x00, 0x00, 0x01, i_slice };
+            buffer_Append(b, slicehdr, sizeof(slicehdr));
+            buffer_AppendPayload(b, b_intra ? 1500 : 400, i_frame * 36 + i_slice);
+        }
+    }
+}
+
+static void generate_a52(struct buffer *b, unsigned i_frames)
+{
+    /* 48kHz, 192kbit/s, bsid 8, stereo: 768 bytes frames */
+    static const uint8_t hdr[] = { 0x0B, 0x77, 0x00, 0x00, 0x14, 0x40, 0x40 };
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        buffer_Append(b, hdr, sizeof(hdr));
+        buffer_AppendPayload(b, 768 - sizeof(hdr), i_frame);
+    }
+}
+
+static void generate_adts(struct buffer *b, unsigned i_frames)
+{
+    /* AAC LC, 48kHz, stereo */
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const unsigned i_len = 300 + i_frame % 200;
+        const uint8_t hdr[] = { 0xFF, 0xF1, 0x4C, 0x80 | ((i_len >> 11) & 0x03),
+                                (i_len >> 3) & 0xFF, ((i_len & 0x07) << 5) | 0x1F, 0xFC };
+        buffer_Append(b, hdr, sizeof(hdr));
+        buffer_AppendPayload(b, i_len - sizeof(hdr), i_frame);
+    }
+}
+
+static void generate_dts(struct buffer *b, unsigned i_frames)
+{
+    /* Core only, 48kHz, 768kbit/s, stereo: 512 samples in 1024 bytes */
+    struct bits_writer w = { .i_bits = 0 };
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        bits_Put(&w, 32, 0x7FFE8001); /* sync */
+        bits_Put(&w, 1, 1); /* normal frame */
+        bits_Put(&w, 5, 31); /* deficit sample count */
+        bits_Put(&w, 1, 0); /* crc present */
+        bits_Put(&w, 7, 15); /* pcm sample blocks - 1 */
+        bits_Put(&w, 14, 1024 - 1); /* frame size - 1 */
+        bits_Put(&w, 6, 2); /* stereo */
+        bits_Put(&w, 4, 13); /* 48kHz */
+        bits_Put(&w, 5, 15); /* 768kbit/s */
+        bits_Put(&w, 11, 0x001); /* fixed ... aspf */
+        bits_Put(&w, 2, 0); /* no lfe */
+        bits_Put(&w, 1, 0); /* predictor history */
+        bits_Put(&w, 1, 0); /* multirate interpolator */
+        bits_Put(&w, 4, 7); /* encoder version */
+        bits_Put(&w, 2, 0); /* copy history */
+        bits_Put(&w, 3, 3); /* 16 bits */
+        bits_Put(&w, 6, 0); /* sumf, sums, dialnorm */
+        bits_Put(&w, 7, 0); /* up to 14 bytes */
+        bits_Write(b, &w);
+        buffer_AppendPayload(b, 1024 - 14, i_frame);
+    }
+}
+
+static uint8_t flac_crc8(const uint8_t *p, size_t i_size)
+{
+    uint8_t i_crc = 0;
+    while(i_size--)
+    {
+        i_crc ^= *p++;
+        for(int i=0; i<8; i++)
+            i_crc = (i_crc & 0x80) ? (i_crc << 1) ^ 0x07 : i_crc << 1;
+    }
+    return i_crc;
+}
+
+static uint16_t flac_crc16(const uint8_t *p, size_t i_size)
+{
+    uint16_t i_crc = 0;
+    while(i_size--)
+    {
+        i_crc ^= *p++ << 8;
+        for(int i=0; i<8; i++)
+            i_crc = (i_crc & 0x8000) ? (i_crc << 1) ^ 0x8005 : i_crc << 1;
+    }
+    return i_crc;
+}
+
+static void generate_flac(struct buffer *b, unsigned i_frames)
+{
+    /* 48kHz, stereo, 16 bits, 4096 samples per frame, no STREAMINFO: the
+     * packetizer gets everything from the frame headers and the CRCs */
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const size_t i_start = b->i_size;
+        uint8_t hdr[8] = { 0xFF, 0xF8, 0xCA, 0x18 };
+        size_t i_hdr = 4;
+
+        /* frame number, UTF-8 coded */
+        if(i_frame < 0x80)
+            hdr[i_hdr++] = i_frame;
+        else
+        {
+            unsigned i_extra = i_frame < 0x800 ? 1 : 2;
+            hdr[i_hdr++] = ((0xFF80 >> i_extra) & 0xFF) | (i_frame >> (6 * i_extra));
+            while(i_extra--)
+                hdr[i_hdr++] = 0x80 | ((i_frame >> (6 * i_extra)) & 0x3F);
+        }
+        hdr[i_hdr] = flac_crc8(hdr, i_hdr);
+        buffer_Append(b, hdr, i_hdr + 1);
+
+        buffer_AppendPayload(b, 3000 + i_frame % 3000, i_frame);
+
+        const uint16_t i_crc = flac_crc16(&b->p[i_start], b->i_size - i_start);
+        const uint8_t crc[2] = { i_crc >> 8, i_crc & 0xFF };
+        buffer_Append(b, crc, 2);
+    }
+}
+
+static void generate_mlp(struct buffer *b, unsigned i_frames)
+{
+    /* TrueHD, 48kHz, stereo, one substream: 40 samples per 160 bytes access
+     * unit, with a major sync every 128 units */
+    struct bits_writer w = { .i_bits = 0 };
+    for(unsigned i_frame=0; i_frame<i_frames; i_frame++)
+    {
+        const unsigned i_words = 80;
+        const uint8_t dir[2] = { 0x10, i_frame }; /* substream directory */
+        uint8_t hdr[4] = { i_words >> 8, i_words & 0xFF, i_frame >> 8, i_frame };
+
+        /* check nibble */
+        uint8_t i_parity = hdr[0] ^ hdr[1] ^ hdr[2] ^ hdr[3] ^ dir[0] ^ dir[1];
+        hdr[0] |= (0xF ^ i_parity ^ (i_parity >> 4)) << 4;
+        buffer_Append(b, hdr, 4);
+        size_t i_size = 4;
+
+        if(i_frame % 128 == 0)
+        {
+            bits_Put(&w, 32, 0xF8726FBA); /* TrueHD major sync */
+            bits_Put(&w, 4, 0); /* 48kHz */
+            bits_Put(&w, 8, 0);
+            bits_Put(&w, 5, 1); /* L, R */
+            bits_Put(&w, 2, 0);
+            bits_Put(&w, 13, 1); /* L, R */
+            bits_Put(&w, 32, 0xB752);
+            bits_Put(&w, 16, 0);
+            bits_Put(&w, 1, 1); /* vbr */
+            bits_Put(&w, 15, 0x7FFF); /* peak bitrate */
+            bits_Put(&w, 4, 1); /* substreams */
+            bits_Put(&w, 4, 0);
+            for(unsigned i=0; i<11; i++)
+                bits_Put(&w, 8, 0);
+            bits_Write(b, &w);
+            i_size += 28;
+        }
+
+        buffer_Append(b, dir, 2);
+        i_size += 2;
+        buffer_AppendPayload(b, i_words * 2 - i_size, i_frame);
+    }
+}
+
+/*****************************************************************************
+ * Benchmark
+ *****************************************************************************/
+struct target
+{
+    const char *psz_name;
+    enum es_format_category_e i_cat;
+    vlc_fourcc_t i_codec;
+    vlc_fourcc_t i_original_fourcc;
+    void (*pf_generate)(struct buffer *, unsigned);
+    unsigned i_frames;
+};
+
+static const struct target targets[] =
+{
+    { "h264", VIDEO_ES, VLC_CODEC_H264, 0, generate_h264, 300 },
+    { "hevc", VIDEO_ES, VLC_CODEC_HEVC, 0, generate_hevc, 300 },
+    { "mpgv", VIDEO_ES, VLC_CODEC_MPGV, 0, generate_mpgv, 600 },
+    { "mp4a", AUDIO_ES, VLC_CODEC_MP4A, VLC_FOURCC('A','D','T','S'), generate_adts, 20000 },
+    { "a52",  AUDIO_ES, VLC_CODEC_A52,  0, generate_a52, 20000 },
+    { "dts",  AUDIO_ES, VLC_CODEC_DTS,  0, generate_dts, 20000 },
+    { "flac", AUDIO_ES, VLC_CODEC_FLAC, 0, generate_flac, 4000 },
+    { "mlp",  AUDIO_ES, VLC_CODEC_TRUEHD, 0, generate_mlp, 50000 },
+};
+
+/* i_expected is the number of frames in the stream, or 0 if unknown */
+static int run_packetizer(vlc_object_t *parent, const struct target *t,
+                          const uint8_t *p_data, size_t i_data,
+                          size_t i_block_size, unsigned i_expected)
+{
+    decoder_t *p_dec = vlc_object_create(parent, sizeof(*p_dec));
+    if(!p_dec)
+        return VLC_ENOMEM;
+
+    es_format_Init(&p_dec->fmt_in, t->i_cat, t->i_codec);
+    p_dec->fmt_in.i_original_fourcc = t->i_original_fourcc;
+    p_dec->fmt_in.b_packetized = false;
+    es_format_Init(&p_dec->fmt_out, t->i_cat, 0);
+
+    p_dec->p_module = module_need(p_dec, "packetizer", NULL, false);
+    if(!p_dec->p_module)
+    {
+        printf("%-5s: no packetizer module, skipped\n", t->psz_name);
+        es_format_Clean(&p_dec->fmt_in);
+        vlc_object_release(p_dec);
+        return VLC_SUCCESS;
+    }
+
+    unsigned long i_frames = 0;
+    size_t i_out = 0;
+    const unsigned long i_allocs = bench_allocs();
+    const uint64_t i_cycles = bench_cycles();
+    const mtime_t i_start = mdate();
+
+    unsigned long i_blocks = 0;
+    for(size_t i_pos = 0; ; i_pos += i_block_size)
+    {
+        /* The packetizers usually take the block and clear *pp_block, so
+         * the input position, not p_in, tells when to drain */
+        const bool b_drain = i_pos >= i_data;
+        block_t *p_in = NULL;
+        if(!b_drain)
+        {
+            const size_t i_size = __MIN(i_data - i_pos, i_block_size);
+            p_in = block_Alloc(i_size);
+            if(!p_in)
+                break;
+            i_blocks++;
+            memcpy(p_in->p_buffer, &p_data[i_pos], i_size);
+            p_in->i_dts = p_in->i_pts = (i_pos == 0) ? VLC_TS_0 : VLC_TS_INVALID;
+        }
+
+        block_t **pp_in = b_drain ? NULL : &p_in;
+        block_t *p_out;
+        while((p_out = p_dec->pf_packetize(p_dec, pp_in)))
+        {
+            while(p_out)
+            {
+                block_t *p_next = p_out->p_next;
+                i_out += p_out->i_buffer;
+                i_frames++;
+                block_Release(p_out);
+                p_out = p_next;
+            }
+        }
+
+        if(b_drain)
+            break;
+    }
+
+    const mtime_t i_time = __MAX(mdate() - i_start, 1);
+    const uint64_t i_total_cycles = bench_cycles() - i_cycles;
+    /* Only count the packetizer allocations, not the input blocks */
+    const unsigned long i_total_allocs = bench_allocs() - i_allocs - i_blocks;
+
+    printf("%-5s %7zu: %8zu KiB in, %8zu KiB out, %7lu frames, %8.1f MB/s",
+           t->psz_name, i_block_size, i_data / 1024, i_out / 1024, i_frames,
+           (double) i_data / i_time);
+#ifdef BENCH_COUNT_ALLOCS
+    if(i_frames)
+        printf(", %6.2f allocs/frame", (double) i_total_allocs / i_frames);
+#else
+    (void) i_total_allocs;
+#endif
+    if(i_total_cycles && i_data)
+        printf(", %6.2f cycles/byte", (double) i_total_cycles / i_data);
+    printf("\n");
+
+    module_unneed(p_dec, p_dec->p_module);
+    es_format_Clean(&p_dec->fmt_in);
+    es_format_Clean(&p_dec->fmt_out);
+    vlc_object_release(p_dec);
+
+    /* The last frame may be held back, as its end is only known from the
+     * start of the next one */
+    if(i_frames == 0 ||
+       (i_expected && (i_frames > i_expected || i_frames + 1 < i_expected)))
+    {
+        fprintf(stderr, "%s: %lu frames output, %u expected\n",
+                t->psz_name, i_frames, i_expected);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int run_file(vlc_object_t *parent, const struct target *t, const char *psz_file)
+{
+    FILE *fp = vlc_fopen(psz_file, "rb");
+    if(!fp)
+    {
+        fprintf(stderr, "cannot open %s\n", psz_file);
+        return VLC_EGENERIC;
+    }
+
+    struct buffer b = { NULL, 0, 0 };
+    uint8_t chunk[65536];
+    size_t i_read;
+    while((i_read = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        buffer_Append(&b, chunk, i_read);
+    fclose(fp);
+
+    int i_ret = run_packetizer(parent, t, b.p, b.i_size,
+                               BENCH_INPUT_BLOCK_SIZE, 0);
+    free(b.p);
+    return i_ret;
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if(!vlc)
+        return 77; /* skip */
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+
+    int i_ret = VLC_SUCCESS;
+
+    if(argc == 3)
+    {
+        i_ret = VLC_EGENERIC;
+        for(size_t i=0; i<ARRAY_SIZE(targets); i++)
+        {
+            if(!strcmp(targets[i].psz_name, argv[1]))
+                i_ret = run_file(parent, &targets[i], argv[2]);
+        }
+    }
+    else
+    {
+        for(size_t i=0; i<ARRAY_SIZE(targets) && i_ret == VLC_SUCCESS; i++)
+        {
+            const struct target *t = &targets[i];
+            if(!t->pf_generate)
+                continue;
+
+            struct buffer b = { NULL, 0, 0 };
+            t->pf_generate(&b, t->i_frames);
+            i_ret = run_packetizer(parent, t, b.p, b.i_size,
+                                   BENCH_INPUT_BLOCK_SIZE, t->i_frames);
+            /* Fragments within a block are output without copies */
+            if(i_ret == VLC_SUCCESS && t->i_cat == VIDEO_ES)
+                i_ret = run_packetizer(parent, t, b.p, b.i_size,
+                                       BENCH_LARGE_BLOCK_SIZE, t->i_frames);
+            free(b.p);
+        }
+    }
+
+    libvlc_release(vlc);
+    return i_ret == VLC_SUCCESS ? 0 : 1;
+}
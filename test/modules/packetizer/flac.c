@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * flac.c: FLAC packetizer CRC and sync code tests
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the slice-by-8 frame CRC against the bytewise one, over random
+ * data, lengths, alignments and initial values, and the sync code search
+ * paths against a bytewise scan.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* The module is built in, as a static one would be */
+#define MODULE_NAME   flac
+#define MODULE_STRING "flac"
+#include "../modules/packetizer/flac.c"
+
+/* Built in, the module does not define the name of its messages */
+const char vlc_module_name[] = MODULE_STRING;
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BUFFER_SIZE 4096
+#define ALIGN_MAX   16
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static uint16_t crc16_bytewise(uint16_t crc, const uint8_t *p, size_t len)
+{
+    while (len--)
+        crc = flac_crc16(crc, *p++);
+    return crc;
+}
+
+/* Candidates rejected early must be ones the header parser rejects */
+static void check_sync_candidates(void)
+{
+    uint8_t hdr[FLAC_HEADER_SIZE_MAX] = { 0xFF, 0xF8 };
+
+    for (unsigned v = 0; v < 0x20000; v++)
+    {
+        hdr[1] = 0xF8 | (v >> 16);
+        hdr[2] = v >> 8;
+        hdr[3] = v;
+
+        /* Too short to tell */
+        for (size_t len = 0; len < 4; len++)
+            assert(FLACIsValidSyncCandidate(hdr, &hdr[len]));
+
+        if (!FLACIsValidSyncCandidate(hdr, &hdr[sizeof(hdr)]))
+        {
+            struct flac_header_info h;
+            if (FLAC_ParseSyncInfo(hdr, NULL, NULL, &h) != 0)
+            {
+                fprintf(stderr, "valid header %02x %02x %02x %02x "
+                        "rejected\n", hdr[0], hdr[1], hdr[2], hdr[3]);
+                abort();
+            }
+        }
+    }
+}
+
+static const uint8_t *sync_find_ref(const uint8_t *p, const uint8_t *end)
+{
+    for (; end - p > 1; p++)
+        if (p[0] == 0xFF && (p[1] & 0xFE) == 0xF8 &&
+            FLACIsValidSyncCandidate(p, end))
+            return p;
+    return NULL;
+}
+
+/* Compares every sync code found from p to end, as the packetizer walks
+ * them, with the bytewise scan */
+static void check_sync_range(const uint8_t *p, const uint8_t *end,
+                             const uint8_t *(*pf_find)(const uint8_t *,
+                                                       const uint8_t *),
+                             const char *name)
+{
+    for (;;)
+    {
+        const uint8_t *ref = sync_find_ref(p, end);
+        const uint8_t *found = pf_find(p, end);
+        if (found != ref)
+        {
+            fprintf(stderr, "%s: from %p to %p, found %p instead of %p\n",
+                    name, (void *)p, (void *)end, (void *)found, (void *)ref);
+            abort();
+        }
+        if (ref == NULL)
+            break;
+        p = ref + 1;
+    }
+}
+
+static void check_sync_find(uint8_t *buf)
+{
+    static const uint8_t valid[4] = { 0xFF, 0xF8, 0x69, 0x08 };
+    static const uint8_t invalid[][4] = {
+        { 0xFF, 0xF9, 0xFF, 0x08 }, /* emulated sync code */
+        { 0xFF, 0xF8, 0x6F, 0x08 }, /* invalid sample rate */
+        { 0xFF, 0xF8, 0x69, 0xB0 }, /* reserved channel assignment */
+        { 0xFF, 0xF8, 0x69, 0x06 }, /* reserved sample size */
+        { 0xFF, 0xF8, 0x69, 0x09 }, /* reserved bit */
+        { 0xFF, 0xFA, 0x69, 0x08 }, /* not a sync code */
+    };
+
+    for (unsigned run = 0; run < 2000; run++)
+    {
+        /* Mostly 0xFF and sync like bytes, for many false candidates */
+        for (size_t i = 0; i < 256 + ALIGN_MAX; i++)
+        {
+            const unsigned r = Random();
+            buf[i] = (r & 3) == 0 ? 0xFF : (r & 3) == 1 ? 0xF8 | (r >> 2 & 7)
+                                         : r >> 4;
+        }
+
+        /* Sync codes on both sides of and across the 16 bytes vectors */
+        for (size_t pos = 13; pos + 4 <= 256; pos += 16 + Random() % 3)
+        {
+            const uint8_t *code = Random() % 2
+                ? valid : invalid[Random() % ARRAY_SIZE(invalid)];
+            memcpy(&buf[pos + (Random() % 5)], code, 4);
+        }
+
+        const size_t align = run % ALIGN_MAX;
+        const size_t len = run < 64 ? run : Random() % 256;
+        const uint8_t *p = &buf[align];
+
+        check_sync_range(p, p + len, FLACStartcodeHelper_Bytes, "bytes");
+#ifdef HAVE_SSE2_INTRINSICS
+        if (vlc_CPU_SSE2())
+            check_sync_range(p, p + len, FLACStartcodeHelper_SSE2, "SSE2");
+#endif
+        check_sync_range(p, p + len, FLACStartcodeHelper, "default");
+    }
+}
+
+int main(void)
+{
+    uint8_t *buf = malloc(BUFFER_SIZE + ALIGN_MAX);
+    assert(buf != NULL);
+
+    check_sync_candidates();
+    check_sync_find(buf);
+
+    flac_crc16_slices_init();
+
+    /* CRC-16 with polynomial 0x8005 and no reflection */
+    static const char check[] = "123456789";
+    assert(crc16_bytewise(0, (const uint8_t *)check, 9) == 0xFEE8);
+    assert(flac_crc16_buf(0, (const uint8_t *)check, 9) == 0xFEE8);
+
+    for (size_t i = 0; i < BUFFER_SIZE + ALIGN_MAX; i++)
+        buf[i] = Random();
+
+    /* Every length around the 8 bytes slices, then random ones */
+    for (unsigned run = 0; run < 20000; run++)
+    {
+        const size_t align = run % ALIGN_MAX;
+        const size_t len = run < 4 * 64 ? run / 4 : Random() % BUFFER_SIZE;
+        const uint16_t init = run % 3 ? Random() : 0;
+
+        const uint16_t ref = crc16_bytewise(init, &buf[align], len);
+        const uint16_t crc = flac_crc16_buf(init, &buf[align], len);
+        if (crc != ref)
+        {
+            fprintf(stderr, "length %zu, alignment %zu, initial %04x: "
+                    "%04x instead of %04x\n", len, align, init, crc, ref);
+            abort();
+        }
+
+        /* Splitting the data must not change the result, as when a frame
+         * spans several blocks */
+        const size_t split = len ? Random() % len : 0;
+        assert(flac_crc16_buf(flac_crc16_buf(init, &buf[align], split),
+                              &buf[align + split], len - split) == ref);
+    }
+
+    free(buf);
+    printf("slice-by-8 CRC matches the bytewise CRC, "
+           "sync code searches match the bytewise scan\n");
+    return 0;
+}
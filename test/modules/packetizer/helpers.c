@@ -30,6 +30,7 @@
 #include <vlc_block_helper.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/packetizer_helper.h"
 
 struct results_s
 {
@@ -77,19 +78,253 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
         return i_ret;
 
     /* Perform same tests on simd optimized code */
-    if( startcode_FindAnnexB_Bits != startcode_FindAnnexB )
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
     {
-        printf("checking asm:\n");
+        printf("checking sse2 code:\n");
         i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                           startcode_FindAnnexB );
+                           startcode_FindAnnexB_SSE2 );
         if( i_ret != 0 )
             return i_ret;
     }
-    else printf("asm not built in, skipping test:\n");
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+    {
+        printf("checking avx2 code:\n");
+        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                           startcode_FindAnnexB_AVX2 );
+        if( i_ret != 0 )
+            return i_ret;
+    }
+#endif
+#ifdef STARTCODE_HAVE_NEON
+    printf("checking neon code:\n");
+    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                       startcode_FindAnnexB_NEON );
+    if( i_ret != 0 )
+        return i_ret;
+#endif
+
+    printf("checking runtime selected code:\n");
+    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                       startcode_FindAnnexB );
+    if( i_ret != 0 )
+        return i_ret;
 
     return 0;
 }
 
+/*
+ * Views of the input blocks
+ */
+static unsigned i_source_released;
+
+static void source_release( block_t *p_block )
+{
+    i_source_released++;
+    free( p_block );
+}
+
+static block_t *source_new( const uint8_t *p_data, size_t i_data )
+{
+    block_t *p_block = malloc( sizeof(*p_block) + i_data );
+    assert( p_block );
+    block_Init( p_block, (uint8_t *) &p_block[1], i_data );
+    p_block->pf_release = source_release;
+    memcpy( p_block->p_buffer, p_data, i_data );
+    return p_block;
+}
+
+static void check_view_refs( void )
+{
+    const uint8_t data[64] = { 0 };
+    block_t *p_views[PACKETIZER_VIEWS * 2 + 1];
+
+    printf("* Checking views refcounting:\n");
+
+    /* The input block is released with the last reference, whatever the
+     * order, and the slots of the owner get reused */
+    for( unsigned i_order = 0; i_order < 3; i_order++ )
+    {
+        i_source_released = 0;
+        block_t *p_owner = packetizer_WrapBlock( source_new( data, sizeof(data) ) );
+        assert( p_owner->pf_release == packetizer_OwnerRelease );
+
+        for( size_t i = 0; i < ARRAY_SIZE(p_views); i++ )
+        {
+            p_views[i] = packetizer_ViewBlock( p_owner, &p_owner->p_buffer[i], 2 );
+            assert( p_views[i] );
+            assert( p_views[i]->p_buffer == &p_owner->p_buffer[i] );
+            assert( p_views[i]->i_buffer == 2 );
+        }
+
+        /* Release a slot and take it again */
+        block_Release( p_views[1] );
+        p_views[1] = packetizer_ViewBlock( p_owner, &p_owner->p_buffer[1], 2 );
+        assert( p_views[1] );
+
+        if( i_order == 0 )
+            block_Release( p_owner );
+        for( size_t i = 0; i < ARRAY_SIZE(p_views); i++ )
+        {
+            assert( i_source_released == 0 );
+            block_Release( p_views[i_order == 2 ? ARRAY_SIZE(p_views) - 1 - i : i] );
+        }
+        if( i_order != 0 )
+        {
+            assert( i_source_released == 0 );
+            block_Release( p_owner );
+        }
+        assert( i_source_released == 1 );
+    }
+}
+
+static void parse_reset( void *p_private, bool b_broken )
+{
+    VLC_UNUSED(p_private); VLC_UNUSED(b_broken);
+}
+
+/* Trims the trailing zeros as the h264 and hevc packetizers do, if asked */
+static block_t *parse_nal( void *p_private, bool *pb_ts_used, block_t *p_block )
+{
+    const bool *pb_trim = p_private;
+
+    while( *pb_trim && p_block->i_buffer > 0 &&
+           p_block->p_buffer[p_block->i_buffer - 1] == 0 )
+        p_block->i_buffer--;
+    *pb_ts_used = false;
+    return p_block;
+}
+
+static int validate_nal( void *p_private, block_t *p_block )
+{
+    VLC_UNUSED(p_private); VLC_UNUSED(p_block);
+    return VLC_SUCCESS;
+}
+
+static size_t packetize_all( packetizer_t *p_pack, block_t *p_block,
+                             block_t **pp_out, size_t i_max )
+{
+    size_t i_out = 0;
+    block_t *p_nal;
+
+    while( (p_nal = packetizer_Packetize( p_pack, &p_block )) )
+    {
+        assert( i_out < i_max );
+        pp_out[i_out++] = p_nal;
+    }
+    while( (p_nal = packetizer_Packetize( p_pack, NULL )) )
+    {
+        assert( i_out < i_max );
+        pp_out[i_out++] = p_nal;
+    }
+    /* Drop the input held by the bytestream */
+    packetizer_Flush( p_pack );
+    return i_out;
+}
+
+static void check_packetizer_views( void )
+{
+    static const uint8_t startcode[3] = { 0, 0, 1 };
+    /* 4 bytes startcodes, and a 3 bytes one */
+    static const uint8_t data[] = { 0, 0, 0, 1, 0x65, 0xAA, 0xAA,
+                                    0, 0, 0, 1, 0x41, 0xBB,
+                                    0, 0, 1, 0x41, 0xCC, 0, 0,
+                                    0, 0, 0, 1, 0x41, 0xDD };
+    static const uint8_t copied[] = { 0, 0, 0, 1, 0x41, 0xCC, 0, 0, 0 };
+    /* zeros trailing the first NAL */
+    static const uint8_t trailing[] = { 0, 0, 0, 1, 0x65, 0xAA, 0, 0,
+                                        0, 0, 0, 1, 0x41, 0xBB };
+    bool b_trim = false;
+    packetizer_t pack;
+    block_t *p_out[8];
+
+    printf("* Checking packetizer views:\n");
+
+    packetizer_Init( &pack, startcode, sizeof(startcode), startcode_FindAnnexB,
+                     startcode, 1, 0, parse_reset, parse_nal, validate_nal, &b_trim );
+
+    i_source_released = 0;
+    block_t *p_source = source_new( data, sizeof(data) );
+    const uint8_t *p_data = p_source->p_buffer;
+    size_t i_out = packetize_all( &pack, p_source, p_out, ARRAY_SIZE(p_out) );
+    assert( i_out == 4 );
+
+    /* The prepended zero of the 4 bytes startcodes is reused in place, so
+     * that consecutive views overlap by that byte */
+    assert( p_out[0]->pf_release == packetizer_ViewRelease );
+    assert( p_out[0]->p_buffer == &p_data[0] );
+    assert( p_out[0]->i_buffer == 8 );
+    assert( p_out[1]->pf_release == packetizer_ViewRelease );
+    assert( p_out[1]->p_buffer == &p_data[7] );
+    assert( p_out[1]->i_buffer == 6 );
+
+    /* The 3 bytes startcode is not preceded by a zero: copied */
+    assert( p_out[2]->pf_release != packetizer_ViewRelease );
+    assert( p_out[2]->i_buffer == sizeof(copied) );
+    assert( !memcmp( p_out[2]->p_buffer, copied, sizeof(copied) ) );
+
+    assert( p_out[3]->pf_release == packetizer_ViewRelease );
+    assert( p_out[3]->p_buffer == &p_data[20] );
+    assert( p_out[3]->i_buffer == 6 );
+
+    /* Overlapping views merge into one, without copy */
+    block_t *p_chain = NULL, **pp_last = &p_chain;
+    packetizer_ChainLastAppend( p_chain, &pp_last, p_out[0] );
+    packetizer_ChainLastAppend( p_chain, &pp_last, p_out[1] );
+    assert( p_chain == p_out[0] && p_chain->p_next == NULL );
+    assert( p_chain->p_buffer == &p_data[0] && p_chain->i_buffer == 13 );
+    assert( &p_chain->p_buffer[p_chain->i_buffer] <=
+            &p_chain->p_start[p_chain->i_size] );
+
+    /* A copy can't be merged, nor a view of non contiguous data */
+    packetizer_ChainLastAppend( p_chain, &pp_last, p_out[2] );
+    assert( p_chain->p_next == p_out[2] );
+    packetizer_ChainLastAppend( p_chain, &pp_last, p_out[3] );
+    assert( p_out[2]->p_next == p_out[3] );
+
+    /* so the chain is gathered by copy */
+    block_t *p_gathered = packetizer_ChainGather( p_chain );
+    assert( p_gathered && p_gathered->pf_release != packetizer_ViewRelease );
+    assert( p_gathered->i_buffer == 13 + sizeof(copied) + 6 );
+    assert( !memcmp( p_gathered->p_buffer, data, 13 ) );
+    assert( !memcmp( &p_gathered->p_buffer[13], copied, sizeof(copied) ) );
+    assert( !memcmp( &p_gathered->p_buffer[13 + sizeof(copied)], &data[20], 6 ) );
+    block_Release( p_gathered );
+    assert( i_source_released == 1 );
+
+    /* Views only separated by trimmed zeros are gathered in place */
+    b_trim = true;
+    i_source_released = 0;
+    p_source = source_new( trailing, sizeof(trailing) );
+    p_data = p_source->p_buffer;
+    i_out = packetize_all( &pack, p_source, p_out, ARRAY_SIZE(p_out) );
+    assert( i_out == 2 );
+    assert( p_out[0]->p_buffer == &p_data[0] && p_out[0]->i_buffer == 6 );
+    assert( p_out[1]->p_buffer == &p_data[8] && p_out[1]->i_buffer == 6 );
+
+    p_out[0]->p_next = p_out[1];
+    p_gathered = packetizer_ChainGather( p_out[0] );
+    assert( p_gathered == p_out[0] && p_gathered->p_next == NULL );
+    assert( p_gathered->p_buffer == &p_data[0] );
+    assert( p_gathered->i_buffer == sizeof(trailing) );
+    assert( &p_gathered->p_buffer[p_gathered->i_buffer] <=
+            &p_gathered->p_start[p_gathered->i_size] );
+    assert( i_source_released == 0 );
+
+    /* Padding a merged view, as decoders do, copies it out of the input */
+    p_gathered = block_Realloc( p_gathered, 0, sizeof(trailing) + 16 );
+    assert( p_gathered != NULL );
+    assert( !memcmp( p_gathered->p_buffer, trailing, sizeof(trailing) ) );
+    assert( i_source_released == 1 );
+    block_Release( p_gathered );
+
+    assert( packetizer_ChainGather( NULL ) == NULL );
+
+    packetizer_Clean( &pack );
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +369,8 @@ int main( void )
             return i_ret;
     }
 
+    check_view_refs();
+    check_packetizer_views();
+
     return 0;
 }
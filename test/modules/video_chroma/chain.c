@@ -0,0 +1,201 @@
+/*****************************************************************************
+ * chain.c: chained video converters test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Converts cropped I420 pictures to RV32 with the chain module, and checks
+ * that only the visible area makes it to the output, and that the number of
+ * steps is reported.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define WIDTH   64
+#define HEIGHT  48
+#define VISIBLE_WIDTH   32
+#define VISIBLE_HEIGHT  24
+#define FRAMES  4
+
+/* Visible area offsets, starting on a chroma sample */
+static const struct
+{
+    unsigned x, y;
+} offsets[] = {
+    { 16, 8 }, { 0, 0 }, { 2, 2 }, { 16, 8 },
+};
+
+static picture_t *BufferNew(filter_t *filter)
+{
+    return picture_NewFromFormat(&filter->fmt_out.video);
+}
+
+static filter_t *Create(vlc_object_t *parent, unsigned x, unsigned y)
+{
+    filter_t *filter = vlc_object_create(parent, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, VIDEO_ES, VLC_CODEC_I420);
+    video_format_Setup(&filter->fmt_in.video, VLC_CODEC_I420, WIDTH, HEIGHT,
+                       VISIBLE_WIDTH, VISIBLE_HEIGHT, 1, 1);
+    filter->fmt_in.video.i_x_offset = x;
+    filter->fmt_in.video.i_y_offset = y;
+    es_format_Init(&filter->fmt_out, VIDEO_ES, VLC_CODEC_RGB32);
+    video_format_Setup(&filter->fmt_out.video, VLC_CODEC_RGB32,
+                       VISIBLE_WIDTH, VISIBLE_HEIGHT,
+                       VISIBLE_WIDTH, VISIBLE_HEIGHT, 1, 1);
+    video_format_FixRgb(&filter->fmt_out.video);
+    filter->owner.video.buffer_new = BufferNew;
+
+    filter->p_module = module_need(filter, "video converter", "chain", true);
+    if (filter->p_module == NULL)
+    {
+        es_format_Clean(&filter->fmt_in);
+        es_format_Clean(&filter->fmt_out);
+        vlc_object_release(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void Delete(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+}
+
+/* White visible area, black around it */
+static void Fill(picture_t *pic, unsigned x0, unsigned y0)
+{
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+        const unsigned div = i == 0 ? 1 : 2;
+
+        for (int y = 0; y < p->i_lines; y++)
+            for (int x = 0; x < p->i_pitch; x++)
+            {
+                const bool visible =
+                    (unsigned)x * div >= x0 &&
+                    (unsigned)x * div < x0 + VISIBLE_WIDTH &&
+                    (unsigned)y * div >= y0 &&
+                    (unsigned)y * div < y0 + VISIBLE_HEIGHT;
+
+                p->p_pixels[y * p->i_pitch + x] = i != 0 ? 128
+                                                : visible ? 235 : 16;
+            }
+    }
+}
+
+static bool IsWhite(const video_format_t *fmt, uint32_t pixel)
+{
+    const uint32_t masks[] = { fmt->i_rmask, fmt->i_gmask, fmt->i_bmask };
+
+    for (size_t i = 0; i < ARRAY_SIZE(masks); i++)
+        if (((pixel & masks[i]) >> ctz(masks[i])) < 0xc0)
+            return false;
+    return true;
+}
+
+static int Test(vlc_object_t *parent, unsigned x0, unsigned y0)
+{
+    filter_t *filter = Create(parent, x0, y0);
+    if (filter == NULL)
+    {
+        printf("offset %2u,%-2u: no converters, skipped\n", x0, y0);
+        return VLC_SUCCESS;
+    }
+
+    const int steps = var_GetInteger(filter, "chain-steps");
+    assert(steps >= 1);
+
+    picture_t *src = picture_NewFromFormat(&filter->fmt_in.video);
+    assert(src != NULL);
+    Fill(src, x0, y0);
+
+    int ret = VLC_SUCCESS;
+    /* A few frames, so that the intermediate pictures get recycled */
+    for (unsigned i = 0; i < FRAMES && ret == VLC_SUCCESS; i++)
+    {
+        picture_t *out = filter->pf_video_filter(filter, picture_Hold(src));
+        assert(out != NULL);
+
+        const video_format_t *fmt = &filter->fmt_out.video;
+        for (unsigned y = 0; y < VISIBLE_HEIGHT; y++)
+            for (unsigned x = 0; x < VISIBLE_WIDTH; x++)
+            {
+                const uint32_t pixel = *(const uint32_t *)
+                    &out->p[0].p_pixels[y * out->p[0].i_pitch + 4 * x];
+
+                if (!IsWhite(fmt, pixel) && ret == VLC_SUCCESS)
+                {
+                    fprintf(stderr, "offset %u,%u: cropped pixel at %ux%u\n",
+                            x0, y0, x, y);
+                    ret = VLC_EGENERIC;
+                }
+            }
+        picture_Release(out);
+    }
+
+    if (ret == VLC_SUCCESS)
+        printf("offset %2u,%-2u: ok, %d step(s)\n", x0, y0, steps);
+    picture_Release(src);
+    Delete(filter);
+    return ret;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+    int ret = VLC_SUCCESS;
+
+    /* The last offsets are the first ones again, with the cached chain */
+    for (size_t i = 0; i < ARRAY_SIZE(offsets) && ret == VLC_SUCCESS; i++)
+        ret = Test(parent, offsets[i].x, offsets[i].y);
+
+    libvlc_release(vlc);
+    return ret == VLC_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/*****************************************************************************
+ * swscale.c: swscale slice-threaded conversion test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Converts pictures with the swscale module on one thread and in slices,
+ * checks that the results match, and reports the throughput of both.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define FRAMES 20
+
+/* Slices may only differ by the rounding of the scaling positions, and
+ * by the dithering pattern */
+#define MAX_DIFF 2
+
+struct target
+{
+    const char *psz_name;
+    vlc_fourcc_t i_chroma_in;
+    unsigned i_width_in, i_height_in;
+    vlc_fourcc_t i_chroma_out;
+    unsigned i_width_out, i_height_out;
+};
+
+static const struct target targets[] =
+{
+    { "I420 -> RV32 2160p", VLC_CODEC_I420, 3840, 2160,
+                            VLC_CODEC_RGB32, 3840, 2160 },
+    { "I420 -> RV32 1080p to 720p", VLC_CODEC_I420, 1920, 1080,
+                                    VLC_CODEC_RGB32, 1280, 720 },
+    { "I420 1080p to 2160p", VLC_CODEC_I420, 1920, 1080,
+                             VLC_CODEC_I420, 3840, 2160 },
+    { "I0AL -> I420 2160p", VLC_CODEC_I420_10L, 3840, 2160,
+                            VLC_CODEC_I420, 3840, 2160 },
+};
+
+static picture_t *BufferNew(filter_t *filter)
+{
+    return picture_NewFromFormat(&filter->fmt_out.video);
+}
+
+/* Smooth gradients with a little noise, so that a misplaced band shows */
+static void Fill(picture_t *pic)
+{
+    unsigned seed = 1;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+        const bool b_16 = p->i_pixel_pitch == 2;
+        const unsigned count = p->i_visible_pitch / p->i_pixel_pitch;
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (unsigned x = 0; x < count; x++)
+            {
+                seed = seed * 1103515245 + 12345;
+                unsigned value = (x + 2 * y + 64 * i) % 200 + 16
+                               + (seed >> 16) % 4;
+
+                if (b_16)
+                    ((uint16_t *)&p->p_pixels[y * p->i_pitch])[x] = value << 2;
+                else
+                    p->p_pixels[y * p->i_pitch + x] = value;
+            }
+    }
+}
+
+static filter_t *Create(vlc_object_t *parent, const struct target *t,
+                        int threads)
+{
+    filter_t *filter = vlc_object_create(parent, sizeof (*filter));
+    if (filter == NULL)
+        return NULL;
+
+    es_format_Init(&filter->fmt_in, VIDEO_ES, t->i_chroma_in);
+    video_format_Setup(&filter->fmt_in.video, t->i_chroma_in,
+                       t->i_width_in, t->i_height_in,
+                       t->i_width_in, t->i_height_in, 1, 1);
+    es_format_Init(&filter->fmt_out, VIDEO_ES, t->i_chroma_out);
+    video_format_Setup(&filter->fmt_out.video, t->i_chroma_out,
+                       t->i_width_out, t->i_height_out,
+                       t->i_width_out, t->i_height_out, 1, 1);
+    video_format_FixRgb(&filter->fmt_out.video);
+    filter->owner.video.buffer_new = BufferNew;
+
+    var_Create(filter, "swscale-threads", VLC_VAR_INTEGER);
+    var_SetInteger(filter, "swscale-threads", threads);
+
+    filter->p_module = module_need(filter, "video converter", "swscale", true);
+    if (filter->p_module == NULL)
+    {
+        es_format_Clean(&filter->fmt_in);
+        es_format_Clean(&filter->fmt_out);
+        vlc_object_release(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void Delete(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+}
+
+static picture_t *Run(filter_t *filter, picture_t *src, mtime_t *time)
+{
+    picture_t *out = NULL;
+    const mtime_t start = mdate();
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        if (out != NULL)
+            picture_Release(out);
+        out = filter->pf_video_filter(filter, picture_Hold(src));
+        if (out == NULL)
+            break;
+    }
+    *time = __MAX(mdate() - start, 1);
+    return out;
+}
+
+static unsigned Compare(const picture_t *a, const picture_t *b)
+{
+    unsigned max = 0;
+
+    for (int i = 0; i < a->i_planes; i++)
+    {
+        const plane_t *pa = &a->p[i], *pb = &b->p[i];
+
+        for (int y = 0; y < pa->i_visible_lines; y++)
+            for (int x = 0; x < pa->i_visible_pitch; x++)
+            {
+                int diff = pa->p_pixels[y * pa->i_pitch + x]
+                         - pb->p_pixels[y * pb->i_pitch + x];
+                if ((unsigned)abs(diff) > max)
+                    max = abs(diff);
+            }
+    }
+    return max;
+}
+
+static int Test(vlc_object_t *parent, const struct target *t)
+{
+    filter_t *single = Create(parent, t, 1);
+    filter_t *sliced = Create(parent, t, 0);
+    int ret = VLC_SUCCESS;
+
+    if (single == NULL || sliced == NULL)
+    {
+        printf("%-28s: no swscale module, skipped\n", t->psz_name);
+        goto end;
+    }
+
+    picture_t *src = picture_NewFromFormat(&single->fmt_in.video);
+    if (src == NULL)
+    {
+        ret = VLC_ENOMEM;
+        goto end;
+    }
+    Fill(src);
+
+    mtime_t single_time, sliced_time;
+    picture_t *ref = Run(single, src, &single_time);
+    picture_t *out = Run(sliced, src, &sliced_time);
+
+    if (ref != NULL && out != NULL)
+    {
+        const unsigned diff = Compare(ref, out);
+
+        printf("%-28s: 1 thread %6.1f fps, slices %6.1f fps, max diff %u\n",
+               t->psz_name, FRAMES * (double)CLOCK_FREQ / single_time,
+               FRAMES * (double)CLOCK_FREQ / sliced_time, diff);
+        if (diff > MAX_DIFF)
+        {
+            fprintf(stderr, "%s: sliced conversion mismatch\n", t->psz_name);
+            ret = VLC_EGENERIC;
+        }
+    }
+    else
+        ret = VLC_EGENERIC;
+
+    if (ref != NULL)
+        picture_Release(ref);
+    if (out != NULL)
+        picture_Release(out);
+    picture_Release(src);
+end:
+    if (single != NULL)
+        Delete(single);
+    if (sliced != NULL)
+        Delete(sliced);
+    return ret;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+    int ret = VLC_SUCCESS;
+
+    for (size_t i = 0; i < ARRAY_SIZE(targets) && ret == VLC_SUCCESS; i++)
+        ret = Test(parent, &targets[i]);
+
+    libvlc_release(vlc);
+    return ret == VLC_SUCCESS ? 0 : 1;
+}
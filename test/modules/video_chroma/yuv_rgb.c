@@ -0,0 +1,312 @@
+/*****************************************************************************
+ * yuv_rgb.c: YUV to RGB row converters test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks the C converter against known colors and against a floating point
+ * reference, checks that the SIMD row converters give the same results as
+ * the C ones, and reports their throughput.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../modules/video_chroma/yuv_rgb_rows.c"
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_cpu.h>
+
+#define WIDTH   3840  /* pixels per row */
+#define RUNS    2000  /* rows converted for the throughput */
+
+static const char *const names[] = { "I420", "NV12", "I010", "P010" };
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* Fills the planes with legal samples of the input */
+static void Fill(enum yuv_rgb_input input, void *p, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        switch (input)
+        {
+            case YUV_RGB_I420:
+            case YUV_RGB_NV12:
+                ((uint8_t *)p)[i] = Random();
+                break;
+            case YUV_RGB_I010:
+                ((uint16_t *)p)[i] = Random() & 0x3ff;
+                break;
+            case YUV_RGB_P010:
+                ((uint16_t *)p)[i] = Random() & 0xffc0;
+                break;
+        }
+}
+
+static void TestColors(void)
+{
+    static const struct
+    {
+        uint8_t y, u, v;
+        uint8_t r, g, b;
+    } colors[] = {
+        { 235, 128, 128, 255, 255, 255 },
+        {  16, 128, 128,   0,   0,   0 },
+        {  81,  90, 240, 254,   0,   0 },
+    };
+    yuv_rgb_coefs_t coefs;
+    uint8_t out[8];
+
+    yuv_rgb_Coefs(&coefs, COLOR_SPACE_BT601, false);
+    for (size_t i = 0; i < ARRAY_SIZE(colors); i++)
+    {
+        const uint8_t y[2] = { colors[i].y, colors[i].y };
+
+        yuv_rgb_GetRowC(YUV_RGB_I420, false)(out, y, &colors[i].u,
+                                             &colors[i].v, 2, &coefs);
+        assert(out[0] == colors[i].r && out[1] == colors[i].g);
+        assert(out[2] == colors[i].b && out[3] == 0xff);
+        assert(!memcmp(out, out + 4, 4));
+    }
+}
+
+/* The fixed-point converters may differ from the exact conversion by one
+ * level per component, from the Q13 coefficients and the truncated
+ * products */
+#define MAX_REF_DIFF 1
+
+/* Exact conversion of samples scaled to 8 bits */
+static void Reference(double y, double u, double v, video_color_space_t space,
+                      bool full, double rgb[3])
+{
+    double kr, kb;
+
+    switch (space)
+    {
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627; kb = 0.0593;
+            break;
+        case COLOR_SPACE_BT709:
+            kr = 0.2126; kb = 0.0722;
+            break;
+        default:
+            kr = 0.299; kb = 0.114;
+            break;
+    }
+
+    const double kg = 1. - kr - kb;
+    const double l = full ? y : (y - 16.) * 255. / 219.;
+    const double cb = (full ? 1. : 255. / 224.) * (u - 128.);
+    const double cr = (full ? 1. : 255. / 224.) * (v - 128.);
+
+    rgb[0] = l + 2. * (1. - kr) * cr;
+    rgb[1] = l - 2. * kb * (1. - kb) / kg * cb - 2. * kr * (1. - kr) / kg * cr;
+    rgb[2] = l + 2. * (1. - kb) * cb;
+    for (int i = 0; i < 3; i++)
+        rgb[i] = fmin(fmax(rgb[i], 0.), 255.);
+}
+
+/* Sample x of a plane, scaled to 8 bits */
+static double Sample(enum yuv_rgb_input input, const void *p, size_t x)
+{
+    switch (input)
+    {
+        case YUV_RGB_I420:
+        case YUV_RGB_NV12:
+            return ((const uint8_t *)p)[x];
+        case YUV_RGB_I010:
+            return ((const uint16_t *)p)[x] / 4.;
+        default:
+            return ((const uint16_t *)p)[x] / 256.;
+    }
+}
+
+static void TestReference(void)
+{
+    const size_t bytes = 2 * WIDTH;
+    uint8_t *buf = malloc(3 * bytes + 4 * WIDTH);
+    assert(buf != NULL);
+
+    uint8_t *y = buf, *u = buf + bytes, *v = buf + 2 * bytes;
+    uint8_t *dst = buf + 3 * bytes;
+
+    for (int input = YUV_RGB_I420; input <= YUV_RGB_P010; input++)
+    {
+        const unsigned size = input >= YUV_RGB_I010 ? 2 : 1;
+        const bool semi = input == YUV_RGB_NV12 || input == YUV_RGB_P010;
+        unsigned max = 0;
+
+        Fill(input, buf, 3 * bytes / size);
+
+        for (int space = COLOR_SPACE_BT601; space <= COLOR_SPACE_BT2020;
+             space++)
+            for (int full = 0; full < 2; full++)
+                for (int bgra = 0; bgra < 2; bgra++)
+                {
+                    yuv_rgb_coefs_t coefs;
+
+                    yuv_rgb_Coefs(&coefs, space, full);
+                    yuv_rgb_GetRowC(input, bgra)(dst, y, u, v, WIDTH, &coefs);
+
+                    for (unsigned x = 0; x < WIDTH; x++)
+                    {
+                        const size_t i = x / 2;
+                        double rgb[3];
+
+                        Reference(Sample(input, y, x),
+                                  Sample(input, u, semi ? 2 * i : i),
+                                  Sample(input, semi ? u : v,
+                                         semi ? 2 * i + 1 : i),
+                                  space, full, rgb);
+
+                        const uint8_t *out = &dst[4 * x];
+                        const int got[3] = {
+                            out[bgra ? 2 : 0], out[1], out[bgra ? 0 : 2],
+                        };
+                        for (int c = 0; c < 3; c++)
+                        {
+                            const unsigned diff = abs(got[c] - (int)lround(rgb[c]));
+                            if (diff > MAX_REF_DIFF)
+                            {
+                                fprintf(stderr, "C %s: %d instead of %.2f "
+                                        "(pixel %u, component %d, space %d, "
+                                        "full %d)\n", names[input], got[c],
+                                        rgb[c], x, c, space, full);
+                                abort();
+                            }
+                            if (diff > max)
+                                max = diff;
+                        }
+                        assert(out[3] == 0xff);
+                    }
+                }
+
+        printf("C     %s: max difference %u from the exact conversion\n",
+               names[input], max);
+    }
+    free(buf);
+}
+
+static void TestRows(const char *name, yuv_rgb_row_t (*get)(enum yuv_rgb_input,
+                                                             bool))
+{
+    const size_t bytes = 2 * (WIDTH + 64);
+    uint8_t *buf = malloc(3 * bytes + 2 * 4 * (WIDTH + 64));
+    assert(buf != NULL);
+
+    uint8_t *y = buf, *u = buf + bytes, *v = buf + 2 * bytes;
+    uint8_t *dst_ref = buf + 3 * bytes, *dst = dst_ref + 4 * (WIDTH + 64);
+
+    for (int input = YUV_RGB_I420; input <= YUV_RGB_P010; input++)
+    {
+        const unsigned size = input >= YUV_RGB_I010 ? 2 : 1;
+
+        Fill(input, buf, 3 * bytes / size);
+
+        for (int space = COLOR_SPACE_BT601; space <= COLOR_SPACE_BT2020;
+             space++)
+            for (int full = 0; full < 2; full++)
+            {
+                yuv_rgb_coefs_t coefs;
+                yuv_rgb_Coefs(&coefs, space, full);
+
+                for (int bgra = 0; bgra < 2; bgra++)
+                {
+                    yuv_rgb_row_t ref = yuv_rgb_GetRowC(input, bgra);
+                    yuv_rgb_row_t simd = get(input, bgra);
+
+                    for (unsigned width = 1; width <= WIDTH;
+                         width += (width < 80) ? 1 : 97)
+                    {
+                        memset(dst_ref, 0, 4 * (WIDTH + 64));
+                        memset(dst, 0, 4 * (WIDTH + 64));
+                        ref(dst_ref, y, u, v, width, &coefs);
+                        simd(dst, y, u, v, width, &coefs);
+                        if (memcmp(dst_ref, dst, 4 * (WIDTH + 64)))
+                        {
+                            fprintf(stderr, "%s %s: mismatch (width %u, "
+                                    "space %d, full %d, bgra %d)\n", name,
+                                    names[input], width, space, full, bgra);
+                            abort();
+                        }
+                    }
+                }
+            }
+
+        yuv_rgb_coefs_t coefs;
+        yuv_rgb_Coefs(&coefs, COLOR_SPACE_BT709, false);
+        yuv_rgb_row_t ref = yuv_rgb_GetRowC(input, false);
+        yuv_rgb_row_t simd = get(input, false);
+
+        mtime_t ref_time = mdate();
+        for (unsigned i = 0; i < RUNS; i++)
+            ref(dst_ref, y, u, v, WIDTH, &coefs);
+        ref_time = mdate() - ref_time;
+
+        mtime_t simd_time = mdate();
+        for (unsigned i = 0; i < RUNS; i++)
+            simd(dst, y, u, v, WIDTH, &coefs);
+        simd_time = mdate() - simd_time;
+
+        printf("%-5s %s: C %7.2f Mpixels/s, SIMD %7.2f Mpixels/s\n",
+               name, names[input], (double)WIDTH * RUNS / __MAX(ref_time, 1),
+               (double)WIDTH * RUNS / __MAX(simd_time, 1));
+    }
+    free(buf);
+}
+
+int main(void)
+{
+    unsigned tested = 0;
+
+    TestColors();
+    TestReference();
+
+#if defined(HAVE_YUV_RGB_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        TestRows("avx2", yuv_rgb_GetRowAVX2);
+        tested++;
+    }
+#endif
+#if defined(HAVE_YUV_RGB_NEON)
+    if (vlc_CPU_ARM_NEON())
+    {
+        TestRows("neon", yuv_rgb_GetRowNEON);
+        tested++;
+    }
+#endif
+
+    if (tested == 0)
+        printf("no SIMD row converter to test on this CPU\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * blend.c: alpha blending rows test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the SIMD blending rows give the same results as the C ones,
+ * and reports their throughput. Both are also checked against the generic
+ * blending of the module, in blend_generic.cpp.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../modules/video_filter/blend_rows.c"
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+
+/* Defined in blend_generic.cpp */
+void blend_TestGeneric(const char *, const blend_rows_t *);
+
+#define WIDTH   3840  /* pixels per row */
+#define RUNS    2000  /* rows blended for the throughput */
+
+enum
+{
+    ROW_PLANE,
+    ROW_CHROMA,
+    ROW_CHROMA_SEMI,
+    ROW_YUVA_RGB32,
+    ROW_RGBA_RGB32,
+    ROW_COUNT
+};
+
+static const char *const names[] = {
+    "plane", "chroma", "chroma_semi", "yuva_rgb32", "rgba_rgb32",
+};
+
+/* RGBA, BGRA and ARGB destinations */
+static const blend_rgb32_t offsets[] = {
+    { 0, 1, 2 }, { 2, 1, 0 }, { 1, 2, 3 },
+};
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+struct buffers
+{
+    uint8_t *y, *u, *v, *a, *rgba;
+    uint8_t *dst;
+};
+
+/* Alphas are biased toward the null and opaque values, like in subtitles */
+static void Fill(struct buffers *b)
+{
+    for (size_t i = 0; i < WIDTH + 64; i++)
+    {
+        const unsigned r = Random();
+
+        b->y[i] = r;
+        b->u[i] = r >> 8;
+        b->v[i] = r >> 16;
+        b->a[i] = (r & 3) == 0 ? 0 : (r & 3) == 1 ? 255 : r >> 4;
+    }
+    for (size_t i = 0; i < 4 * (WIDTH + 64); i++)
+        b->rgba[i] = Random();
+}
+
+static void Run(const blend_rows_t *rows, int row, const struct buffers *b,
+                uint8_t *dst, unsigned width, unsigned alpha,
+                const blend_rgb32_t *o)
+{
+    switch (row)
+    {
+        case ROW_PLANE:
+            rows->plane(dst, b->y, b->a, width, alpha);
+            break;
+        case ROW_CHROMA:
+            rows->chroma(dst, dst + WIDTH, b->u, b->v, b->a, width, alpha);
+            break;
+        case ROW_CHROMA_SEMI:
+            rows->chroma_semi(dst, b->u, b->v, b->a, width, alpha);
+            break;
+        case ROW_YUVA_RGB32:
+            rows->yuva_rgb32(dst, b->y, b->u, b->v, b->a, width, alpha, o);
+            break;
+        case ROW_RGBA_RGB32:
+            rows->rgba_rgb32(dst, b->rgba, width, alpha, o);
+            break;
+    }
+}
+
+static void TestRows(const char *name, void (*get)(blend_rows_t *))
+{
+    const size_t bytes = 4 * (WIDTH + 64);
+    uint8_t *buf = malloc(4 * (WIDTH + 64) + 4 * bytes);
+    assert(buf != NULL);
+
+    struct buffers b = {
+        .y = buf, .u = buf + WIDTH + 64, .v = buf + 2 * (WIDTH + 64),
+        .a = buf + 3 * (WIDTH + 64), .rgba = buf + 4 * (WIDTH + 64),
+    };
+    uint8_t *dst_init = b.rgba + bytes;
+    uint8_t *dst_ref = dst_init + bytes, *dst = dst_ref + bytes;
+    blend_rows_t ref, simd;
+
+    blend_GetRowsC(&ref);
+    get(&simd);
+    blend_TestGeneric(name, &simd);
+    Fill(&b);
+    for (size_t i = 0; i < bytes; i++)
+        dst_init[i] = Random();
+
+    for (int row = 0; row < ROW_COUNT; row++)
+    {
+        for (size_t o = 0; o < ARRAY_SIZE(offsets); o++)
+            for (unsigned alpha = 0; alpha <= 255; alpha += 85)
+                for (unsigned width = 1; width <= WIDTH;
+                     width += (width < 80) ? 1 : 97)
+                {
+                    memcpy(dst_ref, dst_init, bytes);
+                    memcpy(dst, dst_init, bytes);
+                    Run(&ref, row, &b, dst_ref, width, alpha, &offsets[o]);
+                    Run(&simd, row, &b, dst, width, alpha, &offsets[o]);
+                    if (memcmp(dst_ref, dst, bytes))
+                    {
+                        fprintf(stderr, "%s %s: mismatch (width %u, "
+                                "alpha %u, offsets %zu)\n", name, names[row],
+                                width, alpha, o);
+                        abort();
+                    }
+                }
+
+        mtime_t ref_time = mdate();
+        for (unsigned i = 0; i < RUNS; i++)
+            Run(&ref, row, &b, dst_ref, WIDTH, 255, &offsets[0]);
+        ref_time = mdate() - ref_time;
+
+        mtime_t simd_time = mdate();
+        for (unsigned i = 0; i < RUNS; i++)
+            Run(&simd, row, &b, dst, WIDTH, 255, &offsets[0]);
+        simd_time = mdate() - simd_time;
+
+        printf("%-6s %-11s: C %7.2f Mpixels/s, SIMD %7.2f Mpixels/s\n",
+               name, names[row], (double)WIDTH * RUNS / __MAX(ref_time, 1),
+               (double)WIDTH * RUNS / __MAX(simd_time, 1));
+    }
+    free(buf);
+}
+
+int main(void)
+{
+    unsigned tested = 0;
+    blend_rows_t rows;
+
+    blend_GetRowsC(&rows);
+    blend_TestGeneric("c", &rows);
+
+#if defined(HAVE_BLEND_SSE4_1)
+    if (vlc_CPU_SSE4_1())
+    {
+        TestRows("sse4.1", blend_GetRowsSSE4_1);
+        tested++;
+    }
+#endif
+#if defined(HAVE_BLEND_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        TestRows("avx2", blend_GetRowsAVX2);
+        tested++;
+    }
+#endif
+
+    if (tested == 0)
+        printf("no SIMD blending row to test on this CPU\n");
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * blend_generic.cpp: alpha blending rows against the generic blending
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Blends pictures of every chroma pair handled by the rows, once with the
+ * generic Blend<> of the module and once with the rows, as the module does,
+ * and checks that the destination pictures are identical.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* The module is built in, as a static one would be */
+#define MODULE_NAME   blend
+#define MODULE_STRING "blend"
+#include "../modules/video_filter/blend.cpp"
+
+/* Built in, the module does not define the name of its messages */
+const char vlc_module_name[] = MODULE_STRING;
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SRC_WIDTH   77  /* not a multiple of the vectors */
+#define SRC_HEIGHT  9
+#define DST_WIDTH   100
+#define DST_HEIGHT  24
+
+extern "C" void blend_TestGeneric(const char *, const blend_rows_t *);
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static picture_t *NewPicture(video_format_t *fmt, vlc_fourcc_t chroma,
+                             unsigned width, unsigned height,
+                             uint32_t rmask, uint32_t gmask, uint32_t bmask)
+{
+    video_format_Setup(fmt, chroma, width, height, width, height, 1, 1);
+    if (chroma == VLC_CODEC_RGB32) {
+        fmt->i_rmask = rmask;
+        fmt->i_gmask = gmask;
+        fmt->i_bmask = bmask;
+        video_format_FixRgb(fmt);
+    }
+
+    picture_t *pic = picture_NewFromFormat(fmt);
+    assert(pic != NULL);
+    for (int i = 0; i < pic->i_planes; i++)
+        for (int y = 0; y < pic->p[i].i_lines; y++)
+            for (int x = 0; x < pic->p[i].i_pitch; x++)
+                pic->p[i].p_pixels[y * pic->p[i].i_pitch + x] = Random();
+    return pic;
+}
+
+static void CopyPlanes(picture_t *dst, const picture_t *src)
+{
+    for (int i = 0; i < src->i_planes; i++)
+        memcpy(dst->p[i].p_pixels, src->p[i].p_pixels,
+               src->p[i].i_pitch * src->p[i].i_lines);
+}
+
+static bool SamePlanes(const picture_t *a, const picture_t *b)
+{
+    for (int i = 0; i < a->i_planes; i++)
+        if (memcmp(a->p[i].p_pixels, b->p[i].p_pixels,
+                   a->p[i].i_pitch * a->p[i].i_lines))
+            return false;
+    return true;
+}
+
+/* Component layouts of the RV32 destinations */
+static const struct {
+    uint32_t r, g, b;
+} masks[] = {
+    { 0x000000ff, 0x0000ff00, 0x00ff0000 },
+    { 0x00ff0000, 0x0000ff00, 0x000000ff },
+    { 0x0000ff00, 0x00ff0000, 0xff000000 },
+};
+
+/* Destination positions, including odd ones the 4:2:0 rows leave to the
+ * generic blending */
+static const struct {
+    unsigned x, y;
+} positions[] = {
+    { 0, 0 }, { 2, 1 }, { 3, 2 }, { 22, 15 },
+};
+
+void blend_TestGeneric(const char *name, const blend_rows_t *rows)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(blends_rows); i++) {
+        const vlc_fourcc_t dst_chroma = blends_rows[i].dst;
+        const vlc_fourcc_t src_chroma = blends_rows[i].src;
+        const size_t mask_count = dst_chroma == VLC_CODEC_RGB32
+                                ? ARRAY_SIZE(masks) : 1;
+        blend_function_t generic = NULL;
+        unsigned handled = 0;
+
+        for (size_t j = 0; j < ARRAY_SIZE(blends); j++)
+            if (blends[j].dst == dst_chroma && blends[j].src == src_chroma)
+                generic = blends[j].blend;
+        assert(generic != NULL);
+
+        for (size_t m = 0; m < mask_count; m++) {
+            video_format_t src_fmt, dst_fmt, ref_fmt;
+            picture_t *src = NewPicture(&src_fmt, src_chroma,
+                                        SRC_WIDTH, SRC_HEIGHT, 0, 0, 0);
+            picture_t *dst = NewPicture(&dst_fmt, dst_chroma,
+                                        DST_WIDTH, DST_HEIGHT,
+                                        masks[m].r, masks[m].g, masks[m].b);
+            picture_t *ref = NewPicture(&ref_fmt, dst_chroma,
+                                        DST_WIDTH, DST_HEIGHT,
+                                        masks[m].r, masks[m].g, masks[m].b);
+            picture_t *init = NewPicture(&ref_fmt, dst_chroma,
+                                         DST_WIDTH, DST_HEIGHT,
+                                         masks[m].r, masks[m].g, masks[m].b);
+
+            for (size_t p = 0; p < ARRAY_SIZE(positions); p++)
+                for (int alpha = 0; alpha <= 255; alpha += 85) {
+                    const CPicture src_data(src, &src_fmt, 0, 0);
+                    const CPicture dst_data(dst, &dst_fmt,
+                                            positions[p].x, positions[p].y);
+                    const CPicture ref_data(ref, &dst_fmt,
+                                            positions[p].x, positions[p].y);
+
+                    CopyPlanes(dst, init);
+                    CopyPlanes(ref, init);
+
+                    generic(ref_data, src_data, SRC_WIDTH, SRC_HEIGHT, alpha);
+                    if (blends_rows[i].blend(rows, dst_data, src_data,
+                                             SRC_WIDTH, SRC_HEIGHT, alpha))
+                        handled++;
+                    else
+                        generic(dst_data, src_data, SRC_WIDTH, SRC_HEIGHT, alpha);
+
+                    if (!SamePlanes(ref, dst)) {
+                        fprintf(stderr, "%s %4.4s onto %4.4s: mismatch "
+                                "(position %u,%u, alpha %d, masks %zu)\n",
+                                name, (const char *)&src_chroma,
+                                (const char *)&dst_chroma, positions[p].x,
+                                positions[p].y, alpha, m);
+                        abort();
+                    }
+                }
+
+            picture_Release(init);
+            picture_Release(ref);
+            picture_Release(dst);
+            picture_Release(src);
+        }
+
+        /* The rows must handle the usual placements themselves */
+        assert(handled > 0);
+        printf("%-6s %4.4s onto %4.4s: same as the generic blending\n",
+               name, (const char *)&src_chroma, (const char *)&dst_chroma);
+    }
+}
@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * deinterlace.c: deinterlacer line kernels test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the SIMD yadif and merge line kernels give the same results as
+ * the C ones, and reports their throughput.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../modules/video_filter/deinterlace/common.h"
+#include "../modules/video_filter/deinterlace/yadif.h"
+#include "../modules/video_filter/deinterlace/merge.c"
+
+/* The included files include config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+
+#define WIDTH   1920  /* samples per line */
+#define PITCH   (WIDTH + 64)
+#define LINES   8     /* lines around the filtered one */
+#define RUNS    2000  /* lines filtered for the throughput */
+
+typedef void (*yadif_line_t)(uint8_t *, uint8_t *, uint8_t *, uint8_t *,
+                             int, int, int, int, int);
+typedef void (*merge_line_t)(void *, const void *, const void *, size_t);
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* Fills the planes with noise, and with smooth areas so that all the
+ * branches of yadif are taken */
+static void Fill(void *p, size_t count, unsigned size, unsigned bits)
+{
+    const unsigned mask = (1u << bits) - 1;
+    unsigned value = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (Random() % 4 == 0)
+            value = Random() & mask;
+        if (size == 1)
+            ((uint8_t *)p)[i] = value;
+        else
+            ((uint16_t *)p)[i] = value;
+    }
+}
+
+/* The kernels may write up to a multiple of step samples, in the padding */
+static void TestYadif(const char *name, yadif_line_t ref, yadif_line_t simd,
+                      unsigned size, unsigned bits, unsigned step)
+{
+    const size_t pitch = PITCH * size;
+    const size_t plane = pitch * LINES;
+    uint8_t *buf = malloc(5 * plane);
+    assert(buf != NULL);
+
+    uint8_t *prev = buf, *cur = buf + plane, *next = buf + 2 * plane;
+    uint8_t *dst_ref = buf + 3 * plane, *dst = buf + 4 * plane;
+    /* The filtered line, with two lines and 32 samples of margins */
+    const size_t offset = pitch * (LINES / 2) + 32 * size;
+
+    Fill(buf, 3 * plane / size, size, bits);
+
+    for (int width = 1; width <= WIDTH; width += (width < 64) ? 1 : 61)
+        for (int parity = 0; parity < 2; parity++)
+            for (int mode = 0; mode <= 2; mode += 2)
+            {
+                memset(dst_ref, 0, plane);
+                memset(dst, 0, plane);
+                ref(dst_ref + offset, prev + offset, cur + offset,
+                    next + offset, width * size, pitch, -(int)pitch,
+                    parity, mode);
+                simd(dst + offset, prev + offset, cur + offset,
+                     next + offset, width * size, pitch, -(int)pitch,
+                     parity, mode);
+                const size_t end = offset + width * size;
+                const size_t padded = offset + (width + step - 1) / step * step * size;
+                if (memcmp(dst_ref, dst, end)
+                 || memcmp(dst_ref + padded, dst + padded, plane - padded))
+                {
+                    fprintf(stderr, "%s: mismatch (width %d, parity %d, "
+                            "mode %d)\n", name, width, parity, mode);
+                    abort();
+                }
+            }
+
+    mtime_t ref_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+        ref(dst_ref + offset, prev + offset, cur + offset, next + offset,
+            WIDTH * size, pitch, -(int)pitch, i & 1, 0);
+    ref_time = mdate() - ref_time;
+
+    mtime_t simd_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+        simd(dst + offset, prev + offset, cur + offset, next + offset,
+             WIDTH * size, pitch, -(int)pitch, i & 1, 0);
+    simd_time = mdate() - simd_time;
+
+    printf("%-16s %2u-bit: C %6.2f Msamples/s, SIMD %7.2f Msamples/s\n",
+           name, bits, (double)WIDTH * RUNS / __MAX(ref_time, 1),
+           (double)WIDTH * RUNS / __MAX(simd_time, 1));
+    free(buf);
+}
+
+#if defined(HAVE_YADIF_MMX)
+/* Leaves the MMX state before any floating point computation */
+static void yadif_filter_line_mmx_emms(uint8_t *dst, uint8_t *prev,
+                                       uint8_t *cur, uint8_t *next, int w,
+                                       int prefs, int mrefs, int parity,
+                                       int mode)
+{
+    yadif_filter_line_mmx(dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+    __asm__ __volatile__ ("emms");
+}
+#endif
+
+#if defined(HAVE_AVX2_INTRINSICS)
+static void TestMerge(const char *name, merge_line_t ref, merge_line_t simd,
+                      unsigned size)
+{
+    const size_t bytes = PITCH * size;
+    uint8_t *buf = malloc(4 * bytes);
+    assert(buf != NULL);
+
+    uint8_t *s1 = buf, *s2 = buf + bytes;
+    uint8_t *dst_ref = buf + 2 * bytes, *dst = buf + 3 * bytes;
+
+    Fill(buf, 2 * bytes / size, size, 8 * size);
+
+    /* Misaligned starts and tails of all sizes */
+    for (size_t start = 0; start < 4; start++)
+        for (size_t count = 0; count < 80; count++)
+        {
+            const size_t off = start * size, len = count * size;
+
+            memset(dst_ref, 0, bytes);
+            memset(dst, 0, bytes);
+            ref(dst_ref + off, s1 + off, s2 + off, len);
+            simd(dst + off, s1 + off, s2 + off, len);
+            if (memcmp(dst_ref, dst, bytes))
+            {
+                fprintf(stderr, "%s: mismatch (start %zu, count %zu)\n",
+                        name, start, count);
+                abort();
+            }
+        }
+
+    mtime_t ref_time = mdate();
+    for (unsigned i = 0; i < 10 * RUNS; i++)
+        ref(dst_ref, s1, s2, WIDTH * size);
+    ref_time = mdate() - ref_time;
+
+    mtime_t simd_time = mdate();
+    for (unsigned i = 0; i < 10 * RUNS; i++)
+        simd(dst, s1, s2, WIDTH * size);
+    simd_time = mdate() - simd_time;
+
+    printf("%-16s %2u-bit: C %6.2f Msamples/s, SIMD %7.2f Msamples/s\n",
+           name, 8 * size, (double)WIDTH * 10 * RUNS / __MAX(ref_time, 1),
+           (double)WIDTH * 10 * RUNS / __MAX(simd_time, 1));
+    free(buf);
+}
+#endif
+
+int main(void)
+{
+    unsigned tested = 0;
+
+#if !defined(HAVE_YADIF_AVX2)
+    (void) yadif_filter_line_c_16bit; /* only AVX2 has 16-bit kernels */
+#endif
+
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        TestYadif("yadif avx2", yadif_filter_line_c,
+                  yadif_filter_line_avx2, 1, 8, 1);
+        TestYadif("yadif avx2", yadif_filter_line_c_16bit,
+                  yadif_filter_line_16bit_avx2, 2, 10, 1);
+        TestYadif("yadif avx2", yadif_filter_line_c_16bit,
+                  yadif_filter_line_16bit_avx2, 2, 16, 1);
+        tested++;
+    }
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+    if (vlc_CPU_SSSE3())
+    {
+        TestYadif("yadif ssse3", yadif_filter_line_c,
+                  yadif_filter_line_ssse3, 1, 8, 8);
+        tested++;
+    }
+#endif
+#if defined(HAVE_YADIF_SSE2)
+    if (vlc_CPU_SSE2())
+    {
+        TestYadif("yadif sse2", yadif_filter_line_c,
+                  yadif_filter_line_sse2, 1, 8, 8);
+        tested++;
+    }
+#endif
+#if defined(HAVE_YADIF_MMX)
+    if (vlc_CPU_MMX())
+    {
+        TestYadif("yadif mmx", yadif_filter_line_c,
+                  yadif_filter_line_mmx_emms, 1, 8, 4);
+        tested++;
+    }
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if (vlc_CPU_AVX2())
+    {
+        TestMerge("merge avx2", Merge8BitGeneric, Merge8BitAVX2, 1);
+        TestMerge("merge avx2", Merge16BitGeneric, Merge16BitAVX2, 2);
+        tested++;
+    }
+#endif
+#if defined(HAVE_YADIF_NEON)
+    TestYadif("yadif neon", yadif_filter_line_c, yadif_filter_line_neon, 1, 8, 1);
+    tested++;
+#endif
+
+    if (tested == 0)
+        printf("no SIMD line kernel to test on this CPU\n");
+    return 0;
+}
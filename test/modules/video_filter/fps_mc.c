@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * fps_mc.c: fps motion compensation test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the SIMD functions give the same results as the C ones, that
+ * the motion estimation finds a translation and that the compensation
+ * interpolates it, and that unrelated pictures are not matched.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../modules/video_filter/fps_mc.c"
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+
+#define WIDTH   256
+#define HEIGHT  192
+#define RUNS    200000  /* blocks compared for the throughput */
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void TestFunctions(const char *name,
+                          void (*get)(fps_mc_functions_t *))
+{
+    uint8_t a[64 * 16], b[64 * 16], dst_ref[64], dst[64];
+    fps_mc_functions_t ref, simd;
+
+    fps_mc_GetFunctionsC(&ref);
+    get(&simd);
+    for (size_t i = 0; i < sizeof (a); i++)
+    {
+        a[i] = Random();
+        b[i] = (i & 1) ? a[i] ^ (Random() & 15) : Random();
+    }
+
+    for (unsigned offset = 0; offset < 16; offset++)
+    {
+        const unsigned sad = ref.sad16(a + offset, 64, b + 2 * offset, 64);
+        assert(sad == simd.sad16(a + offset, 64, b + 2 * offset, 64));
+    }
+    memset(b, 255, sizeof (b));
+    memset(a, 0, sizeof (a));
+    const unsigned sad = simd.sad16(a, 64, b, 64);
+    assert(sad == 255 * 256);
+
+    for (size_t i = 0; i < sizeof (a); i++)
+        a[i] = Random();
+    for (unsigned phase = 1; phase <= 255; phase += 7)
+        for (unsigned width = 1; width <= 64; width++)
+        {
+            memset(dst_ref, 0, sizeof (dst_ref));
+            memset(dst, 0, sizeof (dst));
+            ref.blend(dst_ref, a, a + 64 + width, width, phase);
+            simd.blend(dst, a, a + 64 + width, width, phase);
+            if (memcmp(dst_ref, dst, sizeof (dst)))
+            {
+                fprintf(stderr, "%s blend: mismatch (width %u, phase %u)\n",
+                        name, width, phase);
+                abort();
+            }
+        }
+
+    unsigned sum = 0;
+    mtime_t ref_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+        sum += ref.sad16(a + (i & 15), 64, b + (i & 31), 64);
+    ref_time = mdate() - ref_time;
+
+    mtime_t simd_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+        sum -= simd.sad16(a + (i & 15), 64, b + (i & 31), 64);
+    simd_time = mdate() - simd_time;
+    assert(sum == 0);
+
+    printf("%-5s sad16: C %7.2f Mblocks/s, SIMD %7.2f Mblocks/s\n", name,
+           (double)RUNS / __MAX(ref_time, 1),
+           (double)RUNS / __MAX(simd_time, 1));
+}
+
+/* Smooth texture, so that the costs lead the search to the motion */
+static double Texture(double x, double y)
+{
+    return 128. + 50. * sin(x * .19 + y * .05) + 40. * cos(y * .23 - x * .07)
+         + 20. * sin((x + y) * .011 * (x - y) * .05);
+}
+
+static void Draw(picture_t *pic, int dx, int dy, unsigned seed_noise)
+{
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *p = &pic->p[i];
+        const int sub = i == 0 ? 1 : 2;
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            for (int x = 0; x < p->i_visible_pitch; x++)
+            {
+                double v = Texture(x * sub + dx, y * sub + dy);
+
+                if (seed_noise)
+                    v = Random() & 255;
+                p->p_pixels[y * p->i_pitch + x] = lround(v);
+            }
+    }
+}
+
+static void TestMotion(void)
+{
+    video_format_t fmt;
+    fps_mc_functions_t functions;
+    fps_mc_field_t field;
+
+    video_format_Setup(&fmt, VLC_CODEC_I420, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                       1, 1);
+    fps_mc_GetFunctionsC(&functions);
+    int ret = fps_mc_Init(&field, WIDTH, HEIGHT,
+                          vlc_fourcc_GetChromaDescription(VLC_CODEC_I420),
+                          &functions);
+    assert(ret == VLC_SUCCESS);
+    assert(field.blocks_x == WIDTH / 16 && field.blocks_y == HEIGHT / 16);
+
+    picture_t *a = picture_NewFromFormat(&fmt);
+    picture_t *b = picture_NewFromFormat(&fmt);
+    picture_t *out = picture_NewFromFormat(&fmt);
+    picture_t *expected = picture_NewFromFormat(&fmt);
+    assert(a && b && out && expected);
+
+    /* B shows the content of A at (x + 12, y - 8), so that the picture
+     * half-way shows it at (x + 6, y - 4) */
+    Draw(a, 0, 0, 0);
+    Draw(b, 12, -8, 0);
+    Draw(expected, 6, -4, 0);
+
+    /* The vectors converge over a few pictures, as the bands predict each
+     * other. They must not depend on the order of the bands, which are
+     * estimated concurrently. */
+    const unsigned bands = fps_mc_CountBands(&field);
+    const size_t size = field.blocks_x * field.blocks_y
+                      * sizeof (*field.vectors);
+    fps_mc_vector_t *forward = malloc(size);
+    assert(forward != NULL);
+
+    for (int order = 0; order < 2; order++)
+    {
+        memset(field.vectors, 0, size);
+        memset(field.previous, 0, size);
+        for (unsigned i = 0; i < 3; i++)
+        {
+            fps_mc_NewPicture(&field);
+            for (unsigned band = 0; band < bands; band++)
+            {
+                unsigned begin, end;
+
+                fps_mc_Band(&field, order ? bands - 1 - band : band,
+                            &begin, &end);
+                fps_mc_Estimate(&field, a, b, 128, begin, end);
+            }
+        }
+        if (order == 0)
+            memcpy(forward, field.vectors, size);
+    }
+    assert(!memcmp(forward, field.vectors, size));
+    free(forward);
+
+    /* Blocks on the edges may not reach the matching content */
+    unsigned estimated, found = 0;
+    const unsigned unmatched = fps_mc_CountUnmatched(&field, &estimated);
+    assert(estimated == field.blocks_x * field.blocks_y);
+    assert(unmatched <= 2 * (field.blocks_x + field.blocks_y));
+    for (unsigned y = 1; y + 1 < field.blocks_y; y++)
+        for (unsigned x = 1; x + 1 < field.blocks_x; x++)
+        {
+            const fps_mc_vector_t *v = &field.vectors[y * field.blocks_x + x];
+            if (v->x == 12 && v->y == -8)
+                found++;
+        }
+    printf("translation found on %u of %u inner blocks\n", found,
+           (field.blocks_x - 2) * (field.blocks_y - 2));
+    assert(found == (field.blocks_x - 2) * (field.blocks_y - 2));
+
+    /* The interpolated luma matches the texture away from the edges, where
+     * the displaced blocks may be clamped */
+    fps_mc_Compensate(&field, &functions, out, a, b, 128, 0, field.blocks_y);
+    const plane_t *o = &out->p[Y_PLANE], *e = &expected->p[Y_PLANE];
+    unsigned long error = 0, count = 0;
+    for (int y = 16; y < HEIGHT - 16; y++)
+        for (int x = 16; x < WIDTH - 16; x++, count++)
+            error += abs(o->p_pixels[y * o->i_pitch + x]
+                         - e->p_pixels[y * e->i_pitch + x]);
+    printf("compensation mean error %.2f\n", (double)error / count);
+    assert(error <= count);
+
+    /* Unrelated pictures, as on a scene change */
+    Draw(b, 0, 0, 1);
+    fps_mc_NewPicture(&field);
+    fps_mc_Estimate(&field, a, b, 64, 0, field.blocks_y);
+    const unsigned changed = fps_mc_CountUnmatched(&field, &estimated);
+    printf("scene change: %u of %u blocks unmatched\n", changed, estimated);
+    assert(2 * changed > estimated);
+
+    picture_Release(expected);
+    picture_Release(out);
+    picture_Release(b);
+    picture_Release(a);
+    fps_mc_Clean(&field);
+}
+
+int main(void)
+{
+    TestMotion();
+
+#if defined(HAVE_FPS_MC_SSE2)
+    if (vlc_CPU_SSE2())
+        TestFunctions("sse2", fps_mc_GetFunctionsSSE2);
+#endif
+#if defined(HAVE_FPS_MC_AVX2)
+    if (vlc_CPU_AVX2())
+        TestFunctions("avx2", fps_mc_GetFunctionsAVX2);
+#endif
+#if defined(HAVE_FPS_MC_NEON)
+    if (vlc_CPU_ARM_NEON())
+        TestFunctions("neon", fps_mc_GetFunctionsNEON);
+#endif
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*****************************************************************************
+ * gaussianblur.c: gaussian blur rows test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks the gaussian kernels, checks that the SIMD blurring rows give the
+ * same results as the C ones, and reports their throughput.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../modules/video_filter/blur_rows.c"
+
+/* The included file includes config.h again, which may define NDEBUG */
+#undef NDEBUG
+#include <assert.h>
+
+#define WIDTH   3840  /* pixels per row */
+#define RUNS    200   /* rows blurred for the throughput */
+#define SIGMA_MAX 6.
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void TestKernels(void)
+{
+    static const double sigmas[] = { 0.01, 0.4, 1., 2., 7.3, 50., 1000. };
+
+    for (size_t i = 0; i < ARRAY_SIZE(sigmas); i++)
+    {
+        uint32_t *weights = malloc(((unsigned)(3. * sigmas[i]) + 1)
+                                   * sizeof (*weights));
+        assert(weights != NULL);
+
+        const unsigned radius = blur_Kernel(weights, sigmas[i]);
+        uint32_t sum = weights[0];
+
+        assert(radius <= 3. * sigmas[i]);
+        assert(weights[0] > 0);
+        for (unsigned k = 1; k <= radius; k++)
+            sum += 2 * weights[k];
+        assert(sum == 1u << BLUR_WEIGHT_BITS);
+        free(weights);
+    }
+}
+
+/* Fills samples no greater than max */
+static void Fill(uint16_t *p, size_t count, unsigned max)
+{
+    for (size_t i = 0; i < count; i++)
+        p[i] = Random() % (max + 1);
+}
+
+static void TestRows(const char *name, void (*get)(blur_rows_t *))
+{
+    static const unsigned depths[] = { 8, 10, 16 };
+    static const double sigmas[] = { 0.4, 2., SIGMA_MAX };
+    const unsigned dim = 3. * SIGMA_MAX;
+    const size_t count = WIDTH + 2 * dim;
+    uint16_t *src = malloc((2 * dim + 1) * count * sizeof (*src));
+    uint16_t *dst_ref = malloc(2 * WIDTH * sizeof (*dst_ref));
+    uint16_t *dst = malloc(2 * WIDTH * sizeof (*dst));
+    const uint16_t *rows[2 * dim + 1];
+    uint32_t weights[dim + 1];
+    blur_rows_t ref, simd;
+
+    assert(src != NULL && dst_ref != NULL && dst != NULL);
+    blur_GetRowsC(&ref);
+    get(&simd);
+
+    for (size_t d = 0; d < ARRAY_SIZE(depths); d++)
+        for (size_t s = 0; s < ARRAY_SIZE(sigmas); s++)
+        {
+            const unsigned depth = depths[d];
+            const unsigned radius = blur_Kernel(weights, sigmas[s]);
+            const unsigned vshift = 2 * BLUR_WEIGHT_BITS - depth;
+
+            for (unsigned k = 0; k <= 2 * radius; k++)
+                rows[k] = &src[k * count];
+
+            for (unsigned width = 1; width <= WIDTH;
+                 width += (width < 80) ? 1 : 97)
+            {
+                /* Horizontally from samples */
+                Fill(src, count, (1u << depth) - 1);
+                ref.horizontal(dst_ref, &src[radius], width, weights, radius,
+                               depth);
+                simd.horizontal(dst, &src[radius], width, weights, radius,
+                                depth);
+                if (memcmp(dst_ref, dst, width * sizeof (*dst)))
+                {
+                    fprintf(stderr, "%s horizontal: mismatch (width %u, "
+                            "depth %u, radius %u)\n", name, width, depth,
+                            radius);
+                    abort();
+                }
+
+                /* Vertically from horizontally blurred samples */
+                Fill(src, (2 * radius + 1) * count,
+                     ((1u << depth) - 1) << (16 - depth));
+                if (depth == 8)
+                {
+                    ref.vertical8((uint8_t *)dst_ref, rows, width, weights,
+                                  radius, vshift);
+                    simd.vertical8((uint8_t *)dst, rows, width, weights,
+                                   radius, vshift);
+                }
+                else
+                {
+                    ref.vertical16(dst_ref, rows, width, weights, radius,
+                                   vshift);
+                    simd.vertical16(dst, rows, width, weights, radius,
+                                    vshift);
+                }
+                if (memcmp(dst_ref, dst, width * (depth > 8 ? 2 : 1)))
+                {
+                    fprintf(stderr, "%s vertical: mismatch (width %u, "
+                            "depth %u, radius %u)\n", name, width, depth,
+                            radius);
+                    abort();
+                }
+            }
+        }
+
+    /* Both passes of an 8-bit plane */
+    const unsigned radius = blur_Kernel(weights, 2.);
+    mtime_t ref_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        ref.horizontal(dst_ref, &src[radius], WIDTH, weights, radius, 8);
+        ref.vertical8((uint8_t *)dst_ref, rows, WIDTH, weights, radius, 24);
+    }
+    ref_time = mdate() - ref_time;
+
+    mtime_t simd_time = mdate();
+    for (unsigned i = 0; i < RUNS; i++)
+    {
+        simd.horizontal(dst, &src[radius], WIDTH, weights, radius, 8);
+        simd.vertical8((uint8_t *)dst, rows, WIDTH, weights, radius, 24);
+    }
+    simd_time = mdate() - simd_time;
+
+    printf("%-6s sigma 2: C %7.2f Mpixels/s, SIMD %7.2f Mpixels/s\n", name,
+           (double)WIDTH * RUNS / __MAX(ref_time, 1),
+           (double)WIDTH * RUNS / __MAX(simd_time, 1));
+
+    free(dst);
+    free(dst_ref);
+    free(src);
+}
+
+int main(void)
+{
+    unsigned tested = 0;
+
+    TestKernels();
+
+#if defined(HAVE_BLUR_SSE4_1)
+    if (vlc_CPU_SSE4_1())
+    {
+        TestRows("sse4.1", blur_GetRowsSSE4_1);
+        tested++;
+    }
+#endif
+#if defined(HAVE_BLUR_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        TestRows("avx2", blur_GetRowsAVX2);
+        tested++;
+    }
+#endif
+#if defined(HAVE_BLUR_NEON)
+    if (vlc_CPU_ARM_NEON())
+    {
+        TestRows("neon", blur_GetRowsNEON);
+        tested++;
+    }
+#endif
+
+    if (tested == 0)
+        printf("no SIMD blurring row to test on this CPU\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * hqdn3d.c: high-quality 3D denoiser test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *****************************************************************************/
+
+/*
+ * Checks that the vectorized denoiser gives the same results as the C one,
+ * over a few frames of 8 and 10-bit samples, and reports their throughput.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../modules/video_filter/hqdn3d.h"
+
+#define WIDTH   1283  /* not a multiple of the vectors */
+#define HEIGHT  101
+#define FRAMES  4
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* A gradient with some noise */
+static void Fill(uint8_t *p, int size, int depth)
+{
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < WIDTH; x++)
+        {
+            unsigned v = ((x + y) % 256) + Random() % 24;
+
+            v = __MIN(v, 255u) << (depth - 8);
+            StorePixel(&p[y * WIDTH * size], x, size, v);
+        }
+}
+
+static void TestDenoise(const char *name, denoise_t denoise)
+{
+    static const double strengths[][2] = {
+        { 4., 6. }, { 0., 6. }, { 4., 0. }, { 30., 40. },
+    };
+    static int coefs[2][512 * 16];
+    const size_t bytes = 2 * WIDTH * HEIGHT;
+    uint8_t *src = malloc(bytes), *dst_ref = malloc(bytes);
+    uint8_t *dst = malloc(bytes);
+    unsigned int *line = malloc(WIDTH * sizeof (*line));
+    unsigned int *rows = malloc(HQDN3D_ROWS * WIDTH * sizeof (*rows));
+
+    assert(src && dst_ref && dst && line && rows);
+
+    for (int size = 1; size <= 2; size++)
+        for (size_t s = 0; s < ARRAY_SIZE(strengths); s++)
+        {
+            const int depth = size == 1 ? 8 : 10;
+            const int shift = 24 - depth;
+
+            PrecalcCoefs(coefs[0], strengths[s][0]);
+            PrecalcCoefs(coefs[1], strengths[s][1]);
+            Fill(src, size, depth);
+
+            unsigned short *ant_ref = deNoiseInit(src, WIDTH, HEIGHT,
+                                                  WIDTH * size, size, shift);
+            unsigned short *ant = deNoiseInit(src, WIDTH, HEIGHT,
+                                              WIDTH * size, size, shift);
+            assert(ant_ref != NULL && ant != NULL);
+
+            for (int i = 0; i < FRAMES; i++)
+            {
+                Fill(src, size, depth);
+                deNoise(src, dst_ref, line, rows, ant_ref, WIDTH, HEIGHT,
+                        WIDTH * size, WIDTH * size, size, shift,
+                        coefs[0], coefs[0], coefs[1]);
+                denoise(src, dst, line, rows, ant, WIDTH, HEIGHT,
+                        WIDTH * size, WIDTH * size, size, shift,
+                        coefs[0], coefs[0], coefs[1]);
+                if (memcmp(dst_ref, dst, WIDTH * HEIGHT * size)
+                 || memcmp(ant_ref, ant, WIDTH * HEIGHT * sizeof (*ant)))
+                {
+                    fprintf(stderr, "%s: mismatch (depth %d, strengths "
+                            "%.0f %.0f, frame %d)\n", name, depth,
+                            strengths[s][0], strengths[s][1], i);
+                    abort();
+                }
+            }
+
+            if (size == 1 && s == 0)
+            {
+                mtime_t ref_time = mdate();
+                for (int i = 0; i < FRAMES; i++)
+                    deNoise(src, dst_ref, line, rows, ant_ref, WIDTH, HEIGHT,
+                            WIDTH, WIDTH, 1, shift, coefs[0], coefs[0],
+                            coefs[1]);
+                ref_time = mdate() - ref_time;
+
+                mtime_t time = mdate();
+                for (int i = 0; i < FRAMES; i++)
+                    denoise(src, dst, line, rows, ant, WIDTH, HEIGHT,
+                            WIDTH, WIDTH, 1, shift, coefs[0], coefs[0],
+                            coefs[1]);
+                time = mdate() - time;
+
+                printf("%-5s: C %7.2f Mpixels/s, SIMD %7.2f Mpixels/s\n",
+                       name,
+                       (double)WIDTH * HEIGHT * FRAMES / __MAX(ref_time, 1),
+                       (double)WIDTH * HEIGHT * FRAMES / __MAX(time, 1));
+            }
+            free(ant);
+            free(ant_ref);
+        }
+
+    free(rows);
+    free(line);
+    free(dst);
+    free(dst_ref);
+    free(src);
+}
+
+int main(void)
+{
+    unsigned tested = 0;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+    {
+        TestDenoise("avx2", deNoiseAVX2);
+        tested++;
+    }
+#endif
+
+    if (tested == 0)
+        printf("no vectorized denoiser to test on this CPU\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * thumbnailer.c: keyframe thumbnailer test
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Extracts pictures of the sample image by position and by time, and checks
+ * that a missing file fails and that the timeout interrupts a stalled
+ * input.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_input_item.h>
+#include <vlc_thumbnailer.h>
+#include <vlc_url.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define TIMEOUT (5 * CLOCK_FREQ)
+
+static input_item_t *NewItem(const char *psz_uri)
+{
+    input_item_t *p_item = input_item_NewFile(psz_uri, "test thumbnail", 0,
+                                              ITEM_LOCAL);
+    assert(p_item != NULL);
+    return p_item;
+}
+
+static void TestImage(vlc_object_t *obj)
+{
+    char *psz_uri = vlc_path2uri(SRCDIR "/samples/image.jpg", NULL);
+    assert(psz_uri != NULL);
+    input_item_t *p_item = NewItem(psz_uri);
+    free(psz_uri);
+
+    /* The picture has the size of the 1x1 image */
+    picture_t *p_pic = vlc_thumbnailer_Extract(obj, p_item, -1, .5, TIMEOUT);
+    assert(p_pic != NULL);
+    assert(p_pic->format.i_visible_width == 1);
+    assert(p_pic->format.i_visible_height == 1);
+    picture_Release(p_pic);
+
+    p_pic = vlc_thumbnailer_Extract(obj, p_item, 0, 0., TIMEOUT);
+    assert(p_pic != NULL);
+    picture_Release(p_pic);
+
+    input_item_Release(p_item);
+}
+
+static void TestMissing(vlc_object_t *obj)
+{
+    input_item_t *p_item = NewItem("file:///nonexistent/thumbnail.jpg");
+
+    assert(vlc_thumbnailer_Extract(obj, p_item, -1, 0., TIMEOUT) == NULL);
+    input_item_Release(p_item);
+}
+
+/* A pipe that never gets data: only the timeout ends the probing */
+static void TestTimeout(vlc_object_t *obj)
+{
+    int p_pipe[2];
+    int i_ret = vlc_pipe(p_pipe);
+    assert(i_ret == 0);
+    (void) i_ret;
+
+    char psz_uri[strlen("fd://") + 11];
+    sprintf(psz_uri, "fd://%u", (unsigned) p_pipe[0]);
+    input_item_t *p_item = NewItem(psz_uri);
+
+    const mtime_t i_start = mdate();
+    assert(vlc_thumbnailer_Extract(obj, p_item, -1, 0.,
+                                   CLOCK_FREQ / 10) == NULL);
+    assert(mdate() - i_start < TIMEOUT);
+
+    input_item_Release(p_item);
+    vlc_close(p_pipe[0]);
+    vlc_close(p_pipe[1]);
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+    alarm(10); /* Make sure "make check" does not get stuck */
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    TestImage(obj);
+    TestMissing(obj);
+    TestTimeout(obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * filter_chain.c: test views passed between chained video filters
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Flips RV32 pictures with transform, which returns views with negative
+ * pitches, and checks what the next filter (invert) and the owner get.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define WIDTH  200 /* not a multiple of the 64 bytes inverted at once */
+#define HEIGHT 48
+
+static picture_t *BufferNew(filter_t *filter)
+{
+    return picture_NewFromFormat(&filter->fmt_out.video);
+}
+
+static uint32_t *Pixel(const picture_t *pic, int x, int y)
+{
+    return (uint32_t *)&pic->p[0].p_pixels[y * pic->p[0].i_pitch + 4 * x];
+}
+
+static filter_chain_t *Create(vlc_object_t *parent, const char *filters,
+                              const filter_owner_t *owner)
+{
+    es_format_t fmt;
+
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_RGB32);
+    video_format_Setup(&fmt.video, VLC_CODEC_RGB32, WIDTH, HEIGHT,
+                       WIDTH, HEIGHT, 1, 1);
+    video_format_FixRgb(&fmt.video);
+
+    filter_chain_t *chain = filter_chain_NewVideo(parent, false, owner);
+    assert(chain != NULL);
+    filter_chain_Reset(chain, &fmt, &fmt);
+    es_format_Clean(&fmt);
+
+    if (filter_chain_AppendFromString(chain, filters) < 0)
+    {
+        filter_chain_Delete(chain);
+        return NULL;
+    }
+    return chain;
+}
+
+/* Runs a few pictures through the chain, so that the intermediate pictures
+ * get recycled, and checks each output against the input */
+static int Test(vlc_object_t *parent, const char *filters,
+                const filter_owner_t *owner, uint32_t mask, bool view)
+{
+    filter_chain_t *chain = Create(parent, filters, owner);
+    if (chain == NULL)
+    {
+        printf("%-24s: filters not found, skipped\n", filters);
+        return VLC_SUCCESS;
+    }
+
+    const video_format_t *fmt = &filter_chain_GetFmtOut(chain)->video;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        picture_t *src = picture_NewFromFormat(fmt);
+        assert(src != NULL);
+        for (int y = 0; y < HEIGHT; y++)
+            for (int x = 0; x < WIDTH; x++)
+                *Pixel(src, x, y) = (i << 24) | (y << 12) | x;
+        src->date = i;
+
+        picture_t *out = filter_chain_VideoFilter(chain, picture_Hold(src));
+        assert(out != NULL);
+        assert(out->date == (mtime_t)i);
+        assert((out->p[0].i_pitch < 0) == view);
+        for (int y = 0; y < HEIGHT; y++)
+            for (int x = 0; x < WIDTH; x++)
+                if (*Pixel(out, x, y) != (*Pixel(src, x, HEIGHT - 1 - y)
+                                          ^ mask))
+                {
+                    fprintf(stderr, "%s: mismatch at %dx%d\n", filters,
+                            x, y);
+                    return VLC_EGENERIC;
+                }
+        picture_Release(out);
+        picture_Release(src);
+    }
+    printf("%-24s: ok\n", filters);
+    filter_chain_Delete(chain);
+    return VLC_SUCCESS;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+
+    vlc_object_t *parent = VLC_OBJECT(vlc->p_libvlc_int);
+    const filter_owner_t owner = {
+        .video = { .buffer_new = BufferNew },
+    };
+    int ret = VLC_SUCCESS;
+
+    /* The next filter gets the flipped pixels with a positive pitch */
+    ret |= Test(parent, "transform{type=vflip}:invert", NULL,
+                0xffffffff, false);
+    ret |= Test(parent, "transform{type=vflip}:invert", &owner,
+                0xffffffff, false);
+    /* The flip is free at the end of a chain without owner pictures, and
+     * copied into the owner pictures otherwise */
+    ret |= Test(parent, "transform{type=vflip}", NULL, 0, true);
+    ret |= Test(parent, "transform{type=vflip}", &owner, 0, false);
+
+    libvlc_release(vlc);
+    return ret == VLC_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * picture.c: test picture views
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+/* Before test.h, which defines log() */
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+#include "../../libvlc/test.h"
+#include <assert.h>
+
+static uint8_t *pixel( const picture_t *pic, int plane, int x, int y )
+{
+    return &pic->p[plane].p_pixels[y * pic->p[plane].i_pitch + x];
+}
+
+static void fill( picture_t *pic )
+{
+    for( int i = 0; i < pic->i_planes; i++ )
+        for( int y = 0; y < pic->p[i].i_lines; y++ )
+            for( int x = 0; x < pic->p[i].i_pitch; x++ )
+                *pixel( pic, i, x, y ) = y * 7 + x + i * 50;
+}
+
+int main( void )
+{
+    test_init();
+
+    picture_t *pic = picture_New( VLC_CODEC_I420, 64, 48, 1, 1 );
+    assert( pic != NULL );
+    fill( pic );
+
+    /* Crop */
+    picture_t *view = picture_NewView( pic, 4, 6, 32, 20, false );
+    assert( view != NULL );
+    assert( view->format.i_visible_width == 32 );
+    assert( view->format.i_visible_height == 20 );
+    assert( view->p[1].i_visible_pitch == 16 );
+    assert( view->p[1].i_visible_lines == 10 );
+    assert( pixel( view, 0, 0, 0 ) == pixel( pic, 0, 4, 6 ) );
+    assert( pixel( view, 1, 1, 2 ) == pixel( pic, 1, 3, 5 ) );
+
+    /* Rectangles not on chroma samples or out of the picture */
+    assert( picture_NewView( pic, 3, 6, 32, 20, false ) == NULL );
+    assert( picture_NewView( pic, 4, 5, 32, 20, false ) == NULL );
+    assert( picture_NewView( pic, 48, 0, 32, 20, false ) == NULL );
+
+    /* Vertical flip, of the picture and of the flipped view */
+    picture_t *flip = picture_NewView( pic, 0, 0, 64, 48, true );
+    assert( flip != NULL );
+    assert( flip->p[0].i_pitch == -pic->p[0].i_pitch );
+    assert( pixel( flip, 0, 5, 0 ) == pixel( pic, 0, 5, 47 ) );
+    assert( pixel( flip, 2, 3, 5 ) == pixel( pic, 2, 3, 18 ) );
+
+    picture_t *unflip = picture_NewView( flip, 0, 0, 64, 48, true );
+    assert( unflip != NULL );
+    assert( unflip->p[0].p_pixels == pic->p[0].p_pixels );
+    assert( unflip->p[0].i_pitch == pic->p[0].i_pitch );
+
+    /* Copy out of a flipped view */
+    picture_t *copy = picture_New( VLC_CODEC_I420, 64, 48, 1, 1 );
+    assert( copy != NULL );
+    picture_Copy( copy, flip );
+    for( int y = 0; y < 48; y++ )
+        assert( *pixel( copy, 0, 9, y ) == *pixel( pic, 0, 9, 47 - y ) );
+
+    /* The views keep the picture alive */
+    picture_Release( pic );
+    assert( *pixel( view, 0, 0, 0 ) == (uint8_t)(6 * 7 + 4) );
+    picture_Release( unflip );
+    picture_Release( flip );
+    picture_Release( view );
+    picture_Release( copy );
+
+    /* Packed 4:2:2 macropixels are not split */
+    pic = picture_New( VLC_CODEC_YUYV, 64, 48, 1, 1 );
+    assert( pic != NULL );
+    assert( picture_NewView( pic, 1, 0, 8, 8, false ) == NULL );
+    view = picture_NewView( pic, 2, 0, 8, 8, true );
+    assert( view != NULL );
+    assert( view->p[0].p_pixels == pixel( pic, 0, 4, 7 ) );
+    picture_Release( view );
+    picture_Release( pic );
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * slices.c: test slice-parallel jobs
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_slices.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#define MAX_SLICES 64
+
+/* The slices must cover the rows in order, without overlap, on aligned
+ * boundaries (but the end of the last one), and be as even as possible */
+static void TestRows(unsigned rows, unsigned count, unsigned align)
+{
+    unsigned next = 0, min = rows, max = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        unsigned begin, end;
+
+        vlc_slice_Rows(rows, i, count, align, &begin, &end);
+        assert(begin == next);
+        assert(begin <= end && end <= rows);
+        assert(begin % align == 0);
+        assert(end % align == 0 || i == count - 1);
+        next = end;
+
+        if (end - begin < min)
+            min = end - begin;
+        if (end - begin > max)
+            max = end - begin;
+    }
+    assert(next == rows);
+
+    /* Slices only get empty with more slices than rows */
+    if (align == 1)
+    {
+        assert(max - min <= 1);
+        assert(min > 0 || count > rows);
+    }
+}
+
+struct job
+{
+    unsigned count;
+    atomic_uint calls[MAX_SLICES];
+};
+
+static void Slice(void *opaque, unsigned index, unsigned count)
+{
+    struct job *job = opaque;
+
+    assert(count == job->count);
+    assert(index < count);
+    atomic_fetch_add(&job->calls[index], 1);
+}
+
+static void TestRun(vlc_object_t *obj, unsigned count)
+{
+    struct job job = { .count = count };
+
+    for (unsigned i = 0; i < count; i++)
+        atomic_init(&job.calls[i], 0);
+
+    vlc_slices_Run(obj, count, Slice, &job);
+
+    /* Every slice ran exactly once when vlc_slices_Run() returns */
+    for (unsigned i = 0; i < count; i++)
+        assert(atomic_load(&job.calls[i]) == 1);
+}
+
+static void *Caller(void *data)
+{
+    vlc_object_t *obj = data;
+
+    for (unsigned i = 0; i < 200; i++)
+        TestRun(obj, 1 + i % MAX_SLICES);
+    return NULL;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    /* Uneven splits, aligned boundaries, and more slices than rows */
+    for (unsigned rows = 0; rows <= 130; rows++)
+        for (unsigned count = 1; count <= 2 * MAX_SLICES; count++)
+            for (unsigned align = 1; align <= 4; align *= 2)
+                TestRows(rows, count, align);
+    TestRows(1080, 7, 2);
+    TestRows(UINT_MAX, 15, 1);
+
+    const char *args[] = { "--quiet", "--ignore-config" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 77; /* skip */
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* Small pictures are not split */
+    assert(vlc_slices_Count(obj, 0) == 1);
+    assert(vlc_slices_Count(obj, VLC_SLICE_MIN_ROWS - 1) == 1);
+    assert(vlc_slices_Count(obj, VLC_SLICE_MIN_ROWS) == 1);
+    for (unsigned rows = 0; rows < 4096; rows += 7)
+    {
+        unsigned count = vlc_slices_Count(obj, rows);
+
+        assert(count >= 1);
+        assert(count == 1 || count <= rows / VLC_SLICE_MIN_ROWS);
+    }
+
+    for (unsigned count = 0; count <= MAX_SLICES; count++)
+        TestRun(obj, count);
+
+    /* Concurrent jobs share the worker threads */
+    vlc_thread_t threads[4];
+
+    for (unsigned i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        int val = vlc_clone(&threads[i], Caller, obj, VLC_THREAD_PRIORITY_LOW);
+        assert(val == 0);
+        (void) val;
+    }
+    Caller(obj);
+    for (unsigned i = 0; i < ARRAY_SIZE(threads); i++)
+        vlc_join(threads[i], NULL);
+
+    libvlc_release(vlc);
+    return 0;
+}